@@ -0,0 +1,61 @@
+#ifndef __DOCUMENT_SYNC_H__
+#define __DOCUMENT_SYNC_H__
+
+#include <QString>
+
+#include <optional>
+
+#include "synergy_protocol/TextOperation.h"
+
+/*
+------------------------------------------------------------------
+--------------------- Client copy of a document ------------------
+Client half of operational transform. At most one local operation is
+in flight (sent, not acked); edits made meanwhile are composed into a
+single buffered operation and sent when the ack arrives. Remote
+operations are transformed over both before being applied locally,
+so local typing never waits for the server.
+------------------------------------------------------------------
+*/
+class DocumentSync {
+public:
+  DocumentSync() = default;
+
+  const QString& content() const { return m_content; }
+  quint64 revision() const { return m_revision; }
+  bool hasPendingChanges() const { return m_outstanding.has_value(); }
+  // Sent but not acked, relative to revision(). Sent again after a resumed connection
+  const std::optional<SynergyProtocol::TextOperation>& outstanding() const { return m_outstanding; }
+
+  // Snapshot from server, unacknowledged local edits are dropped
+  void reset(const QString &content, quint64 revision);
+
+  // Local edit already made in the editor. Returns operation to send now, if nothing is in flight
+  std::optional<SynergyProtocol::TextOperation> applyLocal(const SynergyProtocol::TextOperation &operation);
+
+  // Server confirmed our in-flight operation. Returns buffered operation to send next, if any
+  std::optional<SynergyProtocol::TextOperation> acknowledge(quint64 revision);
+
+  // Operation from another participant. 'applied' is what the editor has to apply. False -> resync needed
+  bool applyRemote(const SynergyProtocol::TextOperation &operation, quint64 revision, SynergyProtocol::TextOperation &applied);
+
+  /*
+  Resume after a dropped connection: the server replays what we missed,
+  acks included, before it answers. beginResume() notes the operation in
+  flight when the resume is requested; finishResume() returns it to send
+  again only if the replay didn't ack it. An ack during the replay hands
+  out the buffered operation, which goes out on the new connection right
+  away and must not be sent a second time.
+  */
+  void beginResume();
+  std::optional<SynergyProtocol::TextOperation> finishResume();
+
+private:
+  QString m_content;
+  quint64 m_revision = 0; // Last server revision we know of
+  std::optional<SynergyProtocol::TextOperation> m_outstanding; // Sent, waiting for ack
+  std::optional<SynergyProtocol::TextOperation> m_buffer;      // Not sent yet
+  bool m_resendOutstanding = false; // In flight before the resume, not acked by the replay
+};
+
+#endif
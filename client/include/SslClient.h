@@ -9,15 +9,81 @@
 #include <QDebug>
 #include <QFile> // For loading ca certificate
 #include <QSslCipher>
+#include <QImage>
+#include <QLineF>
+#include <QPoint>
+#include <QPolygonF>
+#include <QTimer>
+#include <QStringDecoder>
+
+#include <memory>
 
 #include "synergy_protocol/MessageFactory.h"
+#include "synergy_protocol/FrameDecoder.h"
+#include "synergy_protocol/FrameCompressor.h"
+#include "synergy_protocol/FrameBufferPool.h"
+#include "synergy_protocol/AsyncLog.h"
+#include "DocumentSync.h"
+#include "StrokeBatcher.h"
 
 class SslClient : public QObject {
   Q_OBJECT
 public:
   explicit SslClient(QObject *parent = nullptr);
   void connectToServer(const QString &host = QStringLiteral("localhost"), quint16 port = 12345);
+  // Closes the connection for good, no reconnect and no resume afterwards
+  void disconnectFromServer();
+  // Session joined after connecting; empty (default) creates a new one
+  void setSessionToJoin(const QString &sessionId) { m_sessionId = sessionId; }
+  // Display name sent in join requests
+  void setUsername(const QString &username) { m_username = username; }
+  // TLS session ticket of the last connection is kept here and offered on the next connect, to resume instead
+  // of doing a full handshake. Empty path -> ticket kept in memory only
+  void setSessionTicketPath(const QString &path) { m_sessionTicketPath = path; }
   void sendMessage(const QString &message);
+  void sendMessage(const SynergyProtocol::Message_Base &message); // Encoded in negotiated wire format
+  // Formats offered in clientHello, most preferred first (e.g. only JSON for debugging)
+  void setPreferredWireFormats(const QList<SynergyProtocol::t_WireFormat> &formats) { m_preferredFormats = formats; }
+  // Frame compressions offered in clientHello (e.g. only NONE on a fast local network)
+  void setPreferredCompressions(const QList<SynergyProtocol::t_Compression> &compressions) { m_preferredCompressions = compressions; }
+
+  // Local edit of an open file, goes to server as delta (TEXT_OPERATION)
+  void editDocument(const QString &filePath, const SynergyProtocol::TextOperation &operation);
+  const DocumentSync* document(const QString &filePath) const;
+  // Content arrives in pieces (fileChunk), fileOpened once it is complete and editable
+  void openFile(const QString &filePath);
+
+  // Runs 'command' on the session workspace on the server, output comes as runOutputChunk, then runOutput (CLI-FUNC-EXEC-002)
+  void runCode(const QString &command, const QStringList &args = {}, const QString &environment = QString());
+
+  // Freehand drawing on the canvas: beginStroke/addPoint/endStroke, sent as batched DRAW_POLYLINE
+  StrokeBatcher& strokes() { return m_strokes; }
+
+signals:
+  // Editor has to apply 'operation' (already transformed against local edits)
+  void remoteTextOperation(const QString &filePath, const SynergyProtocol::TextOperation &operation);
+  // Whole content replaced (file opened by someone, or resync after rejected edit)
+  void documentReset(const QString &filePath, const QString &content);
+  // Next piece of a file being opened, appends to what came before. Enough to render the first screen early
+  void fileChunk(const QString &filePath, const QString &text, qint64 receivedBytes, qint64 totalBytes);
+  // Whole file arrived, document(filePath) holds it and remote operations follow
+  void fileOpened(const QString &filePath, quint64 revision);
+  // Live output of a run started by any participant. 'truncated' -> text is a server note about dropped output
+  void runOutputChunk(const QString &runId, bool isStderr, const QString &text, bool truncated);
+  // Run ended. Streamed runs carry their output in chunks, texts here are then empty (stderr may hold an error)
+  void runOutput(const QString &stdoutText, const QString &stderrText, int exitCode, const QString &requestingUserId);
+  void serverError(int code, const QString &message);
+  // Canvas state on join: compacted tiles first ('origin' in canvas pixels), then single strokes
+  void canvasTile(const QPoint &origin, const QImage &image);
+  void remoteDraw(const QLineF &line, const QString &color, double strokeWidth, const QString &originatorId);
+  // Batch of another participant's stroke, continues where previous batch of 'strokeId' ended
+  void remoteStroke(quint64 strokeId, const QPolygonF &points, const QString &color, double strokeWidth, const QString &originatorId);
+  void sessionJoined(const QString &sessionId, const QString &userId);
+  void joinFailed(const QString &error);
+  // Socket closed (a reconnect follows unless disconnectFromServer() was called)
+  void connectionLost();
+  // Connection dropped and came back. 'replayed' -> nothing was lost; otherwise session state was sent again
+  void sessionResumed(bool replayed);
 
 private slots:
   void onConnected(); // Standard socket connected signal, before encryption
@@ -26,9 +92,58 @@ private slots:
   void onSslErrors(const QList<QSslError> &errors); // SSL errors
   void onEncrypted(); // handshake successful
   void onErrorOccurred(QAbstractSocket::SocketError socketError); // general socket errors
+  void onNewSessionTicket(); // TLS 1.3 tickets arrive after the handshake
 
 private:
   QSslSocket m_socket;
+  SynergyProtocol::FrameDecoder m_decoder; // Reassembles length-prefixed frames from server
+  QList<SynergyProtocol::t_WireFormat> m_preferredFormats = SynergyProtocol::supportedWireFormats();
+  SynergyProtocol::t_WireFormat m_wireFormat = SynergyProtocol::t_WireFormat::JSON; // JSON until serverHello
+  QList<SynergyProtocol::t_Compression> m_preferredCompressions = SynergyProtocol::supportedCompressions();
+  SynergyProtocol::t_Compression m_compression = SynergyProtocol::t_Compression::NONE; // None until serverHello
+  QHash<QString, DocumentSync> m_documents; // File path -> local copy and in-flight edits
+  QHash<QString, quint64> m_runSequences;   // Run id -> next expected chunk sequence
+
+  // File being received in chunks, operations on it wait until it is complete
+  struct IncomingFile {
+    bool requested = false; // openFile(), otherwise a snapshot the server pushed
+    quint64 transferId = 0;
+    quint64 revision = 0;
+    std::shared_ptr<QStringDecoder> decoder = std::make_shared<QStringDecoder>(QStringDecoder::Utf8); // Chunks may split a character
+    QString content;
+    QList<SynergyProtocol::Message_Text_Operation> pendingOperations;
+  };
+  QHash<QString, IncomingFile> m_incomingFiles; // File path -> transfer in progress
+  StrokeBatcher m_strokes;
+  QString m_sessionTicketPath = QStringLiteral("session.ticket");
+  QString m_serverKey; // host:port the socket connects to, ticket is valid only there
+
+  /*
+  Resume after a dropped connection: server keeps us in the session for a while
+  and journals what we miss. We reconnect with backoff and present the token and
+  the highest sequence seen; server replays the rest, or resends state if it can't.
+  */
+  static constexpr int c_reconnectMinDelayMs = 500;
+  static constexpr int c_reconnectMaxDelayMs = 10000;
+  QString m_host;
+  quint16 m_port = 0;
+  bool m_reconnect = false;
+  int m_reconnectDelayMs = c_reconnectMinDelayMs;
+  QTimer m_reconnectTimer;
+  QString m_sessionId;
+  QString m_userId;
+  QString m_username = QStringLiteral("Client");
+  QString m_resumeToken;
+  quint64 m_lastSequence = 0; // Highest sequenced message received in the session
+
+  void restoreSessionTicket();
+  void scheduleReconnect();
+
+  void applyRemoteOperation(const SynergyProtocol::Message_Text_Operation &remote);
+  void receiveFileChunk(const SynergyProtocol::Message_File_Chunk &chunk);
+
+  void sendFrame(const QByteArray &payload);
+  void handleFrame(const QByteArray &frame);
 
 };
 
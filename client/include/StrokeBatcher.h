@@ -0,0 +1,74 @@
+#ifndef __STROKE_BATCHER_H__
+#define __STROKE_BATCHER_H__
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QPointF>
+#include <QTimer>
+
+#include <functional>
+
+#include "synergy_protocol/Message_Draw_Polyline.h"
+
+/*
+------------------------------------------------------------------
+-------------------- Outbound freehand strokes -------------------
+Mouse moves arrive far faster than anyone needs them on the wire, one
+DRAW_COMMAND per move means hundreds of tiny frames (and TLS records)
+per second, and as many broadcasts on the server. Points of the stroke
+being drawn are collected instead and leave as one DRAW_POLYLINE:
+- 'flushIntervalMs' after the first unsent point (one display frame),
+  so remote participants see the stroke at most a frame later
+- at once when 'maxPointsPerBatch' points are waiting, or stroke ends
+Before sending, points closer than 'minPointDistance' to the previous
+one are merged and, with 'simplifyTolerance' > 0, the batch is reduced
+with Douglas-Peucker (no kept point deviates more than the tolerance).
+Each batch starts at the last point of the previous one. Main thread only.
+------------------------------------------------------------------
+*/
+class StrokeBatcher : public QObject {
+  Q_OBJECT
+public:
+  struct Config {
+    int flushIntervalMs = 16;
+    int maxPointsPerBatch = 256;
+    double minPointDistance = 0.5; // Pixels
+    double simplifyTolerance = 0.0; // Pixels, 0 = Douglas-Peucker off
+  };
+
+  using Sink = std::function<void(const SynergyProtocol::Message_Draw_Polyline&)>;
+
+  explicit StrokeBatcher(Sink sink, Config config = Config(), QObject *parent = nullptr);
+
+  void setConfig(const Config &config);
+  const Config& config() const { return m_config; }
+
+  // Starts a new stroke (ending the current one). Returns its id
+  quint64 beginStroke(const QPointF &point, const QString &color, double strokeWidth);
+  void addPoint(const QPointF &point);
+  // Sends what's left of the stroke
+  void endStroke();
+  bool isDrawing() const { return m_drawing; }
+
+  // Points Douglas-Peucker keeps for 'tolerance', first and last always
+  static QList<QPointF> simplify(const QList<QPointF> &points, double tolerance);
+
+private slots:
+  void flush();
+
+private:
+  Sink m_sink;
+  Config m_config;
+  QTimer m_timer {this};
+
+  bool m_drawing = false;
+  quint64 m_strokeId = 0;
+  QString m_color;
+  double m_width = 1.0;
+  QList<QPointF> m_pending; // Not sent yet. Starts with the last sent point, if any
+  bool m_hasSent = false;   // m_pending[0] was already sent in previous batch
+  QPointF m_latest;         // Last point given, even if merged away
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "LoadStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+void LoadStats::merge(const LoadStats &other){
+  editLatenciesUs.insert(editLatenciesUs.end(), other.editLatenciesUs.cbegin(), other.editLatenciesUs.cend());
+  editsSent += other.editsSent;
+  editsReceived += other.editsReceived;
+  strokesSent += other.strokesSent;
+  strokesReceived += other.strokesReceived;
+  runsRequested += other.runsRequested;
+  runsCompleted += other.runsCompleted;
+  clientsJoined += other.clientsJoined;
+  joinFailures += other.joinFailures;
+  connectionsLost += other.connectionsLost;
+  resumes += other.resumes;
+  serverErrors += other.serverErrors;
+}
+
+qint64 LoadStats::percentile(const std::vector<qint64> &sorted, double fraction){
+  if(sorted.empty()) return 0;
+  const auto rank = static_cast<std::size_t>(std::ceil(fraction * double(sorted.size())));
+  return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+QJsonObject LoadStats::toJson(double seconds) const {
+  std::vector<qint64> sorted = editLatenciesUs;
+  std::sort(sorted.begin(), sorted.end());
+  const double mean = sorted.empty() ? 0.0 : double(std::accumulate(sorted.cbegin(), sorted.cend(), qint64(0))) / double(sorted.size());
+  const auto perSecond = [seconds](quint64 count) { return seconds > 0 ? double(count) / seconds : 0.0; };
+
+  QJsonObject latency {
+    {"samples", qint64(sorted.size())},
+    {"p50", percentile(sorted, 0.50)},
+    {"p99", percentile(sorted, 0.99)},
+    {"p999", percentile(sorted, 0.999)},
+    {"max", sorted.empty() ? 0 : sorted.back()},
+    {"mean", mean}
+  };
+  QJsonObject throughput {
+    {"edits_sent_per_s", perSecond(editsSent)},
+    {"edits_received_per_s", perSecond(editsReceived)},
+    {"strokes_sent_per_s", perSecond(strokesSent)},
+    {"strokes_received_per_s", perSecond(strokesReceived)},
+    {"runs_completed_per_s", perSecond(runsCompleted)}
+  };
+  QJsonObject counts {
+    {"edits_sent", qint64(editsSent)},
+    {"edits_received", qint64(editsReceived)},
+    {"strokes_sent", qint64(strokesSent)},
+    {"strokes_received", qint64(strokesReceived)},
+    {"runs_requested", qint64(runsRequested)},
+    {"runs_completed", qint64(runsCompleted)},
+    {"clients_joined", qint64(clientsJoined)}
+  };
+  const quint64 failures = joinFailures + serverErrors;
+  QJsonObject errors {
+    {"join_failures", qint64(joinFailures)},
+    {"connections_lost", qint64(connectionsLost)},
+    {"resumes", qint64(resumes)},
+    {"server_errors", qint64(serverErrors)},
+    // Failed requests per request made
+    {"error_rate", double(failures) / double(std::max<quint64>(1, editsSent + strokesSent + runsRequested + clientsJoined + joinFailures))}
+  };
+  return QJsonObject {
+    {"edit_latency_us", latency},
+    {"throughput", throughput},
+    {"counts", counts},
+    {"errors", errors}
+  };
+}
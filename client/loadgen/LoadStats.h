@@ -0,0 +1,37 @@
+#ifndef __LOAD_STATS_H__
+#define __LOAD_STATS_H__
+
+#include <QJsonObject>
+
+#include <vector>
+
+/*
+Counters and latency samples of one LoadWorker. Workers fill their own
+instance on their own thread, main thread merges them once the run is
+over, so nothing here is shared or locked while measuring.
+Latencies are kept as raw samples (microseconds) and sorted at the end:
+percentiles are exact, a few million samples are a few MiB.
+*/
+struct LoadStats {
+  std::vector<qint64> editLatenciesUs; // Edit sent by one client -> applied by another
+  quint64 editsSent = 0;
+  quint64 editsReceived = 0;
+  quint64 strokesSent = 0;
+  quint64 strokesReceived = 0;
+  quint64 runsRequested = 0;
+  quint64 runsCompleted = 0;
+  quint64 clientsJoined = 0;
+  quint64 joinFailures = 0;
+  quint64 connectionsLost = 0;
+  quint64 resumes = 0;
+  quint64 serverErrors = 0;
+
+  void merge(const LoadStats &other);
+  // 'seconds' is the measured window, rates are per second of it
+  QJsonObject toJson(double seconds) const;
+
+  // Value below which 'fraction' of sorted samples lie (nearest rank)
+  static qint64 percentile(const std::vector<qint64> &sorted, double fraction);
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include "LoadWorker.h"
+
+#include <QPointF>
+#include <QRandomGenerator>
+#include <QtMath>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+  // Typed text starts with \x01<steady clock ns>\x02, rest is filler
+  constexpr QChar c_markerStart = QChar(0x01);
+  constexpr QChar c_markerEnd = QChar(0x02);
+}
+
+LoadWorker::LoadWorker(int index, Config config) :
+  m_index(index),
+  m_config(std::move(config)) {
+  for(int session = 0; session < m_config.sessionSizes.size(); ++session) {
+    m_sessionIds.append(QString());
+    if(m_config.sessionSizes[session] > 0) m_pendingClients.append(session); // Creator first, the rest follows its join
+  }
+  m_connectTimer.setTimerType(Qt::PreciseTimer);
+  m_tickTimer.setTimerType(Qt::PreciseTimer);
+  connect(&m_connectTimer, &QTimer::timeout, this, &LoadWorker::connectNext);
+  connect(&m_tickTimer, &QTimer::timeout, this, &LoadWorker::tick);
+}
+
+LoadWorker::~LoadWorker() = default;
+
+qint64 LoadWorker::nowNs(){
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Exponential intervals (Poisson arrivals): mean 1/rate, clients drift apart instead of firing in lockstep
+qint64 LoadWorker::nextInterval(double perSecond) const {
+  if(perSecond <= 0) return std::numeric_limits<qint64>::max() / 2;
+  const double uniform = 1.0 - QRandomGenerator::global()->generateDouble(); // (0, 1]
+  return qint64(-std::log(uniform) / perSecond * 1e9);
+}
+
+void LoadWorker::start(){
+  m_running = true;
+  m_connectTimer.start(std::max(1, int(1000.0 / std::max(0.001, m_config.connectRate))));
+  m_tickTimer.start(c_tickMs);
+}
+
+void LoadWorker::startMeasuring(){
+  // Joins stay counted, they happen during warm-up by design
+  const quint64 joined = m_stats.clientsJoined;
+  const quint64 joinFailures = m_stats.joinFailures;
+  m_stats = LoadStats();
+  m_stats.clientsJoined = joined;
+  m_stats.joinFailures = joinFailures;
+}
+
+void LoadWorker::stop(){
+  m_running = false;
+  m_connectTimer.stop();
+  m_tickTimer.stop();
+  for(const std::unique_ptr<Client> &client : m_clients) {
+    client->client->disconnectFromServer();
+  }
+}
+
+LoadStats LoadWorker::takeStats(){
+  LoadStats stats = std::move(m_stats);
+  m_stats = LoadStats();
+  return stats;
+}
+
+void LoadWorker::connectNext(){
+  if(m_pendingClients.isEmpty()) return;
+  // Client of a session nobody created yet waits for its creator's join
+  for(qsizetype i = 0; i < m_pendingClients.size(); ++i) {
+    const int session = m_pendingClients[i];
+    const bool isCreator = m_sessionIds[session].isEmpty() && !std::any_of(m_clients.cbegin(), m_clients.cend(),
+      [session](const std::unique_ptr<Client> &client) { return client->session == session; });
+    if(isCreator || !m_sessionIds[session].isEmpty()) {
+      m_pendingClients.removeAt(i);
+      addClient(session);
+      return;
+    }
+  }
+}
+
+void LoadWorker::addClient(int session){
+  auto entry = std::make_unique<Client>();
+  entry->session = session;
+  entry->client = std::make_unique<SslClient>();
+  Client *client = entry.get();
+  SslClient *ssl = client->client.get();
+  ssl->setSessionTicketPath(QString()); // Thousands of clients, one ticket file would be a write storm
+  ssl->setUsername(QStringLiteral("load-%1-%2").arg(m_index).arg(m_clients.size()));
+  ssl->setSessionToJoin(m_sessionIds[session]);
+
+  connect(ssl, &SslClient::sessionJoined, this, [this, client](const QString &sessionId, const QString &) {
+    if(client->joined) return;
+    client->joined = true;
+    ++m_stats.clientsJoined;
+    if(m_sessionIds[client->session].isEmpty()) {
+      m_sessionIds[client->session] = sessionId;
+      // Rest of the session can connect now
+      for(int i = 1; i < m_config.sessionSizes[client->session]; ++i) m_pendingClients.append(client->session);
+    }
+    const qint64 now = nowNs();
+    client->nextEditNs = now + nextInterval(m_config.editsPerSecond);
+    client->nextStrokeNs = now + nextInterval(m_config.strokesPerSecond);
+    client->nextRunNs = now + nextInterval(m_config.runsPerSecond);
+  });
+  connect(ssl, &SslClient::joinFailed, this, [this](const QString &) { ++m_stats.joinFailures; });
+  connect(ssl, &SslClient::connectionLost, this, [this]() {
+    if(m_running) ++m_stats.connectionsLost;
+  });
+  connect(ssl, &SslClient::sessionResumed, this, [this](bool) { ++m_stats.resumes; });
+  connect(ssl, &SslClient::serverError, this, [this](int, const QString &) { ++m_stats.serverErrors; });
+  connect(ssl, &SslClient::remoteTextOperation, this, [this](const QString &, const SynergyProtocol::TextOperation &operation) {
+    recordRemoteEdit(operation);
+  });
+  connect(ssl, &SslClient::remoteStroke, this, [this]() { ++m_stats.strokesReceived; });
+  connect(ssl, &SslClient::runOutput, this, [this]() { ++m_stats.runsCompleted; });
+
+  m_clients.push_back(std::move(entry));
+  ssl->connectToServer(m_config.host, m_config.port);
+}
+
+void LoadWorker::tick(){
+  const qint64 now = nowNs();
+  for(const std::unique_ptr<Client> &client : m_clients) {
+    if(!client->joined) continue;
+    if(now >= client->nextEditNs) {
+      typeInto(*client, now);
+      client->nextEditNs = now + nextInterval(m_config.editsPerSecond);
+    }
+    if(now >= client->nextStrokeNs) {
+      drawStroke(*client);
+      client->nextStrokeNs = now + nextInterval(m_config.strokesPerSecond);
+    }
+    if(now >= client->nextRunNs) {
+      client->client->runCode(QStringLiteral("echo"), {QStringLiteral("loadgen")});
+      ++m_stats.runsRequested;
+      client->nextRunNs = now + nextInterval(m_config.runsPerSecond);
+    }
+  }
+}
+
+void LoadWorker::typeInto(Client &client, qint64 nowNs){
+  QString text = c_markerStart + QString::number(nowNs) + c_markerEnd;
+  while(text.size() < m_config.editSize) text.append(QChar(u'a' + QRandomGenerator::global()->bounded(26)));
+  // Appended at the end of the local copy, concurrent appends are what OT has to sort out
+  const DocumentSync *document = client.client->document(m_config.filePath);
+  SynergyProtocol::TextOperation operation;
+  operation.retain(document ? document->content().size() : 0).insert(text);
+  client.client->editDocument(m_config.filePath, operation);
+  ++m_stats.editsSent;
+}
+
+void LoadWorker::drawStroke(Client &client){
+  StrokeBatcher &strokes = client.client->strokes();
+  QRandomGenerator *random = QRandomGenerator::global();
+  QPointF point(random->bounded(2000.0), random->bounded(2000.0));
+  strokes.beginStroke(point, QStringLiteral("#336699"), 2.0);
+  for(int i = 1; i < m_config.pointsPerStroke; ++i) {
+    point += QPointF(random->bounded(8.0) - 4.0, random->bounded(8.0) - 4.0);
+    strokes.addPoint(point);
+  }
+  strokes.endStroke();
+  ++m_stats.strokesSent;
+}
+
+void LoadWorker::recordRemoteEdit(const SynergyProtocol::TextOperation &operation){
+  const qint64 now = nowNs();
+  // Several edits may arrive composed into one operation, every marker counts
+  for(const SynergyProtocol::TextOperation::Component &component : operation.components()) {
+    if(component.kind != SynergyProtocol::TextOperation::t_Kind::INSERT) continue;
+    qsizetype start = component.text.indexOf(c_markerStart);
+    while(start >= 0) {
+      const qsizetype end = component.text.indexOf(c_markerEnd, start + 1);
+      if(end < 0) break;
+      bool ok = false;
+      const qint64 typedAt = QStringView(component.text).mid(start + 1, end - start - 1).toLongLong(&ok);
+      if(ok && typedAt <= now) {
+        m_stats.editLatenciesUs.push_back((now - typedAt) / 1000);
+        ++m_stats.editsReceived;
+      }
+      start = component.text.indexOf(c_markerStart, end + 1);
+    }
+  }
+}
@@ -0,0 +1,96 @@
+#ifndef __LOAD_WORKER_H__
+#define __LOAD_WORKER_H__
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QTimer>
+
+#include <memory>
+#include <vector>
+
+#include "SslClient.h"
+#include "LoadStats.h"
+
+/*
+------------------------------------------------------------------
+------------------ Synthetic clients (load generator) ------------
+One LoadWorker drives the clients of a few sessions from its own
+thread: real SslClients (TLS, negotiated format and compression,
+DocumentSync, StrokeBatcher), just without a window.
+- clients connect at 'connectRate' per second; first client of each
+  session creates it, the others join once its id is known
+- every joined client types, draws and requests runs at the given
+  per-client rates (randomized intervals, so clients don't tick together)
+- typed text carries the steady-clock time it was typed at; whoever
+  applies it records typed -> applied latency. All clients live in
+  one process, so the clock is the same for sender and receiver, which
+  is also why the target has to be on localhost.
+Created on the main thread, then moved to its thread; everything else
+runs there. Stats are read once the run is over (takeStats).
+------------------------------------------------------------------
+*/
+class LoadWorker : public QObject {
+  Q_OBJECT
+public:
+  struct Config {
+    QString host = QStringLiteral("localhost");
+    quint16 port = 12345;
+    QList<int> sessionSizes;        // Clients in each session of this worker
+    double connectRate = 100.0;     // Clients connected per second by this worker
+    double editsPerSecond = 2.0;    // Per client
+    int editSize = 16;              // Characters typed per edit, marker included
+    double strokesPerSecond = 0.5;  // Per client
+    int pointsPerStroke = 32;
+    double runsPerSecond = 0.0;     // Per client
+    QString filePath = QStringLiteral("loadgen.txt");
+  };
+
+  LoadWorker(int index, Config config);
+  ~LoadWorker() override;
+
+public slots:
+  void start();          // Begins connecting clients
+  void startMeasuring(); // Warm-up over: activity so far is discarded
+  void stop();           // Ends scripted activity and disconnects every client
+
+public:
+  // Worker's thread only (BlockingQueuedConnection from outside)
+  LoadStats takeStats();
+
+private slots:
+  void connectNext();
+  void tick();
+
+private:
+  static constexpr int c_tickMs = 5;
+
+  struct Client {
+    std::unique_ptr<SslClient> client;
+    int session = 0;
+    bool joined = false;
+    qint64 nextEditNs = 0;
+    qint64 nextStrokeNs = 0;
+    qint64 nextRunNs = 0;
+  };
+
+  int m_index;
+  Config m_config;
+  LoadStats m_stats;
+  std::vector<std::unique_ptr<Client>> m_clients;
+  QList<QString> m_sessionIds;   // Per session, empty until its first client joined
+  QList<int> m_pendingClients;   // Session of each client still to connect
+  QTimer m_connectTimer;
+  QTimer m_tickTimer;
+  bool m_running = false;
+
+  void addClient(int session);
+  void typeInto(Client &client, qint64 nowNs);
+  void drawStroke(Client &client);
+  void recordRemoteEdit(const SynergyProtocol::TextOperation &operation);
+  qint64 nextInterval(double perSecond) const;
+
+  static qint64 nowNs();
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include <QCoreApplication> // Needs Qt6::Core
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QSslSocket>
+#include <QThread>
+#include <QTimer>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "LoadWorker.h"
+
+/*
+------------------------------------------------------------------
+----------------------- synergy_loadgen ---------------------------
+Swarm of headless clients against a local server, results as JSON:
+  synergy_loadgen --clients 2000 --sessions 200 --duration 60 --output run.json
+Clients are split into sessions, sessions over worker threads. Run is
+warm-up (connecting, first edits) followed by the measured window;
+only the window is reported. Same 'cert.pem' as the regular client.
+------------------------------------------------------------------
+*/
+int main(int argc, char *argv[]){
+  QCoreApplication a(argc, argv);
+  QCoreApplication::setApplicationName("synergy_loadgen");
+  SynergyProtocol::AsyncLog logging; // Warnings of thousands of clients must not stall their threads
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Drives many Synergy Studio clients against a local server and reports latency and throughput as JSON");
+  parser.addHelpOption();
+  const QCommandLineOption hostOption("host", "Server host, loopback only.", "host", "localhost");
+  const QCommandLineOption portOption("port", "Server port.", "port", "12345");
+  const QCommandLineOption clientsOption("clients", "Total clients.", "count", "100");
+  const QCommandLineOption sessionsOption("sessions", "Sessions the clients are split into.", "count", "10");
+  const QCommandLineOption threadsOption("threads", "Worker threads (0 = one per core).", "count", "0");
+  const QCommandLineOption connectRateOption("connect-rate", "New connections per second, all workers together.", "rate", "200");
+  const QCommandLineOption warmupOption("warmup", "Seconds before measuring starts.", "seconds", "5");
+  const QCommandLineOption durationOption("duration", "Measured seconds.", "seconds", "30");
+  const QCommandLineOption editRateOption("edit-rate", "Edits per second per client.", "rate", "2");
+  const QCommandLineOption editSizeOption("edit-size", "Characters per edit, at least 24 (latency marker included).", "count", "16");
+  const QCommandLineOption drawRateOption("draw-rate", "Strokes per second per client.", "rate", "0.5");
+  const QCommandLineOption runRateOption("run-rate", "Run requests per second per client.", "rate", "0");
+  const QCommandLineOption outputOption("output", "Result file, stdout if not given.", "file");
+  parser.addOptions({hostOption, portOption, clientsOption, sessionsOption, threadsOption, connectRateOption,
+                     warmupOption, durationOption, editRateOption, editSizeOption, drawRateOption, runRateOption, outputOption});
+  parser.process(a);
+
+  // Latency is measured with one clock for sender and receiver, and nobody should be load tested by accident
+  const QString host = parser.value(hostOption);
+  if(host.compare("localhost", Qt::CaseInsensitive) != 0 && !QHostAddress(host).isLoopback()) {
+    qCritical() << "LOADGEN | Refusing non-loopback host" << host;
+    return 1;
+  }
+  if (!QSslSocket::supportsSsl()) {
+    qCritical() << "LOADGEN | SSL is not supported by this Qt build or system configuration. Cannot run.";
+    return 1;
+  }
+  if (!QFile::exists("cert.pem")) {
+    qCritical() << "LOADGEN | 'cert.pem' not found in the working directory.";
+    return 1;
+  }
+
+  const int clients = qMax(1, parser.value(clientsOption).toInt());
+  const int sessions = qBound(1, parser.value(sessionsOption).toInt(), clients);
+  int threads = parser.value(threadsOption).toInt();
+  if(threads <= 0) threads = qMax(1, QThread::idealThreadCount());
+  threads = qMin(threads, sessions);
+  const double warmup = qMax(0.0, parser.value(warmupOption).toDouble());
+  const double duration = qMax(1.0, parser.value(durationOption).toDouble());
+
+  LoadWorker::Config base;
+  base.host = host;
+  base.port = parser.value(portOption).toUShort();
+  base.connectRate = qMax(1.0, parser.value(connectRateOption).toDouble()) / threads;
+  base.editsPerSecond = parser.value(editRateOption).toDouble();
+  base.editSize = qMax(24, parser.value(editSizeOption).toInt()); // Marker alone is ~21 characters
+  base.strokesPerSecond = parser.value(drawRateOption).toDouble();
+  base.runsPerSecond = parser.value(runRateOption).toDouble();
+
+  // Every client logs each message it handles, thousands of them would measure the terminal
+  QLoggingCategory::setFilterRules("default.debug=false\ndefault.info=false");
+
+  // Session s -> worker s % threads, remainder clients go to the first sessions
+  std::vector<LoadWorker::Config> configs(threads, base);
+  for(int session = 0; session < sessions; ++session) {
+    configs[session % threads].sessionSizes.append(clients / sessions + (session < clients % sessions ? 1 : 0));
+  }
+
+  std::vector<QThread*> workerThreads;
+  std::vector<LoadWorker*> workers;
+  for(int i = 0; i < threads; ++i) {
+    QThread *thread = new QThread(&a);
+    thread->setObjectName(QStringLiteral("load-%1").arg(i));
+    LoadWorker *worker = new LoadWorker(i, configs[i]);
+    worker->moveToThread(thread);
+    QObject::connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+    workerThreads.push_back(thread);
+    workers.push_back(worker);
+    thread->start();
+    QMetaObject::invokeMethod(worker, &LoadWorker::start, Qt::QueuedConnection);
+  }
+
+  QElapsedTimer measured;
+  QTimer::singleShot(qRound(warmup * 1000), &a, [&]() {
+    for(LoadWorker *worker : workers) {
+      QMetaObject::invokeMethod(worker, &LoadWorker::startMeasuring, Qt::BlockingQueuedConnection);
+    }
+    measured.start();
+    QTimer::singleShot(qRound(duration * 1000), &a, [&]() {
+      const double seconds = measured.elapsed() / 1000.0;
+      LoadStats total;
+      for(LoadWorker *worker : workers) {
+        // Stats first, so the disconnects below don't count as lost connections
+        LoadStats stats;
+        QMetaObject::invokeMethod(worker, [worker]() { return worker->takeStats(); }, Qt::BlockingQueuedConnection, &stats);
+        total.merge(stats);
+        QMetaObject::invokeMethod(worker, &LoadWorker::stop, Qt::BlockingQueuedConnection);
+      }
+
+      QJsonObject config;
+      config["host"] = host;
+      config["port"] = base.port;
+      config["clients"] = clients;
+      config["sessions"] = sessions;
+      config["threads"] = threads;
+      config["warmup_s"] = warmup;
+      config["duration_s"] = duration;
+      config["edit_rate"] = base.editsPerSecond;
+      config["edit_size"] = base.editSize;
+      config["draw_rate"] = base.strokesPerSecond;
+      config["run_rate"] = base.runsPerSecond;
+
+      QJsonObject report = total.toJson(seconds);
+      report["config"] = config;
+      const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+      int exitCode = total.clientsJoined > 0 ? 0 : 1;
+      if(parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if(file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+          file.write(json);
+        } else {
+          qCritical() << "LOADGEN | Could not write" << file.fileName() << file.errorString();
+          exitCode = 1;
+        }
+      } else {
+        std::cout << json.constData() << std::flush;
+      }
+      QCoreApplication::exit(exitCode);
+    });
+  });
+
+  const int result = a.exec();
+  for(QThread *thread : workerThreads) thread->quit();
+  for(QThread *thread : workerThreads) thread->wait();
+  return result;
+}
@@ -0,0 +1,64 @@
+#include "../include/DocumentSync.h"
+
+void DocumentSync::reset(const QString &content, quint64 revision){
+  m_content = content;
+  m_revision = revision;
+  m_outstanding.reset();
+  m_buffer.reset();
+  m_resendOutstanding = false;
+}
+
+std::optional<SynergyProtocol::TextOperation> DocumentSync::applyLocal(const SynergyProtocol::TextOperation &operation){
+  if(!operation.applyTo(m_content)) return std::nullopt;
+
+  if(!m_outstanding) {
+    m_outstanding = operation;
+    return operation;
+  }
+  if(!m_buffer) {
+    m_buffer = operation;
+  } else {
+    SynergyProtocol::TextOperation composed;
+    SynergyProtocol::TextOperation::compose(*m_buffer, operation, composed);
+    m_buffer = std::move(composed);
+  }
+  return std::nullopt;
+}
+
+std::optional<SynergyProtocol::TextOperation> DocumentSync::acknowledge(quint64 revision){
+  m_revision = revision;
+  m_outstanding = std::move(m_buffer);
+  m_buffer.reset();
+  m_resendOutstanding = false; // Whatever is in flight now is sent by the caller
+  return m_outstanding;
+}
+
+bool DocumentSync::applyRemote(const SynergyProtocol::TextOperation &operation, quint64 revision, SynergyProtocol::TextOperation &applied){
+  // Remote operation is already in server history -> it wins insert ties, same as on the server
+  applied = operation;
+  if(m_outstanding) {
+    SynergyProtocol::TextOperation remotePrime, outstandingPrime;
+    if(!SynergyProtocol::TextOperation::transform(applied, *m_outstanding, remotePrime, outstandingPrime)) return false;
+    applied = std::move(remotePrime);
+    m_outstanding = std::move(outstandingPrime);
+  }
+  if(m_buffer) {
+    SynergyProtocol::TextOperation remotePrime, bufferPrime;
+    if(!SynergyProtocol::TextOperation::transform(applied, *m_buffer, remotePrime, bufferPrime)) return false;
+    applied = std::move(remotePrime);
+    m_buffer = std::move(bufferPrime);
+  }
+  if(!applied.applyTo(m_content)) return false;
+  m_revision = revision;
+  return true;
+}
+
+void DocumentSync::beginResume(){
+  m_resendOutstanding = m_outstanding.has_value();
+}
+
+std::optional<SynergyProtocol::TextOperation> DocumentSync::finishResume(){
+  if(!m_resendOutstanding) return std::nullopt;
+  m_resendOutstanding = false;
+  return m_outstanding; // Transformed over the replayed operations, relative to revision()
+}
@@ -1,6 +1,15 @@
 #include "../include/SslClient.h"
 
-SslClient::SslClient(QObject *parent) : QObject(parent) {
+#include <QDataStream>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QSaveFile>
+
+#include <algorithm>
+
+SslClient::SslClient(QObject *parent) :
+  QObject(parent),
+  m_strokes([this](const SynergyProtocol::Message_Draw_Polyline &polyline) { sendMessage(polyline); }) {
   // Connect socket's signals to our slots before connecting
   // This ensures we catch all events, including errors during connection/handshake
   connect(&m_socket, &QAbstractSocket::connected, this, &SslClient::onConnected);
@@ -10,6 +19,9 @@ SslClient::SslClient(QObject *parent) : QObject(parent) {
   connect(&m_socket, &QSslSocket::encrypted, this, &SslClient::onEncrypted);
   // Catch generat errors like 'Connection refused'
   connect(&m_socket, &QAbstractSocket::errorOccurred, this, &SslClient::onErrorOccurred);
+  connect(&m_socket, &QSslSocket::newSessionTicketReceived, this, &SslClient::onNewSessionTicket);
+  m_reconnectTimer.setSingleShot(true);
+  connect(&m_reconnectTimer, &QTimer::timeout, this, [this]() { connectToServer(m_host, m_port); });
 
   /* Security: We have two options in regards to certifications
   - Add server certification as CA
@@ -37,6 +49,8 @@ SslClient::SslClient(QObject *parent) : QObject(parent) {
     caCerts.append(serverCerts.first()); // Add servers cert to the list of trusted CAs
     config.setCaCertificates(caCerts);
     config.setProtocol(QSsl::TlsV1_2OrLater);
+    // Keep session (ticket) after handshake, so the next connection can resume it
+    config.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
     m_socket.setSslConfiguration(config);
     qInfo() << "Client: Configured to trust server's self signed certificate.";
   }
@@ -49,6 +63,11 @@ void SslClient::connectToServer(const QString &host, quint16 port){
     return;
   }
   qInfo() << "Client: Attempting to connect to: " << host << ":" << port << " using SSL...";
+  m_host = host;
+  m_port = port;
+  m_reconnect = true;
+  m_serverKey = QStringLiteral("%1:%2").arg(host).arg(port);
+  restoreSessionTicket();
   // Initiate TCP connection and start SSL/TLS handshake immediately after TCP connects
   // m_socket.connectToHostEncrypted(host, port);
   // ^ Doesn't strictly verify that the hostname/IP in the certificate's Common Name (CN)
@@ -58,6 +77,70 @@ void SslClient::connectToServer(const QString &host, quint16 port){
   m_socket.connectToHostEncrypted(host, port, host);
 }
 
+void SslClient::disconnectFromServer(){
+  m_reconnect = false;
+  m_reconnectTimer.stop();
+  m_resumeToken.clear();
+  m_sessionId.clear();
+  m_lastSequence = 0;
+  m_socket.disconnectFromHost();
+}
+
+// Exponential backoff with jitter, so clients dropped together don't come back together
+void SslClient::scheduleReconnect(){
+  if(!m_reconnect || m_reconnectTimer.isActive()) return;
+  const int delay = m_reconnectDelayMs / 2 + QRandomGenerator::global()->bounded(m_reconnectDelayMs / 2 + 1);
+  m_reconnectDelayMs = std::min(m_reconnectDelayMs * 2, c_reconnectMaxDelayMs);
+  qInfo() << "Client: Reconnecting in" << delay << "ms";
+  m_reconnectTimer.start(delay);
+}
+
+/*
+Ticket file: server key, expiry (ms since epoch), ticket bytes.
+Ticket is a resumption secret for this server, file is owner-only.
+Server refuses stale or unknown tickets by doing a full handshake,
+so a bad file costs one handshake, nothing else.
+*/
+void SslClient::restoreSessionTicket(){
+  QSslConfiguration config = m_socket.sslConfiguration();
+  QByteArray ticket;
+  QFile file(m_sessionTicketPath);
+  if(!m_sessionTicketPath.isEmpty() && file.open(QIODevice::ReadOnly)) {
+    QDataStream in(&file);
+    QString serverKey;
+    qint64 expiresAt = 0;
+    in >> serverKey >> expiresAt >> ticket;
+    if(in.status() != QDataStream::Ok || serverKey != m_serverKey || expiresAt <= QDateTime::currentMSecsSinceEpoch()) {
+      ticket.clear();
+    }
+  } else if(m_sessionTicketPath.isEmpty()) {
+    ticket = config.sessionTicket(); // In memory from previous connection
+  }
+  config.setSessionTicket(ticket);
+  m_socket.setSslConfiguration(config);
+  if(!ticket.isEmpty()) qInfo() << "Client: Offering TLS session ticket for resumption";
+}
+
+void SslClient::onNewSessionTicket(){
+  const QSslConfiguration config = m_socket.sslConfiguration();
+  const QByteArray ticket = config.sessionTicket();
+  if(ticket.isEmpty() || m_sessionTicketPath.isEmpty()) return;
+
+  const int lifetimeSecs = config.sessionTicketLifeTimeHint();
+  const qint64 expiresAt = QDateTime::currentMSecsSinceEpoch() + qint64(lifetimeSecs > 0 ? lifetimeSecs : 0) * 1000;
+  QSaveFile file(m_sessionTicketPath);
+  if(!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Client: Could not store TLS session ticket:" << file.errorString();
+    return;
+  }
+  file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+  QDataStream out(&file);
+  out << m_serverKey << expiresAt << ticket;
+  if(!file.commit()) {
+    qWarning() << "Client: Could not store TLS session ticket:" << file.errorString();
+  }
+}
+
 // Slot: Connected (TCP level)
 void SslClient::onConnected(){
   // Emitted before SSL handshake is completed, 'encrypted' indicates successfull secure connection
@@ -68,23 +151,38 @@ void SslClient::onConnected(){
 // Slot: Encrypted (SSL handshake completed)
 void SslClient::onEncrypted(){
   qInfo() << "Client: SSL Handshake successful! Connection is now encrypted.";
+  m_reconnectDelayMs = c_reconnectMinDelayMs;
   qInfo() << "Client: Cipher used:" << m_socket.sessionCipher().name();
   // Now it's safe to send application data securely.
-  SynergyProtocol::Message_Join_Session_Request join_msg {m_socket.socketDescriptor(), QString(""), true, QString("Client")};
-  sendMessage(join_msg.toString());
+  // Protocol starts with clientHello, always in JSON as nothing is negotiated yet
+  m_wireFormat = SynergyProtocol::t_WireFormat::JSON;
+  m_compression = SynergyProtocol::t_Compression::NONE;
+  SynergyProtocol::Message_Client_Hello hello {m_socket.socketDescriptor(), m_preferredFormats, m_preferredCompressions};
+  sendMessage(hello);
 }
 
 // Slot: Disconnected
 void SslClient::onDisconnected(){
   qInfo() << "Client: Disconnected from server.";
-  // TBD : Recconection or notify the user
+  m_decoder.reset(); // Partial frame from old connection is useless
+  emit connectionLost();
+  scheduleReconnect();
 }
 
 // Slot: Data Receive
 void SslClient::onReadyRead(){
   // Explanation: Read encrypted data. Qt decrypts it automatically.
-  QByteArray data = m_socket.readAll();
-  qInfo() << "Client: Received from server:" << data;
+  // Data is split into frames by 4-byte length prefix (CLI-FUNC-NM-009)
+  auto status = m_decoder.readFrames(&m_socket, [this](const QByteArray &frame) {
+    handleFrame(frame);
+  });
+  if(status == SynergyProtocol::FrameDecoder::t_Status::FRAME_TOO_LARGE) {
+    qCritical() << "Client: Server sent frame larger than" << m_decoder.maxFrameSize() << "bytes. Closing connection.";
+    m_socket.abort();
+  } else if(status == SynergyProtocol::FrameDecoder::t_Status::MALFORMED_FRAME) {
+    qCritical() << "Client: Server sent compressed frame that could not be inflated. Closing connection.";
+    m_socket.abort();
+  }
 
   // Example: Send another message after receiving
   // static int count = 0;
@@ -95,6 +193,207 @@ void SslClient::onReadyRead(){
   // }
 }
 
+void SslClient::handleFrame(const QByteArray &frame){
+  qCDebug(SynergyProtocol::logPayload) << "Client: Received from server:" << frame;
+  // Frames that aren't protocol messages (plain text replies) are only logged
+  auto handlers = SynergyProtocol::MessageHandlers {
+    [this](const SynergyProtocol::Message_Server_Hello &hello) {
+      // Every following frame uses the format server picked from our list
+      m_wireFormat = hello.wireFormat();
+      m_compression = hello.compression();
+      m_decoder.setCompression(m_compression); // Frames after this one may be compressed
+      qInfo() << "Client: Server accepted wire format" << SynergyProtocol::wireFormatToString(m_wireFormat)
+              << "compression" << SynergyProtocol::compressionToString(m_compression);
+
+      if(!m_resumeToken.isEmpty()) {
+        for(DocumentSync &document : m_documents) document.beginResume(); // Before any replayed frame
+        sendMessage(SynergyProtocol::Message_Resume_Session_Request {m_socket.socketDescriptor(), m_sessionId, m_resumeToken, m_lastSequence});
+        return;
+      }
+      SynergyProtocol::Message_Join_Session_Request join_msg {m_socket.socketDescriptor(), m_sessionId, m_sessionId.isEmpty(), m_username};
+      sendMessage(join_msg);
+    },
+    [this](const SynergyProtocol::Message_Join_Session_Response &response) {
+      if(!response.success()) {
+        qWarning() << "Client: Join rejected:" << response.errorMessage();
+        emit joinFailed(response.errorMessage());
+        return;
+      }
+      qInfo() << "Client: Joined session" << response.sessionId() << "as" << response.userId();
+      m_sessionId = response.sessionId();
+      m_userId = response.userId();
+      m_resumeToken = response.resumeToken();
+      emit sessionJoined(m_sessionId, m_userId);
+      // Tree comes once, later changes arrive as fileTreeDiff
+      sendMessage(SynergyProtocol::Message_Request_File_Tree {m_socket.socketDescriptor()});
+    },
+    [this](const SynergyProtocol::Message_Resume_Session_Response &response) {
+      if(!response.success()) {
+        // Resume window is over, join the same session as a new participant
+        qWarning() << "Client: Resume rejected:" << response.errorMessage() << ", joining again";
+        m_resumeToken.clear();
+        m_lastSequence = 0;
+        sendMessage(SynergyProtocol::Message_Join_Session_Request {m_socket.socketDescriptor(), m_sessionId, false, m_username});
+        return;
+      }
+      qInfo() << "Client: Resumed session" << m_sessionId << "as" << response.userId() << (response.replayed() ? "(nothing lost)" : "(state resent)");
+      m_resumeToken = response.resumeToken();
+      if(!response.replayed()) {
+        sendMessage(SynergyProtocol::Message_Request_File_Tree {m_socket.socketDescriptor()});
+      }
+      // Transfers die with the connection, ask again (chunks of the new one start over)
+      for(auto it = m_incomingFiles.cbegin(); it != m_incomingFiles.cend(); ++it) {
+        sendMessage(SynergyProtocol::Message_Request_Open_File {m_socket.socketDescriptor(), it.key()});
+      }
+      // Edits the server never acked were lost with the connection, acks of applied ones came in the replay
+      for(auto it = m_documents.begin(); it != m_documents.end(); ++it) {
+        if(auto resend = it->finishResume()) {
+          sendMessage(SynergyProtocol::Message_Text_Operation {m_socket.socketDescriptor(), it.key(), it->revision(), *resend});
+        }
+      }
+      emit sessionResumed(response.replayed());
+    },
+    [this](const SynergyProtocol::Message_Update_Text_Edit &snapshot) {
+      m_incomingFiles.remove(snapshot.filePath()); // Newer than anything still streaming
+      m_documents[snapshot.filePath()].reset(snapshot.content(), snapshot.revision());
+      emit documentReset(snapshot.filePath(), snapshot.content());
+    },
+    [this](const SynergyProtocol::Message_Text_Operation &remote) {
+      auto incoming = m_incomingFiles.find(remote.filePath());
+      if(incoming != m_incomingFiles.end()) {
+        incoming->pendingOperations.append(remote);
+        return;
+      }
+      applyRemoteOperation(remote);
+    },
+    [this](const SynergyProtocol::Message_File_Chunk &chunk) {
+      receiveFileChunk(chunk);
+    },
+    [this](const SynergyProtocol::Message_Text_Operation_Ack &ack) {
+      DocumentSync &document = m_documents[ack.filePath()];
+      if(auto next = document.acknowledge(ack.revision())) {
+        sendMessage(SynergyProtocol::Message_Text_Operation {m_socket.socketDescriptor(), ack.filePath(), document.revision(), *next});
+      }
+    },
+    [this](const SynergyProtocol::Message_Run_Output_Chunk &chunk) {
+      quint64 &expected = m_runSequences[chunk.runId()];
+      if(chunk.sequence() != expected) {
+        qWarning() << "Client: Output of" << chunk.runId() << "skipped from chunk" << expected << "to" << chunk.sequence();
+      }
+      expected = chunk.sequence() + 1;
+      emit runOutputChunk(chunk.runId(), chunk.stream() == SynergyProtocol::Message_Run_Output_Chunk::t_Stream::STDERR, chunk.data(), chunk.truncated());
+    },
+    [this](const SynergyProtocol::Message_Run_Output_Result &result) {
+      m_runSequences.remove(result.runId());
+      emit runOutput(result.stdoutText(), result.stderrText(), result.exitCode(), result.requestingUserId());
+    },
+    [this](const SynergyProtocol::Message_Error_Notification &error) {
+      qWarning() << "Client: Server reported error" << error.code() << ":" << error.message();
+      emit serverError(error.code(), error.message());
+    },
+    [this](const SynergyProtocol::Message_Canvas_Snapshot &snapshot) {
+      for(const SynergyProtocol::Message_Canvas_Snapshot::Tile &tile : snapshot.tiles()) {
+        QImage image;
+        if(!image.loadFromData(tile.png, "PNG")) {
+          qWarning() << "Client: Canvas tile" << tile.x << tile.y << "could not be decoded";
+          continue;
+        }
+        emit canvasTile(QPoint(tile.x * snapshot.tileSize(), tile.y * snapshot.tileSize()), image);
+      }
+    },
+    [this](const SynergyProtocol::Message_Draw_Command &command) {
+      emit remoteDraw(QLineF(command.startX(), command.startY(), command.endX(), command.endY()),
+                      command.color(), command.strokeWidth(), command.originatorId());
+    },
+    [this](const SynergyProtocol::Message_Draw_Polyline &polyline) {
+      emit remoteStroke(polyline.strokeId(), QPolygonF(polyline.points()), polyline.color(), polyline.strokeWidth(), polyline.originatorId());
+    },
+    [this](const SynergyProtocol::Message_Ping &ping) {
+      // Server drops connections that stay silent, answering keeps an idle client connected
+      sendMessage(SynergyProtocol::Message_Pong {m_socket.socketDescriptor(), ping.token()});
+    },
+    [](const auto &message) {
+      qCDebug(SynergyProtocol::logTraffic) << "Client: Message" << SynergyProtocol::messageTypeToString(message.type()) << "not handled yet";
+    }
+  };
+  SynergyProtocol::MessageFactory::dispatch(frame, m_wireFormat, [this, &handlers](const auto &message) {
+    // Position in the session stream, reported on resume
+    m_lastSequence = std::max(m_lastSequence, message.sequence());
+    handlers(message);
+  });
+}
+
+void SslClient::applyRemoteOperation(const SynergyProtocol::Message_Text_Operation &remote){
+  DocumentSync &document = m_documents[remote.filePath()];
+  SynergyProtocol::TextOperation applied;
+  if(!document.applyRemote(remote.operation(), remote.revision(), applied)) {
+    // Local copy no longer matches server, empty operation asks for whole content
+    qWarning() << "Client: Remote operation doesn't apply to" << remote.filePath() << ", requesting resync";
+    sendMessage(SynergyProtocol::Message_Text_Operation {m_socket.socketDescriptor(), remote.filePath(), 0, SynergyProtocol::TextOperation()});
+    return;
+  }
+  emit remoteTextOperation(remote.filePath(), applied);
+}
+
+void SslClient::openFile(const QString &filePath){
+  IncomingFile incoming;
+  incoming.requested = true;
+  m_incomingFiles.insert(filePath, std::move(incoming));
+  sendMessage(SynergyProtocol::Message_Request_Open_File {m_socket.socketDescriptor(), filePath});
+}
+
+void SslClient::receiveFileChunk(const SynergyProtocol::Message_File_Chunk &chunk){
+  auto it = m_incomingFiles.find(chunk.filePath());
+  if(it == m_incomingFiles.end()) {
+    // Server pushes document snapshots the same way (joined session, resync); the rest of a superseded transfer is dropped
+    if(chunk.offset() != 0) return;
+    it = m_incomingFiles.insert(chunk.filePath(), IncomingFile());
+  }
+  IncomingFile &incoming = it.value();
+  if(chunk.offset() == 0) {
+    // First chunk of a transfer; a repeated request restarts from here
+    incoming.transferId = chunk.transferId();
+    incoming.revision = chunk.revision();
+    incoming.decoder->resetState();
+    incoming.content.clear();
+  } else if(chunk.transferId() != incoming.transferId) {
+    return; // Rest of a transfer that was restarted
+  }
+
+  const QString text = incoming.decoder->decode(chunk.data());
+  incoming.content.append(text);
+  emit fileChunk(chunk.filePath(), text, chunk.offset() + chunk.data().size(), chunk.totalSize());
+  if(!chunk.isLast()) return;
+
+  const IncomingFile complete = m_incomingFiles.take(chunk.filePath());
+  m_documents[chunk.filePath()].reset(complete.content, complete.revision);
+  if(complete.requested) {
+    emit fileOpened(chunk.filePath(), complete.revision);
+  } else {
+    emit documentReset(chunk.filePath(), complete.content);
+  }
+  for(const SynergyProtocol::Message_Text_Operation &remote : complete.pendingOperations) {
+    if(remote.revision() > complete.revision) applyRemoteOperation(remote); // Older ones are in the content already
+  }
+}
+
+void SslClient::runCode(const QString &command, const QStringList &args, const QString &environment){
+  sendMessage(SynergyProtocol::Message_Request_Run_Code {m_socket.socketDescriptor(), command, args, environment});
+}
+
+void SslClient::editDocument(const QString &filePath, const SynergyProtocol::TextOperation &operation){
+  DocumentSync &document = m_documents[filePath];
+  // Only one operation in flight per file, the rest is composed until ack arrives
+  if(auto toSend = document.applyLocal(operation)) {
+    sendMessage(SynergyProtocol::Message_Text_Operation {m_socket.socketDescriptor(), filePath, document.revision(), *toSend});
+  }
+}
+
+const DocumentSync* SslClient::document(const QString &filePath) const {
+  auto it = m_documents.constFind(filePath);
+  return it == m_documents.cend() ? nullptr : &it.value();
+}
+
 // Slot: SSL Errors
 // Explanation: This is where we handle certificate validation errors, etc.
 void SslClient::onSslErrors(const QList<QSslError> &errors){
@@ -118,13 +417,30 @@ void SslClient::onErrorOccurred(QAbstractSocket::SocketError socketError)
   // This catches errors *not* related to SSL specifically, like connection refused.
   Q_UNUSED(socketError); // Mark parameter as unused if not needed directly
   qCritical() << "Client: Socket error occurred:" << m_socket.errorString();
+  // Failed connect attempts never reach 'disconnected'
+  if(m_socket.state() == QAbstractSocket::UnconnectedState) scheduleReconnect();
 }
 
 void SslClient::sendMessage(const QString &message){
+  qCDebug(SynergyProtocol::logPayload) << "Client: Sending message: " << message;
+  sendFrame(message.toUtf8());
+}
+
+void SslClient::sendMessage(const SynergyProtocol::Message_Base &message){
+  qCDebug(SynergyProtocol::logTraffic) << "Client: Sending" << SynergyProtocol::messageTypeToString(message.type())
+          << "as" << SynergyProtocol::wireFormatToString(m_wireFormat);
+  sendFrame(message.encode(m_wireFormat));
+}
+
+void SslClient::sendFrame(const QByteArray &payload){
   if(m_socket.state() == QAbstractSocket::ConnectedState && m_socket.isEncrypted()) {
-    qInfo() << "Client: Sending message: " << message;
     // Qt handles encryption
-    m_socket.write(message.toUtf8() + "\n");
+    // Each message is prefixed with its 4-byte big-endian length (CLI-FUNC-NM-008)
+    QByteArray frame = SynergyProtocol::FrameDecoder::encodeFrame(payload);
+    QByteArray compressed = SynergyProtocol::FrameCompressor::compressFrame(frame, m_compression);
+    SynergyProtocol::FrameBufferPool::release(std::move(frame)); // Kept only if compression made a new buffer
+    m_socket.write(compressed);
+    SynergyProtocol::FrameBufferPool::release(std::move(compressed)); // Unless the socket still references it
     // m_socket.flush(); // Usually not required
   } else {
     qWarning() << "Client: Cannot send message, socket not connected or not encrypted.";
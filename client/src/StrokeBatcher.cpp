@@ -0,0 +1,109 @@
+#include "../include/StrokeBatcher.h"
+
+#include <QLineF>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+StrokeBatcher::StrokeBatcher(Sink sink, Config config, QObject *parent) :
+  QObject(parent),
+  m_sink(std::move(sink)) {
+  m_timer.setSingleShot(true);
+  m_timer.setTimerType(Qt::PreciseTimer); // Coarse timers may fire 5% late, that's most of a frame
+  connect(&m_timer, &QTimer::timeout, this, &StrokeBatcher::flush);
+  setConfig(config);
+}
+
+void StrokeBatcher::setConfig(const Config &config){
+  m_config = config;
+  m_config.flushIntervalMs = std::max(0, m_config.flushIntervalMs);
+  m_config.maxPointsPerBatch = static_cast<int>(std::clamp<qsizetype>(m_config.maxPointsPerBatch, 2, SynergyProtocol::Message_Draw_Polyline::c_maxPoints - 1));
+}
+
+quint64 StrokeBatcher::beginStroke(const QPointF &point, const QString &color, double strokeWidth){
+  if(m_drawing) endStroke();
+  m_drawing = true;
+  ++m_strokeId;
+  m_color = color;
+  m_width = strokeWidth;
+  m_pending = {point};
+  m_hasSent = false;
+  m_latest = point;
+  m_timer.start(m_config.flushIntervalMs); // Even a dot shows up within one interval
+  return m_strokeId;
+}
+
+void StrokeBatcher::addPoint(const QPointF &point){
+  if(!m_drawing) return;
+  m_latest = point;
+  if(QLineF(m_pending.last(), point).length() < m_config.minPointDistance) return;
+
+  m_pending.append(point);
+  if(!m_timer.isActive()) m_timer.start(m_config.flushIntervalMs);
+  if(m_pending.size() - (m_hasSent ? 1 : 0) >= m_config.maxPointsPerBatch) flush();
+}
+
+void StrokeBatcher::endStroke(){
+  if(!m_drawing) return;
+  flush();
+  m_drawing = false;
+  m_pending.clear();
+}
+
+void StrokeBatcher::flush(){
+  m_timer.stop();
+  if(!m_drawing || m_pending.isEmpty()) return;
+  // Merged points must not cut the stroke short, where the pointer is now is kept
+  if(m_latest != m_pending.last()) m_pending.append(m_latest);
+  if(m_hasSent && m_pending.size() < 2) return; // Nothing new since last batch
+
+  QList<QPointF> batch = m_config.simplifyTolerance > 0 ? simplify(m_pending, m_config.simplifyTolerance) : m_pending;
+  const QPointF last = batch.last();
+  m_sink(SynergyProtocol::Message_Draw_Polyline {0, m_strokeId, std::move(batch), m_color, m_width});
+  m_pending = {last};
+  m_hasSent = true;
+}
+
+namespace {
+  double distanceToSegment(const QPointF &point, const QPointF &from, const QPointF &to){
+    const QPointF direction = to - from;
+    const double lengthSquared = QPointF::dotProduct(direction, direction);
+    if(lengthSquared == 0) return QLineF(point, from).length();
+    const double t = std::clamp(QPointF::dotProduct(point - from, direction) / lengthSquared, 0.0, 1.0);
+    return QLineF(point, from + t * direction).length();
+  }
+}
+
+// Iterative, a long stroke doesn't recurse once per point
+QList<QPointF> StrokeBatcher::simplify(const QList<QPointF> &points, double tolerance){
+  if(points.size() < 3 || tolerance <= 0) return points;
+
+  std::vector<bool> keep(points.size(), false);
+  keep.front() = keep.back() = true;
+  std::vector<std::pair<qsizetype, qsizetype>> ranges {{0, points.size() - 1}};
+  while(!ranges.empty()) {
+    const auto [first, last] = ranges.back();
+    ranges.pop_back();
+    double farthest = 0;
+    qsizetype split = -1;
+    for(qsizetype i = first + 1; i < last; ++i) {
+      const double distance = distanceToSegment(points[i], points[first], points[last]);
+      if(distance > farthest) {
+        farthest = distance;
+        split = i;
+      }
+    }
+    if(split < 0 || farthest <= tolerance) continue;
+    keep[split] = true;
+    ranges.push_back({first, split});
+    ranges.push_back({split, last});
+  }
+
+  QList<QPointF> kept;
+  for(qsizetype i = 0; i < points.size(); ++i) {
+    if(keep[i]) kept.append(points[i]);
+  }
+  return kept;
+}
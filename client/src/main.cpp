@@ -12,6 +12,8 @@
 
 int main(int argc, char *argv[]){
    QCoreApplication a(argc, argv); 
+  // Log lines are written by a background thread from here on; declared first, so it is flushed last
+  SynergyProtocol::AsyncLog logging;
 
   qInfo() << "Synergy Studio - SSL Test";
   qInfo() << "Using Qt Version:" << QT_VERSION_STR;
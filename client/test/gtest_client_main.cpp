@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <QCoreApplication>
+
 int main(int argc, char **argv){
   ::testing::InitGoogleTest(&argc, argv);
+  QCoreApplication app(argc, argv); // Timers of the classes under test need an event dispatcher
 
   return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
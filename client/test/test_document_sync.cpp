@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include "DocumentSync.h"
+
+using SynergyProtocol::TextOperation;
+
+namespace {
+  // Types 'text' at the end of a document of 'length'
+  TextOperation append(qsizetype length, const QString &text) {
+    return TextOperation().retain(length).insert(text);
+  }
+}
+
+TEST(DocumentSync, LocalEditsWaitForAck){
+  DocumentSync document;
+  document.reset("hello", 1);
+
+  const auto first = document.applyLocal(append(5, "!"));
+  ASSERT_TRUE(first.has_value());
+  EXPECT_FALSE(document.applyLocal(append(6, "?")).has_value()); // Buffered behind the first
+
+  const auto next = document.acknowledge(2);
+  ASSERT_TRUE(next.has_value());
+  EXPECT_EQ(*next, append(6, "?"));
+  EXPECT_EQ(document.revision(), 2u);
+  EXPECT_FALSE(document.acknowledge(3).has_value());
+  EXPECT_FALSE(document.hasPendingChanges());
+  EXPECT_EQ(document.content(), QString("hello!?"));
+}
+
+TEST(DocumentSync, RemoteOperationIsTransformedOverPendingEdits){
+  DocumentSync document;
+  document.reset("hello", 1);
+  ASSERT_TRUE(document.applyLocal(append(5, "!")).has_value());
+
+  TextOperation applied;
+  ASSERT_TRUE(document.applyRemote(TextOperation().insert(">").retain(5), 2, applied));
+  EXPECT_EQ(document.content(), QString(">hello!"));
+  EXPECT_EQ(document.revision(), 2u);
+  ASSERT_TRUE(document.outstanding().has_value());
+  EXPECT_EQ(*document.outstanding(), append(6, "!")); // Now relative to revision 2
+}
+
+TEST(DocumentSync, ResumeResendsOperationTheReplayDidNotAck){
+  DocumentSync document;
+  document.reset("hello", 1);
+  ASSERT_TRUE(document.applyLocal(append(5, "!")).has_value());
+
+  document.beginResume();
+  // Replay only brings someone else's edit
+  TextOperation applied;
+  ASSERT_TRUE(document.applyRemote(TextOperation().insert(">").retain(5), 2, applied));
+
+  const auto resend = document.finishResume();
+  ASSERT_TRUE(resend.has_value());
+  EXPECT_EQ(*resend, append(6, "!"));
+  EXPECT_FALSE(document.finishResume().has_value()); // Once
+}
+
+TEST(DocumentSync, ResumeDoesNotResendOperationAckedByTheReplay){
+  DocumentSync document;
+  document.reset("hello", 1);
+  ASSERT_TRUE(document.applyLocal(append(5, "!")).has_value());
+  EXPECT_FALSE(document.applyLocal(append(6, "?")).has_value()); // Typed while disconnected
+
+  document.beginResume();
+  // Journal holds the ack of the in-flight edit: the buffered one is sent now, on the new connection
+  const auto next = document.acknowledge(2);
+  ASSERT_TRUE(next.has_value());
+  EXPECT_EQ(*next, append(6, "?"));
+
+  EXPECT_FALSE(document.finishResume().has_value());
+  ASSERT_TRUE(document.outstanding().has_value()); // Still waiting for its own ack
+}
+
+TEST(DocumentSync, ResetDropsPendingResend){
+  DocumentSync document;
+  document.reset("hello", 1);
+  ASSERT_TRUE(document.applyLocal(append(5, "!")).has_value());
+
+  document.beginResume();
+  document.reset("hello world", 7); // Not replayed, state resent
+  EXPECT_FALSE(document.finishResume().has_value());
+}
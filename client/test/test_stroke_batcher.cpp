@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QLineF>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "StrokeBatcher.h"
+
+namespace {
+  struct Batch {
+    quint64 strokeId;
+    QList<QPointF> points;
+  };
+
+  // Timer far off: batches leave on the point limit or endStroke()
+  StrokeBatcher::Config manualConfig(int maxPointsPerBatch = 256, double minPointDistance = 0.5){
+    StrokeBatcher::Config config;
+    config.flushIntervalMs = 60 * 1000;
+    config.maxPointsPerBatch = maxPointsPerBatch;
+    config.minPointDistance = minPointDistance;
+    return config;
+  }
+
+  QList<QPointF> line(double fromX, double toX){
+    QList<QPointF> points;
+    for(double x = fromX; x <= toX; x += 1) points.append(QPointF(x, 0));
+    return points;
+  }
+
+  double distanceToSegment(const QPointF &point, const QPointF &from, const QPointF &to){
+    const QPointF direction = to - from;
+    const double lengthSquared = QPointF::dotProduct(direction, direction);
+    if(lengthSquared == 0) return QLineF(point, from).length();
+    const double t = std::clamp(QPointF::dotProduct(point - from, direction) / lengthSquared, 0.0, 1.0);
+    return QLineF(point, from + t * direction).length();
+  }
+}
+
+class StrokeBatcherTest : public ::testing::Test {
+protected:
+  QList<Batch> m_batches;
+
+  StrokeBatcher::Sink sink(){
+    return [this](const SynergyProtocol::Message_Draw_Polyline &polyline) {
+      m_batches.append(Batch{polyline.strokeId(), polyline.points()});
+    };
+  }
+};
+
+TEST(StrokeBatcher, SimplifyKeepsEndpointsAndDropsPointsWithinTolerance){
+  // Collinear: only the ends are needed
+  EXPECT_EQ(StrokeBatcher::simplify(line(0, 10), 0.1), (QList<QPointF> {QPointF(0, 0), QPointF(10, 0)}));
+
+  // Peak 2 px off the chord is kept at tolerance 1, then the rest is within 1 px of the two halves.
+  // At tolerance 2 it isn't more than the tolerance, so it goes too
+  const QList<QPointF> bump {QPointF(0, 0), QPointF(5, 0.5), QPointF(10, 2), QPointF(15, 0), QPointF(20, 0)};
+  EXPECT_EQ(StrokeBatcher::simplify(bump, 1.0), (QList<QPointF> {QPointF(0, 0), QPointF(10, 2), QPointF(20, 0)}));
+  EXPECT_EQ(StrokeBatcher::simplify(bump, 0.5), (QList<QPointF> {QPointF(0, 0), QPointF(10, 2), QPointF(15, 0), QPointF(20, 0)}));
+  EXPECT_EQ(StrokeBatcher::simplify(bump, 2.0), (QList<QPointF> {QPointF(0, 0), QPointF(20, 0)}));
+
+  // Off or nothing to drop: unchanged
+  EXPECT_EQ(StrokeBatcher::simplify(bump, 0.0), bump);
+  const QList<QPointF> two {QPointF(0, 0), QPointF(3, 4)};
+  EXPECT_EQ(StrokeBatcher::simplify(two, 5.0), two);
+}
+
+TEST(StrokeBatcher, SimplifiedCurveStaysWithinToleranceOfEveryPoint){
+  QList<QPointF> curve;
+  for(int i = 0; i <= 2000; ++i) curve.append(QPointF(i * 0.5, 40 * std::sin(i * 0.01) + ((i * 7919) % 13) * 0.05));
+  constexpr double tolerance = 0.75;
+  const QList<QPointF> kept = StrokeBatcher::simplify(curve, tolerance);
+
+  ASSERT_GE(kept.size(), 2);
+  EXPECT_LT(kept.size(), curve.size() / 4);
+  EXPECT_EQ(kept.front(), curve.front());
+  EXPECT_EQ(kept.back(), curve.back());
+  // Kept points are a subsequence, every dropped point lies within tolerance of its segment
+  qsizetype segment = 0;
+  for(const QPointF &point : curve) {
+    if(point == kept[segment + 1] && segment + 2 < kept.size()) {
+      ++segment;
+      continue;
+    }
+    EXPECT_LE(distanceToSegment(point, kept[segment], kept[segment + 1]), tolerance + 1e-9);
+  }
+  EXPECT_EQ(segment, kept.size() - 2);
+}
+
+TEST_F(StrokeBatcherTest, FlushesWhenMaxPointsAreWaitingAndChainsBatches){
+  StrokeBatcher batcher(sink(), manualConfig(4));
+  const quint64 strokeId = batcher.beginStroke(QPointF(0, 0), "#ff0000", 2.0);
+  for(int x = 1; x <= 3; ++x) batcher.addPoint(QPointF(x, 0));
+  ASSERT_EQ(m_batches.size(), 1);
+  EXPECT_EQ(m_batches[0].points, line(0, 3));
+
+  // The carried-over start point doesn't count towards the limit
+  for(int x = 4; x <= 6; ++x) batcher.addPoint(QPointF(x, 0));
+  EXPECT_EQ(m_batches.size(), 1);
+  batcher.addPoint(QPointF(7, 0));
+  ASSERT_EQ(m_batches.size(), 2);
+  EXPECT_EQ(m_batches[1].points, line(3, 7)); // Starts where the previous one ended
+
+  batcher.addPoint(QPointF(8, 0));
+  batcher.endStroke();
+  ASSERT_EQ(m_batches.size(), 3);
+  EXPECT_EQ(m_batches[2].points, line(7, 8));
+  for(const Batch &batch : std::as_const(m_batches)) EXPECT_EQ(batch.strokeId, strokeId);
+  EXPECT_FALSE(batcher.isDrawing());
+}
+
+TEST_F(StrokeBatcherTest, MergedLastPointIsStillSent){
+  StrokeBatcher batcher(sink(), manualConfig(256, 5.0));
+  batcher.beginStroke(QPointF(0, 0), "#000000", 1.0);
+  batcher.addPoint(QPointF(10, 0));
+  batcher.addPoint(QPointF(11, 0)); // Too close to (10, 0), merged
+  batcher.addPoint(QPointF(12, 0)); // Still too close, pointer ends here
+  batcher.endStroke();
+
+  ASSERT_EQ(m_batches.size(), 1);
+  EXPECT_EQ(m_batches[0].points, (QList<QPointF> {QPointF(0, 0), QPointF(10, 0), QPointF(12, 0)}));
+}
+
+TEST_F(StrokeBatcherTest, MergedPointsAfterABatchStillReachTheEnd){
+  StrokeBatcher batcher(sink(), manualConfig(2, 5.0));
+  batcher.beginStroke(QPointF(0, 0), "#000000", 1.0);
+  batcher.addPoint(QPointF(10, 0));
+  ASSERT_EQ(m_batches.size(), 1);
+
+  batcher.addPoint(QPointF(12, 0)); // Merged into the already sent (10, 0)
+  batcher.endStroke();
+  ASSERT_EQ(m_batches.size(), 2);
+  EXPECT_EQ(m_batches[1].points, (QList<QPointF> {QPointF(10, 0), QPointF(12, 0)}));
+}
+
+TEST_F(StrokeBatcherTest, SendsNothingWhenNothingIsNewSinceTheLastBatch){
+  StrokeBatcher batcher(sink(), manualConfig(2));
+  batcher.beginStroke(QPointF(0, 0), "#000000", 1.0);
+  batcher.addPoint(QPointF(10, 0));
+  ASSERT_EQ(m_batches.size(), 1);
+  batcher.endStroke();
+  EXPECT_EQ(m_batches.size(), 1);
+
+  // A dot is one point, sent on its own
+  batcher.beginStroke(QPointF(3, 3), "#000000", 1.0);
+  batcher.endStroke();
+  ASSERT_EQ(m_batches.size(), 2);
+  EXPECT_EQ(m_batches[1].points, QList<QPointF> {QPointF(3, 3)});
+  batcher.addPoint(QPointF(5, 5)); // Not drawing anymore
+  EXPECT_EQ(m_batches.size(), 2);
+}
+
+TEST_F(StrokeBatcherTest, NewStrokeEndsTheCurrentOne){
+  StrokeBatcher batcher(sink(), manualConfig());
+  const quint64 first = batcher.beginStroke(QPointF(0, 0), "#000000", 1.0);
+  batcher.addPoint(QPointF(1, 1));
+  const quint64 second = batcher.beginStroke(QPointF(50, 50), "#000000", 1.0);
+  EXPECT_NE(first, second);
+  ASSERT_EQ(m_batches.size(), 1);
+  EXPECT_EQ(m_batches[0].strokeId, first);
+  EXPECT_EQ(m_batches[0].points, (QList<QPointF> {QPointF(0, 0), QPointF(1, 1)}));
+}
+
+TEST_F(StrokeBatcherTest, SimplifiesBatchesKeepingTheirEnds){
+  StrokeBatcher::Config config = manualConfig();
+  config.simplifyTolerance = 0.5;
+  StrokeBatcher batcher(sink(), config);
+  batcher.beginStroke(QPointF(0, 0), "#000000", 1.0);
+  for(int x = 1; x <= 20; ++x) batcher.addPoint(QPointF(x, 0));
+  batcher.endStroke();
+  ASSERT_EQ(m_batches.size(), 1);
+  EXPECT_EQ(m_batches[0].points, (QList<QPointF> {QPointF(0, 0), QPointF(20, 0)}));
+}
+
+TEST_F(StrokeBatcherTest, TimerFlushesWithinTheInterval){
+  StrokeBatcher::Config config = manualConfig();
+  config.flushIntervalMs = 10;
+  StrokeBatcher batcher(sink(), config);
+  batcher.beginStroke(QPointF(0, 0), "#000000", 1.0);
+  batcher.addPoint(QPointF(4, 0));
+  EXPECT_TRUE(m_batches.isEmpty());
+
+  QElapsedTimer elapsed;
+  elapsed.start();
+  while(m_batches.isEmpty() && elapsed.elapsed() < 2000) QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+  ASSERT_EQ(m_batches.size(), 1);
+  EXPECT_EQ(m_batches[0].points, (QList<QPointF> {QPointF(0, 0), QPointF(4, 0)}));
+  EXPECT_TRUE(batcher.isDrawing());
+}
@@ -0,0 +1,351 @@
+/*
+Microbenchmarks: synergy_protocol codec
+Payloads go from a single draw segment to a 1 MB document snapshot (NFR-PERF-006),
+each encoded and decoded in both wire formats. Decoding starts from raw bytes,
+the way a connection sees them: frame split, parse, typed dispatch.
+Heap allocations are counted (glibc builds: malloc family, which Qt containers and
+operator new both end in) and reported per iteration as "allocs_per_iter".
+Run: ./protocol_bench --benchmark_out=protocol.json --benchmark_out_format=json
+Compare two runs: python3 common/bench/compare_bench.py baseline.json protocol.json
+*/
+#include <benchmark/benchmark.h>
+
+#include <QCborMap>
+#include <QCborValue>
+#include <QJsonDocument>
+#include <QList>
+#include <QPointF>
+#include <QString>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+#include "synergy_protocol/FrameBufferPool.h"
+#include "synergy_protocol/FrameCompressor.h"
+#include "synergy_protocol/FrameDecoder.h"
+#include "synergy_protocol/MessageFactory.h"
+#include "synergy_protocol/MessagePool.h"
+
+using namespace SynergyProtocol;
+
+/* --- Allocation counting --- */
+
+#if defined(__GLIBC__)
+namespace {
+  std::atomic<qint64> g_allocations {0};
+  std::atomic<qint64> g_allocatedBytes {0};
+
+  void countAllocation(std::size_t size){
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(qint64(size), std::memory_order_relaxed);
+  }
+}
+
+// Interposes glibc's allocator for the whole process, realloc counts as an allocation
+extern "C" {
+  void* __libc_malloc(std::size_t size);
+  void* __libc_calloc(std::size_t count, std::size_t size);
+  void* __libc_realloc(void *pointer, std::size_t size);
+
+  void* malloc(std::size_t size){
+    countAllocation(size);
+    return __libc_malloc(size);
+  }
+  void* calloc(std::size_t count, std::size_t size){
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+  }
+  void* realloc(void *pointer, std::size_t size){
+    countAllocation(size);
+    return __libc_realloc(pointer, size);
+  }
+}
+
+namespace {
+  class AllocationCounter : public benchmark::MemoryManager {
+  public:
+    void Start() override {
+      m_allocations = g_allocations.load(std::memory_order_relaxed);
+      m_allocatedBytes = g_allocatedBytes.load(std::memory_order_relaxed);
+    }
+    void Stop(Result &result) override {
+      result.num_allocs = g_allocations.load(std::memory_order_relaxed) - m_allocations;
+      result.total_allocated_bytes = g_allocatedBytes.load(std::memory_order_relaxed) - m_allocatedBytes;
+    }
+    // Pure virtual in older Google Benchmark releases
+    void Stop(Result *result) { Stop(*result); }
+
+  private:
+    qint64 m_allocations = 0;
+    qint64 m_allocatedBytes = 0;
+  };
+}
+#endif
+
+namespace {
+  // Source-like text: 80 column lines
+  QString makeText(qsizetype size){
+    QString text(size, QLatin1Char('x'));
+    for(qsizetype i = 79; i < size; i += 80) {
+      text[i] = QLatin1Char('\n');
+    }
+    return text;
+  }
+
+  QList<QPointF> makePoints(qsizetype count){
+    QList<QPointF> points;
+    points.reserve(count);
+    std::minstd_rand random(42);
+    for(qsizetype i = 0; i < count; ++i) {
+      points.append(QPointF(random() % 4096 / 2.0, random() % 4096 / 2.0));
+    }
+    return points;
+  }
+
+  // Document snapshot: 16 B (empty file), 1 KB, 64 KB, 1 MB
+  void textSizes(benchmark::internal::Benchmark *benchmark){
+    benchmark->ArgName("bytes");
+    for(qsizetype size : {16, 1024, 64 * 1024, 1024 * 1024}) benchmark->Arg(size);
+  }
+
+  void formatsAndTextSizes(benchmark::internal::Benchmark *benchmark){
+    benchmark->ArgNames({"cbor", "bytes"});
+    for(int format : {0, 1}) {
+      for(qsizetype size : {16, 1024, 64 * 1024, 1024 * 1024}) benchmark->Args({format, size});
+    }
+  }
+
+  // Stroke batch: single segment up to a long freehand line
+  void formatsAndPointCounts(benchmark::internal::Benchmark *benchmark){
+    benchmark->ArgNames({"cbor", "points"});
+    for(int format : {0, 1}) {
+      for(qsizetype count : {2, 32, 1024}) benchmark->Args({format, count});
+    }
+  }
+
+  t_WireFormat formatArg(const benchmark::State &state){
+    return state.range(0) ? t_WireFormat::CBOR : t_WireFormat::JSON;
+  }
+
+  Message_Update_Text_Edit makeSnapshot(qsizetype size){
+    return Message_Update_Text_Edit {7, QStringLiteral("src/main.cpp"), makeText(size), QStringLiteral("User_1"), 42};
+  }
+}
+
+/* --- Type name helpers --- */
+
+static void BM_MessageTypeToString(benchmark::State &state){
+  std::size_t index = 0;
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(messageTypeToString(static_cast<t_MessageType>(index)).size());
+    index = (index + 1) % messageTypeIndex(t_MessageType::COUNT);
+  }
+}
+BENCHMARK(BM_MessageTypeToString);
+
+static void BM_StringToMessageType(benchmark::State &state){
+  QList<QString> names;
+  for(std::size_t i = 0; i < messageTypeIndex(t_MessageType::COUNT); ++i) {
+    names.append(messageTypeToString(static_cast<t_MessageType>(i)));
+  }
+  qsizetype index = 0;
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(stringToMessageType(names[index]));
+    index = (index + 1) % names.size();
+  }
+}
+BENCHMARK(BM_StringToMessageType);
+
+/* --- Encoding --- */
+
+static void BM_ToJson(benchmark::State &state){
+  const Message_Update_Text_Edit message = makeSnapshot(state.range(0));
+  for(auto _ : state) {
+    QJsonObject object = message.toJSon();
+    benchmark::DoNotOptimize(object.size());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ToJson)->Apply(textSizes);
+
+static void BM_ToString(benchmark::State &state){
+  const Message_Update_Text_Edit message = makeSnapshot(state.range(0));
+  for(auto _ : state) {
+    QString text = message.toString();
+    benchmark::DoNotOptimize(text.constData());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ToString)->Apply(textSizes);
+
+static void BM_EncodeFrame_Snapshot(benchmark::State &state){
+  const Message_Update_Text_Edit message = makeSnapshot(state.range(1));
+  const t_WireFormat format = formatArg(state);
+  for(auto _ : state) {
+    QByteArray frame = message.encodeFrame(format, 1);
+    benchmark::DoNotOptimize(frame.constData());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_EncodeFrame_Snapshot)->Apply(formatsAndTextSizes);
+
+static void BM_EncodeFrame_Polyline(benchmark::State &state){
+  const Message_Draw_Polyline message {7, 3, makePoints(state.range(1)), QStringLiteral("#336699"), 2.0, QStringLiteral("User_1")};
+  const t_WireFormat format = formatArg(state);
+  for(auto _ : state) {
+    QByteArray frame = message.encodeFrame(format, 1);
+    benchmark::DoNotOptimize(frame.constData());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_EncodeFrame_Polyline)->Apply(formatsAndPointCounts);
+
+static void BM_EncodeFrame_TextOperation(benchmark::State &state){
+  const Message_Text_Operation message {7, QStringLiteral("src/main.cpp"), 42,
+                                        TextOperation().retain(4096).insert(QStringLiteral("x")).retain(8192), QStringLiteral("User_1")};
+  const t_WireFormat format = formatArg(state);
+  for(auto _ : state) {
+    QByteArray frame = message.encodeFrame(format, 1);
+    benchmark::DoNotOptimize(frame.constData());
+  }
+}
+BENCHMARK(BM_EncodeFrame_TextOperation)->ArgName("cbor")->Arg(0)->Arg(1);
+
+/* --- Decoding --- */
+
+// Parse + MessageFactory::createMessage (virtual, heap allocated message)
+static void BM_CreateMessage(benchmark::State &state){
+  const t_WireFormat format = formatArg(state);
+  const QByteArray payload = makeSnapshot(state.range(1)).encode(format, 1);
+  for(auto _ : state) {
+    std::unique_ptr<Message_Base> message;
+    if(format == t_WireFormat::CBOR) {
+      message = MessageFactory::instance().createMessage(QCborValue::fromCbor(payload).toMap());
+    } else {
+      message = MessageFactory::instance().createMessage(QJsonDocument::fromJson(payload).object());
+    }
+    benchmark::DoNotOptimize(message.get());
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_CreateMessage)->Apply(formatsAndTextSizes);
+
+// What a connection does per readyRead: split frames, parse, dispatch on the concrete type
+static void BM_DecodeDispatch_Snapshot(benchmark::State &state){
+  const t_WireFormat format = formatArg(state);
+  const QByteArray frame = makeSnapshot(state.range(1)).encodeFrame(format, 1);
+  FrameDecoder decoder;
+  QByteArray payload;
+  for(auto _ : state) {
+    decoder.append(frame);
+    decoder.nextFrame(payload);
+    const bool ok = MessageFactory::dispatch(payload, format, [](const auto &message) { benchmark::DoNotOptimize(&message); });
+    benchmark::DoNotOptimize(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_DecodeDispatch_Snapshot)->Apply(formatsAndTextSizes);
+
+static void BM_DecodeDispatch_Polyline(benchmark::State &state){
+  const t_WireFormat format = formatArg(state);
+  const QByteArray frame = Message_Draw_Polyline {7, 3, makePoints(state.range(1)), QStringLiteral("#336699"), 2.0,
+                                                  QStringLiteral("User_1")}.encodeFrame(format, 1);
+  FrameDecoder decoder;
+  QByteArray payload;
+  for(auto _ : state) {
+    decoder.append(frame);
+    decoder.nextFrame(payload);
+    const bool ok = MessageFactory::dispatch(payload, format, [](const auto &message) { benchmark::DoNotOptimize(&message); });
+    benchmark::DoNotOptimize(ok);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_DecodeDispatch_Polyline)->Apply(formatsAndPointCounts);
+
+// Many small frames arriving in MTU-sized reads, frames straddle read boundaries
+static void BM_FrameDecoder_Stream(benchmark::State &state){
+  const QByteArray frame = Message_Draw_Command {7, 10, 10, 20, 20}.encodeFrame(t_WireFormat::CBOR, 1);
+  QByteArray stream;
+  for(int i = 0; i < 1000; ++i) FrameDecoder::appendFrame(stream, frame.mid(FrameDecoder::c_headerSize));
+  constexpr qsizetype readSize = 1400;
+  FrameDecoder decoder;
+  QByteArray payload;
+  for(auto _ : state) {
+    for(qsizetype offset = 0; offset < stream.size(); offset += readSize) {
+      decoder.append(stream.constData() + offset, qMin(readSize, stream.size() - offset));
+      while(decoder.nextFrame(payload) == FrameDecoder::t_Status::FRAME_READY) {
+        benchmark::DoNotOptimize(payload.constData());
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+  state.SetBytesProcessed(state.iterations() * stream.size());
+}
+BENCHMARK(BM_FrameDecoder_Stream);
+
+/* --- Pooling --- */
+
+// Decoded message handed to another thread: copied into make_shared (before) or moved into a pooled block
+static void BM_MessageHandoff(benchmark::State &state){
+  const bool pooled = state.range(0) != 0;
+  const QByteArray payload = Message_Text_Operation {7, QStringLiteral("src/main.cpp"), 42,
+                                                     TextOperation().retain(4096).insert(QStringLiteral("x")).retain(8192),
+                                                     QStringLiteral("User_1")}.encode(t_WireFormat::CBOR, 1);
+  std::shared_ptr<const Message_Base> handedOff;
+  for(auto _ : state) {
+    MessageFactory::dispatch(payload, t_WireFormat::CBOR, [&](auto message) {
+      using MessageType = std::decay_t<decltype(message)>;
+      if(pooled) {
+        handedOff = makePooled<const MessageType>(std::move(message));
+      } else {
+        handedOff = std::make_shared<const MessageType>(message);
+      }
+    });
+    benchmark::DoNotOptimize(handedOff.get());
+  }
+}
+BENCHMARK(BM_MessageHandoff)->ArgName("pooled")->Arg(0)->Arg(1);
+
+// Encode, compress, "write", drop: with recycling the frame buffers come back for the next frame
+static void BM_OutboundFrame(benchmark::State &state){
+  const bool recycled = state.range(0) != 0;
+  const Message_Draw_Polyline message {7, 3, makePoints(32), QStringLiteral("#336699"), 2.0, QStringLiteral("User_1")};
+  for(auto _ : state) {
+    QByteArray frame = message.encodeFrame(t_WireFormat::CBOR, 1);
+    QByteArray compressed = FrameCompressor::compressFrame(frame, t_Compression::DEFLATE_DICTIONARY);
+    benchmark::DoNotOptimize(compressed.constData());
+    if(recycled) {
+      FrameBufferPool::release(std::move(frame));
+      FrameBufferPool::release(std::move(compressed));
+    }
+  }
+}
+BENCHMARK(BM_OutboundFrame)->ArgName("recycled")->Arg(0)->Arg(1);
+
+/* --- Compression --- */
+
+static void BM_CompressFrame(benchmark::State &state){
+  const t_Compression compression = state.range(0) ? t_Compression::DEFLATE_DICTIONARY : t_Compression::DEFLATE;
+  const QByteArray frame = makeSnapshot(state.range(1)).encodeFrame(t_WireFormat::CBOR, 1);
+  for(auto _ : state) {
+    QByteArray compressed = FrameCompressor::compressFrame(frame, compression);
+    benchmark::DoNotOptimize(compressed.constData());
+  }
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_CompressFrame)->ArgNames({"dict", "bytes"})
+  ->Args({0, 1024})->Args({1, 1024})->Args({0, 64 * 1024})->Args({1, 64 * 1024});
+
+int main(int argc, char **argv){
+  benchmark::Initialize(&argc, argv);
+  if(benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+#if defined(__GLIBC__)
+  AllocationCounter allocations;
+  benchmark::RegisterMemoryManager(&allocations);
+#endif
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""
+Compares two Google Benchmark JSON result files (--benchmark_out_format=json).
+
+  compare_bench.py baseline.json current.json [--threshold 0.10]
+
+Prints per-benchmark CPU time of both runs and the relative change. Exits
+with 1 if any benchmark present in both got slower than the threshold, so
+it can gate a change. With --benchmark_repetitions the median aggregate is
+compared, otherwise the single run. Benchmarks present in only one file are
+listed, not judged. When both runs counted allocations (allocs_per_iter),
+those are shown next to the time; more allocations are reported, not judged.
+"""
+import argparse
+import json
+import sys
+
+_UNIT_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path):
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+    runs = {}
+    medians = {}
+    allocs = {}
+    for bench in data.get("benchmarks", []):
+        if bench.get("error_occurred"):
+            continue
+        name = bench.get("run_name", bench["name"])
+        if "allocs_per_iter" in bench:
+            allocs.setdefault(name, bench["allocs_per_iter"])
+        cpu_ns = bench["cpu_time"] * _UNIT_NS[bench.get("time_unit", "ns")]
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == "median":
+                medians[bench["run_name"]] = cpu_ns
+        else:
+            runs.setdefault(name, cpu_ns)
+    runs.update(medians)
+    return data.get("context", {}), runs, allocs
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown that fails the comparison (default 0.10)")
+    args = parser.parse_args()
+
+    base_context, baseline, base_allocs = load(args.baseline)
+    current_context, current, current_allocs = load(args.current)
+    for key in ("host_name", "num_cpus", "mhz_per_cpu", "library_build_type"):
+        if base_context.get(key) != current_context.get(key):
+            print(f"note: {key} differs ({base_context.get(key)} vs {current_context.get(key)})")
+
+    regressions = 0
+    width = max((len(name) for name in baseline.keys() | current.keys()), default=0)
+    width = max(width, len("benchmark"))
+    print(f"{'benchmark':<{width}}  {'baseline':>12}  {'current':>12}  {'change':>8}")
+    for name in sorted(baseline.keys() & current.keys()):
+        before, after = baseline[name], current[name]
+        change = (after - before) / before if before > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  SLOWER"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  faster"
+        allocs = ""
+        if name in base_allocs and name in current_allocs:
+            allocs = f"  allocs {base_allocs[name]:g} -> {current_allocs[name]:g}"
+            if current_allocs[name] > base_allocs[name]:
+                allocs += " (more)"
+        print(f"{name:<{width}}  {before:>10.1f}ns  {after:>10.1f}ns  {change:>+7.1%}{flag}{allocs}")
+    for name in sorted(baseline.keys() - current.keys()):
+        print(f"{name:<{width}}  only in baseline")
+    for name in sorted(current.keys() - baseline.keys()):
+        print(f"{name:<{width}}  only in current")
+
+    if regressions:
+        print(f"{regressions} benchmark(s) slower than baseline by more than {args.threshold:.0%}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
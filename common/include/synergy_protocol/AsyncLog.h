@@ -0,0 +1,115 @@
+#ifndef __SYNERGY_PROTOCOL_ASYNC_LOG__
+#define __SYNERGY_PROTOCOL_ASYNC_LOG__
+
+#include <QByteArray>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QSemaphore>
+#include <QString>
+#include <QThread>
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+namespace SynergyProtocol {
+
+  // Whole frames as received / sent. Off unless enabled ("synergy.payload.debug=true")
+  Q_DECLARE_LOGGING_CATEGORY(logPayload)
+  // One line per message sent or handled. Off unless enabled ("synergy.traffic.debug=true")
+  Q_DECLARE_LOGGING_CATEGORY(logTraffic)
+
+  /*
+  ------------------------------------------------------------------
+  -------------------- Asynchronous log backend --------------------
+  Installed as Qt's message handler: qInfo()/qWarning()/qCDebug()...
+  keep working unchanged, they only stop writing to stderr on the
+  calling thread.
+  - caller moves the formatted text into a bounded lock-free ring
+    (many producers, one consumer); a full ring drops the record and
+    counts it, an I/O thread never waits for the log
+  - one writer thread stamps, formats and writes records in batches
+  - repeated messages are rate limited: after 'burst' records from one
+    call site (file:line, or the text with numbers blanked out when Qt
+    gives no location) within 'windowMs', the rest are counted and
+    summarized in one line when the window ends
+  Which categories and levels get here at all is QLoggingCategory's
+  filter (QT_LOGGING_RULES, setFilterRules at runtime); disabled
+  qCDebug() lines cost one branch and never format anything.
+  Fatal messages are written synchronously, after the queue is drained.
+  One instance at a time, normally a local in main(); its destructor
+  flushes everything and restores the previous handler.
+  ------------------------------------------------------------------
+  */
+  class AsyncLog {
+  public:
+    struct Config {
+      std::size_t capacity = 8192; // Records in the ring, rounded up to a power of two
+      int burst = 20;
+      int windowMs = 1000;
+      FILE *output = stderr;
+    };
+
+    explicit AsyncLog(Config config = Config());
+    ~AsyncLog();
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+  private:
+    struct Record {
+      QtMsgType type = QtDebugMsg;
+      qint64 timeUs = 0;
+      const char *category = nullptr; // Owned by the QLoggingCategory, static
+      const char *file = nullptr;     // __FILE__ or null
+      int line = 0;
+      QString message;
+    };
+
+    struct Slot {
+      std::atomic<std::size_t> sequence;
+      Record record;
+    };
+
+    // Repeats of one call site within the current window
+    struct Window {
+      qint64 startUs = 0;
+      int written = 0;
+      quint64 suppressed = 0;
+      Record last; // Shown in the summary
+    };
+
+    Config m_config;
+    std::size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(64) std::atomic<std::size_t> m_tail {0}; // Next slot producers claim
+    alignas(64) std::atomic<std::size_t> m_head {0}; // Next slot writer reads, written by writer only
+    std::atomic<quint64> m_dropped {0};
+    std::atomic<bool> m_writerIdle {false};
+    std::atomic<bool> m_stopping {false};
+    QSemaphore m_wake;
+    QThread *m_writer = nullptr;
+    QtMessageHandler m_previous = nullptr;
+    QHash<QString, Window> m_windows;   // Writer only
+
+    static std::atomic<AsyncLog*> s_instance;
+    static std::atomic<int> s_inFlight; // Handler calls that may still use s_instance, waited for on shutdown
+    static void handler(QtMsgType type, const QMessageLogContext &context, const QString &message);
+
+    bool push(Record &&record);
+    bool pop(Record &record);
+    bool isEmpty() const;
+    void wakeWriter();
+    void run();                  // Writer thread
+    void drain(QByteArray &out);
+    void accept(Record &&record, QByteArray &out); // Rate limiting
+    void expireWindows(qint64 now, QByteArray &out);
+    void summarize(const Window &window, QByteArray &out) const;
+    void flush(QByteArray &out);
+
+    static QString siteKey(const Record &record);
+    static void format(const Record &record, QByteArray &out);
+    static qint64 nowUs();
+  };
+}
+
+#endif
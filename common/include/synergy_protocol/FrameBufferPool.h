@@ -0,0 +1,39 @@
+#ifndef __SYNERGY_PROTOCOL_FRAME_BUFFER_POOL__
+#define __SYNERGY_PROTOCOL_FRAME_BUFFER_POOL__
+
+#include <QByteArray>
+
+namespace SynergyProtocol {
+
+  /*
+  ------------------------------------------------------------------
+  ----------------------- Frame buffer reuse -----------------------
+  Every frame used to be a fresh QByteArray: encoded, maybe compressed
+  into another one, written to the socket (which copies it) and freed.
+  Buffers are recycled instead: acquire() hands out an empty buffer
+  with at least the asked capacity, release() takes it back once the
+  bytes are gone (after socket write). Only buffers nobody else holds
+  are kept, a frame still shared with a queue, a journal or another
+  recipient is simply dropped by the caller, as before.
+  Buffers are kept by capacity (powers of two, 256 B .. 1 MiB) in a
+  per-thread cache, no locking on the common path. Frames are often
+  encoded on one thread and written on another, so a thread with more
+  than its share hands a batch to a shared depot, and a thread that
+  runs out takes a batch from it: one mutex per batch, not per frame.
+  Cache and depot are bounded by bytes per size, beyond that buffers
+  are freed. Bigger buffers aren't pooled.
+  ------------------------------------------------------------------
+  */
+  class FrameBufferPool {
+  public:
+    static constexpr qsizetype c_minCapacity = 256;
+    static constexpr qsizetype c_maxCapacity = 1024 * 1024;
+
+    // Empty buffer, capacity() >= 'capacity' (resize within it doesn't allocate)
+    static QByteArray acquire(qsizetype capacity);
+    // Takes the buffer; kept only if it isn't shared and its size is pooled
+    static void release(QByteArray buffer);
+  };
+}
+
+#endif
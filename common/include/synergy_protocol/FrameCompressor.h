@@ -0,0 +1,47 @@
+#ifndef __SYNERGY_PROTOCOL_FRAME_COMPRESSOR__
+#define __SYNERGY_PROTOCOL_FRAME_COMPRESSOR__
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+#include "protocol.h"
+
+namespace SynergyProtocol {
+
+  /*
+  ------------------------------------------------------------------
+  ----------------------- Frame compression ------------------------
+  Each frame is compressed on its own (raw deflate, zlib), so a frame
+  encoded once can go to every recipient that negotiated the same
+  compression, and frames can still be dropped or replayed
+  independently. Frames are flagged with the top bit of the length
+  prefix; the payload of a flagged frame is
+    4-byte big-endian original size | deflate stream
+  so the receiver knows the size (and can reject a bomb) before
+  inflating anything. Frames under c_minPayloadSize, or that don't
+  get smaller, stay as they are.
+  DEFLATE_DICTIONARY primes both sides with dictionary(): envelope
+  keys, message type names and payload keys, so even a short
+  TEXT_OPERATION shrinks. Dictionary is part of the negotiated name
+  (deflate-dict-v1); a changed one needs a new name.
+  Compression state is kept per thread and reused between frames.
+  ------------------------------------------------------------------
+  */
+  class FrameCompressor {
+  public:
+    static constexpr quint32 c_compressedFlag = 0x80000000u;
+    static constexpr quint32 c_lengthMask = ~c_compressedFlag;
+    static constexpr qsizetype c_minPayloadSize = 64;
+    static constexpr qsizetype c_sizeHeader = 4;
+
+    // Complete frame (length prefix included) in, complete frame out. Same frame back if it doesn't pay off
+    static QByteArray compressFrame(const QByteArray &frame, t_Compression compression);
+
+    // Payload of a flagged frame -> original payload. False if corrupt, or bigger than 'maxSize'
+    static bool decompress(QByteArrayView payload, t_Compression compression, quint32 maxSize, QByteArray &out);
+
+    static QByteArrayView dictionary();
+  };
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef __SYNERGY_PROTOCOL_FRAME_DECODER__
+#define __SYNERGY_PROTOCOL_FRAME_DECODER__
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QtEndian>
+
+#include <vector>
+
+#include "protocol.h"
+#include "FrameBufferPool.h"
+
+namespace SynergyProtocol {
+
+  /*
+  ------------------------------------------------------------------
+  -------------- Length-prefixed framing (PROT-TF-004) -------------
+  Every logical message on the TLS stream is preceded by a 4-byte
+  unsigned length in network byte order (big-endian).
+  TCP gives us a byte stream, so one readyRead can carry several
+  frames, half of one, or both. FrameDecoder keeps a per-connection
+  ring buffer, reads straight from the device into its free space and
+  hands out every complete frame it holds. Leftover bytes of a partial
+  frame stay where they are (no compaction / memmove between reads).
+  The ring grows (doubling) only once it is full of a frame's bytes,
+  so a header announcing 16 MiB costs nothing until the payload
+  actually arrives, and it shrinks back to its initial capacity once
+  an oversized frame is consumed and what is left fits again.
+  Memory is bounded by the largest accepted frame (m_maxFrameSize).
+  Once a compression is negotiated (setCompression), frames flagged as
+  compressed are inflated here, callers only ever see plain payloads.
+  ------------------------------------------------------------------
+  */
+  class FrameDecoder {
+  public:
+    enum class t_Status {
+      FRAME_READY,    // 'frame' argument holds one complete payload
+      NEED_MORE_DATA, // no complete frame buffered yet
+      FRAME_TOO_LARGE, // header announced more than max frame size, stream must be dropped
+      MALFORMED_FRAME  // compressed frame that can't be inflated (or wasn't negotiated), stream must be dropped
+    };
+
+    static constexpr qsizetype c_headerSize = 4;
+    static constexpr quint32 c_defaultMaxFrameSize = 16 * 1024 * 1024; // 16 MiB
+    static constexpr qsizetype c_defaultInitialCapacity = 64 * 1024;
+
+    explicit FrameDecoder(quint32 maxFrameSize = c_defaultMaxFrameSize,
+                          qsizetype initialCapacity = c_defaultInitialCapacity);
+
+    // Append raw bytes (used when data is not pulled from a QIODevice)
+    void append(const char* data, qsizetype size);
+    void append(const QByteArray& data) { append(data.constData(), data.size()); }
+
+    // Read as much as fits into the ring from device. Returns bytes read, -1 on device error
+    qint64 readFrom(QIODevice* device);
+
+    // Extract next complete frame payload (without the length prefix)
+    // 'frame' is resized in place, so callers reusing one QByteArray avoid reallocations
+    t_Status nextFrame(QByteArray& frame);
+
+    /*
+    Drains device completely: reads into the ring, hands every complete frame
+    to onFrame(const QByteArray&) and repeats until device has nothing left.
+    Stops early and returns FRAME_TOO_LARGE / MALFORMED_FRAME on a framing violation.
+    'frame' is a pooled scratch buffer shared by every frame of the call, returned
+    afterwards; a handler that keeps a copy of it just takes it out of the pool.
+    */
+    template<typename FrameHandler>
+    t_Status readFrames(QIODevice* device, FrameHandler&& onFrame) {
+      // Returns the scratch buffer on every exit path
+      struct Scratch {
+        QByteArray frame = FrameBufferPool::acquire(FrameBufferPool::c_minCapacity);
+        ~Scratch() { FrameBufferPool::release(std::move(frame)); }
+      } scratch;
+      QByteArray &frame = scratch.frame;
+      t_Status status = t_Status::NEED_MORE_DATA;
+      do {
+        if(readFrom(device) < 0) {
+          break;
+        }
+        while((status = nextFrame(frame)) == t_Status::FRAME_READY) {
+          onFrame(frame);
+        }
+        if(status != t_Status::NEED_MORE_DATA) {
+          return status;
+        }
+      } while(device->bytesAvailable() > 0);
+      return status;
+    }
+
+    qsizetype bufferedBytes() const { return m_size; }
+    qsizetype capacity() const { return static_cast<qsizetype>(m_ring.size()); }
+    quint32 maxFrameSize() const { return m_maxFrameSize; }
+    void reset() { m_head = 0; m_size = 0; m_compression = t_Compression::NONE; if(capacity() > m_initialCapacity) resizeRing(m_initialCapacity); }
+    void setCompression(t_Compression compression) { m_compression = compression; }
+
+    // Prepend 4-byte big-endian length to payload. Result comes from FrameBufferPool
+    static QByteArray encodeFrame(const QByteArray& payload);
+    static void appendFrame(QByteArray& out, const QByteArray& payload);
+
+  private:
+    void resizeRing(qsizetype minCapacity); // also linearizes buffered bytes to index 0
+    void copyOut(qsizetype offset, char* dest, qsizetype len) const;
+    qsizetype mask() const { return capacity() - 1; }
+
+    std::vector<char> m_ring; // capacity is always a power of two
+    qsizetype m_head = 0;     // index of first buffered byte
+    qsizetype m_size = 0;     // number of buffered bytes
+    qsizetype m_initialCapacity; // Power of two, the ring shrinks back to it
+    quint32 m_maxFrameSize;
+    t_Compression m_compression = t_Compression::NONE;
+    QByteArray m_compressed; // Reused buffer for compressed payloads
+  };
+}
+
+#endif
@@ -1,45 +1,212 @@
 #ifndef __SYNERGY_PROTOCOL_MESSAGE_FACTOR__
 #define __SYNERGY_PROTOCOL_MESSAGE_FACTOR__
 
-#include <functional>
+#include <array>
 #include <memory>
+#include <type_traits>
+#include <utility>
 #include <QJsonObject>
-#include <QMap>
+#include <QCborMap>
 
 #include "protocol.h"
 #include "Message_Base.h"
 
 #include "Message_Join_Session_Request.h"
+#include "Message_Client_Hello.h"
+#include "Message_Server_Hello.h"
+#include "Message_Update_Text_Edit.h"
+#include "Message_Draw_Command.h"
+#include "Message_Join_Session_Response.h"
+#include "Message_User_Joined.h"
+#include "Message_User_Left.h"
+#include "Message_Text_Operation.h"
+#include "Message_Text_Operation_Ack.h"
+#include "Message_Request_File_Tree.h"
+#include "Message_File_Tree_Update.h"
+#include "Message_File_Tree_Diff.h"
+#include "Message_File_Saved.h"
+#include "Message_Request_Run_Code.h"
+#include "Message_Run_Output_Result.h"
+#include "Message_Error_Notification.h"
+#include "Message_Run_Output_Chunk.h"
+#include "Message_Canvas_Snapshot.h"
+#include "Message_Draw_Polyline.h"
+#include "Message_Resume_Session_Request.h"
+#include "Message_Resume_Session_Response.h"
+#include "Message_Request_Open_File.h"
+#include "Message_File_Chunk.h"
+#include "Message_Ping.h"
+#include "Message_Pong.h"
 
 namespace SynergyProtocol {
-  using MessageCreatorFunc = std::function<std::unique_ptr<Message_Base>()>;
+
+  template<typename... Messages>
+  struct MessageTypeList {};
+
+  /*
+  Compile-time message registry
+  Every concrete message class is listed here once. Dispatch tables indexed by
+  t_MessageType are generated from this list at compile time, so there's no
+  registration step at startup and lookup is one array access per message.
+  */
+  using RegisteredMessages = MessageTypeList<
+    Message_Join_Session_Request,
+    Message_Client_Hello,
+    Message_Server_Hello,
+    Message_Update_Text_Edit,
+    Message_Draw_Command,
+    Message_Join_Session_Response,
+    Message_User_Joined,
+    Message_User_Left,
+    Message_Text_Operation,
+    Message_Text_Operation_Ack,
+    Message_Request_File_Tree,
+    Message_File_Tree_Update,
+    Message_File_Tree_Diff,
+    Message_File_Saved,
+    Message_Request_Run_Code,
+    Message_Run_Output_Result,
+    Message_Error_Notification,
+    Message_Run_Output_Chunk,
+    Message_Canvas_Snapshot,
+    Message_Draw_Polyline,
+    Message_Resume_Session_Request,
+    Message_Resume_Session_Response,
+    Message_Request_Open_File,
+    Message_File_Chunk,
+    Message_Ping,
+    Message_Pong
+  >;
+
+  // Convenience for typed handlers: MessageHandlers{ [](const Message_X&){}, [](const auto&){} }
+  template<typename... Fs>
+  struct MessageHandlers : Fs... { using Fs::operator()...; };
+  template<typename... Fs>
+  MessageHandlers(Fs...) -> MessageHandlers<Fs...>;
 
   class MessageFactory {
   public:
-    // We can do two approaches: Singleton or static class aproach, which we chose here
+    // Stateless: all tables are constexpr, nothing to initialize on first use
     static MessageFactory& instance() {
       static MessageFactory factory;
-      // Registration happens once, only on startup
-      if(!factory.m_initialized) {
-        factory.registerMessages();
-        factory.m_initialized = true;
-      }
       return factory;
     }
 
+    // Heap-allocating path, for messages that must outlive the current frame
     std::unique_ptr<Message_Base> createMessage(const QJsonObject& jsonObject) const;
-  
+    std::unique_ptr<Message_Base> createMessage(const QCborMap& cborMap) const;
+
+    // Parse one frame payload encoded in given wire format
+    std::unique_ptr<Message_Base> decode(const QByteArray& payload, t_WireFormat format) const;
+
+    /*
+    Typed dispatch
+    Parses the payload into a stack object of the concrete message type and calls
+    handler(const Message_X&) directly. No heap allocation and no virtual parse call.
+    Message is passed as an rvalue: a handler keeping it (e.g. makePooled) can move
+    its strings and arrays instead of copying them.
+    Handler must accept every registered type (a generic 'const auto&' overload works as fallback).
+    Returns false if type is unknown or message failed to parse.
+    */
+    template<typename Handler>
+    static bool dispatch(const QJsonObject& jsonObject, Handler&& handler) {
+      using H = std::remove_reference_t<Handler>;
+      static constexpr auto table = makeTable<JsonDispatchFn<H>>(RegisteredMessages{},
+        []<typename M>(std::type_identity<M>) -> JsonDispatchFn<H> { return &dispatchJsonAs<M, H>; });
+      const JsonDispatchFn<H> fn = table[messageTypeIndex(typeOf(jsonObject))];
+      if(!fn) {
+        qCritical() << "MESSAGE FACTORY | Unknown message type encountered";
+        return false;
+      }
+      return fn(jsonObject, handler);
+    }
+
+    template<typename Handler>
+    static bool dispatch(const QCborMap& cborMap, Handler&& handler) {
+      using H = std::remove_reference_t<Handler>;
+      static constexpr auto table = makeTable<CborDispatchFn<H>>(RegisteredMessages{},
+        []<typename M>(std::type_identity<M>) -> CborDispatchFn<H> { return &dispatchCborAs<M, H>; });
+      const CborDispatchFn<H> fn = table[messageTypeIndex(typeOf(cborMap))];
+      if(!fn) {
+        qCritical() << "MESSAGE FACTORY | Unknown message type encountered";
+        return false;
+      }
+      return fn(cborMap, handler);
+    }
+
+    template<typename Handler>
+    static bool dispatch(const QByteArray& payload, t_WireFormat format, Handler&& handler) {
+      if(format == t_WireFormat::CBOR) {
+        QCborMap map;
+        return parseCbor(payload, map) && dispatch(map, handler);
+      }
+      QJsonObject object;
+      return parseJson(payload, object) && dispatch(object, handler);
+    }
+
+    // Type lookup only (perfect hash for JSON names, range check for CBOR integers)
+    static t_MessageType typeOf(const QJsonObject& jsonObject);
+    static t_MessageType typeOf(const QCborMap& cborMap);
+
   private:
     MessageFactory() = default; // Private constructor for singleton-like pattern
     ~MessageFactory() = default;
     MessageFactory(const MessageFactory&) = delete;
     MessageFactory& operator=(const MessageFactory&) = delete;
 
-    void registerMessages(); // Private helper to register all types
+    template<typename H> using JsonDispatchFn = bool(*)(const QJsonObject&, H&);
+    template<typename H> using CborDispatchFn = bool(*)(const QCborMap&, H&);
+    using JsonCreateFn = std::unique_ptr<Message_Base>(*)(const QJsonObject&);
+    using CborCreateFn = std::unique_ptr<Message_Base>(*)(const QCborMap&);
+
+    static bool parseJson(const QByteArray& payload, QJsonObject& object);
+    static bool parseCbor(const QByteArray& payload, QCborMap& map);
+
+    // Header is shared code, payload parser is called on the final type -> resolved statically
+    template<typename M>
+    static bool decodeAs(M& message, const QJsonObject& jsonObject) {
+      QJsonObject payload;
+      return message.headerFromJson(jsonObject, payload) && message.M::payloadFromJson(payload);
+    }
+    template<typename M>
+    static bool decodeAs(M& message, const QCborMap& cborMap) {
+      QCborMap payload;
+      return message.headerFromCbor(cborMap, payload) && message.M::payloadFromCbor(payload);
+    }
+
+    template<typename M, typename H>
+    static bool dispatchJsonAs(const QJsonObject& jsonObject, H& handler) {
+      M message;
+      if(!decodeAs(message, jsonObject)) return false;
+      handler(std::move(message));
+      return true;
+    }
+    template<typename M, typename H>
+    static bool dispatchCborAs(const QCborMap& cborMap, H& handler) {
+      M message;
+      if(!decodeAs(message, cborMap)) return false;
+      handler(std::move(message));
+      return true;
+    }
+
+    template<typename M, typename Source>
+    static std::unique_ptr<Message_Base> createAs(const Source& source) {
+      auto message = std::make_unique<M>();
+      if(!decodeAs(*message, source)) return nullptr;
+      return message;
+    }
+
+    // Builds array indexed by t_MessageType, unregistered slots stay nullptr
+    template<typename Fn, typename... Ms, typename MakeEntry>
+    static constexpr std::array<Fn, messageTypeIndex(t_MessageType::COUNT)> makeTable(MessageTypeList<Ms...>, MakeEntry makeEntry) {
+      std::array<Fn, messageTypeIndex(t_MessageType::COUNT)> table {};
+      ((table[messageTypeIndex(Ms::c_type)] = makeEntry(std::type_identity<Ms>{})), ...);
+      return table;
+    }
 
-    QMap<QString, MessageCreatorFunc> m_creators;
-    bool m_initialized = false;
+    static const std::array<JsonCreateFn, messageTypeIndex(t_MessageType::COUNT)> c_jsonCreators;
+    static const std::array<CborCreateFn, messageTypeIndex(t_MessageType::COUNT)> c_cborCreators;
   };
 }
 
-#endif
\ No newline at end of file
+#endif
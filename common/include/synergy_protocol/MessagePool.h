@@ -0,0 +1,75 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_POOL__
+#define __SYNERGY_PROTOCOL_MESSAGE_POOL__
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  ------------------------------------------------------------------
+  ---------------- Pooled storage for message objects --------------
+  Decoded messages are short lived and almost all the same few sizes:
+  parsed on an I/O thread, handed to the main thread in a shared_ptr,
+  dropped there once handled. Going through malloc for each one means
+  every I/O thread and the main thread meet in the allocator, and
+  days of mixed sizes fragment the heap.
+  Blocks come in a few size classes (64 .. 1024 bytes); each thread
+  keeps its own free lists, so allocate and free on the owning thread
+  touch no shared state at all. A block freed by another thread (the
+  usual case: main thread dropping an I/O thread's message) is pushed
+  onto its owner's lock-free return stack, which the owner takes over
+  in one exchange the next time its free list runs dry. Blocks never
+  change owner, so every size class settles at what its thread needs
+  at peak; a free list holds at most c_maxCachedBlocks, beyond that
+  blocks go back to the heap. Caches of finished threads, blocks
+  included, go to the next new thread.
+  Larger requests go straight to operator new.
+  Use makePooled<M>(...) instead of std::make_shared<M>(...); object
+  and shared_ptr control block share one pooled block.
+  ------------------------------------------------------------------
+  */
+  class MessagePool {
+  public:
+    static constexpr std::size_t c_alignment = 16;
+    static constexpr std::size_t c_maxBlockSize = 1024;
+    static constexpr int c_maxCachedBlocks = 1024; // Per thread and size class
+
+    // 'size' must be the same in both calls (as allocators guarantee)
+    static void* allocate(std::size_t size);
+    static void deallocate(void *pointer, std::size_t size) noexcept;
+
+    struct Cache;
+  };
+
+  template<typename T>
+  class PoolAllocator {
+  public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t count) {
+      static_assert(alignof(T) <= MessagePool::c_alignment, "over-aligned types can't be pooled");
+      return static_cast<T*>(MessagePool::allocate(count * sizeof(T)));
+    }
+    void deallocate(T *pointer, std::size_t count) noexcept {
+      MessagePool::deallocate(pointer, count * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+  };
+
+  template<typename T, typename... Args>
+  std::shared_ptr<T> makePooled(Args&&... args) {
+    using Stored = std::remove_cv_t<T>;
+    return std::allocate_shared<Stored>(PoolAllocator<Stored>(), std::forward<Args>(args)...);
+  }
+}
+
+#endif
@@ -1,12 +1,26 @@
 #ifndef __SYNERGY_PROTOCOL_MESSAGE_BASE__
 #define __SYNERGY_PROTOCOL_MESSAGE_BASE__
 
+#include <QCborMap>
+#include <QCborValue>
+#include <QCborStreamWriter>
+
 #include "protocol.h"
 
 namespace SynergyProtocol {
 
   class Message_Base {
-  public: 
+  public:
+
+    // Integer keys of the top level CBOR map (mirrors JSON "version", "type", "id", "payload", "seq")
+    // Small integers encode in a single byte, and the type is sent as enum value instead of a string
+    enum t_CborKey : qint64 {
+      CBOR_KEY_VERSION = 0,
+      CBOR_KEY_TYPE = 1,
+      CBOR_KEY_ID = 2,
+      CBOR_KEY_PAYLOAD = 3,
+      CBOR_KEY_SEQUENCE = 4
+    };
 
     virtual ~Message_Base() = default;
 
@@ -14,15 +28,23 @@ namespace SynergyProtocol {
     SynergyProtocol::t_Versions version() const { return m_version; }
     void setVersion(const SynergyProtocol::t_Versions& version) { m_version = version; }
     qintptr clientId() const { return m_id; }
+    /*
+    Position in the session's outbound stream, 0 = not sequenced.
+    Server numbers everything a session sends (broadcast and targeted alike),
+    client reports the highest number it has seen when it resumes after a drop.
+    */
+    quint64 sequence() const { return m_sequence; }
+    void setSequence(quint64 sequence) { m_sequence = sequence; }
 
     // Serialize entire message to JSON
-    virtual QJsonObject toJSon() const {
+    virtual QJsonObject toJSon() const { return toJSon(m_sequence); }
+    QJsonObject toJSon(quint64 sequence) const {
       QJsonObject obj;
       obj["version"] = SynergyProtocol::versionTypeToString(m_version);
       obj["type"] = SynergyProtocol::messageTypeToString(type()); // use mapping function
       obj["id"] = m_id;
+      if(sequence != 0) obj["seq"] = qint64(sequence);
       obj["payload"] = payloadToJson(); // delegate payload creation
-      // TBD : should we add seq_id here or in payload later?
       return obj;
     }
 
@@ -30,9 +52,39 @@ namespace SynergyProtocol {
       return QJsonDocument(this->toJSon()).toJson(QJsonDocument::Compact);
     }
 
+    // Serialize entire message to CBOR, written directly into the stream (no intermediate tree)
+    void toCbor(QCborStreamWriter& writer) const { toCbor(writer, m_sequence); }
+    void toCbor(QCborStreamWriter& writer, quint64 sequence) const;
+
+    // Serialize into bytes of a frame payload in requested wire format
+    QByteArray encode(SynergyProtocol::t_WireFormat format) const { return encode(format, m_sequence); }
+    QByteArray encode(SynergyProtocol::t_WireFormat format, quint64 sequence) const;
+
+    // Same as encode(), with 4-byte length prefix already in front (ready for socket write)
+    // CBOR is written after a reserved header, so payload isn't copied a second time.
+    // 'sequence' overrides the message's own, so a const message can be sequenced when sent
+    QByteArray encodeFrame(SynergyProtocol::t_WireFormat format) const { return encodeFrame(format, m_sequence); }
+    QByteArray encodeFrame(SynergyProtocol::t_WireFormat format, quint64 sequence) const;
+
     // Deserialize common fields from a full JSON message object
     // Returns false if basic structure (version, type) is invalid
     virtual bool fromJson(const QJsonObject& obj) {
+      QJsonObject payload;
+      return headerFromJson(obj, payload) && payloadFromJson(payload);
+    }
+
+    // Deserialize common fields from a full CBOR message map
+    virtual bool fromCbor(const QCborMap& map) {
+      QCborMap payload;
+      return headerFromCbor(map, payload) && payloadFromCbor(payload);
+    }
+
+  protected:
+    /*
+    Common header parsing, split from payload parsing so MessageFactory can call
+    the payload part on the concrete type (no virtual call, see MessageFactory::decodeAs)
+    */
+    bool headerFromJson(const QJsonObject& obj, QJsonObject& payload) {
       if(!obj.contains("version") || !obj.value("version").isString()) {
         qCritical() << "BASE MESAGE |  JSON message missing version string";
         return false;
@@ -47,24 +99,40 @@ namespace SynergyProtocol {
       }
       m_version = SynergyProtocol::stringToVersionType(obj["version"].toString());
       m_id = (quintptr)obj["id"].toDouble();
+      m_sequence = quint64(obj.value("seq").toInteger(0)); // Optional
       if (!obj.contains("payload") || !obj.value("payload").isObject()) {
         qCritical() << "Base JSON missing payload object.";
         return false;
       }
-      // TBD : Where is sequence value stored/client id?
-
-      return payloadFromJson(obj["payload"].toObject());
+      payload = obj["payload"].toObject();
+      return true;
     }
 
-  protected:
+    bool headerFromCbor(const QCborMap& map, QCborMap& payload);
 
     // Derived classes implement how their specific payload is built/parsed
     virtual QJsonObject payloadToJson() const = 0;
     virtual bool payloadFromJson(const QJsonObject& payloadObj) = 0;
 
-    SynergyProtocol::t_Versions m_version;
-    qintptr m_id;
+    /*
+    CBOR payload hooks. Default implementation reuses JSON payload code, so every
+    message speaks CBOR without extra work. Large/high-rate messages override them
+    to use integer keys and skip the QJsonObject round trip.
+    */
+    virtual void payloadToCbor(QCborStreamWriter& writer) const {
+      QCborValue::fromJsonValue(payloadToJson()).toCbor(writer);
+    }
+    virtual bool payloadFromCbor(const QCborMap& payloadMap) {
+      return payloadFromJson(payloadMap.toJsonObject());
+    }
+
+    // Single precision when that is exact (whole and half pixels), double otherwise: same value as over JSON
+    static void appendReal(QCborStreamWriter& writer, double value);
+
+    SynergyProtocol::t_Versions m_version = SynergyProtocol::t_Versions::V1_0;
+    qintptr m_id = 0;
+    quint64 m_sequence = 0;
   };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,60 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_CANVAS_SNAPSHOT__
+#define __SYNERGY_PROTOCOL_MESSAGE_CANVAS_SNAPSHOT__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <QByteArray>
+#include <QList>
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  Compacted canvas state, sent to a joining client before the DRAW_COMMANDs
+  not yet compacted (replaces full history replay of spec 11.2.2).
+  Canvas is cut into 'tile_size' x 'tile_size' squares, tile (x, y) covers
+  canvas pixels [x * tile_size, (x + 1) * tile_size) horizontally, same for y.
+  Only tiles with something drawn on them are sent, each as PNG with alpha.
+  */
+  class Message_Canvas_Snapshot final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::CANVAS_SNAPSHOT;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    struct Tile {
+      qint32 x = 0; // Grid coordinates, not pixels
+      qint32 y = 0;
+      QByteArray png;
+    };
+
+    int tileSize() const { return m_tile_size; }
+    const QList<Tile>& tiles() const { return m_tiles; }
+
+    explicit Message_Canvas_Snapshot(qintptr id = 0, int tileSize = 0, QList<Tile> tiles = {}) :
+      m_tile_size(tileSize),
+      m_tiles(std::move(tiles)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    // Payload keys used in CBOR encoding
+    enum t_CborPayloadKey : qint64 {
+      CBOR_TILE_SIZE = 0,
+      CBOR_TILES = 1 // Array of [x, y, png byte string]
+    };
+
+    int m_tile_size;
+    QList<Tile> m_tiles;
+
+    virtual QJsonObject payloadToJson() const override;
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+
+    // PNG goes as byte string, JSON has to carry it in base64
+    virtual void payloadToCbor(QCborStreamWriter& writer) const override;
+    virtual bool payloadFromCbor(const QCborMap& payloadMap) override;
+  };
+}
+
+#endif
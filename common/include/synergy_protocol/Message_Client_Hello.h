@@ -0,0 +1,43 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_CLIENT_HELLO__
+#define __SYNERGY_PROTOCOL_MESSAGE_CLIENT_HELLO__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  First message on a new connection (spec 5.4.1). Always sent as JSON, since
+  wire format isn't agreed yet. Client lists wire formats it can speak, most
+  preferred first; server answers with the chosen one in serverHello.
+  Frame compressions are offered the same way.
+  */
+  class Message_Client_Hello final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::CLIENT_HELLO;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QList<SynergyProtocol::t_WireFormat>& wireFormats() const { return m_wire_formats; }
+    const QList<SynergyProtocol::t_Compression>& compressions() const { return m_compressions; }
+
+    explicit Message_Client_Hello(qintptr id = 0, QList<SynergyProtocol::t_WireFormat> formats = SynergyProtocol::supportedWireFormats(),
+                                  QList<SynergyProtocol::t_Compression> compressions = SynergyProtocol::supportedCompressions()) :
+      m_wire_formats(std::move(formats)),
+      m_compressions(std::move(compressions)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QList<SynergyProtocol::t_WireFormat> m_wire_formats;
+    QList<SynergyProtocol::t_Compression> m_compressions;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
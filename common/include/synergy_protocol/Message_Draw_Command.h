@@ -0,0 +1,72 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_DRAW_COMMAND__
+#define __SYNERGY_PROTOCOL_MESSAGE_DRAW_COMMAND__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  // Single drawing action on the canvas overlay (spec 5.4.7 / 5.5.9)
+  class Message_Draw_Command final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::DRAW_COMMAND;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    static constexpr double c_defaultStrokeWidth = 1.0;
+
+    const QString& shape() const { return m_shape; }
+    double startX() const { return m_start_x; }
+    double startY() const { return m_start_y; }
+    double endX() const { return m_end_x; }
+    double endY() const { return m_end_y; }
+    const QString& color() const { return m_color; }
+    double strokeWidth() const { return m_stroke_width; }
+    const QString& originatorId() const { return m_originator_id; }
+    // Server stamps sender before relaying to other participants
+    void setOriginatorId(QString originator) { m_originator_id = std::move(originator); }
+
+    explicit Message_Draw_Command(qintptr id = 0, double startX = 0, double startY = 0, double endX = 0, double endY = 0,
+                                  QString color = "#000000", double strokeWidth = c_defaultStrokeWidth, QString originator = "") :
+      m_shape(QStringLiteral("line")),
+      m_start_x(startX), m_start_y(startY),
+      m_end_x(endX), m_end_y(endY),
+      m_color(std::move(color)),
+      m_stroke_width(strokeWidth),
+      m_originator_id(std::move(originator)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    // Payload keys used in CBOR encoding
+    enum t_CborPayloadKey : qint64 {
+      CBOR_SHAPE = 0,
+      CBOR_START_X = 1,
+      CBOR_START_Y = 2,
+      CBOR_END_X = 3,
+      CBOR_END_Y = 4,
+      CBOR_COLOR = 5,
+      CBOR_STROKE_WIDTH = 6,
+      CBOR_ORIGINATOR_ID = 7
+    };
+
+    QString m_shape; // Only "line" for MVP
+    double m_start_x;
+    double m_start_y;
+    double m_end_x;
+    double m_end_y;
+    QString m_color;
+    double m_stroke_width;
+    QString m_originator_id;
+
+    virtual QJsonObject payloadToJson() const override;
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+
+    virtual void payloadToCbor(QCborStreamWriter& writer) const override;
+    virtual bool payloadFromCbor(const QCborMap& payloadMap) override;
+  };
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_DRAW_POLYLINE__
+#define __SYNERGY_PROTOCOL_MESSAGE_DRAW_POLYLINE__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <QList>
+#include <QPointF>
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  Part of a freehand stroke, batch of consecutive points drawn as one polyline
+  (both directions, batched form of DRAW_COMMAND). A stroke is sent in several
+  batches with the same 'stroke_id', each batch starts at the last point of the
+  previous one, so every batch can be drawn on its own.
+  */
+  class Message_Draw_Polyline final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::DRAW_POLYLINE;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    static constexpr qsizetype c_maxPoints = 4096; // Larger batches are rejected on decode
+
+    quint64 strokeId() const { return m_stroke_id; }
+    const QList<QPointF>& points() const { return m_points; }
+    const QString& color() const { return m_color; }
+    double strokeWidth() const { return m_stroke_width; }
+    const QString& originatorId() const { return m_originator_id; }
+    // Server stamps sender before relaying to other participants
+    void setOriginatorId(QString originator) { m_originator_id = std::move(originator); }
+
+    explicit Message_Draw_Polyline(qintptr id = 0, quint64 strokeId = 0, QList<QPointF> points = {}, QString color = "#000000",
+                                   double strokeWidth = 1.0, QString originator = "") :
+      m_stroke_id(strokeId),
+      m_points(std::move(points)),
+      m_color(std::move(color)),
+      m_stroke_width(strokeWidth),
+      m_originator_id(std::move(originator)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    // Payload keys used in CBOR encoding
+    enum t_CborPayloadKey : qint64 {
+      CBOR_STROKE_ID = 0,
+      CBOR_POINTS = 1, // Flat array x0, y0, x1, y1, ...
+      CBOR_COLOR = 2,
+      CBOR_STROKE_WIDTH = 3,
+      CBOR_ORIGINATOR_ID = 4
+    };
+
+    quint64 m_stroke_id;
+    QList<QPointF> m_points;
+    QString m_color;
+    double m_stroke_width;
+    QString m_originator_id;
+
+    virtual QJsonObject payloadToJson() const override;
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+
+    virtual void payloadToCbor(QCborStreamWriter& writer) const override;
+    virtual bool payloadFromCbor(const QCborMap& payloadMap) override;
+  };
+}
+
+#endif
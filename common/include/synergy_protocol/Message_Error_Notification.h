@@ -0,0 +1,51 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_ERROR_NOTIFICATION__
+#define __SYNERGY_PROTOCOL_MESSAGE_ERROR_NOTIFICATION__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <QJsonObject>
+#include <utility>
+
+namespace SynergyProtocol {
+
+  // Recoverable error reported to client(s), connection stays open (NFR-REL-002)
+  class Message_Error_Notification final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::ERROR_NOTIFICATION;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    // Numeric codes for programmatic handling, 0 = unspecified
+    enum t_ErrorCode : int {
+      UNSPECIFIED = 0,
+      INVALID_REQUEST = 4001,
+      NOT_IN_SESSION = 4002,
+      EXECUTION_FAILED = 5001,
+      SAVE_FAILED = 5002, // context: filePath, revision; FILE_SAVED of that file ends it
+      EXECUTION_UNAVAILABLE = 5003
+    };
+
+    int code() const { return m_code; }
+    const QString& message() const { return m_message; }
+    const QJsonObject& context() const { return m_context; }
+
+    explicit Message_Error_Notification(qintptr id = 0, int code = UNSPECIFIED, QString message = "", QJsonObject context = {}) :
+      m_code(code),
+      m_message(std::move(message)),
+      m_context(std::move(context)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    int m_code;
+    QString m_message;
+    QJsonObject m_context;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
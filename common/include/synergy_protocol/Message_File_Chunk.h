@@ -0,0 +1,77 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_FILE_CHUNK__
+#define __SYNERGY_PROTOCOL_MESSAGE_FILE_CHUNK__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <QByteArray>
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  One piece of a file being opened (replaces the single SetActiveFile of the spec).
+  Content is UTF-8 bytes [offset, offset + size of data) of 'total_size' bytes,
+  chunks of one transfer arrive in order, the one that reaches 'total_size' is the
+  last. A chunk may end inside a multi-byte character, decode with a stateful decoder.
+  Content is the file at 'revision'; TEXT_OPERATIONs of the file that arrive during
+  the transfer apply on top of it, after the last chunk.
+  'file_path' and 'revision' are the same in every chunk of a transfer.
+  */
+  class Message_File_Chunk final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::FILE_CHUNK;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    quint64 transferId() const { return m_transfer_id; }
+    const QString& filePath() const { return m_file_path; }
+    quint64 revision() const { return m_revision; }
+    qint64 offset() const { return m_offset; }
+    qint64 totalSize() const { return m_total_size; }
+    const QByteArray& data() const { return m_data; }
+    bool isLast() const { return m_offset + m_data.size() >= m_total_size; }
+
+    // 'data' may be QByteArray::fromRawData over mapped file memory, it is only read while encoding
+    explicit Message_File_Chunk(qintptr id = 0, quint64 transferId = 0, QString filePath = "", quint64 revision = 0,
+                                qint64 offset = 0, qint64 totalSize = 0, QByteArray data = QByteArray()) :
+      m_transfer_id(transferId),
+      m_file_path(std::move(filePath)),
+      m_revision(revision),
+      m_offset(offset),
+      m_total_size(totalSize),
+      m_data(std::move(data)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    // Payload keys used in CBOR encoding
+    enum t_CborPayloadKey : qint64 {
+      CBOR_TRANSFER_ID = 0,
+      CBOR_FILE_PATH = 1,
+      CBOR_REVISION = 2,
+      CBOR_OFFSET = 3,
+      CBOR_TOTAL_SIZE = 4,
+      CBOR_DATA = 5
+    };
+
+    quint64 m_transfer_id;
+    QString m_file_path;
+    quint64 m_revision;
+    qint64 m_offset;
+    qint64 m_total_size;
+    QByteArray m_data;
+
+    virtual QJsonObject payloadToJson() const override;
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+
+    // Content goes as byte string, JSON has to carry it in base64
+    virtual void payloadToCbor(QCborStreamWriter& writer) const override;
+    virtual bool payloadFromCbor(const QCborMap& payloadMap) override;
+
+  private:
+    bool validate() const;
+  };
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_FILE_SAVED__
+#define __SYNERGY_PROTOCOL_MESSAGE_FILE_SAVED__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  // Durability ack: content of 'file_path' up to 'revision' is on the server's disk
+  class Message_File_Saved final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::FILE_SAVED;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QString& filePath() const { return m_file_path; }
+    quint64 revision() const { return m_revision; }
+
+    explicit Message_File_Saved(qintptr id = 0, QString path = "", quint64 revision = 0) :
+      m_file_path(std::move(path)),
+      m_revision(revision) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QString m_file_path;
+    quint64 m_revision;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
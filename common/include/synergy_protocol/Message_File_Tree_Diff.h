@@ -0,0 +1,54 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_FILE_TREE_DIFF__
+#define __SYNERGY_PROTOCOL_MESSAGE_FILE_TREE_DIFF__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <QList>
+#include <QStringList>
+#include <utility>
+
+namespace SynergyProtocol {
+
+  // Workspace change, paths are relative to workspace root with '/' separators
+  struct FileTreeDiff {
+    struct Entry {
+      QString path;
+      bool isDirectory;
+    };
+    struct Rename {
+      QString from;
+      QString to;
+    };
+
+    QList<Entry> added;
+    QStringList removed; // Removing a directory implies everything below it
+    QList<Rename> renamed;
+
+    bool isEmpty() const { return added.isEmpty() && removed.isEmpty() && renamed.isEmpty(); }
+  };
+
+  // Incremental change of the tree sent earlier in FILE_TREE_UPDATE
+  class Message_File_Tree_Diff final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::FILE_TREE_DIFF;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const FileTreeDiff& diff() const { return m_diff; }
+
+    explicit Message_File_Tree_Diff(qintptr id = 0, FileTreeDiff diff = FileTreeDiff()) :
+      m_diff(std::move(diff)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    FileTreeDiff m_diff;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
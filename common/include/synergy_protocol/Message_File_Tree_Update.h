@@ -0,0 +1,38 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_FILE_TREE_UPDATE__
+#define __SYNERGY_PROTOCOL_MESSAGE_FILE_TREE_UPDATE__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  Whole workspace structure (spec 5.5.6), nested objects:
+  {"name": "/", "type": "directory", "children": [{"name": "Makefile", "type": "file"}, ...]}
+  Sent once per request, later changes arrive as FILE_TREE_DIFF
+  */
+  class Message_File_Tree_Update final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::FILE_TREE_UPDATE;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QJsonObject& tree() const { return m_tree; }
+
+    explicit Message_File_Tree_Update(qintptr id = 0, QJsonObject tree = QJsonObject()) :
+      m_tree(std::move(tree)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QJsonObject m_tree;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
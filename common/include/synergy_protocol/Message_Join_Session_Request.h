@@ -7,9 +7,10 @@
 
 namespace SynergyProtocol {
 
-  class Message_Join_Session_Request : public SynergyProtocol::Message_Base {
+  class Message_Join_Session_Request final : public SynergyProtocol::Message_Base {
   public:
-  SynergyProtocol::t_MessageType type() const override { return SynergyProtocol::t_MessageType::JOIN_SESSION_REQUEST; }
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::JOIN_SESSION_REQUEST;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
 
     // Const getters provide read-only access
     const QString& sessionIdToJoin() const { return m_session_id_to_join; }
@@ -24,6 +25,8 @@ namespace SynergyProtocol {
       }
 
   protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
     QString m_session_id_to_join;
     bool m_create_new;
     QString m_username;
@@ -0,0 +1,48 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_JOIN_SESSION_RESPONSE__
+#define __SYNERGY_PROTOCOL_MESSAGE_JOIN_SESSION_RESPONSE__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  // Answer to JOIN_SESSION_REQUEST (spec 5.5.2 / 5.5.3)
+  class Message_Join_Session_Response final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::JOIN_SESSION_RESPONSE;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    bool success() const { return m_success; }
+    const QString& sessionId() const { return m_session_id; }
+    const QString& userId() const { return m_user_id; }
+    const QString& errorMessage() const { return m_error_message; }
+    // Secret for RESUME_SESSION_REQUEST after a dropped connection
+    const QString& resumeToken() const { return m_resume_token; }
+
+    explicit Message_Join_Session_Response(qintptr id = 0, bool success = false, QString sessionId = "", QString userId = "", QString error = "",
+                                           QString resumeToken = "") :
+      m_success(success),
+      m_session_id(std::move(sessionId)),
+      m_user_id(std::move(userId)),
+      m_error_message(std::move(error)),
+      m_resume_token(std::move(resumeToken)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    bool m_success;
+    QString m_session_id;    // Present only on success
+    QString m_user_id;       // Id other participants will see for us, present only on success
+    QString m_error_message; // Present only on failure
+    QString m_resume_token;  // Optional, only on success
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
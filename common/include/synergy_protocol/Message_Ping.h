@@ -0,0 +1,33 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_PING__
+#define __SYNERGY_PROTOCOL_MESSAGE_PING__
+
+#include "protocol.h"
+#include "Message_Base.h"
+
+namespace SynergyProtocol {
+
+  // Liveness probe, sent by server to a connection that has been quiet for a while. Answered with PONG carrying the same token
+  class Message_Ping final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::PING;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    quint32 token() const { return m_token; }
+
+    explicit Message_Ping(qintptr id = 0, quint32 token = 0) :
+      m_token(token) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    quint32 m_token;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_PONG__
+#define __SYNERGY_PROTOCOL_MESSAGE_PONG__
+
+#include "protocol.h"
+#include "Message_Base.h"
+
+namespace SynergyProtocol {
+
+  // Answer to PING, echoes its token
+  class Message_Pong final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::PONG;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    quint32 token() const { return m_token; }
+
+    explicit Message_Pong(qintptr id = 0, quint32 token = 0) :
+      m_token(token) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    quint32 m_token;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_REQUEST_FILE_TREE__
+#define __SYNERGY_PROTOCOL_MESSAGE_REQUEST_FILE_TREE__
+
+#include "protocol.h"
+#include "Message_Base.h"
+
+namespace SynergyProtocol {
+
+  // Ask for current workspace structure of joined session (spec 5.4.4), no payload fields
+  class Message_Request_File_Tree final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::REQUEST_FILE_TREE;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    explicit Message_Request_File_Tree(qintptr id = 0) {
+      m_id = id;
+    }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
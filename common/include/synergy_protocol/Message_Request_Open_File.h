@@ -0,0 +1,34 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_REQUEST_OPEN_FILE__
+#define __SYNERGY_PROTOCOL_MESSAGE_REQUEST_OPEN_FILE__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  // Ask for content of a workspace file (spec RequestOpenFile), answered with FILE_CHUNKs to the requester only
+  class Message_Request_Open_File final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::REQUEST_OPEN_FILE;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QString& filePath() const { return m_file_path; }
+
+    explicit Message_Request_Open_File(qintptr id = 0, QString filePath = "") :
+      m_file_path(std::move(filePath)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QString m_file_path; // Relative to session workspace
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
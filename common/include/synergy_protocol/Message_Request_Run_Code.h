@@ -0,0 +1,42 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_REQUEST_RUN_CODE__
+#define __SYNERGY_PROTOCOL_MESSAGE_REQUEST_RUN_CODE__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <QStringList>
+#include <utility>
+
+namespace SynergyProtocol {
+
+  // Run 'command' with 'args' in a container holding the session workspace (CLI-FUNC-EXEC-002)
+  class Message_Request_Run_Code final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::REQUEST_RUN_CODE;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QString& command() const { return m_command; }
+    const QStringList& args() const { return m_args; }
+    // Empty -> server default environment
+    const QString& targetEnvironment() const { return m_target_environment; }
+
+    explicit Message_Request_Run_Code(qintptr id = 0, QString command = "", QStringList args = {}, QString environment = "") :
+      m_command(std::move(command)),
+      m_args(std::move(args)),
+      m_target_environment(std::move(environment)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QString m_command;
+    QStringList m_args;
+    QString m_target_environment;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_RESUME_SESSION_REQUEST__
+#define __SYNERGY_PROTOCOL_MESSAGE_RESUME_SESSION_REQUEST__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  Sent instead of JOIN_SESSION_REQUEST on a new connection after the old one
+  dropped. 'last_sequence' is the highest message sequence seen on the old
+  connection, server sends only what came after it when it still can.
+  */
+  class Message_Resume_Session_Request final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::RESUME_SESSION_REQUEST;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QString& sessionId() const { return m_session_id; }
+    const QString& resumeToken() const { return m_resume_token; }
+    quint64 lastSequence() const { return m_last_sequence; }
+
+    explicit Message_Resume_Session_Request(qintptr id = 0, QString sessionId = "", QString resumeToken = "", quint64 lastSequence = 0) :
+      m_session_id(std::move(sessionId)),
+      m_resume_token(std::move(resumeToken)),
+      m_last_sequence(lastSequence) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QString m_session_id;
+    QString m_resume_token;
+    quint64 m_last_sequence;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_RESUME_SESSION_RESPONSE__
+#define __SYNERGY_PROTOCOL_MESSAGE_RESUME_SESSION_RESPONSE__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  Answer to RESUME_SESSION_REQUEST, sent after whatever the resume delivered:
+  - replayed: messages missed since 'last_sequence' were sent again, in order,
+    client state continues as it was
+  - !replayed: server no longer had all of them, current state was sent as on
+    join (participants, open files, canvas); client should request the file tree
+  Failure -> client has to join from scratch, 'resume_token' is then empty.
+  On success 'resume_token' replaces the old one.
+  */
+  class Message_Resume_Session_Response final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::RESUME_SESSION_RESPONSE;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    bool success() const { return m_success; }
+    bool replayed() const { return m_replayed; }
+    const QString& userId() const { return m_user_id; }
+    const QString& resumeToken() const { return m_resume_token; }
+    const QString& errorMessage() const { return m_error_message; }
+
+    explicit Message_Resume_Session_Response(qintptr id = 0, bool success = false, bool replayed = false, QString userId = "",
+                                             QString resumeToken = "", QString error = "") :
+      m_success(success),
+      m_replayed(replayed),
+      m_user_id(std::move(userId)),
+      m_resume_token(std::move(resumeToken)),
+      m_error_message(std::move(error)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    bool m_success;
+    bool m_replayed;
+    QString m_user_id;       // Present only on success
+    QString m_resume_token;  // Present only on success
+    QString m_error_message; // Present only on failure
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_RUN_OUTPUT_CHUNK__
+#define __SYNERGY_PROTOCOL_MESSAGE_RUN_OUTPUT_CHUNK__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  Piece of a run's output, broadcast while the process is still running.
+  'sequence' starts at 0 for each run and increases by one per chunk, a gap
+  means chunks were dropped. 'truncated' marks the place where server dropped
+  output ('data' then says how much), RUN_OUTPUT_RESULT with the same run id ends the run.
+  */
+  class Message_Run_Output_Chunk final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::RUN_OUTPUT_CHUNK;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    enum class t_Stream { STDOUT, STDERR };
+
+    const QString& runId() const { return m_run_id; }
+    quint64 sequence() const { return m_sequence; }
+    t_Stream stream() const { return m_stream; }
+    const QString& data() const { return m_data; }
+    bool truncated() const { return m_truncated; }
+
+    explicit Message_Run_Output_Chunk(qintptr id = 0, QString runId = "", quint64 sequence = 0, t_Stream stream = t_Stream::STDOUT,
+                                      QString data = "", bool truncated = false) :
+      m_run_id(std::move(runId)),
+      m_sequence(sequence),
+      m_stream(stream),
+      m_data(std::move(data)),
+      m_truncated(truncated) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QString m_run_id;
+    quint64 m_sequence;
+    t_Stream m_stream;
+    QString m_data;
+    bool m_truncated;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
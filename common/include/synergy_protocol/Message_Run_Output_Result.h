@@ -0,0 +1,52 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_RUN_OUTPUT_RESULT__
+#define __SYNERGY_PROTOCOL_MESSAGE_RUN_OUTPUT_RESULT__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  // Broadcast to the whole session once a run finished (SRV-FUNC-DOCKER-006)
+  // Output streamed as RUN_OUTPUT_CHUNK isn't repeated here: 'run_id' is set, 'chunk_count' tells how many were sent
+
+  class Message_Run_Output_Result final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::RUN_OUTPUT_RESULT;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QString& stdoutText() const { return m_stdout; }
+    const QString& stderrText() const { return m_stderr; }
+    int exitCode() const { return m_exit_code; }
+    const QString& requestingUserId() const { return m_requesting_user_id; }
+    const QString& runId() const { return m_run_id; }
+    quint64 chunkCount() const { return m_chunk_count; }
+
+    explicit Message_Run_Output_Result(qintptr id = 0, QString out = "", QString err = "", int exitCode = 0, QString requester = "",
+                                       QString runId = "", quint64 chunkCount = 0) :
+      m_stdout(std::move(out)),
+      m_stderr(std::move(err)),
+      m_exit_code(exitCode),
+      m_requesting_user_id(std::move(requester)),
+      m_run_id(std::move(runId)),
+      m_chunk_count(chunkCount) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QString m_stdout;
+    QString m_stderr;
+    int m_exit_code;
+    QString m_requesting_user_id;
+    QString m_run_id;
+    quint64 m_chunk_count;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_SERVER_HELLO__
+#define __SYNERGY_PROTOCOL_MESSAGE_SERVER_HELLO__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  Answer to clientHello (spec 5.5.1). Sent as JSON, every frame after it is
+  encoded in 'wire_format' in both directions and may be compressed with
+  'compression' (absent from older servers -> none).
+  */
+  class Message_Server_Hello final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::SERVER_HELLO;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QString& serverVersion() const { return m_server_version; }
+    SynergyProtocol::t_WireFormat wireFormat() const { return m_wire_format; }
+    SynergyProtocol::t_Compression compression() const { return m_compression; }
+
+    explicit Message_Server_Hello(qintptr id = 0, QString serverVersion = "", SynergyProtocol::t_WireFormat format = SynergyProtocol::t_WireFormat::JSON,
+                                  SynergyProtocol::t_Compression compression = SynergyProtocol::t_Compression::NONE) :
+      m_server_version(std::move(serverVersion)),
+      m_wire_format(format),
+      m_compression(compression) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QString m_server_version;
+    SynergyProtocol::t_WireFormat m_wire_format;
+    SynergyProtocol::t_Compression m_compression;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_TEXT_OPERATION__
+#define __SYNERGY_PROTOCOL_MESSAGE_TEXT_OPERATION__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include "TextOperation.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  Delta edit of the Active File, replaces full-content updateTextEdit per keystroke
+  C->S: 'revision' is the server revision the operation was made on
+  S->C: 'revision' is the server revision after applying it (already transformed, apply as is)
+  Empty operation from client asks for a snapshot, answered with UPDATE_TEXT_EDIT
+  */
+  class Message_Text_Operation final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::TEXT_OPERATION;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QString& filePath() const { return m_file_path; }
+    quint64 revision() const { return m_revision; }
+    const TextOperation& operation() const { return m_operation; }
+    const QString& originatorId() const { return m_originator_id; }
+
+    explicit Message_Text_Operation(qintptr id = 0, QString path = "", quint64 revision = 0, TextOperation operation = TextOperation(), QString originator = "") :
+      m_file_path(std::move(path)),
+      m_revision(revision),
+      m_operation(std::move(operation)),
+      m_originator_id(std::move(originator)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    // Payload keys used in CBOR encoding
+    enum t_CborPayloadKey : qint64 {
+      CBOR_FILE_PATH = 0,
+      CBOR_REVISION = 1,
+      CBOR_OPERATION = 2,
+      CBOR_ORIGINATOR_ID = 3
+    };
+
+    QString m_file_path;
+    quint64 m_revision;
+    TextOperation m_operation;
+    QString m_originator_id; // Empty in C->S direction, set by server on broadcast
+
+    virtual QJsonObject payloadToJson() const override;
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+
+    virtual void payloadToCbor(QCborStreamWriter& writer) const override;
+    virtual bool payloadFromCbor(const QCborMap& payloadMap) override;
+  };
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_TEXT_OPERATION_ACK__
+#define __SYNERGY_PROTOCOL_MESSAGE_TEXT_OPERATION_ACK__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  // Server applied sender's last TEXT_OPERATION (or full update), 'revision' is the resulting revision
+  class Message_Text_Operation_Ack final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::TEXT_OPERATION_ACK;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QString& filePath() const { return m_file_path; }
+    quint64 revision() const { return m_revision; }
+
+    explicit Message_Text_Operation_Ack(qintptr id = 0, QString path = "", quint64 revision = 0) :
+      m_file_path(std::move(path)),
+      m_revision(revision) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QString m_file_path;
+    quint64 m_revision;
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
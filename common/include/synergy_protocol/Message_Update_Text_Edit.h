@@ -0,0 +1,59 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_UPDATE_TEXT_EDIT__
+#define __SYNERGY_PROTOCOL_MESSAGE_UPDATE_TEXT_EDIT__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  /*
+  Full content of the Active File (spec 5.4.6 / 5.5.8)
+  Keystrokes travel as TEXT_OPERATION deltas, this one is only for opening a file
+  (C->S: replace content) and for snapshots/resync (S->C: content at 'revision')
+  */
+  class Message_Update_Text_Edit final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::UPDATE_TEXT_EDIT;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QString& filePath() const { return m_file_path; }
+    const QString& content() const { return m_content; }
+    const QString& originatorId() const { return m_originator_id; }
+    quint64 revision() const { return m_revision; }
+    // Server stamps sender before relaying to other participants
+    void setOriginatorId(QString originator) { m_originator_id = std::move(originator); }
+
+    explicit Message_Update_Text_Edit(qintptr id = 0, QString path = "", QString content = "", QString originator = "", quint64 revision = 0) :
+      m_file_path(std::move(path)),
+      m_content(std::move(content)),
+      m_originator_id(std::move(originator)),
+      m_revision(revision) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    // Payload keys used in CBOR encoding
+    enum t_CborPayloadKey : qint64 {
+      CBOR_FILE_PATH = 0,
+      CBOR_CONTENT = 1,
+      CBOR_ORIGINATOR_ID = 2,
+      CBOR_REVISION = 3
+    };
+
+    QString m_file_path;
+    QString m_content;
+    QString m_originator_id; // Empty in C->S direction, set by server on broadcast
+    quint64 m_revision;      // Server document revision this content corresponds to
+
+    virtual QJsonObject payloadToJson() const override;
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+
+    virtual void payloadToCbor(QCborStreamWriter& writer) const override;
+    virtual bool payloadFromCbor(const QCborMap& payloadMap) override;
+  };
+}
+
+#endif
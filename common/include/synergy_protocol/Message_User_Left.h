@@ -0,0 +1,37 @@
+#ifndef __SYNERGY_PROTOCOL_MESSAGE_USER_LEFT__
+#define __SYNERGY_PROTOCOL_MESSAGE_USER_LEFT__
+
+#include "protocol.h"
+#include "Message_Base.h"
+#include <utility>
+
+namespace SynergyProtocol {
+
+  // Broadcast to remaining participants when someone leaves the session (spec 5.5.5)
+  class Message_User_Left final : public SynergyProtocol::Message_Base {
+  public:
+    static constexpr SynergyProtocol::t_MessageType c_type = SynergyProtocol::t_MessageType::USER_LEFT;
+    SynergyProtocol::t_MessageType type() const override { return c_type; }
+
+    const QString& userId() const { return m_user_id; }
+    const QString& username() const { return m_username; }
+
+    explicit Message_User_Left(qintptr id = 0, QString userId = "", QString username = "") :
+      m_user_id(std::move(userId)),
+      m_username(std::move(username)) {
+        m_id = id;
+      }
+
+  protected:
+    friend class SynergyProtocol::MessageFactory; // Typed decoding calls payload parsers directly
+
+    QString m_user_id;
+    QString m_username; // Optional display name
+
+    virtual QJsonObject payloadToJson() const override;
+
+    virtual bool payloadFromJson(const QJsonObject& payloadObj) override;
+  };
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef __SYNERGY_PROTOCOL_TEXT_OPERATION__
+#define __SYNERGY_PROTOCOL_TEXT_OPERATION__
+
+#include <QString>
+#include <QJsonArray>
+#include <QCborArray>
+#include <QCborStreamWriter>
+
+#include <vector>
+
+namespace SynergyProtocol {
+
+  /*
+  ------------------------------------------------------------------
+  ------------------- Text operation (delta edit) ------------------
+  Edit of a whole document expressed as a sequence of components
+  walked left to right over the old text:
+    retain(n) - keep next n characters
+    insert(s) - insert s at current position
+    remove(n) - delete next n characters
+  Operation covers the document exactly: sum of retains and removes is
+  the length it applies to (baseLength), so a stale operation is
+  detected instead of corrupting text.
+  Lengths are QString (UTF-16) units, same as editors on both ends.
+
+  transform() is what makes concurrent edits converge (operational
+  transform): for a and b made on the same revision, it produces a'
+  and b' such that apply(apply(doc, a), b') == apply(apply(doc, b), a').
+
+  Wire form (JSON array and CBOR array alike):
+    positive int -> retain, negative int -> remove, string -> insert
+  e.g. [5, "abc", -2, 10] : keep 5, insert "abc", delete 2, keep 10
+  Decoding rejects operations whose base or target length would pass
+  c_maxDocumentLength (sums are overflow checked), so no later length
+  arithmetic on a received operation can wrap.
+  ------------------------------------------------------------------
+  */
+  class TextOperation {
+  public:
+    enum class t_Kind : quint8 { RETAIN, INSERT, REMOVE };
+
+    static constexpr qsizetype c_maxDocumentLength = 64 * 1024 * 1024; // UTF-16 units
+
+    struct Component {
+      t_Kind kind;
+      qsizetype length; // Retain / remove count, size of text for insert
+      QString text;     // Insert only
+    };
+
+    TextOperation() = default;
+
+    // Builders, adjacent components of the same kind are merged
+    TextOperation& retain(qsizetype count);
+    TextOperation& insert(const QString& text);
+    TextOperation& remove(qsizetype count);
+
+    const std::vector<Component>& components() const { return m_components; }
+    qsizetype baseLength() const { return m_baseLength; }     // Length of text it applies to
+    qsizetype targetLength() const { return m_targetLength; } // Length of text after applying
+    bool isNoop() const;
+
+    // Edits text in place. False (text untouched) if length of text isn't baseLength()
+    bool applyTo(QString& text) const;
+
+    // Single operation with the effect of 'first' followed by 'second'
+    static bool compose(const TextOperation& first, const TextOperation& second, TextOperation& composed);
+
+    // Both on same base. On equal insert positions, inserts of 'a' end up first
+    static bool transform(const TextOperation& a, const TextOperation& b, TextOperation& aPrime, TextOperation& bPrime);
+
+    QJsonArray toJson() const;
+    static bool fromJson(const QJsonArray& array, TextOperation& operation);
+    void toCbor(QCborStreamWriter& writer) const;
+    static bool fromCbor(const QCborArray& array, TextOperation& operation);
+
+    bool operator==(const TextOperation& other) const;
+
+  private:
+    std::vector<Component> m_components;
+    qsizetype m_baseLength = 0;
+    qsizetype m_targetLength = 0;
+  };
+}
+
+#endif
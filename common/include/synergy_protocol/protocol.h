@@ -5,7 +5,12 @@
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QHash>
+#include <QList>
+#include <QDebug>
 
+#include <array>
+#include <cstdint>
+#include <string_view>
 #include <vector>
 
 namespace SynergyProtocol {
@@ -14,29 +19,171 @@ namespace SynergyProtocol {
   };
   enum class t_MessageType {
     UNKNOWN,
-    JOIN_SESSION_REQUEST
+    JOIN_SESSION_REQUEST,
+    CLIENT_HELLO,
+    SERVER_HELLO,
+    UPDATE_TEXT_EDIT,
+    DRAW_COMMAND,
+    JOIN_SESSION_RESPONSE,
+    USER_JOINED,
+    USER_LEFT,
+    TEXT_OPERATION,
+    TEXT_OPERATION_ACK,
+    REQUEST_FILE_TREE,
+    FILE_TREE_UPDATE,
+    FILE_TREE_DIFF,
+    FILE_SAVED,
+    REQUEST_RUN_CODE,
+    RUN_OUTPUT_RESULT,
+    ERROR_NOTIFICATION,
+    RUN_OUTPUT_CHUNK,
+    CANVAS_SNAPSHOT,
+    DRAW_POLYLINE,
+    RESUME_SESSION_REQUEST,
+    RESUME_SESSION_RESPONSE,
+    REQUEST_OPEN_FILE,
+    FILE_CHUNK,
+    PING,
+    PONG,
+    COUNT // Keep last: number of message types, not a real type
+  };
+  // Encoding of a frame payload, negotiated in clientHello/serverHello
+  // JSON stays available for debugging, CBOR is compact binary (RFC 8949)
+  enum class t_WireFormat {
+    JSON = 0,
+    CBOR = 1
   };
 
-  // static const ensures the maps are built only once.
-  // QStringLiteral avoids runtime allocation, making it faster than QString("...").
-  // QHash::value(..., default) returns a default enum if not found
+  // Per-frame compression, negotiated in clientHello/serverHello next to the wire format
+  // Compressed frames have the top bit of their length prefix set (see FrameCompressor)
+  enum class t_Compression {
+    NONE = 0,
+    DEFLATE = 1,           // Raw deflate (RFC 1951)
+    DEFLATE_DICTIONARY = 2 // Same, primed with FrameCompressor's protocol dictionary
+  };
 
-  inline QString messageTypeToString(t_MessageType type){
-    static const QHash<t_MessageType, QString> typeToString {
-        { t_MessageType::UNKNOWN, QStringLiteral("UNKNOWN") },
-        { t_MessageType::JOIN_SESSION_REQUEST, QStringLiteral("JOIN_SESSION_REQUEST") },
-    };
-    return typeToString.value(type, QStringLiteral("UNKNOWN"));
+  /*
+  ------------------------------------------------------------------
+  ------------------ Message type <-> wire name -------------------
+  Names are a constexpr table indexed by t_MessageType, so enum -> name is
+  a single array access. Name -> enum uses a perfect hash built at compile
+  time: one hash over the incoming string, one slot load, one compare.
+  Cost doesn't grow with number of message types.
+  To add a type: add enumerator (before COUNT) and its name at same index.
+  ------------------------------------------------------------------
+  */
+  inline constexpr auto c_messageTypeNames = std::to_array<std::string_view>({
+    "UNKNOWN",
+    "JOIN_SESSION_REQUEST",
+    "CLIENT_HELLO",
+    "SERVER_HELLO",
+    "UPDATE_TEXT_EDIT",
+    "DRAW_COMMAND",
+    "JOIN_SESSION_RESPONSE",
+    "USER_JOINED",
+    "USER_LEFT",
+    "TEXT_OPERATION",
+    "TEXT_OPERATION_ACK",
+    "REQUEST_FILE_TREE",
+    "FILE_TREE_UPDATE",
+    "FILE_TREE_DIFF",
+    "FILE_SAVED",
+    "REQUEST_RUN_CODE",
+    "RUN_OUTPUT_RESULT",
+    "ERROR_NOTIFICATION",
+    "RUN_OUTPUT_CHUNK",
+    "CANVAS_SNAPSHOT",
+    "DRAW_POLYLINE",
+    "RESUME_SESSION_REQUEST",
+    "RESUME_SESSION_RESPONSE",
+    "REQUEST_OPEN_FILE",
+    "FILE_CHUNK",
+    "PING",
+    "PONG",
+  });
+  // Size comes from the list itself, so a name missing for a new type fails here instead of decoding as ""
+  static_assert(c_messageTypeNames.size() == static_cast<std::size_t>(t_MessageType::COUNT),
+                "c_messageTypeNames needs exactly one name per t_MessageType");
+
+  constexpr std::size_t messageTypeIndex(t_MessageType type) {
+    return static_cast<std::size_t>(type);
   }
 
-  inline t_MessageType stringToMessageType(const QString &typeStr){
-    static const QHash<QString, t_MessageType> stringToType {
-        { QStringLiteral("UNKNOWN"), t_MessageType::UNKNOWN },
-        { QStringLiteral("JOIN_SESSION_REQUEST"), t_MessageType::JOIN_SESSION_REQUEST },
+  namespace detail {
+    constexpr std::uint16_t codeUnit(char ch) { return static_cast<unsigned char>(ch); }
+    constexpr std::uint16_t codeUnit(QChar ch) { return ch.unicode(); }
+
+    // FNV-1a over code units (wire names are plain ASCII, so string_view and QStringView hash equally)
+    template<typename CharRange>
+    constexpr std::uint32_t hashTypeName(const CharRange& name, std::uint32_t seed) {
+      std::uint32_t hash = 2166136261u ^ seed;
+      for(auto ch : name) {
+        hash ^= codeUnit(ch);
+        hash *= 16777619u;
+      }
+      return hash;
+    }
+
+    struct MessageTypeHashTable {
+      static constexpr std::size_t c_slots = 128; // power of two, >= 4x number of types keeps seed search short
+      std::uint32_t seed = 0;
+      std::array<std::uint8_t, c_slots> slots {}; // message type index + 1, 0 = empty slot
     };
-    return stringToType.value(typeStr, t_MessageType::UNKNOWN);
+
+    // Tries seeds until every name lands in its own slot (runs only in the compiler)
+    constexpr MessageTypeHashTable buildMessageTypeHashTable() {
+      for(std::uint32_t seed = 1; seed < 100000; ++seed) {
+        MessageTypeHashTable table;
+        table.seed = seed;
+        bool collision = false;
+        for(std::size_t i = 0; i < c_messageTypeNames.size() && !collision; ++i) {
+          std::size_t slot = hashTypeName(c_messageTypeNames[i], seed) & (MessageTypeHashTable::c_slots - 1);
+          collision = table.slots[slot] != 0;
+          table.slots[slot] = static_cast<std::uint8_t>(i + 1);
+        }
+        if(!collision) return table;
+      }
+      return MessageTypeHashTable{};
+    }
+
+    inline constexpr MessageTypeHashTable c_messageTypeHash = buildMessageTypeHashTable();
+    static_assert(c_messageTypeHash.seed != 0, "No perfect hash seed found for message type names");
+    static_assert(c_messageTypeNames.size() < MessageTypeHashTable::c_slots / 2, "Grow MessageTypeHashTable::c_slots");
+  }
+
+  // Returned reference points into a table built once, no QString is created per call
+  inline const QString& messageTypeToString(t_MessageType type){
+    static const std::array<QString, c_messageTypeNames.size()> names = []() {
+      std::array<QString, c_messageTypeNames.size()> result;
+      for(std::size_t i = 0; i < c_messageTypeNames.size(); ++i) {
+        result[i] = QString::fromLatin1(c_messageTypeNames[i].data(), static_cast<qsizetype>(c_messageTypeNames[i].size()));
+      }
+      return result;
+    }();
+    const std::size_t index = messageTypeIndex(type);
+    return index < names.size() ? names[index] : names[messageTypeIndex(t_MessageType::UNKNOWN)];
+  }
+
+  inline t_MessageType stringToMessageType(QStringView typeStr){
+    const auto& table = detail::c_messageTypeHash;
+    const std::uint8_t entry = table.slots[detail::hashTypeName(typeStr, table.seed) & (table.c_slots - 1)];
+    if(entry == 0) return t_MessageType::UNKNOWN;
+    // Slot only tells us the candidate, string must still match exactly
+    const std::string_view name = c_messageTypeNames[entry - 1];
+    if(typeStr != QLatin1StringView(name.data(), static_cast<qsizetype>(name.size()))) return t_MessageType::UNKNOWN;
+    return static_cast<t_MessageType>(entry - 1);
+  }
+
+  // CBOR carries the enum value directly, this only range-checks it
+  inline t_MessageType intToMessageType(qint64 value){
+    if(value < 0 || value >= static_cast<qint64>(t_MessageType::COUNT)) return t_MessageType::UNKNOWN;
+    return static_cast<t_MessageType>(value);
   }
 
+  // static const ensures the maps are built only once.
+  // QStringLiteral avoids runtime allocation, making it faster than QString("...").
+  // QHash::value(..., default) returns a default enum if not found
+
   inline QString versionTypeToString(t_Versions version){
     static const QHash<t_Versions, QString> versionToString {
         { t_Versions::V1_0, QStringLiteral("V1_0") },
@@ -51,10 +198,127 @@ namespace SynergyProtocol {
     return stringToVersion.value(versionStr, t_Versions::V1_0);
   }
 
+  inline QString wireFormatToString(t_WireFormat format){
+    static const QHash<t_WireFormat, QString> formatToString {
+        { t_WireFormat::JSON, QStringLiteral("JSON") },
+        { t_WireFormat::CBOR, QStringLiteral("CBOR") },
+    };
+    return formatToString.value(format, QStringLiteral("JSON"));
+  }
+
+  inline t_WireFormat stringToWireFormat(const QString &formatStr, bool *ok = nullptr){
+    static const QHash<QString, t_WireFormat> stringToFormat {
+        { QStringLiteral("JSON"), t_WireFormat::JSON },
+        { QStringLiteral("CBOR"), t_WireFormat::CBOR },
+    };
+    if(ok) *ok = stringToFormat.contains(formatStr);
+    return stringToFormat.value(formatStr, t_WireFormat::JSON);
+  }
+
+  // Formats this build can speak, in order of preference
+  inline QList<t_WireFormat> supportedWireFormats(){
+    return { t_WireFormat::CBOR, t_WireFormat::JSON };
+  }
+
+  // Server side of negotiation: first format offered by the client that we also support
+  // JSON is mandatory for every peer, so it is the fallback
+  inline t_WireFormat negotiateWireFormat(const QList<t_WireFormat> &offered){
+    const QList<t_WireFormat> supported = supportedWireFormats();
+    for(t_WireFormat format : offered) {
+      if(supported.contains(format)) return format;
+    }
+    return t_WireFormat::JSON;
+  }
+
+  inline QString compressionToString(t_Compression compression){
+    static const QHash<t_Compression, QString> compressionToString {
+        { t_Compression::NONE, QStringLiteral("none") },
+        { t_Compression::DEFLATE, QStringLiteral("deflate") },
+        { t_Compression::DEFLATE_DICTIONARY, QStringLiteral("deflate-dict-v1") },
+    };
+    return compressionToString.value(compression, QStringLiteral("none"));
+  }
+
+  inline t_Compression stringToCompression(const QString &compressionStr, bool *ok = nullptr){
+    static const QHash<QString, t_Compression> stringToCompression {
+        { QStringLiteral("none"), t_Compression::NONE },
+        { QStringLiteral("deflate"), t_Compression::DEFLATE },
+        { QStringLiteral("deflate-dict-v1"), t_Compression::DEFLATE_DICTIONARY },
+    };
+    if(ok) *ok = stringToCompression.contains(compressionStr);
+    return stringToCompression.value(compressionStr, t_Compression::NONE);
+  }
+
+  // Compressions this build can speak, in order of preference
+  inline QList<t_Compression> supportedCompressions(){
+    return { t_Compression::DEFLATE_DICTIONARY, t_Compression::DEFLATE, t_Compression::NONE };
+  }
+
+  // Same rule as wire format: first offered one we support, uncompressed as fallback
+  inline t_Compression negotiateCompression(const QList<t_Compression> &offered){
+    const QList<t_Compression> supported = supportedCompressions();
+    for(t_Compression compression : offered) {
+      if(supported.contains(compression)) return compression;
+    }
+    return t_Compression::NONE;
+  }
+
   class Message_Base;
 
   class Message_Join_Session_Request;
 
+  class Message_Client_Hello;
+
+  class Message_Server_Hello;
+
+  class Message_Update_Text_Edit;
+
+  class Message_Draw_Command;
+
   class MessageFactory;
+
+  class FrameDecoder;
+
+  class Message_Join_Session_Response;
+
+  class Message_User_Joined;
+
+  class Message_User_Left;
+
+  class Message_Text_Operation;
+
+  class Message_Text_Operation_Ack;
+
+  class Message_Request_File_Tree;
+
+  class Message_File_Tree_Update;
+
+  class Message_File_Tree_Diff;
+
+  class Message_File_Saved;
+
+  class Message_Request_Run_Code;
+
+  class Message_Run_Output_Result;
+
+  class Message_Error_Notification;
+
+  class Message_Run_Output_Chunk;
+
+  class Message_Ping;
+
+  class Message_Pong;
+
+  class Message_Canvas_Snapshot;
+
+  class Message_Draw_Polyline;
+
+  class Message_Resume_Session_Request;
+
+  class Message_Resume_Session_Response;
+
+  class Message_Request_Open_File;
+
+  class Message_File_Chunk;
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,282 @@
+#include "../../include/synergy_protocol/AsyncLog.h"
+
+#include <QDateTime>
+
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+namespace SynergyProtocol {
+  Q_LOGGING_CATEGORY(logPayload, "synergy.payload", QtWarningMsg)
+  Q_LOGGING_CATEGORY(logTraffic, "synergy.traffic", QtWarningMsg)
+}
+
+using namespace SynergyProtocol;
+
+std::atomic<AsyncLog*> AsyncLog::s_instance {nullptr};
+std::atomic<int> AsyncLog::s_inFlight {0};
+
+namespace {
+  constexpr qsizetype c_flushBytes = 64 * 1024;
+  constexpr qsizetype c_maxKeyLength = 160;
+}
+
+AsyncLog::AsyncLog(Config config) :
+  m_config(config) {
+  std::size_t capacity = 2;
+  while(capacity < m_config.capacity) capacity <<= 1;
+  m_mask = capacity - 1;
+  m_slots = std::make_unique<Slot[]>(capacity);
+  for(std::size_t i = 0; i < capacity; ++i) {
+    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  m_writer = QThread::create([this]() { run(); });
+  m_writer->setObjectName(QStringLiteral("log-writer"));
+  m_writer->start();
+
+  AsyncLog *expected = nullptr;
+  const bool installed = s_instance.compare_exchange_strong(expected, this);
+  Q_ASSERT_X(installed, "AsyncLog", "only one instance at a time");
+  Q_UNUSED(installed);
+  m_previous = qInstallMessageHandler(&AsyncLog::handler);
+}
+
+AsyncLog::~AsyncLog(){
+  qInstallMessageHandler(m_previous);
+  AsyncLog *self = this;
+  s_instance.compare_exchange_strong(self, nullptr);
+  // A handler that already picked us up finishes its push first
+  while(s_inFlight.load() > 0) QThread::yieldCurrentThread();
+
+  m_stopping.store(true);
+  m_wake.release();
+  m_writer->wait();
+  delete m_writer;
+}
+
+qint64 AsyncLog::nowUs(){
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/*
+Runs on whichever thread logged. Message is already formatted by Qt (that part
+can't be moved), everything else - timestamp text, encoding, the write - is the
+writer's. Disabled categories never get here.
+*/
+void AsyncLog::handler(QtMsgType type, const QMessageLogContext &context, const QString &message){
+  s_inFlight.fetch_add(1);
+  AsyncLog *log = s_instance.load();
+  if(!log) {
+    s_inFlight.fetch_sub(1);
+    const QByteArray line = qFormatLogMessage(type, context, message).toLocal8Bit() + '\n';
+    std::fwrite(line.constData(), 1, static_cast<std::size_t>(line.size()), stderr);
+    return;
+  }
+
+  Record record {type, nowUs(), context.category, context.file, context.line, message};
+  if(type == QtFatalMsg) {
+    // Process ends right after this: whatever is queued goes first, then this line, synchronously
+    log->wakeWriter();
+    for(int i = 0; i < 200 && !log->isEmpty(); ++i) QThread::msleep(1);
+    QByteArray out;
+    format(record, out);
+    std::fwrite(out.constData(), 1, static_cast<std::size_t>(out.size()), log->m_config.output);
+    std::fflush(log->m_config.output);
+  } else if(log->push(std::move(record))) {
+    log->wakeWriter();
+  } else {
+    log->m_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+  s_inFlight.fetch_sub(1);
+}
+
+/*
+Bounded MPSC ring (D. Vyukov's sequence-per-slot queue). Slot sequence tells
+whose turn it is: == position -> free for the producer that claims 'position',
+== position + 1 -> holds a record for the writer. Producers claim a position
+with one CAS on the tail and never wait for each other or for the writer.
+*/
+bool AsyncLog::push(Record &&record){
+  std::size_t position = m_tail.load(std::memory_order_relaxed);
+  for(;;) {
+    Slot &slot = m_slots[position & m_mask];
+    const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+    if(difference == 0) {
+      if(m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        slot.record = std::move(record);
+        slot.sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+    } else if(difference < 0) {
+      return false; // Writer hasn't freed this slot yet: ring is full
+    } else {
+      position = m_tail.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool AsyncLog::pop(Record &record){
+  const std::size_t head = m_head.load(std::memory_order_relaxed);
+  Slot &slot = m_slots[head & m_mask];
+  if(slot.sequence.load(std::memory_order_acquire) != head + 1) return false;
+  record = std::move(slot.record);
+  slot.sequence.store(head + m_mask + 1, std::memory_order_release);
+  m_head.store(head + 1, std::memory_order_relaxed);
+  return true;
+}
+
+bool AsyncLog::isEmpty() const {
+  const std::size_t head = m_head.load(std::memory_order_relaxed);
+  return m_slots[head & m_mask].sequence.load(std::memory_order_acquire) != head + 1;
+}
+
+// Semaphore is only touched when the writer said it's going to sleep
+void AsyncLog::wakeWriter(){
+  if(m_writerIdle.load(std::memory_order_relaxed) && m_writerIdle.exchange(false)) {
+    m_wake.release();
+  }
+}
+
+void AsyncLog::run(){
+  QByteArray out;
+  qint64 lastExpiryUs = nowUs();
+  for(;;) {
+    drain(out);
+    if(const quint64 dropped = m_dropped.exchange(0, std::memory_order_relaxed)) {
+      out += "log queue full, " + QByteArray::number(dropped) + " records dropped\n";
+    }
+    const qint64 now = nowUs();
+    if(now - lastExpiryUs >= qint64(m_config.windowMs) * 1000) {
+      expireWindows(now, out);
+      lastExpiryUs = now;
+    }
+    flush(out);
+
+    if(m_stopping.load()) {
+      drain(out);
+      expireWindows(std::numeric_limits<qint64>::max(), out);
+      flush(out);
+      return;
+    }
+
+    m_writerIdle.store(true);
+    if(!isEmpty()) {
+      // Raced with a producer; at worst it still releases and we loop once for nothing
+      m_writerIdle.store(false);
+      continue;
+    }
+    // Timed, so suppressed-message summaries come out even when nothing else is logged
+    m_wake.tryAcquire(1, m_config.windowMs);
+  }
+}
+
+void AsyncLog::drain(QByteArray &out){
+  Record record;
+  while(pop(record)) {
+    accept(std::move(record), out);
+    if(out.size() >= c_flushBytes) flush(out);
+  }
+}
+
+void AsyncLog::accept(Record &&record, QByteArray &out){
+  if(m_config.burst <= 0) {
+    format(record, out);
+    return;
+  }
+  Window &window = m_windows[siteKey(record)];
+  if(record.timeUs - window.startUs >= qint64(m_config.windowMs) * 1000) {
+    if(window.suppressed > 0) summarize(window, out);
+    window.startUs = record.timeUs;
+    window.written = 0;
+    window.suppressed = 0;
+  }
+  if(window.written < m_config.burst) {
+    ++window.written;
+    format(record, out);
+    return;
+  }
+  ++window.suppressed;
+  window.last = std::move(record);
+}
+
+void AsyncLog::expireWindows(qint64 now, QByteArray &out){
+  for(auto it = m_windows.begin(); it != m_windows.end();) {
+    if(now - it->startUs >= qint64(m_config.windowMs) * 1000) {
+      if(it->suppressed > 0) summarize(*it, out);
+      it = m_windows.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void AsyncLog::summarize(const Window &window, QByteArray &out) const {
+  Record summary = window.last;
+  summary.message = QStringLiteral("(%1 similar messages suppressed, last one:) %2").arg(window.suppressed).arg(window.last.message);
+  format(summary, out);
+}
+
+void AsyncLog::flush(QByteArray &out){
+  if(out.isEmpty()) return;
+  std::fwrite(out.constData(), 1, static_cast<std::size_t>(out.size()), m_config.output);
+  std::fflush(m_config.output);
+  out.clear(); // Keeps capacity
+}
+
+// Call site when Qt knows it (QT_MESSAGELOGCONTEXT / debug builds), else the text with numbers blanked out
+QString AsyncLog::siteKey(const Record &record){
+  if(record.file) {
+    return QString::fromLatin1(record.file) + u':' + QString::number(record.line);
+  }
+  QString key = record.category ? QString::fromLatin1(record.category) : QString();
+  key += u'|';
+  bool inNumber = false;
+  for(QChar character : record.message) {
+    if(key.size() >= c_maxKeyLength) break;
+    if(character.isDigit()) {
+      if(!inNumber) key += u'#';
+      inNumber = true;
+    } else {
+      key += character;
+      inNumber = false;
+    }
+  }
+  return key;
+}
+
+// 2026-01-31T12:00:00.123Z W synergy.net: text
+void AsyncLog::format(const Record &record, QByteArray &out){
+  thread_local qint64 cachedSecond = -1;
+  thread_local QByteArray cachedPrefix;
+  const qint64 second = record.timeUs / 1000000;
+  if(second != cachedSecond) {
+    cachedSecond = second;
+    cachedPrefix = QDateTime::fromSecsSinceEpoch(second).toUTC().toString(QStringLiteral("yyyy-MM-ddTHH:mm:ss")).toLatin1();
+  }
+  const int millis = static_cast<int>(record.timeUs / 1000 % 1000);
+  char level = 'D';
+  switch(record.type) {
+    case QtDebugMsg: level = 'D'; break;
+    case QtInfoMsg: level = 'I'; break;
+    case QtWarningMsg: level = 'W'; break;
+    case QtCriticalMsg: level = 'C'; break;
+    case QtFatalMsg: level = 'F'; break;
+  }
+
+  out += cachedPrefix;
+  out += '.';
+  out += char('0' + millis / 100);
+  out += char('0' + millis / 10 % 10);
+  out += char('0' + millis % 10);
+  out += "Z ";
+  out += level;
+  out += ' ';
+  if(record.category && std::strcmp(record.category, "default") != 0) {
+    out += record.category;
+    out += ": ";
+  }
+  out += record.message.toUtf8();
+  out += '\n';
+}
@@ -0,0 +1,109 @@
+#include "../../include/synergy_protocol/FrameBufferPool.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <vector>
+
+using namespace SynergyProtocol;
+
+namespace {
+  constexpr int c_minBits = std::bit_width(quint64(FrameBufferPool::c_minCapacity)) - 1;
+  constexpr int c_bucketCount = std::bit_width(quint64(FrameBufferPool::c_maxCapacity)) - c_minBits; // 256 B .. 1 MiB
+  constexpr qsizetype c_localBytes = 512 * 1024;   // Per thread and bucket
+  constexpr qsizetype c_depotBytes = 4 * 1024 * 1024; // Per bucket
+  constexpr qsizetype c_batch = 8;
+
+  constexpr qsizetype bucketCapacity(int bucket) {
+    return qsizetype(1) << (bucket + c_minBits);
+  }
+
+  // Buffers kept per bucket, at least a couple of the big ones
+  constexpr qsizetype localLimit(int bucket) {
+    return std::clamp<qsizetype>(c_localBytes / bucketCapacity(bucket), 2, 32);
+  }
+  constexpr qsizetype depotLimit(int bucket) {
+    return std::clamp<qsizetype>(c_depotBytes / bucketCapacity(bucket), 4, 256);
+  }
+
+  // Smallest bucket whose every buffer holds 'capacity'
+  int bucketFor(qsizetype capacity) {
+    if(capacity <= FrameBufferPool::c_minCapacity) return 0;
+    return std::bit_width(quint64(capacity - 1)) - c_minBits;
+  }
+
+  // Largest bucket 'capacity' satisfies, -1 if too small
+  int bucketOf(qsizetype capacity) {
+    if(capacity < FrameBufferPool::c_minCapacity) return -1;
+    return std::bit_width(quint64(capacity)) - 1 - c_minBits;
+  }
+
+  using Buckets = std::array<std::vector<QByteArray>, c_bucketCount>;
+
+  struct Depot {
+    QMutex mutex;
+    Buckets buckets;
+  };
+
+  // Never destroyed: other threads may still release while static objects go away at exit
+  Depot& depot(){
+    static Depot *instance = new Depot;
+    return *instance;
+  }
+
+  Buckets& localBuckets(){
+    thread_local Buckets buckets;
+    return buckets;
+  }
+
+  // Moves up to 'count' buffers from the back of 'from' to 'to'
+  void moveBatch(std::vector<QByteArray> &from, std::vector<QByteArray> &to, qsizetype count, qsizetype limit){
+    while(count-- > 0 && !from.empty() && qsizetype(to.size()) < limit) {
+      to.push_back(std::move(from.back()));
+      from.pop_back();
+    }
+  }
+}
+
+QByteArray FrameBufferPool::acquire(qsizetype capacity){
+  QByteArray buffer;
+  if(capacity > c_maxCapacity) {
+    buffer.reserve(capacity);
+    return buffer;
+  }
+
+  const int bucket = bucketFor(capacity);
+  std::vector<QByteArray> &local = localBuckets()[bucket];
+  if(local.empty()) {
+    Depot &shared = depot();
+    QMutexLocker lock(&shared.mutex);
+    moveBatch(shared.buckets[bucket], local, c_batch, localLimit(bucket));
+  }
+  if(!local.empty()) {
+    buffer = std::move(local.back());
+    local.pop_back();
+    return buffer;
+  }
+  // Full bucket size, so it goes back into the same bucket
+  buffer.reserve(bucketCapacity(bucket));
+  return buffer;
+}
+
+void FrameBufferPool::release(QByteArray buffer){
+  if(!buffer.isDetached() || buffer.capacity() > c_maxCapacity) return;
+  const int bucket = bucketOf(buffer.capacity());
+  if(bucket < 0) return;
+
+  buffer.resize(0); // Keeps the allocation
+  std::vector<QByteArray> &local = localBuckets()[bucket];
+  if(qsizetype(local.size()) >= localLimit(bucket)) {
+    Depot &shared = depot();
+    QMutexLocker lock(&shared.mutex);
+    moveBatch(local, shared.buckets[bucket], c_batch, depotLimit(bucket));
+  }
+  // Depot full too -> this one is freed
+  if(qsizetype(local.size()) < localLimit(bucket)) local.push_back(std::move(buffer));
+}
@@ -0,0 +1,105 @@
+#include "../../include/synergy_protocol/FrameCompressor.h"
+#include "../../include/synergy_protocol/FrameDecoder.h"
+#include "../../include/synergy_protocol/FrameBufferPool.h"
+
+#include <QtEndian>
+
+#include <zlib.h>
+
+using namespace SynergyProtocol;
+
+namespace {
+  /*
+  Strings most frames share. deflate finds matches up to 32 KiB back and
+  shorter distances are cheaper, so the most frequent strings come last.
+  JSON documents are compact with sorted keys: {"id":..,"payload":{..},"seq":..,"type":"..","version":"1.0"}
+  */
+  constexpr char c_dictionary[] =
+    "\"target_environment\":\"\"command\":\"\"args\":[\"context\":{\"code\":\"message\":\""
+    "\"chunk_count\":\"exit_code\":\"stdout\":\"\"stderr\":\"\"requesting_user_id\":\"\"run_id\":\"RUN_\"stream\":\"truncated\":false"
+    "\"protocol_version\":\"1.0\"\"server_version\":\"\"wire_formats\":[\"CBOR\",\"JSON\"]\"compressions\":[\"deflate-dict-v1\",\"deflate\",\"none\"]"
+    "\"create_new\":true\"session_id\":\"SESS_\"success\":true\"error_message\":\"\"resume_token\":\"\"last_sequence\":\"replayed\":true"
+    "\"tree\":{\"added\":[\"removed\":[\"renamed\":[{\"from\":\"\"to\":\"\"children\":[{\"path\":\"\"type\":\"file\"},{\"type\":\"directory\"}"
+    "\"tile_size\":256,\"tiles\":[{\"png\":\"iVBORw0KGgo\"x\":\"y\":\"shape\":\"line\"\"start_x\":\"start_y\":\"end_x\":\"end_y\":"
+    "\"transfer_id\":\"offset\":0,\"total_size\":\"data\":\""
+    "CLIENT_HELLOSERVER_HELLOJOIN_SESSION_REQUESTJOIN_SESSION_RESPONSERESUME_SESSION_REQUESTRESUME_SESSION_RESPONSE"
+    "USER_JOINEDUSER_LEFTREQUEST_FILE_TREEFILE_TREE_UPDATEFILE_TREE_DIFFREQUEST_OPEN_FILEFILE_CHUNKFILE_SAVED"
+    "REQUEST_RUN_CODERUN_OUTPUT_CHUNKRUN_OUTPUT_RESULTERROR_NOTIFICATIONCANVAS_SNAPSHOTDRAW_COMMAND"
+    "\"username\":\"\"user_id\":\"User_"
+    "\"stroke_id\":\"points\":[\"stroke_width\":2,\"color\":\"#000000\"\"originator_id\":\"User_\"type\":\"DRAW_POLYLINE\""
+    "\"content\":\"\"operation\":[\"file_path\":\"src/main.cpp\",\"revision\":\"type\":\"TEXT_OPERATION_ACK\""
+    "\"type\":\"UPDATE_TEXT_EDIT\"\"type\":\"TEXT_OPERATION\",\"version\":\"1.0\"}"
+    "{\"id\":0,\"payload\":{\"file_path\":\"\",\"originator_id\":\"User_\",\"revision\":},\"seq\":";
+
+  // Reused by every frame compressed on this thread (deflateInit allocates ~256 KiB)
+  struct Deflater {
+    z_stream stream {};
+    bool ok = false;
+    Deflater() { ok = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK; }
+    ~Deflater() { if(ok) deflateEnd(&stream); }
+  };
+
+  struct Inflater {
+    z_stream stream {};
+    bool ok = false;
+    Inflater() { ok = inflateInit2(&stream, -MAX_WBITS) == Z_OK; }
+    ~Inflater() { if(ok) inflateEnd(&stream); }
+  };
+}
+
+QByteArrayView FrameCompressor::dictionary(){
+  return QByteArrayView(c_dictionary, qsizetype(sizeof(c_dictionary) - 1));
+}
+
+QByteArray FrameCompressor::compressFrame(const QByteArray &frame, t_Compression compression){
+  const qsizetype payloadSize = frame.size() - FrameDecoder::c_headerSize;
+  if(compression == t_Compression::NONE || payloadSize < c_minPayloadSize) return frame;
+
+  thread_local Deflater deflater;
+  if(!deflater.ok || deflateReset(&deflater.stream) != Z_OK) return frame;
+  if(compression == t_Compression::DEFLATE_DICTIONARY) {
+    const QByteArrayView dict = dictionary();
+    deflateSetDictionary(&deflater.stream, reinterpret_cast<const Bytef*>(dict.data()), uInt(dict.size()));
+  }
+
+  // Not worth it unless it saves something, so output never needs more than the input
+  const qsizetype prefix = FrameDecoder::c_headerSize + c_sizeHeader;
+  QByteArray out = FrameBufferPool::acquire(frame.size());
+  out.resize(frame.size());
+  z_stream &stream = deflater.stream;
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(frame.constData() + FrameDecoder::c_headerSize));
+  stream.avail_in = uInt(payloadSize);
+  stream.next_out = reinterpret_cast<Bytef*>(out.data() + prefix);
+  stream.avail_out = uInt(out.size() - prefix);
+  if(deflate(&stream, Z_FINISH) != Z_STREAM_END) { // Ran out of room -> didn't pay off
+    FrameBufferPool::release(std::move(out));
+    return frame;
+  }
+
+  out.resize(prefix + qsizetype(stream.total_out));
+  qToBigEndian<quint32>(quint32(out.size() - FrameDecoder::c_headerSize) | c_compressedFlag, out.data());
+  qToBigEndian<quint32>(quint32(payloadSize), out.data() + FrameDecoder::c_headerSize);
+  return out;
+}
+
+bool FrameCompressor::decompress(QByteArrayView payload, t_Compression compression, quint32 maxSize, QByteArray &out){
+  if(compression == t_Compression::NONE || payload.size() < c_sizeHeader) return false;
+  const quint32 size = qFromBigEndian<quint32>(payload.data());
+  if(size > maxSize) return false;
+
+  thread_local Inflater inflater;
+  if(!inflater.ok || inflateReset(&inflater.stream) != Z_OK) return false;
+  z_stream &stream = inflater.stream;
+  if(compression == t_Compression::DEFLATE_DICTIONARY) {
+    const QByteArrayView dict = dictionary();
+    if(inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dict.data()), uInt(dict.size())) != Z_OK) return false;
+  }
+
+  out.resize(size);
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(payload.data() + c_sizeHeader));
+  stream.avail_in = uInt(payload.size() - c_sizeHeader);
+  stream.next_out = reinterpret_cast<Bytef*>(out.data());
+  stream.avail_out = uInt(size);
+  // Must end exactly at the announced size
+  return inflate(&stream, Z_FINISH) == Z_STREAM_END && stream.total_out == size;
+}
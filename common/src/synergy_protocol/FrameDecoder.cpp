@@ -0,0 +1,125 @@
+#include "../../include/synergy_protocol/FrameDecoder.h"
+#include "../../include/synergy_protocol/FrameCompressor.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace SynergyProtocol;
+
+namespace {
+  qsizetype nextPowerOfTwo(qsizetype value) {
+    qsizetype result = 1;
+    while(result < value) {
+      result <<= 1;
+    }
+    return result;
+  }
+}
+
+FrameDecoder::FrameDecoder(quint32 maxFrameSize, qsizetype initialCapacity) :
+  m_ring(static_cast<size_t>(nextPowerOfTwo(std::max(initialCapacity, c_headerSize)))),
+  m_initialCapacity(capacity()),
+  m_maxFrameSize(maxFrameSize) {
+}
+
+void FrameDecoder::append(const char* data, qsizetype size) {
+  if(m_size + size > capacity()) {
+    resizeRing(m_size + size);
+  }
+  qsizetype tail = (m_head + m_size) & mask();
+  // Free space can wrap around the end of the ring -> at most two copies
+  qsizetype first = std::min(size, capacity() - tail);
+  std::memcpy(m_ring.data() + tail, data, static_cast<size_t>(first));
+  std::memcpy(m_ring.data(), data + first, static_cast<size_t>(size - first));
+  m_size += size;
+}
+
+qint64 FrameDecoder::readFrom(QIODevice* device) {
+  qint64 total = 0;
+  while(m_size < capacity()) {
+    qsizetype tail = (m_head + m_size) & mask();
+    // Contiguous free region starting at tail (stops at ring end or at head)
+    qsizetype contiguous = std::min(capacity() - tail, capacity() - m_size);
+    qint64 got = device->read(m_ring.data() + tail, contiguous);
+    if(got < 0) {
+      return total > 0 ? total : -1;
+    }
+    m_size += got;
+    total += got;
+    if(got < contiguous) {
+      break; // device drained
+    }
+  }
+  return total;
+}
+
+FrameDecoder::t_Status FrameDecoder::nextFrame(QByteArray& frame) {
+  if(m_size < c_headerSize) {
+    if(capacity() > m_initialCapacity) resizeRing(m_initialCapacity); // Oversized frame is gone
+    return t_Status::NEED_MORE_DATA;
+  }
+
+  uchar header[c_headerSize];
+  copyOut(0, reinterpret_cast<char*>(header), c_headerSize);
+  const quint32 prefix = qFromBigEndian<quint32>(header);
+  const bool compressed = (prefix & FrameCompressor::c_compressedFlag) != 0;
+  const quint32 length = prefix & FrameCompressor::c_lengthMask;
+
+  if(compressed && m_compression == t_Compression::NONE) {
+    return t_Status::MALFORMED_FRAME;
+  }
+  if(length > m_maxFrameSize) {
+    return t_Status::FRAME_TOO_LARGE;
+  }
+
+  const qsizetype needed = c_headerSize + static_cast<qsizetype>(length);
+  if(m_size < needed) {
+    if(needed > capacity() && m_size == capacity()) {
+      // Ring is full of this frame: double, capped at the frame, so memory follows bytes received
+      resizeRing(std::min(needed, capacity() * 2));
+    } else if(capacity() > m_initialCapacity && needed <= m_initialCapacity) {
+      resizeRing(m_initialCapacity); // Small frame behind an oversized one
+    }
+    return t_Status::NEED_MORE_DATA;
+  }
+
+  QByteArray &target = compressed ? m_compressed : frame;
+  target.resize(length);
+  copyOut(c_headerSize, target.data(), length);
+  m_head = (m_head + needed) & mask();
+  m_size -= needed;
+  if(m_size == 0) {
+    m_head = 0; // keeps next read contiguous
+  }
+  // Inflated size is checked against the same limit before anything is allocated
+  const bool inflated = !compressed || FrameCompressor::decompress(m_compressed, m_compression, m_maxFrameSize, frame);
+  if(m_compressed.capacity() > m_initialCapacity) m_compressed = QByteArray(); // Same bound as the ring
+  return inflated ? t_Status::FRAME_READY : t_Status::MALFORMED_FRAME;
+}
+
+void FrameDecoder::copyOut(qsizetype offset, char* dest, qsizetype len) const {
+  qsizetype start = (m_head + offset) & mask();
+  qsizetype first = std::min(len, capacity() - start);
+  std::memcpy(dest, m_ring.data() + start, static_cast<size_t>(first));
+  std::memcpy(dest + first, m_ring.data(), static_cast<size_t>(len - first));
+}
+
+void FrameDecoder::resizeRing(qsizetype minCapacity) {
+  std::vector<char> resized(static_cast<size_t>(nextPowerOfTwo(std::max(minCapacity, m_size))));
+  copyOut(0, resized.data(), m_size);
+  m_ring.swap(resized);
+  m_head = 0;
+}
+
+QByteArray FrameDecoder::encodeFrame(const QByteArray& payload) {
+  QByteArray out = FrameBufferPool::acquire(c_headerSize + payload.size());
+  appendFrame(out, payload);
+  return out;
+}
+
+void FrameDecoder::appendFrame(QByteArray& out, const QByteArray& payload) {
+  const qsizetype offset = out.size();
+  out.resize(offset + c_headerSize + payload.size());
+  qToBigEndian<quint32>(static_cast<quint32>(payload.size()), out.data() + offset);
+  std::memcpy(out.data() + offset + c_headerSize, payload.constData(), static_cast<size_t>(payload.size()));
+}
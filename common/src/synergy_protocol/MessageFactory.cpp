@@ -2,41 +2,100 @@
 
 using namespace SynergyProtocol;
 
+// Creator tables, generated from RegisteredMessages at compile time
+// Registering a new message is adding it to RegisteredMessages, nothing else
+const std::array<MessageFactory::JsonCreateFn, messageTypeIndex(t_MessageType::COUNT)> MessageFactory::c_jsonCreators =
+  MessageFactory::makeTable<MessageFactory::JsonCreateFn>(RegisteredMessages{},
+    []<typename M>(std::type_identity<M>) -> JsonCreateFn { return &createAs<M, QJsonObject>; });
+
+const std::array<MessageFactory::CborCreateFn, messageTypeIndex(t_MessageType::COUNT)> MessageFactory::c_cborCreators =
+  MessageFactory::makeTable<MessageFactory::CborCreateFn>(RegisteredMessages{},
+    []<typename M>(std::type_identity<M>) -> CborCreateFn { return &createAs<M, QCborMap>; });
+
+t_MessageType MessageFactory::typeOf(const QJsonObject& jsonObject) {
+  const QJsonValue typeValue = jsonObject.value(QLatin1StringView("type"));
+  if(!typeValue.isString()) {
+    return t_MessageType::UNKNOWN;
+  }
+  return stringToMessageType(typeValue.toString());
+}
+
+t_MessageType MessageFactory::typeOf(const QCborMap& cborMap) {
+  const QCborValue typeValue = cborMap.value(Message_Base::CBOR_KEY_TYPE);
+  if(!typeValue.isInteger()) {
+    return t_MessageType::UNKNOWN;
+  }
+  return intToMessageType(typeValue.toInteger());
+}
+
 std::unique_ptr<Message_Base> MessageFactory::createMessage(const QJsonObject& jsonObject) const {
   if(!jsonObject.contains("type") || !jsonObject["type"].isString()) {
     qCritical() << "MESSAGE FACTORY | JSON missing 'type' string";
     return nullptr;
   }
 
-  QString messageTypeStr = jsonObject["type"].toString();
-  if(m_creators.contains(messageTypeStr)) {
-    // We create empty object using registered function
-    std::unique_ptr<Message_Base> message = m_creators[messageTypeStr]();
-
-    // Populate it using its virtual fromJson method
-    if(message && message->fromJson(jsonObject)){
-      // created and parsed
-      return message; // ownership transfered via unique_ptr
-    } else {
-      qCritical() << "MESSAGE FACTORY | Failed to parse JSON for type" << messageTypeStr;
-      return nullptr;
-    }
-  } else {
+  const t_MessageType type = typeOf(jsonObject);
+  const JsonCreateFn creator = c_jsonCreators[messageTypeIndex(type)];
+  if(!creator) {
     qCritical() << "MESSAGE FACTORY | Unknown message type encountered";
     return nullptr;
   }
+
+  // Creates object of the concrete type and parses payload on it directly
+  std::unique_ptr<Message_Base> message = creator(jsonObject);
+  if(!message) {
+    qCritical() << "MESSAGE FACTORY | Failed to parse JSON for type" << messageTypeToString(type);
+  }
+  return message; // ownership transfered via unique_ptr
 }
 
-// We map type string to function that creates the corresponding C++ object
-void MessageFactory::registerMessages() {
-  m_creators.insert(messageTypeToString(t_MessageType::JOIN_SESSION_REQUEST),
-                    []() { return std::make_unique<Message_Join_Session_Request>(); });
+std::unique_ptr<Message_Base> MessageFactory::createMessage(const QCborMap& cborMap) const {
+  if(!cborMap.value(Message_Base::CBOR_KEY_TYPE).isInteger()) {
+    qCritical() << "MESSAGE FACTORY | CBOR missing integer 'type'";
+    return nullptr;
+  }
 
-  
-  // m_creators.insert(messageTypeToString(t_MessageType::TEXT_EDIT),
-  //                   []() { return std::make_unique<Message_Text_Edit>(); });
+  const t_MessageType type = typeOf(cborMap);
+  const CborCreateFn creator = c_cborCreators[messageTypeIndex(type)];
+  if(!creator) {
+    qCritical() << "MESSAGE FACTORY | Unknown message type encountered";
+    return nullptr;
+  }
+
+  std::unique_ptr<Message_Base> message = creator(cborMap);
+  if(!message) {
+    qCritical() << "MESSAGE FACTORY | Failed to parse CBOR for type" << messageTypeToString(type);
+  }
+  return message;
+}
+
+bool MessageFactory::parseJson(const QByteArray& payload, QJsonObject& object) {
+  QJsonParseError error;
+  QJsonDocument document = QJsonDocument::fromJson(payload, &error);
+  if(document.isNull() || !document.isObject()) {
+    qCritical() << "MESSAGE FACTORY | Invalid JSON frame:" << error.errorString();
+    return false;
+  }
+  object = document.object();
+  return true;
+}
 
-  // ... register ALL further message types here ...
+bool MessageFactory::parseCbor(const QByteArray& payload, QCborMap& map) {
+  QCborParserError error;
+  QCborValue value = QCborValue::fromCbor(payload, &error);
+  if(error.error != QCborError::NoError || !value.isMap()) {
+    qCritical() << "MESSAGE FACTORY | Invalid CBOR frame:" << error.errorString();
+    return false;
+  }
+  map = value.toMap();
+  return true;
+}
 
-  qInfo() << "MessageFactory: Registered" << m_creators.count() << "message types.";
-}
\ No newline at end of file
+std::unique_ptr<Message_Base> MessageFactory::decode(const QByteArray& payload, t_WireFormat format) const {
+  if(format == t_WireFormat::CBOR) {
+    QCborMap map;
+    return parseCbor(payload, map) ? createMessage(map) : nullptr;
+  }
+  QJsonObject object;
+  return parseJson(payload, object) ? createMessage(object) : nullptr;
+}
@@ -0,0 +1,161 @@
+#include "../../include/synergy_protocol/MessagePool.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <new>
+#include <vector>
+
+using namespace SynergyProtocol;
+
+namespace {
+  constexpr int c_minClassBits = 6; // 64 bytes
+  constexpr int c_classCount = std::bit_width(MessagePool::c_maxBlockSize) - c_minClassBits; // 64, 128, 256, 512, 1024
+
+  constexpr std::size_t classSize(int sizeClass) {
+    return std::size_t(1) << (sizeClass + c_minClassBits);
+  }
+
+  // -1 when too big to pool
+  int classOf(std::size_t size) {
+    if(size > MessagePool::c_maxBlockSize) return -1;
+    if(size <= classSize(0)) return 0;
+    return std::bit_width(size - 1) - c_minClassBits;
+  }
+
+  // In front of every block, stays valid while the block is free
+  struct alignas(MessagePool::c_alignment) Header {
+    MessagePool::Cache *owner;
+    int sizeClass;
+  };
+  constexpr std::size_t c_headerSize = sizeof(Header);
+  static_assert(c_headerSize == MessagePool::c_alignment);
+
+  // Overlays the user part of a free block
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  Header* headerOf(void *pointer) {
+    return reinterpret_cast<Header*>(static_cast<char*>(pointer) - c_headerSize);
+  }
+}
+
+struct MessagePool::Cache {
+  struct SizeClass {
+    FreeBlock *free = nullptr; // Owner only
+    int count = 0;
+    alignas(64) std::atomic<FreeBlock*> returned {nullptr}; // Pushed by other threads
+  };
+  std::array<SizeClass, c_classCount> classes;
+  bool inUse = false; // Guarded by registry mutex
+};
+
+namespace {
+  struct Registry {
+    QMutex mutex;
+    std::vector<MessagePool::Cache*> caches;
+
+    MessagePool::Cache* acquire(){
+      QMutexLocker lock(&mutex);
+      for(MessagePool::Cache *cache : caches) {
+        if(!cache->inUse) {
+          cache->inUse = true;
+          return cache;
+        }
+      }
+      caches.push_back(new MessagePool::Cache);
+      caches.back()->inUse = true;
+      return caches.back();
+    }
+
+    void release(MessagePool::Cache *cache){
+      QMutexLocker lock(&mutex);
+      cache->inUse = false;
+    }
+  };
+
+  // Never destroyed, like the caches: blocks may be freed while static objects go away at exit
+  Registry& registry(){
+    static Registry *instance = new Registry;
+    return *instance;
+  }
+
+  // Returns its cache, free blocks included, to the registry when the thread ends
+  struct CacheLease {
+    MessagePool::Cache *cache = registry().acquire();
+    ~CacheLease() { registry().release(cache); }
+  };
+
+  MessagePool::Cache& localCache(){
+    thread_local CacheLease lease;
+    return *lease.cache;
+  }
+
+  void freeBlock(FreeBlock *block){
+    ::operator delete(headerOf(block));
+  }
+}
+
+void* MessagePool::allocate(std::size_t size){
+  const int sizeClass = classOf(size);
+  if(sizeClass < 0) return ::operator new(size);
+
+  Cache &cache = localCache();
+  Cache::SizeClass &local = cache.classes[static_cast<std::size_t>(sizeClass)];
+  if(!local.free) {
+    // Take back everything other threads returned; keeps the list within its cap
+    FreeBlock *returned = local.returned.exchange(nullptr, std::memory_order_acquire);
+    while(returned) {
+      FreeBlock *next = returned->next;
+      if(local.count < c_maxCachedBlocks) {
+        returned->next = local.free;
+        local.free = returned;
+        ++local.count;
+      } else {
+        freeBlock(returned);
+      }
+      returned = next;
+    }
+  }
+  if(FreeBlock *block = local.free) {
+    local.free = block->next;
+    --local.count;
+    return block;
+  }
+
+  void *raw = ::operator new(c_headerSize + classSize(sizeClass));
+  new (raw) Header{&cache, sizeClass};
+  return static_cast<char*>(raw) + c_headerSize;
+}
+
+void MessagePool::deallocate(void *pointer, std::size_t size) noexcept {
+  if(!pointer) return;
+  if(classOf(size) < 0) {
+    ::operator delete(pointer);
+    return;
+  }
+
+  const Header *header = headerOf(pointer);
+  Cache::SizeClass &owner = header->owner->classes[static_cast<std::size_t>(header->sizeClass)];
+  FreeBlock *block = new (pointer) FreeBlock{nullptr};
+  if(header->owner == &localCache()) {
+    if(owner.count >= c_maxCachedBlocks) {
+      freeBlock(block);
+      return;
+    }
+    block->next = owner.free;
+    owner.free = block;
+    ++owner.count;
+    return;
+  }
+
+  // Another thread's block: back to its owner, picked up on its next empty free list
+  FreeBlock *head = owner.returned.load(std::memory_order_relaxed);
+  do {
+    block->next = head;
+  } while(!owner.returned.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+}
@@ -1,3 +1,86 @@
 #include "../../include/synergy_protocol/Message_Base.h"
+#include "../../include/synergy_protocol/FrameDecoder.h"
+#include "../../include/synergy_protocol/FrameBufferPool.h"
 
-using namespace SynergyProtocol;
\ No newline at end of file
+#include <limits>
+
+using namespace SynergyProtocol;
+
+void Message_Base::toCbor(QCborStreamWriter& writer, quint64 sequence) const {
+  writer.startMap(sequence != 0 ? 5 : 4);
+  writer.append(qint64(CBOR_KEY_VERSION));
+  writer.append(qint64(m_version));
+  writer.append(qint64(CBOR_KEY_TYPE));
+  writer.append(qint64(type()));
+  writer.append(qint64(CBOR_KEY_ID));
+  writer.append(qint64(m_id));
+  if(sequence != 0) {
+    writer.append(qint64(CBOR_KEY_SEQUENCE));
+    writer.append(sequence);
+  }
+  writer.append(qint64(CBOR_KEY_PAYLOAD));
+  payloadToCbor(writer); // delegate payload creation
+  writer.endMap();
+}
+
+QByteArray Message_Base::encode(SynergyProtocol::t_WireFormat format, quint64 sequence) const {
+  if(format == t_WireFormat::CBOR) {
+    QByteArray out;
+    QCborStreamWriter writer(&out);
+    toCbor(writer, sequence);
+    return out;
+  }
+  return QJsonDocument(toJSon(sequence)).toJson(QJsonDocument::Compact);
+}
+
+QByteArray Message_Base::encodeFrame(SynergyProtocol::t_WireFormat format, quint64 sequence) const {
+  if(format == t_WireFormat::CBOR) {
+    // Size is known only once written, most frames fit the smallest pooled buffers
+    QByteArray out = FrameBufferPool::acquire(2 * FrameBufferPool::c_minCapacity);
+    out.resize(FrameDecoder::c_headerSize);
+    {
+      QCborStreamWriter writer(&out); // appends after the reserved header
+      toCbor(writer, sequence);
+    }
+    qToBigEndian<quint32>(static_cast<quint32>(out.size() - FrameDecoder::c_headerSize), out.data());
+    return out;
+  }
+  return FrameDecoder::encodeFrame(encode(format, sequence));
+}
+
+bool Message_Base::headerFromCbor(const QCborMap& map, QCborMap& payload) {
+  const QCborValue version = map.value(CBOR_KEY_VERSION);
+  if(!version.isInteger()) {
+    qCritical() << "BASE MESAGE | CBOR message missing version";
+    return false;
+  }
+  if(!map.value(CBOR_KEY_TYPE).isInteger()) {
+    qCritical() << "BASE MESAGE | CBOR message missing type";
+    return false;
+  }
+  const QCborValue id = map.value(CBOR_KEY_ID);
+  if(!id.isInteger()) {
+    qCritical() << "BASE MESAGE | CBOR message missing id";
+    return false;
+  }
+  const QCborValue payloadValue = map.value(CBOR_KEY_PAYLOAD);
+  if(!payloadValue.isMap()) {
+    qCritical() << "BASE MESAGE | CBOR message missing payload map";
+    return false;
+  }
+  m_version = static_cast<t_Versions>(version.toInteger());
+  m_id = static_cast<qintptr>(id.toInteger());
+  m_sequence = quint64(map.value(CBOR_KEY_SEQUENCE).toInteger(0)); // Optional
+
+  payload = payloadValue.toMap();
+  return true;
+}
+
+void Message_Base::appendReal(QCborStreamWriter& writer, double value) {
+  // Out of float range the conversion itself is undefined
+  if(qAbs(value) <= std::numeric_limits<float>::max() && double(float(value)) == value) {
+    writer.append(float(value));
+  } else {
+    writer.append(value);
+  }
+}
@@ -0,0 +1,87 @@
+#include "../../include/synergy_protocol/Message_Canvas_Snapshot.h"
+
+#include <QJsonArray>
+#include <QCborArray>
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Canvas_Snapshot::payloadToJson() const {
+  QJsonArray tiles;
+  for(const Tile &tile : m_tiles) {
+    tiles.append(QJsonObject {
+      {"x", tile.x},
+      {"y", tile.y},
+      {"png", QString::fromLatin1(tile.png.toBase64())}
+    });
+  }
+  QJsonObject payload;
+  payload.insert("tile_size", m_tile_size);
+  payload.insert("tiles", tiles);
+  return payload;
+}
+
+bool Message_Canvas_Snapshot::payloadFromJson(const QJsonObject& payloadObj) {
+  const int tileSize = payloadObj.value("tile_size").toInt(0);
+  if(tileSize <= 0) {
+    qCritical() << "CANVAS_SNAPSHOT | Payload missing or invalid 'tile_size'.";
+    return false;
+  }
+  if(!payloadObj.value("tiles").isArray()) {
+    qCritical() << "CANVAS_SNAPSHOT | Payload missing or invalid 'tiles'.";
+    return false;
+  }
+  QList<Tile> tiles;
+  for(const QJsonValue &value : payloadObj.value("tiles").toArray()) {
+    const QJsonObject entry = value.toObject();
+    if(!entry.value("x").isDouble() || !entry.value("y").isDouble() || !entry.value("png").isString()) {
+      qCritical() << "CANVAS_SNAPSHOT | Invalid tile entry.";
+      return false;
+    }
+    tiles.append(Tile {entry.value("x").toInt(), entry.value("y").toInt(), QByteArray::fromBase64(entry.value("png").toString().toLatin1())});
+  }
+  m_tile_size = tileSize;
+  m_tiles = std::move(tiles);
+  return true;
+}
+
+void Message_Canvas_Snapshot::payloadToCbor(QCborStreamWriter& writer) const {
+  writer.startMap(2);
+  writer.append(qint64(CBOR_TILE_SIZE));
+  writer.append(qint64(m_tile_size));
+  writer.append(qint64(CBOR_TILES));
+  writer.startArray(quint64(m_tiles.size()));
+  for(const Tile &tile : m_tiles) {
+    writer.startArray(3);
+    writer.append(qint64(tile.x));
+    writer.append(qint64(tile.y));
+    writer.append(tile.png);
+    writer.endArray();
+  }
+  writer.endArray();
+  writer.endMap();
+}
+
+bool Message_Canvas_Snapshot::payloadFromCbor(const QCborMap& payloadMap) {
+  const QCborValue tileSize = payloadMap.value(CBOR_TILE_SIZE);
+  const QCborValue tiles = payloadMap.value(CBOR_TILES);
+  if(!tileSize.isInteger() || tileSize.toInteger() <= 0) {
+    qCritical() << "CANVAS_SNAPSHOT | CBOR payload missing or invalid tile size.";
+    return false;
+  }
+  if(!tiles.isArray()) {
+    qCritical() << "CANVAS_SNAPSHOT | CBOR payload missing tiles.";
+    return false;
+  }
+  QList<Tile> decoded;
+  for(const QCborValue &value : tiles.toArray()) {
+    const QCborArray entry = value.toArray();
+    if(entry.size() != 3 || !entry.at(0).isInteger() || !entry.at(1).isInteger() || !entry.at(2).isByteArray()) {
+      qCritical() << "CANVAS_SNAPSHOT | Invalid CBOR tile entry.";
+      return false;
+    }
+    decoded.append(Tile {qint32(entry.at(0).toInteger()), qint32(entry.at(1).toInteger()), entry.at(2).toByteArray()});
+  }
+  m_tile_size = int(tileSize.toInteger());
+  m_tiles = std::move(decoded);
+  return true;
+}
@@ -0,0 +1,58 @@
+#include "../../include/synergy_protocol/Message_Client_Hello.h"
+
+#include <QJsonArray>
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Client_Hello::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("protocol_version", versionTypeToString(m_version));
+  QJsonArray formats;
+  for(t_WireFormat format : m_wire_formats) {
+    formats.append(wireFormatToString(format));
+  }
+  payload.insert("wire_formats", formats);
+  QJsonArray compressions;
+  for(t_Compression compression : m_compressions) {
+    compressions.append(compressionToString(compression));
+  }
+  payload.insert("compressions", compressions);
+  return payload;
+}
+
+bool Message_Client_Hello::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.contains("protocol_version") || !payloadObj.value("protocol_version").isString()) {
+    qCritical() << "CLIENT_HELLO | Payload missing or invalid 'protocol_version'.";
+    return false;
+  }
+  m_version = stringToVersionType(payloadObj.value("protocol_version").toString());
+
+  // Older clients don't send the list -> they don't compress
+  m_compressions.clear();
+  if(payloadObj.value("compressions").isArray()) {
+    for(const QJsonValue& value : payloadObj.value("compressions").toArray()) {
+      bool known = false;
+      t_Compression compression = stringToCompression(value.toString(), &known);
+      if(known) m_compressions.append(compression);
+    }
+  }
+
+  m_wire_formats.clear();
+  // Older clients don't send the list -> they only speak JSON
+  if(!payloadObj.contains("wire_formats")) {
+    m_wire_formats.append(t_WireFormat::JSON);
+    return true;
+  }
+  if(!payloadObj.value("wire_formats").isArray()) {
+    qCritical() << "CLIENT_HELLO | 'wire_formats' needs to be an array of strings.";
+    return false;
+  }
+  const QJsonArray formats = payloadObj.value("wire_formats").toArray();
+  for(const QJsonValue& value : formats) {
+    bool known = false;
+    t_WireFormat format = stringToWireFormat(value.toString(), &known);
+    // Unknown formats are skipped, they might come from a newer client
+    if(known) m_wire_formats.append(format);
+  }
+  return true;
+}
@@ -0,0 +1,93 @@
+#include "../../include/synergy_protocol/Message_Draw_Command.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Draw_Command::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("shape", m_shape);
+  payload.insert("start_x", m_start_x);
+  payload.insert("start_y", m_start_y);
+  payload.insert("end_x", m_end_x);
+  payload.insert("end_y", m_end_y);
+  payload.insert("color", m_color);
+  payload.insert("stroke_width", m_stroke_width);
+  if(!m_originator_id.isEmpty()) {
+    payload.insert("originator_id", m_originator_id);
+  }
+  return payload;
+}
+
+bool Message_Draw_Command::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("shape").isString()) {
+    qCritical() << "DRAW_COMMAND | Payload missing or invalid 'shape'.";
+    return false;
+  }
+  for(const char* key : {"start_x", "start_y", "end_x", "end_y"}) {
+    if(!payloadObj.value(QLatin1StringView(key)).isDouble()) {
+      qCritical() << "DRAW_COMMAND | Payload missing or invalid" << key;
+      return false;
+    }
+  }
+  if(!payloadObj.value("color").isString()) {
+    qCritical() << "DRAW_COMMAND | Payload missing or invalid 'color'.";
+    return false;
+  }
+  m_shape = payloadObj.value("shape").toString();
+  m_start_x = payloadObj.value("start_x").toDouble();
+  m_start_y = payloadObj.value("start_y").toDouble();
+  m_end_x = payloadObj.value("end_x").toDouble();
+  m_end_y = payloadObj.value("end_y").toDouble();
+  m_color = payloadObj.value("color").toString();
+  m_stroke_width = payloadObj.value("stroke_width").toDouble(c_defaultStrokeWidth); // Optional
+  m_originator_id = payloadObj.value("originator_id").toString();
+  return true;
+}
+
+void Message_Draw_Command::payloadToCbor(QCborStreamWriter& writer) const {
+  writer.startMap(m_originator_id.isEmpty() ? 7 : 8);
+  writer.append(qint64(CBOR_SHAPE));
+  writer.append(m_shape);
+  // Coordinates are canvas pixels, mostly whole: 4 bytes each, but never rounded
+  writer.append(qint64(CBOR_START_X));
+  appendReal(writer, m_start_x);
+  writer.append(qint64(CBOR_START_Y));
+  appendReal(writer, m_start_y);
+  writer.append(qint64(CBOR_END_X));
+  appendReal(writer, m_end_x);
+  writer.append(qint64(CBOR_END_Y));
+  appendReal(writer, m_end_y);
+  writer.append(qint64(CBOR_COLOR));
+  writer.append(m_color);
+  writer.append(qint64(CBOR_STROKE_WIDTH));
+  appendReal(writer, m_stroke_width);
+  if(!m_originator_id.isEmpty()) {
+    writer.append(qint64(CBOR_ORIGINATOR_ID));
+    writer.append(m_originator_id);
+  }
+  writer.endMap();
+}
+
+bool Message_Draw_Command::payloadFromCbor(const QCborMap& payloadMap) {
+  const QCborValue shape = payloadMap.value(CBOR_SHAPE);
+  const QCborValue color = payloadMap.value(CBOR_COLOR);
+  if(!shape.isString() || !color.isString()) {
+    qCritical() << "DRAW_COMMAND | CBOR payload missing shape or color.";
+    return false;
+  }
+  for(qint64 key : {qint64(CBOR_START_X), qint64(CBOR_START_Y), qint64(CBOR_END_X), qint64(CBOR_END_Y)}) {
+    const QCborValue coordinate = payloadMap.value(key);
+    if(!coordinate.isDouble() && !coordinate.isInteger()) {
+      qCritical() << "DRAW_COMMAND | CBOR payload missing coordinate" << key;
+      return false;
+    }
+  }
+  m_shape = shape.toString();
+  m_start_x = payloadMap.value(CBOR_START_X).toDouble();
+  m_start_y = payloadMap.value(CBOR_START_Y).toDouble();
+  m_end_x = payloadMap.value(CBOR_END_X).toDouble();
+  m_end_y = payloadMap.value(CBOR_END_Y).toDouble();
+  m_color = color.toString();
+  m_stroke_width = payloadMap.value(CBOR_STROKE_WIDTH).toDouble(c_defaultStrokeWidth);
+  m_originator_id = payloadMap.value(CBOR_ORIGINATOR_ID).toString();
+  return true;
+}
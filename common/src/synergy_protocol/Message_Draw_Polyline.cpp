@@ -0,0 +1,103 @@
+#include "../../include/synergy_protocol/Message_Draw_Polyline.h"
+
+#include <QJsonArray>
+#include <QCborArray>
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Draw_Polyline::payloadToJson() const {
+  QJsonArray points;
+  for(const QPointF &point : m_points) {
+    points.append(point.x());
+    points.append(point.y());
+  }
+  QJsonObject payload;
+  payload.insert("stroke_id", qint64(m_stroke_id));
+  payload.insert("points", points);
+  payload.insert("color", m_color);
+  payload.insert("stroke_width", m_stroke_width);
+  if(!m_originator_id.isEmpty()) {
+    payload.insert("originator_id", m_originator_id);
+  }
+  return payload;
+}
+
+bool Message_Draw_Polyline::payloadFromJson(const QJsonObject& payloadObj) {
+  const QJsonArray points = payloadObj.value("points").toArray();
+  if(points.isEmpty() || points.size() % 2 != 0 || points.size() / 2 > c_maxPoints) {
+    qCritical() << "DRAW_POLYLINE | Payload missing or invalid 'points'.";
+    return false;
+  }
+  if(!payloadObj.value("color").isString()) {
+    qCritical() << "DRAW_POLYLINE | Payload missing or invalid 'color'.";
+    return false;
+  }
+  QList<QPointF> decoded;
+  decoded.reserve(points.size() / 2);
+  for(qsizetype i = 0; i < points.size(); i += 2) {
+    if(!points.at(i).isDouble() || !points.at(i + 1).isDouble()) {
+      qCritical() << "DRAW_POLYLINE | Non-numeric coordinate at" << i;
+      return false;
+    }
+    decoded.append(QPointF(points.at(i).toDouble(), points.at(i + 1).toDouble()));
+  }
+  m_stroke_id = quint64(payloadObj.value("stroke_id").toInteger());
+  m_points = std::move(decoded);
+  m_color = payloadObj.value("color").toString();
+  m_stroke_width = payloadObj.value("stroke_width").toDouble(1.0);
+  m_originator_id = payloadObj.value("originator_id").toString();
+  return true;
+}
+
+void Message_Draw_Polyline::payloadToCbor(QCborStreamWriter& writer) const {
+  writer.startMap(m_originator_id.isEmpty() ? 4 : 5);
+  writer.append(qint64(CBOR_STROKE_ID));
+  writer.append(m_stroke_id);
+  // Same encoding as DRAW_COMMAND coordinates: float when exact, double otherwise
+  writer.append(qint64(CBOR_POINTS));
+  writer.startArray(quint64(m_points.size()) * 2);
+  for(const QPointF &point : m_points) {
+    appendReal(writer, point.x());
+    appendReal(writer, point.y());
+  }
+  writer.endArray();
+  writer.append(qint64(CBOR_COLOR));
+  writer.append(m_color);
+  writer.append(qint64(CBOR_STROKE_WIDTH));
+  appendReal(writer, m_stroke_width);
+  if(!m_originator_id.isEmpty()) {
+    writer.append(qint64(CBOR_ORIGINATOR_ID));
+    writer.append(m_originator_id);
+  }
+  writer.endMap();
+}
+
+bool Message_Draw_Polyline::payloadFromCbor(const QCborMap& payloadMap) {
+  const QCborArray points = payloadMap.value(CBOR_POINTS).toArray();
+  const QCborValue color = payloadMap.value(CBOR_COLOR);
+  if(points.isEmpty() || points.size() % 2 != 0 || points.size() / 2 > c_maxPoints) {
+    qCritical() << "DRAW_POLYLINE | CBOR payload missing or invalid points.";
+    return false;
+  }
+  if(!color.isString()) {
+    qCritical() << "DRAW_POLYLINE | CBOR payload missing color.";
+    return false;
+  }
+  QList<QPointF> decoded;
+  decoded.reserve(points.size() / 2);
+  for(qsizetype i = 0; i < points.size(); i += 2) {
+    const QCborValue x = points.at(i);
+    const QCborValue y = points.at(i + 1);
+    if((!x.isDouble() && !x.isInteger()) || (!y.isDouble() && !y.isInteger())) {
+      qCritical() << "DRAW_POLYLINE | CBOR non-numeric coordinate at" << i;
+      return false;
+    }
+    decoded.append(QPointF(x.toDouble(), y.toDouble()));
+  }
+  m_stroke_id = quint64(payloadMap.value(CBOR_STROKE_ID).toInteger());
+  m_points = std::move(decoded);
+  m_color = color.toString();
+  m_stroke_width = payloadMap.value(CBOR_STROKE_WIDTH).toDouble(1.0);
+  m_originator_id = payloadMap.value(CBOR_ORIGINATOR_ID).toString();
+  return true;
+}
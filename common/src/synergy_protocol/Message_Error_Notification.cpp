@@ -0,0 +1,34 @@
+#include "../../include/synergy_protocol/Message_Error_Notification.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Error_Notification::payloadToJson() const {
+  QJsonObject payload;
+  if(m_code != UNSPECIFIED) {
+    payload.insert("code", m_code);
+  }
+  payload.insert("message", m_message);
+  if(!m_context.isEmpty()) {
+    payload.insert("context", m_context);
+  }
+  return payload;
+}
+
+bool Message_Error_Notification::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("message").isString()) {
+    qCritical() << "ERROR_NOTIFICATION | Payload missing or invalid 'message'.";
+    return false;
+  }
+  if(payloadObj.contains("code") && !payloadObj.value("code").isDouble()) {
+    qCritical() << "ERROR_NOTIFICATION | Invalid 'code'.";
+    return false;
+  }
+  if(payloadObj.contains("context") && !payloadObj.value("context").isObject()) {
+    qCritical() << "ERROR_NOTIFICATION | Invalid 'context'.";
+    return false;
+  }
+  m_code = payloadObj.value("code").toInt(UNSPECIFIED);
+  m_message = payloadObj.value("message").toString();
+  m_context = payloadObj.value("context").toObject();
+  return true;
+}
@@ -0,0 +1,73 @@
+#include "../../include/synergy_protocol/Message_File_Chunk.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_File_Chunk::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("transfer_id", qint64(m_transfer_id));
+  payload.insert("file_path", m_file_path);
+  payload.insert("revision", qint64(m_revision));
+  payload.insert("offset", m_offset);
+  payload.insert("total_size", m_total_size);
+  payload.insert("data", QString::fromLatin1(m_data.toBase64()));
+  return payload;
+}
+
+bool Message_File_Chunk::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("file_path").isString()) {
+    qCritical() << "FILE_CHUNK | Payload missing or invalid 'file_path'.";
+    return false;
+  }
+  if(!payloadObj.value("data").isString()) {
+    qCritical() << "FILE_CHUNK | Payload missing or invalid 'data'.";
+    return false;
+  }
+  m_transfer_id = quint64(payloadObj.value("transfer_id").toInteger(0));
+  m_file_path = payloadObj.value("file_path").toString();
+  m_revision = quint64(payloadObj.value("revision").toInteger(0));
+  m_offset = payloadObj.value("offset").toInteger(-1);
+  m_total_size = payloadObj.value("total_size").toInteger(-1);
+  m_data = QByteArray::fromBase64(payloadObj.value("data").toString().toLatin1());
+  return validate();
+}
+
+void Message_File_Chunk::payloadToCbor(QCborStreamWriter& writer) const {
+  writer.startMap(6);
+  writer.append(qint64(CBOR_TRANSFER_ID));
+  writer.append(m_transfer_id);
+  writer.append(qint64(CBOR_FILE_PATH));
+  writer.append(m_file_path);
+  writer.append(qint64(CBOR_REVISION));
+  writer.append(m_revision);
+  writer.append(qint64(CBOR_OFFSET));
+  writer.append(m_offset);
+  writer.append(qint64(CBOR_TOTAL_SIZE));
+  writer.append(m_total_size);
+  writer.append(qint64(CBOR_DATA));
+  writer.appendByteString(m_data.constData(), m_data.size()); // Straight from mapped memory into the frame
+  writer.endMap();
+}
+
+bool Message_File_Chunk::payloadFromCbor(const QCborMap& payloadMap) {
+  const QCborValue filePath = payloadMap.value(CBOR_FILE_PATH);
+  const QCborValue data = payloadMap.value(CBOR_DATA);
+  if(!filePath.isString() || !data.isByteArray()) {
+    qCritical() << "FILE_CHUNK | CBOR payload missing file path or data.";
+    return false;
+  }
+  m_transfer_id = quint64(payloadMap.value(CBOR_TRANSFER_ID).toInteger(0));
+  m_file_path = filePath.toString();
+  m_revision = quint64(payloadMap.value(CBOR_REVISION).toInteger(0));
+  m_offset = payloadMap.value(CBOR_OFFSET).toInteger(-1);
+  m_total_size = payloadMap.value(CBOR_TOTAL_SIZE).toInteger(-1);
+  m_data = data.toByteArray();
+  return validate();
+}
+
+bool Message_File_Chunk::validate() const {
+  if(m_offset < 0 || m_total_size < 0 || m_offset + m_data.size() > m_total_size) {
+    qCritical() << "FILE_CHUNK | Chunk range outside of file size.";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,24 @@
+#include "../../include/synergy_protocol/Message_File_Saved.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_File_Saved::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("file_path", m_file_path);
+  payload.insert("revision", qint64(m_revision));
+  return payload;
+}
+
+bool Message_File_Saved::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("file_path").isString()) {
+    qCritical() << "FILE_SAVED | Payload missing or invalid 'file_path'.";
+    return false;
+  }
+  if(!payloadObj.value("revision").isDouble() || payloadObj.value("revision").toInteger(-1) < 0) {
+    qCritical() << "FILE_SAVED | Payload missing or invalid 'revision'.";
+    return false;
+  }
+  m_file_path = payloadObj.value("file_path").toString();
+  m_revision = quint64(payloadObj.value("revision").toInteger());
+  return true;
+}
@@ -0,0 +1,50 @@
+#include "../../include/synergy_protocol/Message_File_Tree_Diff.h"
+
+#include <QJsonArray>
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_File_Tree_Diff::payloadToJson() const {
+  QJsonArray added;
+  for(const FileTreeDiff::Entry& entry : m_diff.added) {
+    added.append(QJsonObject{{"path", entry.path}, {"type", entry.isDirectory ? "directory" : "file"}});
+  }
+  QJsonArray renamed;
+  for(const FileTreeDiff::Rename& rename : m_diff.renamed) {
+    renamed.append(QJsonObject{{"from", rename.from}, {"to", rename.to}});
+  }
+
+  QJsonObject payload;
+  payload.insert("added", added);
+  payload.insert("removed", QJsonArray::fromStringList(m_diff.removed));
+  payload.insert("renamed", renamed);
+  return payload;
+}
+
+bool Message_File_Tree_Diff::payloadFromJson(const QJsonObject& payloadObj) {
+  m_diff = FileTreeDiff();
+  for(const QJsonValue& value : payloadObj.value("added").toArray()) {
+    const QJsonObject entry = value.toObject();
+    if(!entry.value("path").isString()) {
+      qCritical() << "FILE_TREE_DIFF | Invalid entry in 'added'.";
+      return false;
+    }
+    m_diff.added.append(FileTreeDiff::Entry{entry.value("path").toString(), entry.value("type").toString() == "directory"});
+  }
+  for(const QJsonValue& value : payloadObj.value("removed").toArray()) {
+    if(!value.isString()) {
+      qCritical() << "FILE_TREE_DIFF | Invalid entry in 'removed'.";
+      return false;
+    }
+    m_diff.removed.append(value.toString());
+  }
+  for(const QJsonValue& value : payloadObj.value("renamed").toArray()) {
+    const QJsonObject rename = value.toObject();
+    if(!rename.value("from").isString() || !rename.value("to").isString()) {
+      qCritical() << "FILE_TREE_DIFF | Invalid entry in 'renamed'.";
+      return false;
+    }
+    m_diff.renamed.append(FileTreeDiff::Rename{rename.value("from").toString(), rename.value("to").toString()});
+  }
+  return true;
+}
@@ -0,0 +1,18 @@
+#include "../../include/synergy_protocol/Message_File_Tree_Update.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_File_Tree_Update::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("tree", m_tree);
+  return payload;
+}
+
+bool Message_File_Tree_Update::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("tree").isObject()) {
+    qCritical() << "FILE_TREE_UPDATE | Payload missing or invalid 'tree'.";
+    return false;
+  }
+  m_tree = payloadObj.value("tree").toObject();
+  return true;
+}
@@ -53,7 +53,7 @@ bool Message_Join_Session_Request::payloadFromJson(const QJsonObject& payloadObj
     }
     m_create_new = true;
   }
-  if(payloadObj["session_id"].isString()) {
+  else if(!payloadObj["session_id"].isString()) {
     qCritical() << "JOIN_SESSION_REQUEST | String needs to be assigned to session_id_to_join";
     return false;
   }
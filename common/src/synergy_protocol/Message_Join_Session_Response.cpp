@@ -0,0 +1,33 @@
+#include "../../include/synergy_protocol/Message_Join_Session_Response.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Join_Session_Response::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("success", m_success);
+  if(m_success) {
+    payload.insert("session_id", m_session_id);
+    payload.insert("user_id", m_user_id);
+    if(!m_resume_token.isEmpty()) payload.insert("resume_token", m_resume_token);
+  } else {
+    payload.insert("error_message", m_error_message);
+  }
+  return payload;
+}
+
+bool Message_Join_Session_Response::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.contains("success") || !payloadObj.value("success").isBool()) {
+    qCritical() << "JOIN_SESSION_RESPONSE | Payload missing or invalid 'success'.";
+    return false;
+  }
+  m_success = payloadObj.value("success").toBool();
+  if(m_success && !payloadObj.value("session_id").isString()) {
+    qCritical() << "JOIN_SESSION_RESPONSE | Successful response needs 'session_id' string.";
+    return false;
+  }
+  m_session_id = payloadObj.value("session_id").toString();
+  m_user_id = payloadObj.value("user_id").toString();
+  m_error_message = payloadObj.value("error_message").toString();
+  m_resume_token = payloadObj.value("resume_token").toString();
+  return true;
+}
@@ -0,0 +1,21 @@
+#include "../../include/synergy_protocol/Message_Ping.h"
+
+#include <limits>
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Ping::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("token", qint64(m_token));
+  return payload;
+}
+
+bool Message_Ping::payloadFromJson(const QJsonObject& payloadObj) {
+  const qint64 token = payloadObj.value("token").toInteger(-1);
+  if(!payloadObj.value("token").isDouble() || token < 0 || token > qint64(std::numeric_limits<quint32>::max())) {
+    qCritical() << "PING | Payload missing or invalid 'token'.";
+    return false;
+  }
+  m_token = quint32(token);
+  return true;
+}
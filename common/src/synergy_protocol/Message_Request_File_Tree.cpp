@@ -0,0 +1,12 @@
+#include "../../include/synergy_protocol/Message_Request_File_Tree.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Request_File_Tree::payloadToJson() const {
+  return QJsonObject();
+}
+
+bool Message_Request_File_Tree::payloadFromJson(const QJsonObject& payloadObj) {
+  Q_UNUSED(payloadObj);
+  return true;
+}
@@ -0,0 +1,18 @@
+#include "../../include/synergy_protocol/Message_Request_Open_File.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Request_Open_File::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("file_path", m_file_path);
+  return payload;
+}
+
+bool Message_Request_Open_File::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("file_path").isString() || payloadObj.value("file_path").toString().isEmpty()) {
+    qCritical() << "REQUEST_OPEN_FILE | Payload missing or invalid 'file_path'.";
+    return false;
+  }
+  m_file_path = payloadObj.value("file_path").toString();
+  return true;
+}
@@ -0,0 +1,42 @@
+#include "../../include/synergy_protocol/Message_Request_Run_Code.h"
+
+#include <QJsonArray>
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Request_Run_Code::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("command", m_command);
+  payload.insert("args", QJsonArray::fromStringList(m_args));
+  if(!m_target_environment.isEmpty()) {
+    payload.insert("target_environment", m_target_environment);
+  }
+  return payload;
+}
+
+bool Message_Request_Run_Code::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("command").isString() || payloadObj.value("command").toString().isEmpty()) {
+    qCritical() << "REQUEST_RUN_CODE | Payload missing or invalid 'command'.";
+    return false;
+  }
+  if(!payloadObj.value("args").isArray()) {
+    qCritical() << "REQUEST_RUN_CODE | Payload missing or invalid 'args'.";
+    return false;
+  }
+  QStringList args;
+  for(const QJsonValue &arg : payloadObj.value("args").toArray()) {
+    if(!arg.isString()) {
+      qCritical() << "REQUEST_RUN_CODE | Non-string entry in 'args'.";
+      return false;
+    }
+    args.append(arg.toString());
+  }
+  if(payloadObj.contains("target_environment") && !payloadObj.value("target_environment").isString()) {
+    qCritical() << "REQUEST_RUN_CODE | Invalid 'target_environment'.";
+    return false;
+  }
+  m_command = payloadObj.value("command").toString();
+  m_args = std::move(args);
+  m_target_environment = payloadObj.value("target_environment").toString();
+  return true;
+}
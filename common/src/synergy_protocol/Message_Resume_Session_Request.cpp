@@ -0,0 +1,26 @@
+#include "../../include/synergy_protocol/Message_Resume_Session_Request.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Resume_Session_Request::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("session_id", m_session_id);
+  payload.insert("resume_token", m_resume_token);
+  payload.insert("last_sequence", qint64(m_last_sequence));
+  return payload;
+}
+
+bool Message_Resume_Session_Request::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("session_id").isString() || !payloadObj.value("resume_token").isString()) {
+    qCritical() << "RESUME_SESSION_REQUEST | Payload missing 'session_id' or 'resume_token'.";
+    return false;
+  }
+  if(!payloadObj.value("last_sequence").isDouble() || payloadObj.value("last_sequence").toInteger(-1) < 0) {
+    qCritical() << "RESUME_SESSION_REQUEST | Payload missing or invalid 'last_sequence'.";
+    return false;
+  }
+  m_session_id = payloadObj.value("session_id").toString();
+  m_resume_token = payloadObj.value("resume_token").toString();
+  m_last_sequence = quint64(payloadObj.value("last_sequence").toInteger());
+  return true;
+}
@@ -0,0 +1,33 @@
+#include "../../include/synergy_protocol/Message_Resume_Session_Response.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Resume_Session_Response::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("success", m_success);
+  if(m_success) {
+    payload.insert("replayed", m_replayed);
+    payload.insert("user_id", m_user_id);
+    payload.insert("resume_token", m_resume_token);
+  } else {
+    payload.insert("error_message", m_error_message);
+  }
+  return payload;
+}
+
+bool Message_Resume_Session_Response::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("success").isBool()) {
+    qCritical() << "RESUME_SESSION_RESPONSE | Payload missing or invalid 'success'.";
+    return false;
+  }
+  m_success = payloadObj.value("success").toBool();
+  if(m_success && (!payloadObj.value("user_id").isString() || !payloadObj.value("resume_token").isString())) {
+    qCritical() << "RESUME_SESSION_RESPONSE | Successful response needs 'user_id' and 'resume_token'.";
+    return false;
+  }
+  m_replayed = payloadObj.value("replayed").toBool(false);
+  m_user_id = payloadObj.value("user_id").toString();
+  m_resume_token = payloadObj.value("resume_token").toString();
+  m_error_message = payloadObj.value("error_message").toString();
+  return true;
+}
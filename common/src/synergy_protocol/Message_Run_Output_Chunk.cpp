@@ -0,0 +1,41 @@
+#include "../../include/synergy_protocol/Message_Run_Output_Chunk.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Run_Output_Chunk::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("run_id", m_run_id);
+  payload.insert("sequence", qint64(m_sequence));
+  payload.insert("stream", m_stream == t_Stream::STDERR ? QStringLiteral("stderr") : QStringLiteral("stdout"));
+  payload.insert("data", m_data);
+  if(m_truncated) {
+    payload.insert("truncated", true);
+  }
+  return payload;
+}
+
+bool Message_Run_Output_Chunk::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("run_id").isString()) {
+    qCritical() << "RUN_OUTPUT_CHUNK | Payload missing or invalid 'run_id'.";
+    return false;
+  }
+  if(!payloadObj.value("sequence").isDouble() || payloadObj.value("sequence").toInteger(-1) < 0) {
+    qCritical() << "RUN_OUTPUT_CHUNK | Payload missing or invalid 'sequence'.";
+    return false;
+  }
+  const QString stream = payloadObj.value("stream").toString();
+  if(stream != QLatin1String("stdout") && stream != QLatin1String("stderr")) {
+    qCritical() << "RUN_OUTPUT_CHUNK | Payload missing or invalid 'stream'.";
+    return false;
+  }
+  if(!payloadObj.value("data").isString()) {
+    qCritical() << "RUN_OUTPUT_CHUNK | Payload missing or invalid 'data'.";
+    return false;
+  }
+  m_run_id = payloadObj.value("run_id").toString();
+  m_sequence = quint64(payloadObj.value("sequence").toInteger());
+  m_stream = stream == QLatin1String("stderr") ? t_Stream::STDERR : t_Stream::STDOUT;
+  m_data = payloadObj.value("data").toString();
+  m_truncated = payloadObj.value("truncated").toBool(false);
+  return true;
+}
@@ -0,0 +1,36 @@
+#include "../../include/synergy_protocol/Message_Run_Output_Result.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Run_Output_Result::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("stdout", m_stdout);
+  payload.insert("stderr", m_stderr);
+  payload.insert("exit_code", m_exit_code);
+  if(!m_requesting_user_id.isEmpty()) {
+    payload.insert("requesting_user_id", m_requesting_user_id);
+  }
+  if(!m_run_id.isEmpty()) {
+    payload.insert("run_id", m_run_id);
+    payload.insert("chunk_count", qint64(m_chunk_count));
+  }
+  return payload;
+}
+
+bool Message_Run_Output_Result::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("stdout").isString() || !payloadObj.value("stderr").isString()) {
+    qCritical() << "RUN_OUTPUT_RESULT | Payload missing or invalid 'stdout'/'stderr'.";
+    return false;
+  }
+  if(!payloadObj.value("exit_code").isDouble()) {
+    qCritical() << "RUN_OUTPUT_RESULT | Payload missing or invalid 'exit_code'.";
+    return false;
+  }
+  m_stdout = payloadObj.value("stdout").toString();
+  m_stderr = payloadObj.value("stderr").toString();
+  m_exit_code = payloadObj.value("exit_code").toInt();
+  m_requesting_user_id = payloadObj.value("requesting_user_id").toString();
+  m_run_id = payloadObj.value("run_id").toString();
+  m_chunk_count = quint64(qMax<qint64>(0, payloadObj.value("chunk_count").toInteger()));
+  return true;
+}
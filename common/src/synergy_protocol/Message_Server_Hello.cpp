@@ -0,0 +1,37 @@
+#include "../../include/synergy_protocol/Message_Server_Hello.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Server_Hello::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("protocol_version", versionTypeToString(m_version));
+  payload.insert("server_version", m_server_version);
+  payload.insert("wire_format", wireFormatToString(m_wire_format));
+  payload.insert("compression", compressionToString(m_compression));
+  return payload;
+}
+
+bool Message_Server_Hello::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.contains("protocol_version") || !payloadObj.value("protocol_version").isString()) {
+    qCritical() << "SERVER_HELLO | Payload missing or invalid 'protocol_version'.";
+    return false;
+  }
+  if(!payloadObj.contains("wire_format") || !payloadObj.value("wire_format").isString()) {
+    qCritical() << "SERVER_HELLO | Payload missing or invalid 'wire_format'.";
+    return false;
+  }
+  bool known = false;
+  m_wire_format = stringToWireFormat(payloadObj.value("wire_format").toString(), &known);
+  if(!known) {
+    qCritical() << "SERVER_HELLO | Server selected unsupported wire format" << payloadObj.value("wire_format").toString();
+    return false;
+  }
+  m_compression = stringToCompression(payloadObj.value("compression").toString(), &known);
+  if(payloadObj.contains("compression") && !known) {
+    qCritical() << "SERVER_HELLO | Server selected unsupported compression" << payloadObj.value("compression").toString();
+    return false;
+  }
+  m_version = stringToVersionType(payloadObj.value("protocol_version").toString());
+  m_server_version = payloadObj.value("server_version").toString();
+  return true;
+}
@@ -0,0 +1,70 @@
+#include "../../include/synergy_protocol/Message_Text_Operation.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Text_Operation::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("file_path", m_file_path);
+  payload.insert("revision", qint64(m_revision));
+  payload.insert("operation", m_operation.toJson());
+  if(!m_originator_id.isEmpty()) {
+    payload.insert("originator_id", m_originator_id);
+  }
+  return payload;
+}
+
+bool Message_Text_Operation::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("file_path").isString()) {
+    qCritical() << "TEXT_OPERATION | Payload missing or invalid 'file_path'.";
+    return false;
+  }
+  if(!payloadObj.value("revision").isDouble() || payloadObj.value("revision").toInteger(-1) < 0) {
+    qCritical() << "TEXT_OPERATION | Payload missing or invalid 'revision'.";
+    return false;
+  }
+  if(!payloadObj.value("operation").isArray() || !TextOperation::fromJson(payloadObj.value("operation").toArray(), m_operation)) {
+    qCritical() << "TEXT_OPERATION | Payload missing or invalid 'operation'.";
+    return false;
+  }
+  m_file_path = payloadObj.value("file_path").toString();
+  m_revision = quint64(payloadObj.value("revision").toInteger());
+  m_originator_id = payloadObj.value("originator_id").toString();
+  return true;
+}
+
+void Message_Text_Operation::payloadToCbor(QCborStreamWriter& writer) const {
+  writer.startMap(m_originator_id.isEmpty() ? 3 : 4);
+  writer.append(qint64(CBOR_FILE_PATH));
+  writer.append(m_file_path);
+  writer.append(qint64(CBOR_REVISION));
+  writer.append(m_revision);
+  writer.append(qint64(CBOR_OPERATION));
+  m_operation.toCbor(writer);
+  if(!m_originator_id.isEmpty()) {
+    writer.append(qint64(CBOR_ORIGINATOR_ID));
+    writer.append(m_originator_id);
+  }
+  writer.endMap();
+}
+
+bool Message_Text_Operation::payloadFromCbor(const QCborMap& payloadMap) {
+  const QCborValue path = payloadMap.value(CBOR_FILE_PATH);
+  const QCborValue revision = payloadMap.value(CBOR_REVISION);
+  const QCborValue operation = payloadMap.value(CBOR_OPERATION);
+  if(!path.isString()) {
+    qCritical() << "TEXT_OPERATION | CBOR payload missing or invalid file path.";
+    return false;
+  }
+  if(!revision.isInteger() || revision.toInteger() < 0) {
+    qCritical() << "TEXT_OPERATION | CBOR payload missing or invalid revision.";
+    return false;
+  }
+  if(!operation.isArray() || !TextOperation::fromCbor(operation.toArray(), m_operation)) {
+    qCritical() << "TEXT_OPERATION | CBOR payload missing or invalid operation.";
+    return false;
+  }
+  m_file_path = path.toString();
+  m_revision = quint64(revision.toInteger());
+  m_originator_id = payloadMap.value(CBOR_ORIGINATOR_ID).toString();
+  return true;
+}
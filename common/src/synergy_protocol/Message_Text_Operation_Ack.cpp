@@ -0,0 +1,24 @@
+#include "../../include/synergy_protocol/Message_Text_Operation_Ack.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Text_Operation_Ack::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("file_path", m_file_path);
+  payload.insert("revision", qint64(m_revision));
+  return payload;
+}
+
+bool Message_Text_Operation_Ack::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.value("file_path").isString()) {
+    qCritical() << "TEXT_OPERATION_ACK | Payload missing or invalid 'file_path'.";
+    return false;
+  }
+  if(!payloadObj.value("revision").isDouble() || payloadObj.value("revision").toInteger(-1) < 0) {
+    qCritical() << "TEXT_OPERATION_ACK | Payload missing or invalid 'revision'.";
+    return false;
+  }
+  m_file_path = payloadObj.value("file_path").toString();
+  m_revision = quint64(payloadObj.value("revision").toInteger());
+  return true;
+}
@@ -0,0 +1,63 @@
+#include "../../include/synergy_protocol/Message_Update_Text_Edit.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_Update_Text_Edit::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("file_path", m_file_path);
+  payload.insert("content", m_content);
+  payload.insert("revision", qint64(m_revision));
+  if(!m_originator_id.isEmpty()) {
+    payload.insert("originator_id", m_originator_id);
+  }
+  return payload;
+}
+
+bool Message_Update_Text_Edit::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.contains("file_path") || !payloadObj.value("file_path").isString()) {
+    qCritical() << "UPDATE_TEXT_EDIT | Payload missing or invalid 'file_path'.";
+    return false;
+  }
+  if(!payloadObj.contains("content") || !payloadObj.value("content").isString()) {
+    qCritical() << "UPDATE_TEXT_EDIT | Payload missing or invalid 'content'.";
+    return false;
+  }
+  m_file_path = payloadObj.value("file_path").toString();
+  m_content = payloadObj.value("content").toString();
+  m_originator_id = payloadObj.value("originator_id").toString();
+  m_revision = quint64(qMax<qint64>(0, payloadObj.value("revision").toInteger()));
+  return true;
+}
+
+void Message_Update_Text_Edit::payloadToCbor(QCborStreamWriter& writer) const {
+  writer.startMap(m_originator_id.isEmpty() ? 3 : 4);
+  writer.append(qint64(CBOR_FILE_PATH));
+  writer.append(m_file_path);
+  writer.append(qint64(CBOR_CONTENT));
+  writer.append(m_content);
+  writer.append(qint64(CBOR_REVISION));
+  writer.append(m_revision);
+  if(!m_originator_id.isEmpty()) {
+    writer.append(qint64(CBOR_ORIGINATOR_ID));
+    writer.append(m_originator_id);
+  }
+  writer.endMap();
+}
+
+bool Message_Update_Text_Edit::payloadFromCbor(const QCborMap& payloadMap) {
+  const QCborValue path = payloadMap.value(CBOR_FILE_PATH);
+  const QCborValue content = payloadMap.value(CBOR_CONTENT);
+  if(!path.isString()) {
+    qCritical() << "UPDATE_TEXT_EDIT | CBOR payload missing or invalid file path.";
+    return false;
+  }
+  if(!content.isString()) {
+    qCritical() << "UPDATE_TEXT_EDIT | CBOR payload missing or invalid content.";
+    return false;
+  }
+  m_file_path = path.toString();
+  m_content = content.toString();
+  m_originator_id = payloadMap.value(CBOR_ORIGINATOR_ID).toString();
+  m_revision = quint64(qMax<qint64>(0, payloadMap.value(CBOR_REVISION).toInteger()));
+  return true;
+}
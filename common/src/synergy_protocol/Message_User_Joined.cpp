@@ -0,0 +1,22 @@
+#include "../../include/synergy_protocol/Message_User_Joined.h"
+
+using namespace SynergyProtocol;
+
+QJsonObject Message_User_Joined::payloadToJson() const {
+  QJsonObject payload;
+  payload.insert("user_id", m_user_id);
+  if(!m_username.isEmpty()) {
+    payload.insert("username", m_username);
+  }
+  return payload;
+}
+
+bool Message_User_Joined::payloadFromJson(const QJsonObject& payloadObj) {
+  if(!payloadObj.contains("user_id") || !payloadObj.value("user_id").isString()) {
+    qCritical() << "USER_JOINED | Payload missing or invalid 'user_id'.";
+    return false;
+  }
+  m_user_id = payloadObj.value("user_id").toString();
+  m_username = payloadObj.value("username").toString();
+  return true;
+}
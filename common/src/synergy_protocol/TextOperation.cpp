@@ -0,0 +1,304 @@
+#include "../../include/synergy_protocol/TextOperation.h"
+
+#include <QDebug>
+#include <QtNumeric>
+#include <algorithm>
+
+using namespace SynergyProtocol;
+
+TextOperation& TextOperation::retain(qsizetype count){
+  if(count <= 0) return *this;
+  m_baseLength += count;
+  m_targetLength += count;
+  if(!m_components.empty() && m_components.back().kind == t_Kind::RETAIN) {
+    m_components.back().length += count;
+  } else {
+    m_components.push_back(Component{t_Kind::RETAIN, count, QString()});
+  }
+  return *this;
+}
+
+TextOperation& TextOperation::insert(const QString& text){
+  if(text.isEmpty()) return *this;
+  m_targetLength += text.size();
+  if(!m_components.empty() && m_components.back().kind == t_Kind::INSERT) {
+    m_components.back().text += text;
+    m_components.back().length += text.size();
+    return *this;
+  }
+  /*
+  Insert directly after remove is stored before it (same result), so equal
+  edits always have the same components and compose/transform see one form
+  */
+  if(!m_components.empty() && m_components.back().kind == t_Kind::REMOVE) {
+    const std::size_t count = m_components.size();
+    if(count >= 2 && m_components[count - 2].kind == t_Kind::INSERT) {
+      m_components[count - 2].text += text;
+      m_components[count - 2].length += text.size();
+    } else {
+      m_components.insert(m_components.end() - 1, Component{t_Kind::INSERT, text.size(), text});
+    }
+    return *this;
+  }
+  m_components.push_back(Component{t_Kind::INSERT, text.size(), text});
+  return *this;
+}
+
+TextOperation& TextOperation::remove(qsizetype count){
+  if(count <= 0) return *this;
+  m_baseLength += count;
+  if(!m_components.empty() && m_components.back().kind == t_Kind::REMOVE) {
+    m_components.back().length += count;
+  } else {
+    m_components.push_back(Component{t_Kind::REMOVE, count, QString()});
+  }
+  return *this;
+}
+
+bool TextOperation::isNoop() const {
+  return m_components.empty() || (m_components.size() == 1 && m_components.front().kind == t_Kind::RETAIN);
+}
+
+bool TextOperation::applyTo(QString& text) const {
+  if(text.size() != m_baseLength) {
+    qCritical() << "TEXT OPERATION | Base length" << m_baseLength << "doesn't match text length" << text.size();
+    return false;
+  }
+  // Walk with position in the new text, each insert/remove is one in-place edit
+  qsizetype position = 0;
+  for(const Component& component : m_components) {
+    switch(component.kind) {
+      case t_Kind::RETAIN:
+        position += component.length;
+        break;
+      case t_Kind::INSERT:
+        text.insert(position, component.text);
+        position += component.length;
+        break;
+      case t_Kind::REMOVE:
+        text.remove(position, component.length);
+        break;
+    }
+  }
+  return true;
+}
+
+namespace {
+  // Cursor over components that can hand out a component piece by piece
+  class ComponentCursor {
+  public:
+    explicit ComponentCursor(const std::vector<TextOperation::Component>& components) :
+      m_components(components) {}
+
+    bool atEnd() const { return m_index >= m_components.size(); }
+    TextOperation::t_Kind kind() const { return m_components[m_index].kind; }
+    qsizetype remaining() const { return m_components[m_index].length - m_offset; }
+
+    // Consumes up to 'count' units of the current component (text for inserts)
+    QString take(qsizetype count) {
+      const TextOperation::Component& component = m_components[m_index];
+      QString text;
+      if(component.kind == TextOperation::t_Kind::INSERT) {
+        text = component.text.mid(m_offset, count);
+      }
+      m_offset += count;
+      if(m_offset >= component.length) {
+        ++m_index;
+        m_offset = 0;
+      }
+      return text;
+    }
+
+  private:
+    const std::vector<TextOperation::Component>& m_components;
+    std::size_t m_index = 0;
+    qsizetype m_offset = 0;
+  };
+}
+
+bool TextOperation::compose(const TextOperation& first, const TextOperation& second, TextOperation& composed){
+  if(first.m_targetLength != second.m_baseLength) {
+    qCritical() << "TEXT OPERATION | Compose: target length of first operation doesn't match base of second";
+    return false;
+  }
+
+  composed = TextOperation();
+  ComponentCursor a(first.m_components);
+  ComponentCursor b(second.m_components);
+  while(!a.atEnd() || !b.atEnd()) {
+    // Removed by first never reaches second, inserted by second doesn't exist for first
+    if(!a.atEnd() && a.kind() == t_Kind::REMOVE) {
+      composed.remove(a.remaining());
+      a.take(a.remaining());
+      continue;
+    }
+    if(!b.atEnd() && b.kind() == t_Kind::INSERT) {
+      composed.insert(b.take(b.remaining()));
+      continue;
+    }
+    if(a.atEnd() || b.atEnd()) {
+      qCritical() << "TEXT OPERATION | Compose: operations have inconsistent lengths";
+      return false;
+    }
+
+    const qsizetype count = std::min(a.remaining(), b.remaining());
+    if(a.kind() == t_Kind::RETAIN && b.kind() == t_Kind::RETAIN) {
+      composed.retain(count);
+      a.take(count);
+      b.take(count);
+    } else if(a.kind() == t_Kind::RETAIN && b.kind() == t_Kind::REMOVE) {
+      composed.remove(count);
+      a.take(count);
+      b.take(count);
+    } else if(a.kind() == t_Kind::INSERT && b.kind() == t_Kind::RETAIN) {
+      composed.insert(a.take(count));
+      b.take(count);
+    } else { // insert then remove of the same text cancels out
+      a.take(count);
+      b.take(count);
+    }
+  }
+  return true;
+}
+
+bool TextOperation::transform(const TextOperation& a, const TextOperation& b, TextOperation& aPrime, TextOperation& bPrime){
+  if(a.m_baseLength != b.m_baseLength) {
+    qCritical() << "TEXT OPERATION | Transform: operations don't share base length";
+    return false;
+  }
+
+  aPrime = TextOperation();
+  bPrime = TextOperation();
+  ComponentCursor left(a.m_components);
+  ComponentCursor right(b.m_components);
+  while(!left.atEnd() || !right.atEnd()) {
+    // Inserts don't touch existing text, other side just skips over them. 'a' wins ties
+    if(!left.atEnd() && left.kind() == t_Kind::INSERT) {
+      const QString text = left.take(left.remaining());
+      aPrime.insert(text);
+      bPrime.retain(text.size());
+      continue;
+    }
+    if(!right.atEnd() && right.kind() == t_Kind::INSERT) {
+      const QString text = right.take(right.remaining());
+      aPrime.retain(text.size());
+      bPrime.insert(text);
+      continue;
+    }
+    if(left.atEnd() || right.atEnd()) {
+      qCritical() << "TEXT OPERATION | Transform: operations have inconsistent lengths";
+      return false;
+    }
+
+    const qsizetype count = std::min(left.remaining(), right.remaining());
+    if(left.kind() == t_Kind::RETAIN && right.kind() == t_Kind::RETAIN) {
+      aPrime.retain(count);
+      bPrime.retain(count);
+    } else if(left.kind() == t_Kind::REMOVE && right.kind() == t_Kind::RETAIN) {
+      aPrime.remove(count);
+    } else if(left.kind() == t_Kind::RETAIN && right.kind() == t_Kind::REMOVE) {
+      bPrime.remove(count);
+    }
+    // Both removed the same range -> already gone for both
+    left.take(count);
+    right.take(count);
+  }
+  return true;
+}
+
+QJsonArray TextOperation::toJson() const {
+  QJsonArray array;
+  for(const Component& component : m_components) {
+    switch(component.kind) {
+      case t_Kind::RETAIN: array.append(qint64(component.length)); break;
+      case t_Kind::INSERT: array.append(component.text); break;
+      case t_Kind::REMOVE: array.append(-qint64(component.length)); break;
+    }
+  }
+  return array;
+}
+
+namespace {
+  // Checked sum, false on overflow or past the document limit
+  bool addLength(qsizetype& total, qint64 count){
+    qsizetype sum = 0;
+    if(qAddOverflow(total, qsizetype(count), &sum) || sum > TextOperation::c_maxDocumentLength) return false;
+    total = sum;
+    return true;
+  }
+
+  // Retain (count > 0) or remove (count < 0) from the wire, lengths checked before the builder sees them
+  bool appendCount(TextOperation& operation, qint64 count){
+    if(count < -TextOperation::c_maxDocumentLength || count > TextOperation::c_maxDocumentLength) return false; // Also keeps -count defined
+    qsizetype base = operation.baseLength();
+    qsizetype target = operation.targetLength();
+    if(!addLength(base, count > 0 ? count : -count)) return false;
+    if(count > 0 && !addLength(target, count)) return false;
+    count > 0 ? operation.retain(count) : operation.remove(-count);
+    return true;
+  }
+
+  bool appendText(TextOperation& operation, const QString& text){
+    qsizetype target = operation.targetLength();
+    if(!addLength(target, text.size())) return false;
+    operation.insert(text);
+    return true;
+  }
+}
+
+bool TextOperation::fromJson(const QJsonArray& array, TextOperation& operation){
+  operation = TextOperation();
+  for(const QJsonValue& value : array) {
+    bool ok = false;
+    if(value.isString()) {
+      ok = appendText(operation, value.toString());
+    } else if(value.isDouble() && value.toDouble() == double(value.toInteger()) && value.toInteger() != 0) {
+      ok = appendCount(operation, value.toInteger());
+    }
+    if(!ok) {
+      qCritical() << "TEXT OPERATION | Invalid or oversized component in JSON operation:" << value;
+      return false;
+    }
+  }
+  return true;
+}
+
+void TextOperation::toCbor(QCborStreamWriter& writer) const {
+  writer.startArray(m_components.size());
+  for(const Component& component : m_components) {
+    switch(component.kind) {
+      case t_Kind::RETAIN: writer.append(qint64(component.length)); break;
+      case t_Kind::INSERT: writer.append(component.text); break;
+      case t_Kind::REMOVE: writer.append(-qint64(component.length)); break;
+    }
+  }
+  writer.endArray();
+}
+
+bool TextOperation::fromCbor(const QCborArray& array, TextOperation& operation){
+  operation = TextOperation();
+  for(const QCborValue& value : array) {
+    bool ok = false;
+    if(value.isString()) {
+      ok = appendText(operation, value.toString());
+    } else if(value.isInteger() && value.toInteger() != 0) {
+      ok = appendCount(operation, value.toInteger());
+    }
+    if(!ok) {
+      qCritical() << "TEXT OPERATION | Invalid or oversized component in CBOR operation";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TextOperation::operator==(const TextOperation& other) const {
+  if(m_baseLength != other.m_baseLength || m_targetLength != other.m_targetLength) return false;
+  if(m_components.size() != other.m_components.size()) return false;
+  for(std::size_t i = 0; i < m_components.size(); ++i) {
+    const Component& left = m_components[i];
+    const Component& right = other.m_components[i];
+    if(left.kind != right.kind || left.length != right.length || left.text != right.text) return false;
+  }
+  return true;
+}
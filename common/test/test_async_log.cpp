@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <QByteArray>
+#include <QList>
+#include <QThread>
+
+#include <cstdio>
+#include <memory>
+#include <unistd.h>
+
+#include "synergy_protocol/AsyncLog.h"
+
+using SynergyProtocol::AsyncLog;
+
+namespace {
+  QList<QByteArray> linesOf(FILE *file){
+    std::rewind(file);
+    QByteArray all;
+    char buffer[4096];
+    while(const std::size_t got = std::fread(buffer, 1, sizeof(buffer), file)) all.append(buffer, qsizetype(got));
+    QList<QByteArray> lines = all.split('\n');
+    if(!lines.isEmpty() && lines.last().isEmpty()) lines.removeLast();
+    return lines;
+  }
+
+  qsizetype countContaining(const QList<QByteArray> &lines, const char *text){
+    qsizetype count = 0;
+    for(const QByteArray &line : lines) count += line.contains(text) ? 1 : 0;
+    return count;
+  }
+}
+
+// Writer blocked on a pipe nobody reads yet: the ring fills up and the rest is dropped, never waited for
+TEST(AsyncLog, FullRingDropsRecordsAndReportsHowMany){
+  int fds[2];
+  ASSERT_EQ(::pipe(fds), 0);
+  FILE *writeEnd = ::fdopen(fds[1], "w");
+  ASSERT_NE(writeEnd, nullptr);
+
+  QByteArray received;
+  std::unique_ptr<QThread> reader;
+  {
+    AsyncLog::Config config;
+    config.capacity = 4;
+    config.burst = 0;
+    config.output = writeEnd;
+    AsyncLog log(config);
+
+    // More than a pipe buffer holds, written on its own (over the flush threshold)
+    qInfo("%s", QByteArray(256 * 1024, 'a').constData());
+    QThread::msleep(200);
+    for(int i = 0; i < 20; ++i) qInfo("small %d", i);
+
+    reader.reset(QThread::create([&received, fd = fds[0]]() {
+      char buffer[4096];
+      ssize_t got = 0;
+      while((got = ::read(fd, buffer, sizeof(buffer))) > 0) received.append(buffer, qsizetype(got));
+    }));
+    reader->start();
+  } // Flushes everything
+  std::fclose(writeEnd);
+  reader->wait();
+  ::close(fds[0]);
+
+  const QList<QByteArray> lines = received.split('\n');
+  EXPECT_EQ(countContaining(lines, "small "), 4);
+  EXPECT_EQ(countContaining(lines, "log queue full, 16 records dropped"), 1);
+}
+
+TEST(AsyncLog, SuppressesRepeatsPastTheBurstAndSummarizesThem){
+  FILE *output = std::tmpfile();
+  ASSERT_NE(output, nullptr);
+  {
+    AsyncLog::Config config;
+    config.burst = 3;
+    config.windowMs = 60 * 1000; // Summary comes from the final flush
+    config.output = output;
+    AsyncLog log(config);
+    for(int i = 0; i < 10; ++i) qInfo("tick %d", i);
+    qWarning("other");
+    qWarning("other");
+  }
+
+  const QList<QByteArray> lines = linesOf(output);
+  std::fclose(output);
+  ASSERT_EQ(lines.size(), 3 + 2 + 1);
+  EXPECT_TRUE(lines[0].endsWith(" I tick 0"));
+  EXPECT_TRUE(lines[2].endsWith(" I tick 2"));
+  EXPECT_EQ(countContaining(lines, " W other"), 2); // Different site, own burst
+  EXPECT_TRUE(lines.last().endsWith(" I (7 similar messages suppressed, last one:) tick 9")) << lines.last().toStdString();
+}
+
+TEST(AsyncLog, NewWindowWritesAgainAfterTheSummary){
+  FILE *output = std::tmpfile();
+  ASSERT_NE(output, nullptr);
+  {
+    AsyncLog::Config config;
+    config.burst = 1;
+    config.windowMs = 100;
+    config.output = output;
+    AsyncLog log(config);
+    // One call site, whether Qt passes file:line or not
+    const auto retry = [](int attempt) { qInfo("retry %d", attempt); };
+    retry(1);
+    retry(2);
+    QThread::msleep(300);
+    retry(3);
+  }
+
+  const QList<QByteArray> lines = linesOf(output);
+  std::fclose(output);
+  ASSERT_EQ(lines.size(), 3);
+  EXPECT_TRUE(lines[0].endsWith(" I retry 1"));
+  EXPECT_TRUE(lines[1].endsWith(" I (1 similar messages suppressed, last one:) retry 2")) << lines[1].toStdString();
+  EXPECT_TRUE(lines[2].endsWith(" I retry 3"));
+}
+
+TEST(AsyncLog, FormatsTimestampLevelAndCategory){
+  FILE *output = std::tmpfile();
+  ASSERT_NE(output, nullptr);
+  {
+    AsyncLog::Config config;
+    config.output = output;
+    AsyncLog log(config);
+    qCWarning(SynergyProtocol::logTraffic) << "sent" << 3;
+  }
+
+  const QList<QByteArray> lines = linesOf(output);
+  std::fclose(output);
+  ASSERT_EQ(lines.size(), 1);
+  // 2026-01-31T12:00:00.123Z W synergy.traffic: sent 3
+  const QByteArray &line = lines.front();
+  ASSERT_GT(line.size(), 25);
+  EXPECT_EQ(line[10], 'T');
+  EXPECT_EQ(line[19], '.');
+  EXPECT_EQ(line.mid(23), QByteArray("Z W synergy.traffic: sent 3"));
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <QCborValue>
+#include <QJsonDocument>
+
+#include "synergy_protocol/Message_Draw_Command.h"
+
+using SynergyProtocol::Message_Draw_Command;
+using SynergyProtocol::t_WireFormat;
+
+namespace {
+  Message_Draw_Command throughCbor(const Message_Draw_Command &message){
+    Message_Draw_Command decoded;
+    EXPECT_TRUE(decoded.fromCbor(QCborValue::fromCbor(message.encode(t_WireFormat::CBOR)).toMap()));
+    return decoded;
+  }
+
+  Message_Draw_Command throughJson(const Message_Draw_Command &message){
+    Message_Draw_Command decoded;
+    EXPECT_TRUE(decoded.fromJson(QJsonDocument::fromJson(message.encode(t_WireFormat::JSON)).object()));
+    return decoded;
+  }
+
+  void expectSameCoordinates(const Message_Draw_Command &a, const Message_Draw_Command &b){
+    EXPECT_EQ(a.startX(), b.startX());
+    EXPECT_EQ(a.startY(), b.startY());
+    EXPECT_EQ(a.endX(), b.endX());
+    EXPECT_EQ(a.endY(), b.endY());
+    EXPECT_EQ(a.strokeWidth(), b.strokeWidth());
+  }
+}
+
+// Both codecs must hand every participant the same stroke, whatever format each negotiated
+TEST(DrawCommand, CborAndJsonDecodeToTheSameCoordinates){
+  const Message_Draw_Command message(1, 16777217.0, 0.1, -1234.5678, 1.0 / 3.0, "#ff0000", 2.25);
+  const Message_Draw_Command cbor = throughCbor(message);
+  expectSameCoordinates(cbor, message);
+  expectSameCoordinates(cbor, throughJson(message));
+}
+
+TEST(DrawCommand, WholePixelsStaySinglePrecision){
+  const Message_Draw_Command whole(1, 10, 20, 300.5, 400, "#000000", 1.0);
+  const Message_Draw_Command fractional(1, 10.1, 20.1, 300.1, 400.1, "#000000", 1.1);
+  // Five values, 4 extra bytes each once they need double precision
+  EXPECT_EQ(fractional.encode(t_WireFormat::CBOR).size() - whole.encode(t_WireFormat::CBOR).size(), 5 * 4);
+  expectSameCoordinates(throughCbor(whole), whole);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <QByteArray>
+#include <QSet>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "synergy_protocol/FrameBufferPool.h"
+
+using SynergyProtocol::FrameBufferPool;
+
+TEST(FrameBufferPool, AcquireGivesEmptyBuffersOfAtLeastTheCapacity){
+  for(qsizetype capacity : {qsizetype(0), qsizetype(1), qsizetype(256), qsizetype(257), qsizetype(70000)}) {
+    const QByteArray buffer = FrameBufferPool::acquire(capacity);
+    EXPECT_TRUE(buffer.isEmpty());
+    EXPECT_GE(buffer.capacity(), std::max(capacity, FrameBufferPool::c_minCapacity)) << capacity;
+  }
+  const QByteArray big = FrameBufferPool::acquire(FrameBufferPool::c_maxCapacity + 1);
+  EXPECT_GE(big.capacity(), FrameBufferPool::c_maxCapacity + 1);
+}
+
+TEST(FrameBufferPool, ReleasedBufferIsHandedOutAgain){
+  QByteArray buffer = FrameBufferPool::acquire(3000);
+  buffer.append("frame bytes");
+  const char *storage = buffer.constData();
+  FrameBufferPool::release(std::move(buffer));
+
+  const QByteArray again = FrameBufferPool::acquire(3000);
+  EXPECT_EQ(again.constData(), storage);
+  EXPECT_TRUE(again.isEmpty());
+}
+
+// A frame still queued for another recipient must never be handed out for writing
+TEST(FrameBufferPool, SharedBuffersAreNotPooled){
+  QByteArray frame = FrameBufferPool::acquire(1000);
+  frame.append(QByteArray(600, 'x'));
+  const QByteArray stillQueued = frame;
+  FrameBufferPool::release(std::move(frame));
+
+  QByteArray next = FrameBufferPool::acquire(1000);
+  next.append(QByteArray(600, 'y'));
+  EXPECT_NE(next.constData(), stillQueued.constData());
+  EXPECT_EQ(stillQueued, QByteArray(600, 'x'));
+}
+
+// Frames encoded on one thread are often written (and released) on another
+TEST(FrameBufferPool, SurplusMovesToOtherThreadsThroughTheDepot){
+  QSet<const char*> released;
+  std::thread writer([&]() {
+    std::vector<QByteArray> buffers;
+    for(int i = 0; i < 64; ++i) buffers.push_back(FrameBufferPool::acquire(FrameBufferPool::c_minCapacity));
+    for(QByteArray &buffer : buffers) {
+      released.insert(buffer.constData());
+      FrameBufferPool::release(std::move(buffer));
+    }
+  });
+  writer.join();
+
+  bool fromWriter = false;
+  std::thread encoder([&]() {
+    const QByteArray buffer = FrameBufferPool::acquire(FrameBufferPool::c_minCapacity);
+    fromWriter = released.contains(buffer.constData());
+  });
+  encoder.join();
+  EXPECT_TRUE(fromWriter);
+}
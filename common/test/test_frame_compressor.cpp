@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <QRandomGenerator>
+#include <QtEndian>
+
+#include "synergy_protocol/FrameCompressor.h"
+#include "synergy_protocol/FrameDecoder.h"
+
+using SynergyProtocol::FrameCompressor;
+using SynergyProtocol::FrameDecoder;
+using SynergyProtocol::t_Compression;
+
+namespace {
+  // Looks like what goes over the wire: JSON envelope, keys the dictionary knows
+  QByteArray jsonPayload(int operations){
+    QByteArray payload = R"({"id":0,"payload":{"file_path":"src/main.cpp","operation":[)";
+    for(int i = 0; i < operations; ++i) {
+      payload += (i ? "," : "") + QByteArray(R"({"retain":)") + QByteArray::number(i * 7) + R"(},{"insert":"x"})";
+    }
+    payload += R"(],"originator_id":"User_3","revision":42},"seq":17,"type":"TEXT_OPERATION","version":"1.0"})";
+    return payload;
+  }
+
+  quint32 prefixOf(const QByteArray &frame){
+    return qFromBigEndian<quint32>(frame.constData());
+  }
+
+  QByteArrayView payloadOf(const QByteArray &frame){
+    return QByteArrayView(frame).sliced(FrameDecoder::c_headerSize);
+  }
+}
+
+class FrameCompressorRoundTrip : public ::testing::TestWithParam<t_Compression> {};
+
+TEST_P(FrameCompressorRoundTrip, FlaggedFrameInflatesToTheOriginalPayload){
+  const QByteArray payload = jsonPayload(40);
+  const QByteArray frame = FrameDecoder::encodeFrame(payload);
+  const QByteArray compressed = FrameCompressor::compressFrame(frame, GetParam());
+
+  ASSERT_LT(compressed.size(), frame.size());
+  const quint32 prefix = prefixOf(compressed);
+  EXPECT_TRUE(prefix & FrameCompressor::c_compressedFlag);
+  EXPECT_EQ(qsizetype(prefix & FrameCompressor::c_lengthMask), compressed.size() - FrameDecoder::c_headerSize);
+  EXPECT_EQ(qFromBigEndian<quint32>(compressed.constData() + FrameDecoder::c_headerSize), quint32(payload.size()));
+
+  QByteArray out;
+  ASSERT_TRUE(FrameCompressor::decompress(payloadOf(compressed), GetParam(), FrameDecoder::c_defaultMaxFrameSize, out));
+  EXPECT_EQ(out, payload);
+
+  // Per-thread stream state is reset between frames
+  const QByteArray other = jsonPayload(12);
+  ASSERT_TRUE(FrameCompressor::decompress(payloadOf(FrameCompressor::compressFrame(FrameDecoder::encodeFrame(other), GetParam())),
+                                          GetParam(), FrameDecoder::c_defaultMaxFrameSize, out));
+  EXPECT_EQ(out, other);
+}
+
+INSTANTIATE_TEST_SUITE_P(FrameCompressor, FrameCompressorRoundTrip,
+                         ::testing::Values(t_Compression::DEFLATE, t_Compression::DEFLATE_DICTIONARY));
+
+TEST(FrameCompressor, DictionaryShrinksShortFramesFurther){
+  const QByteArray frame = FrameDecoder::encodeFrame(jsonPayload(1));
+  const QByteArray plain = FrameCompressor::compressFrame(frame, t_Compression::DEFLATE);
+  const QByteArray primed = FrameCompressor::compressFrame(frame, t_Compression::DEFLATE_DICTIONARY);
+  EXPECT_LT(primed.size(), plain.size());
+}
+
+TEST(FrameCompressor, LeavesSmallAndIncompressibleFramesUnchanged){
+  const QByteArray small = FrameDecoder::encodeFrame(QByteArray(FrameCompressor::c_minPayloadSize - 1, 'a'));
+  EXPECT_EQ(FrameCompressor::compressFrame(small, t_Compression::DEFLATE_DICTIONARY), small);
+
+  const QByteArray compressible = FrameDecoder::encodeFrame(jsonPayload(10));
+  EXPECT_EQ(FrameCompressor::compressFrame(compressible, t_Compression::NONE), compressible);
+
+  // Random bytes can't shrink, the frame goes out as it was, unflagged
+  QByteArray noise(4096, '\0');
+  QRandomGenerator random(1234);
+  random.fillRange(reinterpret_cast<quint32*>(noise.data()), noise.size() / qsizetype(sizeof(quint32)));
+  const QByteArray noisy = FrameDecoder::encodeFrame(noise);
+  const QByteArray result = FrameCompressor::compressFrame(noisy, t_Compression::DEFLATE);
+  EXPECT_EQ(result, noisy);
+  EXPECT_FALSE(prefixOf(result) & FrameCompressor::c_compressedFlag);
+}
+
+TEST(FrameCompressor, RejectsAnnouncedSizeOverTheLimitBeforeInflating){
+  const QByteArray payload = jsonPayload(40);
+  const QByteArray compressed = FrameCompressor::compressFrame(FrameDecoder::encodeFrame(payload), t_Compression::DEFLATE);
+  QByteArray out;
+  EXPECT_FALSE(FrameCompressor::decompress(payloadOf(compressed), t_Compression::DEFLATE, quint32(payload.size() - 1), out));
+  EXPECT_TRUE(FrameCompressor::decompress(payloadOf(compressed), t_Compression::DEFLATE, quint32(payload.size()), out));
+
+  // Bomb: tiny frame announcing 4 GiB is refused without allocating it
+  QByteArray bomb = QByteArray(payloadOf(compressed).toByteArray());
+  qToBigEndian<quint32>(0xFFFFFFFFu, bomb.data());
+  out.clear();
+  EXPECT_FALSE(FrameCompressor::decompress(bomb, t_Compression::DEFLATE, FrameDecoder::c_defaultMaxFrameSize, out));
+  EXPECT_LE(out.size(), payload.size());
+}
+
+TEST(FrameCompressor, FailsWhenInflatedSizeDiffersFromTheAnnouncedOne){
+  const QByteArray payload = jsonPayload(40);
+  const QByteArray compressed = FrameCompressor::compressFrame(FrameDecoder::encodeFrame(payload), t_Compression::DEFLATE);
+  QByteArray out;
+  for(const qint64 delta : {-1, 1, 100}) {
+    QByteArray forged = payloadOf(compressed).toByteArray();
+    qToBigEndian<quint32>(quint32(payload.size() + delta), forged.data());
+    EXPECT_FALSE(FrameCompressor::decompress(forged, t_Compression::DEFLATE, FrameDecoder::c_defaultMaxFrameSize, out)) << delta;
+  }
+  // Truncated stream never reaches its end
+  const QByteArrayView truncated = payloadOf(compressed).chopped(8);
+  EXPECT_FALSE(FrameCompressor::decompress(truncated, t_Compression::DEFLATE, FrameDecoder::c_defaultMaxFrameSize, out));
+  EXPECT_FALSE(FrameCompressor::decompress(payloadOf(compressed), t_Compression::NONE, FrameDecoder::c_defaultMaxFrameSize, out));
+}
+
+TEST(FrameDecoder, InflatesFlaggedFramesOnceCompressionIsNegotiated){
+  const QByteArray payload = jsonPayload(40);
+  const QByteArray compressed = FrameCompressor::compressFrame(FrameDecoder::encodeFrame(payload), t_Compression::DEFLATE_DICTIONARY);
+  ASSERT_TRUE(prefixOf(compressed) & FrameCompressor::c_compressedFlag);
+
+  FrameDecoder decoder;
+  decoder.setCompression(t_Compression::DEFLATE_DICTIONARY);
+  // Flagged and plain frames mix on one stream, split at an odd spot
+  const QByteArray wire = compressed + FrameDecoder::encodeFrame("plain");
+  decoder.append(wire.left(7));
+  QByteArray frame;
+  EXPECT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::NEED_MORE_DATA);
+  decoder.append(wire.mid(7));
+  ASSERT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::FRAME_READY);
+  EXPECT_EQ(frame, payload);
+  ASSERT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::FRAME_READY);
+  EXPECT_EQ(frame, QByteArray("plain"));
+  EXPECT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::NEED_MORE_DATA);
+}
+
+TEST(FrameDecoder, RejectsFlaggedFrameWhoseSizeExceedsMaxFrameSize){
+  const QByteArray payload = jsonPayload(40);
+  const QByteArray compressed = FrameCompressor::compressFrame(FrameDecoder::encodeFrame(payload), t_Compression::DEFLATE);
+  FrameDecoder decoder(quint32(payload.size() - 1));
+  decoder.setCompression(t_Compression::DEFLATE);
+  decoder.append(compressed);
+  QByteArray frame;
+  EXPECT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::MALFORMED_FRAME);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <QList>
+#include <QtEndian>
+
+#include "synergy_protocol/FrameDecoder.h"
+#include "synergy_protocol/FrameCompressor.h"
+
+using SynergyProtocol::FrameDecoder;
+
+namespace {
+  QByteArray header(quint32 prefix) {
+    QByteArray bytes(FrameDecoder::c_headerSize, '\0');
+    qToBigEndian<quint32>(prefix, bytes.data());
+    return bytes;
+  }
+
+  QByteArray frameOf(const QByteArray &payload) {
+    return header(static_cast<quint32>(payload.size())) + payload;
+  }
+}
+
+TEST(FrameDecoder, FrameSplitAcrossAppends){
+  FrameDecoder decoder;
+  const QByteArray wire = frameOf("hello");
+  QByteArray frame;
+  for(qsizetype i = 0; i < wire.size() - 1; ++i) {
+    decoder.append(wire.constData() + i, 1);
+    EXPECT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::NEED_MORE_DATA);
+  }
+  decoder.append(wire.constData() + wire.size() - 1, 1);
+  ASSERT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::FRAME_READY);
+  EXPECT_EQ(frame, QByteArray("hello"));
+  EXPECT_EQ(decoder.bufferedBytes(), 0);
+}
+
+TEST(FrameDecoder, SeveralFramesInOneAppend){
+  FrameDecoder decoder;
+  decoder.append(frameOf("one") + frameOf(QByteArray()) + frameOf("three") + header(10));
+  QByteArray frame;
+  ASSERT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::FRAME_READY);
+  EXPECT_EQ(frame, QByteArray("one"));
+  ASSERT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::FRAME_READY);
+  EXPECT_TRUE(frame.isEmpty());
+  ASSERT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::FRAME_READY);
+  EXPECT_EQ(frame, QByteArray("three"));
+  EXPECT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::NEED_MORE_DATA);
+  EXPECT_EQ(decoder.bufferedBytes(), FrameDecoder::c_headerSize);
+}
+
+TEST(FrameDecoder, FramesWrapAroundTheRing){
+  FrameDecoder decoder(FrameDecoder::c_defaultMaxFrameSize, 16);
+  QByteArray wire;
+  QList<QByteArray> payloads;
+  for(int i = 0; i < 20; ++i) {
+    payloads.append(QByteArray::number(i).rightJustified(7, 'x'));
+    wire += frameOf(payloads.last()); // 11 bytes each
+  }
+  // 5 byte pieces: a partial frame is always left behind, so frames keep crossing the end of the 16 byte ring
+  QList<QByteArray> received;
+  QByteArray frame;
+  for(qsizetype offset = 0; offset < wire.size(); offset += 5) {
+    decoder.append(wire.mid(offset, 5));
+    while(decoder.nextFrame(frame) == FrameDecoder::t_Status::FRAME_READY) received.append(frame);
+  }
+  EXPECT_EQ(received, payloads);
+  EXPECT_EQ(decoder.capacity(), 16);
+}
+
+TEST(FrameDecoder, RejectsFrameOverLimit){
+  FrameDecoder decoder(100);
+  decoder.append(header(101));
+  QByteArray frame;
+  EXPECT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::FRAME_TOO_LARGE);
+}
+
+TEST(FrameDecoder, RejectsCompressedFrameWithoutNegotiation){
+  FrameDecoder decoder;
+  decoder.append(header(SynergyProtocol::FrameCompressor::c_compressedFlag | 3) + QByteArray("abc"));
+  QByteArray frame;
+  EXPECT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::MALFORMED_FRAME);
+}
+
+TEST(FrameDecoder, GrowsOnlyAsPayloadArrives){
+  const qsizetype initial = FrameDecoder::c_defaultInitialCapacity;
+  FrameDecoder decoder(32 * 1024 * 1024, initial);
+  decoder.append(header(16 * 1024 * 1024));
+  QByteArray frame;
+  EXPECT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::NEED_MORE_DATA);
+  EXPECT_EQ(decoder.capacity(), initial); // Announced size alone allocates nothing
+
+  decoder.append(QByteArray(initial - FrameDecoder::c_headerSize, 'a'));
+  EXPECT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::NEED_MORE_DATA);
+  EXPECT_EQ(decoder.capacity(), 2 * initial); // Full ring -> one doubling
+}
+
+TEST(FrameDecoder, ShrinksAfterOversizedFrame){
+  const qsizetype initial = FrameDecoder::c_defaultInitialCapacity;
+  FrameDecoder decoder(FrameDecoder::c_defaultMaxFrameSize, initial);
+  const QByteArray big(1024 * 1024, 'b');
+  decoder.append(frameOf(big) + frameOf("small"));
+  EXPECT_GT(decoder.capacity(), initial);
+
+  QByteArray frame;
+  ASSERT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::FRAME_READY);
+  EXPECT_EQ(frame.size(), big.size());
+  ASSERT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::FRAME_READY);
+  EXPECT_EQ(frame, QByteArray("small"));
+  EXPECT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::NEED_MORE_DATA);
+  EXPECT_EQ(decoder.capacity(), initial);
+}
+
+TEST(FrameDecoder, ResetDropsPartialFrameAndMemory){
+  FrameDecoder decoder(FrameDecoder::c_defaultMaxFrameSize, 64);
+  decoder.append(header(1000) + QByteArray(500, 'x'));
+  decoder.reset();
+  EXPECT_EQ(decoder.bufferedBytes(), 0);
+  EXPECT_EQ(decoder.capacity(), 64);
+  decoder.append(frameOf("after"));
+  QByteArray frame;
+  ASSERT_EQ(decoder.nextFrame(frame), FrameDecoder::t_Status::FRAME_READY);
+  EXPECT_EQ(frame, QByteArray("after"));
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "synergy_protocol/MessagePool.h"
+
+using SynergyProtocol::MessagePool;
+
+namespace {
+  bool isAligned(void *pointer){
+    return reinterpret_cast<std::uintptr_t>(pointer) % MessagePool::c_alignment == 0;
+  }
+
+  struct Tracked {
+    static inline std::atomic<int> s_alive {0};
+    int value;
+    explicit Tracked(int v) : value(v) { ++s_alive; }
+    ~Tracked() { --s_alive; }
+  };
+}
+
+TEST(MessagePool, ReusesFreedBlocksOnTheSameThread){
+  void *first = MessagePool::allocate(200);
+  MessagePool::deallocate(first, 200);
+  void *second = MessagePool::allocate(256); // Same size class
+  EXPECT_EQ(second, first);
+  MessagePool::deallocate(second, 256);
+}
+
+TEST(MessagePool, BlocksAreAlignedForEverySize){
+  for(std::size_t size : {1u, 17u, 64u, 65u, 500u, 1024u, 1025u, 5000u}) {
+    void *block = MessagePool::allocate(size);
+    EXPECT_TRUE(isAligned(block)) << size;
+    MessagePool::deallocate(block, size);
+  }
+}
+
+// Main thread dropping an I/O thread's message: block has to get back to that thread's cache
+TEST(MessagePool, BlocksFreedElsewhereReturnToTheirOwner){
+  std::atomic<void*> handedOver {nullptr};
+  std::atomic<bool> freed {false};
+  bool reused = false;
+
+  std::thread owner([&]() {
+    handedOver = MessagePool::allocate(100);
+    while(!freed) std::this_thread::yield();
+    // Free list may hold blocks inherited from finished threads, the returned one comes after those
+    std::vector<void*> taken;
+    for(int i = 0; i <= 2 * MessagePool::c_maxCachedBlocks && !reused; ++i) {
+      taken.push_back(MessagePool::allocate(100));
+      reused = taken.back() == handedOver.load();
+    }
+    for(void *block : taken) MessagePool::deallocate(block, 100);
+  });
+
+  while(!handedOver) std::this_thread::yield();
+  MessagePool::deallocate(handedOver, 100);
+  freed = true;
+  owner.join();
+  EXPECT_TRUE(reused);
+}
+
+TEST(MessagePool, MakePooledSharesAcrossThreads){
+  std::vector<std::shared_ptr<Tracked>> messages;
+  std::thread producer([&]() {
+    for(int i = 0; i < 1000; ++i) messages.push_back(SynergyProtocol::makePooled<Tracked>(i));
+  });
+  producer.join();
+  EXPECT_EQ(Tracked::s_alive, 1000);
+  EXPECT_EQ(messages[999]->value, 999);
+  EXPECT_TRUE(isAligned(messages.front().get()));
+  messages.clear();
+  EXPECT_EQ(Tracked::s_alive, 0);
+}
+
+TEST(MessagePool, ConcurrentAllocateAndCrossThreadFree){
+  constexpr int c_threads = 4;
+  constexpr int c_rounds = 20000;
+  std::vector<std::atomic<void*>> slots(64);
+  std::vector<std::thread> threads;
+  for(int t = 0; t < c_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      for(int i = 0; i < c_rounds; ++i) {
+        // Swap a fresh block into a shared slot, free whatever another thread left there
+        const std::size_t size = 32u << ((i + t) % 5);
+        void *block = MessagePool::allocate(size);
+        *static_cast<std::size_t*>(block) = size;
+        if(void *previous = slots[(i * 7 + t) % slots.size()].exchange(block)) {
+          MessagePool::deallocate(previous, *static_cast<std::size_t*>(previous));
+        }
+      }
+    });
+  }
+  for(std::thread &thread : threads) thread.join();
+  for(std::atomic<void*> &slot : slots) {
+    if(void *block = slot.exchange(nullptr)) MessagePool::deallocate(block, *static_cast<std::size_t*>(block));
+  }
+  SUCCEED(); // Checked by sanitizers: no double free, no use after free
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <QCborArray>
+#include <QCborValue>
+#include <QJsonArray>
+
+#include <limits>
+
+#include "synergy_protocol/TextOperation.h"
+
+using SynergyProtocol::TextOperation;
+
+namespace {
+  QString applied(QString text, const TextOperation &operation) {
+    EXPECT_TRUE(operation.applyTo(text));
+    return text;
+  }
+
+  // apply(apply(doc, a), b') == apply(apply(doc, b), a')
+  void expectConverges(const QString &document, const TextOperation &a, const TextOperation &b, const QString &expected) {
+    TextOperation aPrime, bPrime;
+    ASSERT_TRUE(TextOperation::transform(a, b, aPrime, bPrime));
+    EXPECT_EQ(applied(applied(document, a), bPrime), expected);
+    EXPECT_EQ(applied(applied(document, b), aPrime), expected);
+  }
+}
+
+TEST(TextOperation, BuilderMergesAndCountsLengths){
+  TextOperation operation;
+  operation.retain(2).retain(3).insert("ab").insert("c").remove(1).remove(2);
+  EXPECT_EQ(operation.components().size(), 3u);
+  EXPECT_EQ(operation.baseLength(), 8);
+  EXPECT_EQ(operation.targetLength(), 8);
+  EXPECT_EQ(applied("hello world", TextOperation().retain(5).remove(6).insert("!")), QString("hello!"));
+}
+
+TEST(TextOperation, ApplyRejectsWrongBaseLength){
+  QString text = "abc";
+  EXPECT_FALSE(TextOperation().retain(4).applyTo(text));
+  EXPECT_EQ(text, QString("abc"));
+}
+
+TEST(TextOperation, TransformConcurrentInserts){
+  // Same position: inserts of 'a' end up first
+  expectConverges("abc", TextOperation().retain(1).insert("X").retain(2), TextOperation().retain(1).insert("Y").retain(2), "aXYbc");
+  expectConverges("abc", TextOperation().insert("<").retain(3), TextOperation().retain(3).insert(">"), "<abc>");
+}
+
+TEST(TextOperation, TransformOverlappingRemoves){
+  expectConverges("abcdef", TextOperation().retain(1).remove(3).retain(2), TextOperation().retain(2).remove(3).retain(1), "af");
+  expectConverges("abcdef", TextOperation().remove(6), TextOperation().retain(3).insert("X").retain(3), "X");
+}
+
+TEST(TextOperation, TransformRejectsDifferentBases){
+  TextOperation aPrime, bPrime;
+  EXPECT_FALSE(TextOperation::transform(TextOperation().retain(3), TextOperation().retain(4), aPrime, bPrime));
+}
+
+TEST(TextOperation, ComposeMatchesSequentialApply){
+  const TextOperation first = TextOperation().retain(5).insert(" there");
+  const TextOperation second = TextOperation().remove(1).insert("H").retain(10);
+  TextOperation composed;
+  ASSERT_TRUE(TextOperation::compose(first, second, composed));
+  EXPECT_EQ(applied("hello", composed), applied(applied("hello", first), second));
+  EXPECT_FALSE(TextOperation::compose(first, first, composed)); // first doesn't apply to its own result
+}
+
+TEST(TextOperation, WireFormsRoundTrip){
+  const TextOperation operation = TextOperation().retain(5).insert("abc").remove(2).retain(10);
+  TextOperation fromJson;
+  ASSERT_TRUE(TextOperation::fromJson(operation.toJson(), fromJson));
+  EXPECT_EQ(fromJson, operation);
+
+  TextOperation fromCbor;
+  ASSERT_TRUE(TextOperation::fromCbor(QCborArray {5, "abc", -2, 10}, fromCbor));
+  EXPECT_EQ(fromCbor, operation);
+}
+
+TEST(TextOperation, DecodeRejectsLengthsPastTheLimit){
+  TextOperation operation;
+  const qint64 limit = TextOperation::c_maxDocumentLength;
+  EXPECT_TRUE(TextOperation::fromCbor(QCborArray {limit}, operation));
+  EXPECT_FALSE(TextOperation::fromCbor(QCborArray {limit + 1}, operation));
+  EXPECT_FALSE(TextOperation::fromCbor(QCborArray {limit, 1}, operation));       // Sum over the limit
+  EXPECT_FALSE(TextOperation::fromCbor(QCborArray {-limit, -1}, operation));     // Base via removes
+  EXPECT_FALSE(TextOperation::fromJson(QJsonArray {double(limit), double(-1), double(1)}, operation));
+}
+
+TEST(TextOperation, DecodeRejectsValuesThatWouldOverflow){
+  TextOperation operation;
+  const qint64 max = std::numeric_limits<qint64>::max();
+  const qint64 min = std::numeric_limits<qint64>::min();
+  EXPECT_FALSE(TextOperation::fromCbor(QCborArray {max, max}, operation));
+  EXPECT_FALSE(TextOperation::fromCbor(QCborArray {min}, operation)); // -min isn't representable
+  EXPECT_FALSE(TextOperation::fromJson(QJsonArray {9.0e18, 9.0e18}, operation));
+  EXPECT_FALSE(TextOperation::fromCbor(QCborArray {0}, operation));
+  EXPECT_FALSE(TextOperation::fromCbor(QCborArray {1.5}, operation));
+}
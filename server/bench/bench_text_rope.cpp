@@ -0,0 +1,104 @@
+/*
+Microbenchmarks: TextRope vs flat QString as Active File buffer
+Sizes follow NFR-PERF-006 and generated files seen in real workspaces: 10 KB, 1 MB, 10 MB.
+Each edit is insert + remove at random positions so document size stays fixed.
+Run: ./server_bench --benchmark_format=json
+*/
+#include <benchmark/benchmark.h>
+
+#include <QString>
+
+#include <random>
+
+#include "TextRope.h"
+
+namespace {
+  // Source-like text: 80 column lines
+  QString makeText(qsizetype size){
+    QString text(size, QLatin1Char('x'));
+    for(qsizetype i = 79; i < size; i += 80) {
+      text[i] = QLatin1Char('\n');
+    }
+    return text;
+  }
+
+  void sizes(benchmark::internal::Benchmark *benchmark){
+    benchmark->Arg(10 * 1024)->Arg(1024 * 1024)->Arg(10 * 1024 * 1024);
+  }
+}
+
+static void BM_QString_Edit(benchmark::State &state){
+  QString text = makeText(state.range(0));
+  std::minstd_rand random(42);
+  for(auto _ : state) {
+    text.insert(random() % text.size(), QLatin1Char('a'));
+    text.remove(random() % text.size(), 1);
+    benchmark::DoNotOptimize(text.data());
+  }
+}
+BENCHMARK(BM_QString_Edit)->Apply(sizes);
+
+static void BM_TextRope_Edit(benchmark::State &state){
+  TextRope rope(makeText(state.range(0)));
+  const QString character(QLatin1Char('a'));
+  std::minstd_rand random(42);
+  for(auto _ : state) {
+    rope.insert(random() % rope.length(), character);
+    rope.remove(random() % rope.length(), 1);
+  }
+  benchmark::DoNotOptimize(rope.length());
+}
+BENCHMARK(BM_TextRope_Edit)->Apply(sizes);
+
+// Late joiner takes a snapshot while editing continues: QString detaches (full copy) on next edit
+static void BM_QString_SnapshotThenEdit(benchmark::State &state){
+  QString text = makeText(state.range(0));
+  std::minstd_rand random(42);
+  for(auto _ : state) {
+    QString snapshot = text;
+    text[random() % text.size()] = QLatin1Char('a');
+    benchmark::DoNotOptimize(snapshot.constData());
+  }
+}
+BENCHMARK(BM_QString_SnapshotThenEdit)->Apply(sizes);
+
+static void BM_TextRope_SnapshotThenEdit(benchmark::State &state){
+  TextRope rope(makeText(state.range(0)));
+  const QString character(QLatin1Char('a'));
+  std::minstd_rand random(42);
+  for(auto _ : state) {
+    TextRope snapshot = rope.snapshot();
+    const qsizetype position = random() % rope.length();
+    rope.remove(position, 1);
+    rope.insert(position, character);
+    benchmark::DoNotOptimize(snapshot.length());
+  }
+}
+BENCHMARK(BM_TextRope_SnapshotThenEdit)->Apply(sizes);
+
+// Start offset of a random line (QString has no index, newlines are scanned)
+static void BM_QString_LineStart(benchmark::State &state){
+  const QString text = makeText(state.range(0));
+  const qsizetype lines = text.count(QLatin1Char('\n')) + 1;
+  std::minstd_rand random(42);
+  for(auto _ : state) {
+    qsizetype line = random() % lines;
+    qsizetype position = 0;
+    while(line-- > 0) {
+      position = text.indexOf(QLatin1Char('\n'), position) + 1;
+    }
+    benchmark::DoNotOptimize(position);
+  }
+}
+BENCHMARK(BM_QString_LineStart)->Apply(sizes);
+
+static void BM_TextRope_LineStart(benchmark::State &state){
+  const TextRope rope(makeText(state.range(0)));
+  std::minstd_rand random(42);
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(rope.lineStart(random() % rope.lineCount()));
+  }
+}
+BENCHMARK(BM_TextRope_LineStart)->Apply(sizes);
+
+BENCHMARK_MAIN();
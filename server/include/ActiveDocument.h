@@ -0,0 +1,55 @@
+#ifndef __ACTIVE_DOCUMENT_H__
+#define __ACTIVE_DOCUMENT_H__
+
+#include <QString>
+
+#include <deque>
+
+#include "synergy_protocol/TextOperation.h"
+#include "TextRope.h"
+
+/*
+------------------------------------------------------------------
+------------------ Authoritative document (server) ---------------
+Current text of one file in a session, its revision (number of
+operations applied so far) and the recent operations themselves.
+Operation made by a client on an older revision is transformed over
+everything applied after that revision, then applied. Result is what
+other clients receive, so every copy converges without full-file
+transfers.
+Only a bounded window of history is kept; operation based on a
+revision older than that is rejected and its author resyncs from a
+snapshot.
+Text is a TextRope, so applying an edit costs O(log n) in file size
+and snapshots for late joiners are O(1).
+------------------------------------------------------------------
+*/
+class ActiveDocument {
+public:
+  enum class t_ApplyResult { APPLIED, STALE_REVISION, INVALID_OPERATION };
+
+  static constexpr std::size_t c_maxHistory = 1024;
+
+  ActiveDocument() = default;
+  explicit ActiveDocument(const QString &content);
+
+  const TextRope& text() const { return m_text; }
+  QString content() const { return m_text.toString(); } // Materializes whole file
+  quint64 revision() const { return m_revision; }
+
+  // 'applied' receives operation as it was applied on top of current revision
+  t_ApplyResult apply(quint64 baseRevision, const SynergyProtocol::TextOperation &operation, SynergyProtocol::TextOperation &applied);
+
+  // Full content replacement, recorded in history like any other edit
+  void replaceContent(const QString &content);
+
+private:
+  TextRope m_text;
+  quint64 m_revision = 0;
+  std::deque<SynergyProtocol::TextOperation> m_history; // Operations that produced revisions (m_revision - size, m_revision]
+
+  void record(SynergyProtocol::TextOperation operation);
+  bool applyToText(const SynergyProtocol::TextOperation &operation);
+};
+
+#endif
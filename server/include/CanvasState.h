@@ -0,0 +1,86 @@
+#ifndef __CANVAS_STATE_H__
+#define __CANVAS_STATE_H__
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QRectF>
+#include <QPointF>
+
+#include <vector>
+
+#include "synergy_protocol/Message_Draw_Command.h"
+#include "synergy_protocol/Message_Draw_Polyline.h"
+#include "synergy_protocol/Message_Canvas_Snapshot.h"
+
+/*
+------------------------------------------------------------------
+----------------------- Canvas of one session --------------------
+Server side whiteboard state, so a late joiner gets the picture
+without a replay of the whole history (spec 11.2.2, SRV-FUNC-SYNC-005):
+- every relayed DRAW_COMMAND / DRAW_POLYLINE is appended to a log
+- once the log holds 'compactThreshold' points it is compacted: strokes
+  are rasterized into 'c_tileSize' square tiles of a grid (only tiles
+  a segment actually crosses), stored as PNG, log is emptied
+- joiner gets snapshot() (non-empty tiles) followed by tail() replayed
+  as DRAW_POLYLINEs
+Drawing outside +-c_maxExtent pixels is relayed live but not kept, so
+tile count, log length and therefore memory and join cost are bounded
+however long the session runs. Compaction (PNG decode, paint, encode)
+runs on the global thread pool over a copy of the log and of the tiles
+it touches; the main thread only swaps the new tiles in when it is
+done. Strokes being compacted stay in tail() until then, and strokes
+drawn meanwhile wait for the next round, so a joiner always gets tiles
+plus exactly the strokes they don't contain yet. One compaction per
+canvas at a time.
+------------------------------------------------------------------
+*/
+class CanvasState : public QObject {
+  Q_OBJECT
+public:
+  static constexpr int c_tileSize = 256;
+  static constexpr int c_defaultCompactThreshold = 2048; // Points
+  static constexpr double c_maxExtent = 4096.0;          // Kept area is [-extent, extent) on both axes
+  static constexpr double c_maxStrokeWidth = 64.0;
+
+  explicit CanvasState(int compactThreshold = c_defaultCompactThreshold, QObject *parent = nullptr);
+
+  void append(const SynergyProtocol::Message_Draw_Command &command);
+  void append(const SynergyProtocol::Message_Draw_Polyline &polyline);
+  // Starts folding the whole log into tiles in the background (no-op while one runs), append() calls it when log is full
+  void compact();
+  bool isCompacting() const { return !m_compacting.empty(); }
+
+  SynergyProtocol::Message_Canvas_Snapshot snapshot() const;
+  QList<SynergyProtocol::Message_Draw_Polyline> tail() const;
+  bool isEmpty() const { return m_tiles.isEmpty() && m_log.empty() && m_compacting.empty(); }
+  int tileCount() const { return static_cast<int>(m_tiles.size()); }
+
+private:
+  struct Stroke {
+    QList<QPointF> points;
+    QString color;
+    double width;
+    QString originatorId;
+    quint64 strokeId;
+  };
+
+  using Tiles = QHash<qint64, QByteArray>; // Tile key -> PNG
+
+  int m_compactThreshold;
+  std::vector<Stroke> m_compacting;  // Handed to the running compaction, in order
+  std::vector<Stroke> m_log;         // Strokes after those, in order
+  int m_logPoints = 0;
+  Tiles m_tiles;
+
+  static qint64 tileKey(qint32 x, qint32 y) { return (qint64(y) << 32) | quint32(x); }
+  static QRectF tileRect(qint32 x, qint32 y);
+  static bool crosses(const QPointF &from, const QPointF &to, double width, const QRectF &area);
+  // Worker thread: tiles touched by 'strokes', painted over their version in 'tiles'
+  static Tiles render(const std::vector<Stroke> &strokes, const Tiles &tiles);
+  void append(Stroke stroke);
+  void compacted(const Tiles &updated);
+};
+
+#endif
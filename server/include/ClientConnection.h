@@ -0,0 +1,102 @@
+#ifndef __CLIENT_CONNECTION_H__
+#define __CLIENT_CONNECTION_H__
+
+#include <QObject>
+#include <QSslSocket>
+#include <QSslConfiguration>
+#include <QDebug>
+
+#include <memory>
+
+#include "synergy_protocol/MessageFactory.h"
+#include "synergy_protocol/FrameDecoder.h"
+#include "synergy_protocol/FrameCompressor.h"
+#include "synergy_protocol/FrameBufferPool.h"
+#include "synergy_protocol/MessagePool.h"
+#include "synergy_protocol/Message_Ping.h"
+#include "synergy_protocol/Message_Pong.h"
+#include "synergy_protocol/AsyncLog.h"
+#include "OutboundQueue.h"
+#include "TlsContextCache.h"
+#include "Metrics.h"
+
+/*
+------------------------------------------------------------------
+---------------------- One connected client ----------------------
+Owns the QSslSocket of a single client and everything that is
+per-socket: TLS handshake, frame reassembly, wire format negotiation
+and parsing, outbound backlog (OutboundQueue). Lives in (and is only touched from) the thread of the
+ConnectionWorker that accepted it.
+Parsed messages leave the I/O thread through messageReceived.
+------------------------------------------------------------------
+*/
+class ClientConnection : public QObject {
+  Q_OBJECT
+public:
+  explicit ClientConnection(qintptr clientId, OutboundQueue::Limits outboundLimits = OutboundQueue::Limits(), QObject *parent = nullptr);
+
+  // Wraps accepted descriptor and starts server-side handshake (on the shared TLS context, if any). False if descriptor is invalid
+  bool start(qintptr socketDescriptor, const QSslConfiguration &configuration, TlsContextCache *tlsContexts = nullptr);
+
+  qintptr clientId() const { return m_clientId; }
+  SynergyProtocol::t_WireFormat wireFormat() const { return m_wireFormat; }
+  SynergyProtocol::t_Compression compression() const { return m_compression; }
+  bool isEncrypted() const { return m_socket && m_socket->isEncrypted(); }
+  // Metrics::now() of the last bytes received (connection start until then)
+  qint64 lastReceivedNs() const { return m_lastReceivedNs; }
+
+  void sendFrame(const QByteArray &payload);
+  // Already length-prefixed and compressed for compression() (shared broadcast frames, see ConnectionWorker)
+  void writeFrame(const QByteArray &frame, const FramePolicy &policy = FramePolicy());
+  void sendMessage(const SynergyProtocol::Message_Base &message);
+  void sendPing(); // Liveness probe, any reply refreshes lastReceivedNs
+  void close();
+  void abort();    // Drops the connection without waiting for the peer (dead or stalled ones)
+
+signals:
+  void messageReceived(qintptr clientId, std::shared_ptr<const SynergyProtocol::Message_Base> message);
+  void disconnected(qintptr clientId);
+  void wireFormatNegotiated(qintptr clientId, SynergyProtocol::t_WireFormat format);
+  // DELTA frames of 'key' were dropped, client needs the full state of it
+  void resyncNeeded(qintptr clientId, const QString &key);
+  // Frame posted with FramePolicy::deliveryToken was handed to the socket
+  void frameDelivered(qintptr clientId, quint64 deliveryToken);
+  // Frame posted with FramePolicy::deliveryToken was dropped or replaced in the outbound queue
+  void frameDiscarded(qintptr clientId, quint64 deliveryToken);
+  // Handshake completed or connection died during it, emitted once
+  void handshakeFinished(qintptr clientId);
+
+private slots:
+  void onReadyRead();
+  void onDisconnected();
+  void onSslErrors(const QList<QSslError> &errors);
+  void onEncrypted(); // Slot notified when handshake is complete
+  void pumpOutbound(); // Moves queued frames into the socket while it is under budget
+
+private:
+  static constexpr const char* c_serverVersion = "1.0.0";
+
+  qintptr m_clientId;
+  QSslSocket *m_socket = nullptr; // Child of this object
+  TlsContextCache *m_tlsContexts = nullptr;
+  bool m_handshaking = false;
+  qint64 m_handshakeStartNs = 0;
+  qint64 m_lastReceivedNs = 0;
+  quint32 m_pingToken = 0;   // Of the last PING sent
+  qint64 m_pingSentNs = 0;
+  SynergyProtocol::FrameDecoder m_decoder; // Reassembly buffer for length-prefixed frames
+  SynergyProtocol::t_WireFormat m_wireFormat = SynergyProtocol::t_WireFormat::JSON; // JSON until clientHello negotiates
+  SynergyProtocol::t_Compression m_compression = SynergyProtocol::t_Compression::NONE; // Same
+  OutboundQueue m_outbound;
+  qint64 m_reportedBacklog = 0;  // Share of OUTBOUND_QUEUED_BYTES this connection added
+  quint64 m_reportedDropped = 0;
+
+  void handleFrame(const QByteArray &frame);
+  void finishHandshake();
+  void reportBacklog(); // Queue changes since last call -> metrics
+  void handleClientHello(const SynergyProtocol::Message_Client_Hello &hello);
+};
+
+Q_DECLARE_METATYPE(std::shared_ptr<const SynergyProtocol::Message_Base>)
+
+#endif
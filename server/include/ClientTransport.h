@@ -0,0 +1,28 @@
+#ifndef __CLIENT_TRANSPORT_H__
+#define __CLIENT_TRANSPORT_H__
+
+#include <QList>
+#include <QByteArray>
+
+#include "synergy_protocol/protocol.h"
+#include "OutboundQueue.h"
+
+/*
+What sessions need from the network layer: which wire format a client
+negotiated and a way to hand ready-made frames to a group of clients.
+Implemented by SslServer, which knows which I/O worker owns each client.
+*/
+class ClientTransport {
+public:
+  virtual ~ClientTransport() = default;
+
+  virtual SynergyProtocol::t_WireFormat wireFormat(qintptr clientId) const = 0;
+
+  // 'frame' is complete (length prefix included) and is shared, not copied, between recipients.
+  // 'policy' says what may happen to it for a recipient that can't keep up
+  virtual void postFrame(const QList<qintptr> &clientIds, const QByteArray &frame, const FramePolicy &policy = FramePolicy()) = 0;
+
+  virtual void disconnectClient(qintptr clientId) = 0;
+};
+
+#endif
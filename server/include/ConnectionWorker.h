@@ -0,0 +1,126 @@
+#ifndef __CONNECTION_WORKER_H__
+#define __CONNECTION_WORKER_H__
+
+#include <QObject>
+#include <QHash>
+#include <QSslConfiguration>
+#include <QTimer>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+#include "ClientConnection.h"
+#include "TimerWheel.h"
+
+/*
+------------------------------------------------------------------
+--------------------- I/O worker (one thread) --------------------
+Each worker runs in its own QThread with its own event loop and owns
+the ClientConnections handed to it. TLS handshakes, decryption and
+parsing of those clients all happen on that thread.
+At most 'maxConcurrentHandshakes' handshakes run at once per worker,
+accepted descriptors beyond that wait (TCP connected, kernel buffers
+the ClientHello) and start in order as slots free up. When a whole lab
+reconnects at once, connections complete one batch after the other
+instead of all crawling along together and timing out. The queue is
+bounded: past 'c_maxWaitingHandshakes' the oldest waiting descriptor
+is closed (its client has most likely given up already).
+Liveness: every connection has one timer in the worker's TimerWheel
+(one QTimer per worker, ticking only while timers exist). First it
+is the handshake deadline, armed when the descriptor is accepted so
+time queued for a slot counts (a queued descriptor past it is closed
+unstarted); once encrypted it becomes a lazy idle
+check that reads the connection's last receive time, so traffic
+never touches the wheel. A connection quiet for 'pingIntervalMs'
+gets a PING (any frame back counts, PONG included), one that stays
+silent for 'idleTimeoutMs' is aborted: half-open TCP connections
+and stalled handshakes free their descriptor and handshake slot.
+Public methods marked thread-safe may be called from any thread: they
+only post a queued call into the worker's event loop.
+------------------------------------------------------------------
+*/
+class ConnectionWorker : public QObject {
+  Q_OBJECT
+public:
+  static constexpr int c_defaultMaxConcurrentHandshakes = 32;
+  static constexpr int c_maxWaitingHandshakes = 1024; // Per worker
+
+  // Milliseconds, 0 turns a check off (pingIntervalMs 0: no idle checks at all)
+  struct Liveness {
+    int handshakeTimeoutMs = 10000; // From accept: wait for a slot + handshake
+    int pingIntervalMs = 15000;     // Nothing received this long -> PING, repeated while quiet
+    int idleTimeoutMs = 45000;      // Nothing received this long -> connection aborted
+    int tickMs = 250;               // Timer resolution
+  };
+
+  ConnectionWorker(int index, const QSslConfiguration &configuration, OutboundQueue::Limits outboundLimits = OutboundQueue::Limits(),
+                   TlsContextCache *tlsContexts = nullptr, int maxConcurrentHandshakes = c_defaultMaxConcurrentHandshakes,
+                   Liveness liveness = Liveness());
+
+  int index() const { return m_index; }
+
+  // Number of clients assigned to this worker (thread-safe, approximate while handoffs are in flight)
+  int load() const { return m_load.load(std::memory_order_relaxed); }
+
+  // Thread-safe: accepted descriptor is wrapped into a QSslSocket on the worker thread
+  void addConnection(qintptr socketDescriptor, qintptr clientId);
+
+  // Thread-safe: queue a raw frame payload / message for one client. Unknown ids are ignored
+  void postFrame(qintptr clientId, const QByteArray &payload);
+  void postMessage(qintptr clientId, std::shared_ptr<const SynergyProtocol::Message_Base> message);
+
+  // Thread-safe: one queued call writes the same pre-encoded frame (length prefix included) to many clients
+  void postEncodedFrame(const QList<qintptr> &clientIds, const QByteArray &frame, const FramePolicy &policy = FramePolicy());
+
+  // Thread-safe: gracefully close client connection
+  void postDisconnect(qintptr clientId);
+
+signals:
+  // Emitted from worker thread, receivers in other threads get them queued
+  void clientConnected(qintptr clientId);
+  void clientDisconnected(qintptr clientId);
+  void messageReceived(qintptr clientId, std::shared_ptr<const SynergyProtocol::Message_Base> message);
+  void wireFormatNegotiated(qintptr clientId, SynergyProtocol::t_WireFormat format);
+  void resyncNeeded(qintptr clientId, const QString &key);
+  void frameDelivered(qintptr clientId, quint64 deliveryToken);
+  void frameDiscarded(qintptr clientId, quint64 deliveryToken);
+
+private:
+  enum t_Timer : int {
+    HANDSHAKE_DEADLINE,
+    LIVENESS
+  };
+
+  struct WaitingHandshake {
+    qintptr socketDescriptor;
+    qintptr clientId;
+  };
+
+  int m_index;
+  QSslConfiguration m_sslConfiguration;
+  OutboundQueue::Limits m_outboundLimits;
+  TlsContextCache *m_tlsContexts; // Owned by server, shared by all workers
+  int m_maxConcurrentHandshakes;
+  int m_handshakes = 0;                                   // In flight on this worker
+  std::deque<WaitingHandshake> m_waitingHandshakes; // Oldest first
+  QHash<qintptr, ClientConnection*> m_connections; // Only touched on worker thread
+  std::atomic<int> m_load {0};
+  Liveness m_liveness;
+  TimerWheel m_wheel;
+  QTimer *m_tick;                              // Child, drives m_wheel
+  QHash<qintptr, TimerWheel::t_TimerId> m_timers; // At most one per connection
+
+  void openConnection(qintptr socketDescriptor, qintptr clientId);
+  void startConnection(qintptr socketDescriptor, qintptr clientId);
+  void shedWaiting(std::deque<WaitingHandshake>::iterator waiting); // Closes the descriptor unstarted
+  void onHandshakeFinished(qintptr finishedClientId);
+  void onConnectionClosed(qintptr clientId);
+  void scheduleTimer(qintptr clientId, t_Timer kind, qint64 delayMs); // Replaces the client's timer
+  void onTick();
+  void onTimer(qintptr clientId, int kind);
+
+  static qint64 nowMs() { return Metrics::now() / 1000000; }
+};
+
+#endif
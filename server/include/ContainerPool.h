@@ -0,0 +1,120 @@
+#ifndef __CONTAINER_POOL_H__
+#define __CONTAINER_POOL_H__
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+
+#include <functional>
+
+#include "DockerApiClient.h"
+
+/*
+------------------------------------------------------------------
+------------------ Warm worker containers (one image) ------------
+Creating and starting a container dominates run latency, so containers
+are created ahead of time and reused:
+- 'warmContainers' idle, started containers are kept ready
+- lease() hands out an idle one at once, otherwise the request waits
+  until one is created/returned; never more than 'maxContainers' exist
+- release() resets the container (kills leftover processes, empties
+  the scratch tmpfs mounts and /dev/shm) and puts it back, or removes
+  it when run failed/timed out or it has served 'maxRunsPerContainer'
+  runs. Root file system is read-only, so besides /workspace nothing a
+  run writes survives into another session's lease
+- /workspace survives the reset: lease() prefers an idle container last
+  released with the same affinity key (workspace), so the caller only
+  has to send what changed. Caller owns what's in /workspace and must
+  clear it when the container comes from another workspace
+- health check inspects idle containers periodically, dead ones are
+  removed and replaced
+Containers carry label synergy.pool=<image>, leftovers of a previous
+server process are removed on start(). Main thread only.
+------------------------------------------------------------------
+*/
+class ContainerPool : public QObject {
+  Q_OBJECT
+public:
+  struct Config {
+    QString image = QStringLiteral("synergy-worker:latest");
+    int warmContainers = 2;
+    int maxContainers = 8;
+    int maxRunsPerContainer = 20;
+    int healthCheckIntervalMs = 10000;
+    qint64 memoryLimitBytes = 512ll * 1024 * 1024;
+    int pidsLimit = 256;
+    qint64 scratchLimitBytes = 64ll * 1024 * 1024; // Each tmpfs scratch mount and /dev/shm
+  };
+
+  static constexpr const char* c_poolLabel = "synergy.pool";
+  static constexpr const char* c_workspacePath = "/workspace";
+  // Writable tmpfs mounts on the read-only root file system, emptied on every reset
+  static constexpr const char* c_scratchPaths[] = {"/tmp", "/var/tmp", "/root", "/home"};
+
+  // Empty error -> 'containerId' is leased to the caller, who must release() it
+  using LeaseHandler = std::function<void(const QString &containerId, const QString &error)>;
+
+  ContainerPool(DockerApiClient &docker, Config config, QObject *parent = nullptr);
+  ~ContainerPool() override;
+
+  // Removes leftovers, then warms the pool and starts health checks
+  void start();
+
+  void lease(LeaseHandler handler, const QString &affinity = QString());
+  // healthy == false -> container is removed instead of reused
+  void release(const QString &containerId, bool healthy, const QString &affinity = QString());
+
+  const Config& config() const { return m_config; }
+  int idleCount() const { return m_idle.size(); }
+  int containerCount() const { return m_containers.size() + m_creating; }
+
+signals:
+  // Container is gone (recycled, unhealthy), anything known about its content is stale
+  void containerRemoved(const QString &containerId);
+
+private slots:
+  void checkHealth();
+
+private:
+  enum class t_State { IDLE, LEASED, RESETTING };
+
+  struct Container {
+    t_State state = t_State::IDLE;
+    int runs = 0;
+    QString affinity; // Key of last lease
+  };
+
+  struct Waiter {
+    LeaseHandler handler;
+    QString affinity;
+  };
+
+  static constexpr int c_resetTimeoutMs = 10000;
+  static constexpr int c_maxBackoffMs = 60000;
+
+  DockerApiClient &m_docker;
+  Config m_config;
+  QHash<QString, Container> m_containers; // Created and started containers by id
+  QList<QString> m_idle;                  // Ready for lease, oldest first
+  QList<Waiter> m_waiters;                // Lease requests waiting for a container
+  int m_creating = 0;                     // Creations in flight, count towards the cap
+  int m_resetting = 0;
+  int m_failedCreations = 0;              // Consecutive, drives backoff
+  bool m_started = false;
+  QTimer m_healthTimer {this};
+  QTimer m_retryTimer {this};
+
+  void removeLeftovers();
+  void replenish();
+  void createContainer();
+  void onContainerReady(const QString &containerId);
+  void onCreationFailed(const QString &error);
+  void resetContainer(const QString &containerId);
+  void recycle(const QString &containerId);
+  void handOut();
+  QByteArray createBody() const;
+};
+
+#endif
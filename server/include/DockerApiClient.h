@@ -0,0 +1,142 @@
+#ifndef __DOCKER_API_CLIENT_H__
+#define __DOCKER_API_CLIENT_H__
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QStringList>
+#include <QLocalSocket>
+#include <QIODevice>
+#include <QTimer>
+#include <QPointer>
+
+#include <functional>
+#include <memory>
+
+/*
+------------------------------------------------------------------
+------------------ Docker Engine API client (async) --------------
+Minimal HTTP/1.1 client for the Docker Engine REST API over its Unix
+socket (IF-SW-DOCKER-003). Socket path is configurable, so any local
+stand-in speaking the same HTTP subset can replace the daemon.
+One connection per request ("Connection: close"), everything is
+driven by QLocalSocket signals on the calling thread, nothing blocks.
+Response body: Content-Length, chunked, or until connection close
+(raw exec streams). With a data callback body is streamed instead of
+collected.
+------------------------------------------------------------------
+*/
+class DockerHttpExchange;
+
+class DockerApiClient : public QObject {
+  Q_OBJECT
+public:
+  static constexpr const char* c_defaultSocketPath = "/var/run/docker.sock";
+  static constexpr const char* c_apiVersion = "/v1.41"; // Docker 20.10+ (IF-SW-DOCKER-002)
+  static constexpr int c_defaultTimeoutMs = 30000;
+
+  struct Response {
+    int status = 0;      // HTTP status, 0 if request never completed
+    QByteArray body;     // Empty when streamed through data callback
+    QString error;       // Transport error or API error message
+
+    bool ok() const { return status >= 200 && status < 300; }
+    QJsonDocument json() const { return QJsonDocument::fromJson(body); }
+  };
+
+  using ResponseHandler = std::function<void(const Response&)>;
+  using DataHandler = std::function<void(const QByteArray&)>;
+  using ExecDoneHandler = std::function<void(int exitCode, const QString &error)>;
+
+  // Running exec, see cancelExec()
+  struct ExecHandle {
+    QPointer<DockerHttpExchange> stream; // Attached start request while it runs
+    QString cancelReason;                // Non-empty once cancelled
+  };
+
+  explicit DockerApiClient(QString socketPath = QString::fromLatin1(c_defaultSocketPath), QObject *parent = nullptr);
+
+  const QString& socketPath() const { return m_socketPath; }
+
+  // 'path' without version prefix, e.g. "/containers/create". timeoutMs <= 0 -> no timeout.
+  // Exchange deletes itself once onDone ran, hold it in a QPointer
+  DockerHttpExchange* request(const QByteArray &method, const QString &path, const QByteArray &body, ResponseHandler onDone,
+               DataHandler onData = {}, const QByteArray &contentType = "application/json", int timeoutMs = c_defaultTimeoutMs);
+
+  /*
+  Request whose body is read from 'body' while it's being sent (e.g. tar stream), so
+  body never has to be in memory at once. Socket buffer is kept below c_sendWatermark,
+  'body' is read only as fast as the daemon takes it. 'length' goes into Content-Length,
+  device must deliver exactly that many bytes. Exchange drops its reference once body is sent.
+  */
+  void upload(const QByteArray &method, const QString &path, std::shared_ptr<QIODevice> body, qint64 length,
+              const QByteArray &contentType, ResponseHandler onDone, int timeoutMs = c_defaultTimeoutMs);
+
+  void get(const QString &path, ResponseHandler onDone) { request("GET", path, QByteArray(), std::move(onDone)); }
+  void post(const QString &path, const QByteArray &json, ResponseHandler onDone) { request("POST", path, json, std::move(onDone)); }
+  void remove(const QString &path, ResponseHandler onDone) { request("DELETE", path, QByteArray(), std::move(onDone)); }
+
+  /*
+  Runs command in a running container: exec create -> start (attached) -> inspect.
+  onOutput gets raw multiplexed stream (8-byte frame headers, Tty is off).
+  exitCode is -1 when exec didn't complete, 'error' then says why.
+  */
+  std::shared_ptr<ExecHandle> exec(const QString &containerId, const QStringList &command, const QString &workingDir,
+                                   DataHandler onOutput, ExecDoneHandler onDone, int timeoutMs = c_defaultTimeoutMs);
+
+  /*
+  Detaches from the exec: output stream is closed and onDone gets -1 with 'reason'.
+  The API can't kill an exec, the process keeps running until its container is
+  stopped, so the container must not be reused.
+  */
+  static void cancelExec(const std::shared_ptr<ExecHandle> &exec, const QString &reason);
+
+private:
+  QString m_socketPath;
+
+  static QByteArray requestHead(const QByteArray &method, const QString &path, const QByteArray &contentType, qint64 length);
+};
+
+// One in-flight request, deletes itself when done. Internal to DockerApiClient
+class DockerHttpExchange : public QObject {
+  Q_OBJECT
+public:
+  static constexpr qint64 c_sendWatermark = 256 * 1024;
+  static constexpr qint64 c_sendChunk = 64 * 1024;
+
+  DockerHttpExchange(const QString &socketPath, QByteArray request, DockerApiClient::ResponseHandler onDone,
+                     DockerApiClient::DataHandler onData, int timeoutMs, QObject *parent,
+                     std::shared_ptr<QIODevice> body = nullptr, qint64 bodyLength = 0);
+
+  void abort(const QString &reason);
+
+private slots:
+  void onConnected();
+  void onReadyRead();
+  void onDisconnected();
+  void onError(QLocalSocket::LocalSocketError error);
+
+private:
+  enum class t_State { HEADERS, BODY_LENGTH, BODY_CHUNK_SIZE, BODY_CHUNK_DATA, BODY_CHUNK_END, BODY_UNTIL_CLOSE, DONE };
+
+  QLocalSocket m_socket;
+  QTimer m_timeout;
+  QByteArray m_request;
+  std::shared_ptr<QIODevice> m_body; // Streamed request body, null when body is part of m_request
+  qint64 m_bodyRemaining = 0;
+  QByteArray m_buffer;
+  DockerApiClient::ResponseHandler m_onDone;
+  DockerApiClient::DataHandler m_onData;
+  DockerApiClient::Response m_response;
+  t_State m_state = t_State::HEADERS;
+  qint64 m_remaining = 0; // Bytes left of body / current chunk
+
+  bool parseHeaders();
+  void parseBody();
+  void pumpBody();
+  void deliver(const QByteArray &data);
+  void finish();
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef __DOCKER_EXECUTOR_H__
+#define __DOCKER_EXECUTOR_H__
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+
+#include <functional>
+#include <memory>
+
+#include "DockerApiClient.h"
+#include "ContainerPool.h"
+#include "WorkspaceManifest.h"
+#include "DockerStreamDemuxer.h"
+
+/*
+------------------------------------------------------------------
+------------------ Code execution in Docker ----------------------
+Runs a RequestRunCode in a worker container (SRV-FUNC-DOCKER-004),
+with creation/removal taken out of the request path:
+1. scan workspace into a content manifest (thread pool, hashes are
+   reused for files whose size/mtime didn't change)
+2. lease warm container from the image's pool, preferring one that
+   already holds this workspace
+3. bring container's /workspace in line with the manifest: list what
+   changed inside since last upload, delete what the host doesn't have,
+   stream a tar of only the files whose content differs
+4. exec create + start attached, output is demultiplexed and handed on
+   as it arrives, until the exec exits, the run timeout hits or the
+   output handler wants no more (output limit); exec inspect -> exit code.
+   A run that is cut short leaves its process running, the container
+   is recycled instead of reused
+5. container goes back to the pool (reset) or is recycled on failure
+Container that comes from another workspace (or whose state is unknown)
+is wiped and gets the full workspace.
+One pool per image: default image plus the ones named in
+'environments' (RequestRunCode.targetEnvironment), created on first use.
+Everything is asynchronous on the main thread (SRV-FUNC-DOCKER-002).
+------------------------------------------------------------------
+*/
+class DockerExecutor : public QObject {
+  Q_OBJECT
+public:
+  struct Config {
+    QString socketPath = QString::fromLatin1(DockerApiClient::c_defaultSocketPath);
+    ContainerPool::Config pool;           // Default environment, other environments copy it with their image
+    QHash<QString, QString> environments; // Environment name -> image
+    int runTimeoutMs = 30000;
+    int uploadTimeoutMs = 120000;
+  };
+
+  struct Result {
+    int exitCode = -1;
+    QString error; // Non-empty -> run didn't complete, exitCode is meaningless
+  };
+
+  // False -> no more output wanted, the run is stopped (result carries an error)
+  using OutputHandler = std::function<bool(DockerStreamDemuxer::t_Stream stream, QByteArrayView data)>;
+  using ResultHandler = std::function<void(const Result&)>;
+
+  explicit DockerExecutor(Config config = Config(), QObject *parent = nullptr);
+  ~DockerExecutor() override;
+
+  // Warms the default pool. Without it pools start on first run
+  void start();
+
+  void run(const QString &workspaceRoot, const QString &command, const QStringList &args,
+           const QString &environment, OutputHandler output, ResultHandler done);
+
+  // Session closed: drop cached hashes of its workspace
+  void forgetWorkspace(const QString &workspaceRoot);
+
+private:
+  struct Run; // State of one run while it's in flight
+
+  // What a container's /workspace holds, as of our last upload
+  struct ContainerWorkspace {
+    QString workspaceRoot;
+    QHash<QString, QByteArray> hashes; // Relative path -> content hash
+  };
+
+  static constexpr const char* c_stampName = ".synergy-stamp";
+  static constexpr int c_syncTimeoutMs = 30000;
+  static constexpr int c_maxDeletePaths = 1000; // More than that -> wipe and upload everything
+
+  Config m_config;
+  DockerApiClient m_docker;
+  QHash<QString, ContainerPool*> m_pools;                  // Image -> pool, children of this
+  QHash<QString, WorkspaceManifest> m_hostManifests;       // Workspace root -> last scan, hash cache
+  QHash<QString, ContainerWorkspace> m_containerWorkspaces; // Container id -> its /workspace
+
+  ContainerPool* poolFor(const QString &environment, QString &error);
+  void scan(const std::shared_ptr<Run> &run);
+  void lease(const std::shared_ptr<Run> &run);
+  void listContainerWorkspace(const std::shared_ptr<Run> &run);
+  void synchronize(const std::shared_ptr<Run> &run, const QByteArray &listing);
+  void wipe(const std::shared_ptr<Run> &run);
+  void upload(const std::shared_ptr<Run> &run, const QSet<QString> &files, const QSet<QString> &directories);
+  void execute(const std::shared_ptr<Run> &run);
+  void fail(const std::shared_ptr<Run> &run, const QString &error);
+  void complete(const std::shared_ptr<Run> &run, bool containerHealthy);
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __DOCKER_STREAM_DEMUXER_H__
+#define __DOCKER_STREAM_DEMUXER_H__
+
+#include <QtGlobal>
+#include <QByteArrayView>
+
+#include <functional>
+
+/*
+Splits an attached (Tty: false) exec stream into stdout/stderr.
+Docker prefixes every write with 8 bytes:
+[stream: 1 byte][3 bytes 0][payload size: 4 bytes big-endian]
+Reads from the socket don't follow these boundaries. Payload is passed
+on as it arrives (a frame may come in pieces), nothing is buffered
+except an incomplete header.
+*/
+class DockerStreamDemuxer {
+public:
+  enum class t_Stream : quint8 {
+    STDIN = 0,
+    STDOUT = 1,
+    STDERR = 2
+  };
+
+  using PayloadHandler = std::function<void(t_Stream stream, QByteArrayView payload)>;
+
+  void feed(QByteArrayView data, const PayloadHandler &handler);
+
+  // True when stream ended inside a frame (connection cut off)
+  bool midFrame() const { return m_headerFill != 0 || m_payloadRemaining != 0; }
+
+private:
+  static constexpr int c_headerSize = 8;
+
+  uchar m_header[c_headerSize] {};
+  int m_headerFill = 0;
+  quint32 m_payloadRemaining = 0;
+  t_Stream m_stream = t_Stream::STDOUT;
+};
+
+#endif
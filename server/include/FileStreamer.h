@@ -0,0 +1,89 @@
+#ifndef __FILE_STREAMER_H__
+#define __FILE_STREAMER_H__
+
+#include <QString>
+#include <QHash>
+#include <QFile>
+
+#include <memory>
+
+#include "ClientTransport.h"
+#include "TextRope.h"
+
+/*
+------------------------------------------------------------------
+------------------ Chunked file open (server) --------------------
+Content of an opened file goes to the requester as FILE_CHUNKs of
+c_chunkSize bytes, so the client can show the beginning long before
+the end arrives and nothing on the way holds the whole file. Document
+snapshots the server pushes (join state, rejected operation) travel
+the same way. A new transfer of a file to a client replaces one still
+running (client restarts on the first chunk anyway).
+- File not edited in the session: read through QFile::map, one chunk
+  mapped at a time and encoded straight from the mapping. Workspace
+  saves replace files by rename, the open handle keeps the old content.
+- File edited in the session (disk may lag behind): from a snapshot of
+  its TextRope, converted to UTF-8 one chunk at a time.
+At most c_chunksInFlight chunks of a transfer sit in the client's
+outbound queue; next one is encoded when the socket takes one
+(FramePolicy::deliveryToken = transfer id). Server memory per open is
+bounded by chunk size, not file size, and a slow client only slows
+its own transfer. First chunk of a transfer is the document's STATE
+frame in the outbound queue, the rest are its STATE_PARTs, so a newer
+transfer (or full text) removes the chunks of an older one still
+queued and the older one is stopped (onDiscarded). The STATE
+supersedes queued operations of that document and ends a resync
+(stale key), operations after it are buffered by the client until the
+last chunk and can't start another resync before that chunk is out.
+Main thread only, like SessionManager.
+------------------------------------------------------------------
+*/
+class FileStreamer {
+public:
+  static constexpr qint64 c_chunkSize = 64 * 1024;
+  static constexpr int c_chunksInFlight = 4;
+
+  explicit FileStreamer(ClientTransport &transport);
+
+  // Streams file from disk as revision 'revision'. False if it can't be opened
+  bool openFile(qintptr clientId, const QString &filePath, const QString &absolutePath, quint64 revision);
+  // Streams 'text' (snapshot, editing may continue meanwhile) as revision 'revision'
+  void openText(qintptr clientId, const QString &filePath, const TextRope &text, quint64 revision);
+
+  // Chunk posted with 'deliveryToken' left the client's queue
+  void onDelivered(qintptr clientId, quint64 deliveryToken);
+  // Chunk posted with 'deliveryToken' was replaced in the client's queue, its transfer stops
+  void onDiscarded(qintptr clientId, quint64 deliveryToken);
+  // Client is gone, its transfers stop
+  void cancel(qintptr clientId);
+
+  int activeTransfers() const { return static_cast<int>(m_transfers.size()); }
+
+private:
+  struct Transfer {
+    quint64 id = 0;
+    qintptr clientId = 0;
+    QString filePath;
+    quint64 revision = 0;
+    qint64 totalSize = 0;    // UTF-8 bytes
+    qint64 offset = 0;       // Bytes already posted
+    int inFlight = 0;
+    bool posted = false;         // Last chunk is on its way
+    std::unique_ptr<QFile> file; // Disk source
+    TextRope text;               // Memory source (when there is no file)
+    qsizetype textPosition = 0;  // UTF-16 units already posted
+    QString stateKey;            // Document key, chunks are its STATE and STATE_PARTs
+  };
+
+  ClientTransport &m_transport;
+  QHash<quint64, Transfer> m_transfers; // Transfer id -> transfer
+  quint64 m_nextId = 1;
+
+  void start(Transfer transfer);
+  // Posts chunks until window is full or transfer is done (then it is removed)
+  void pump(quint64 transferId);
+  QByteArray nextFrame(Transfer &transfer);
+  static qint64 utf8Length(const TextRope &text);
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <QByteArray>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "synergy_protocol/protocol.h"
+
+/*
+------------------------------------------------------------------
+------------------------ Server metrics --------------------------
+Counters, gauges and latency histograms of the hot paths, scraped in
+Prometheus text format (MetricsEndpoint).
+Every thread writes into its own shard, picked once per thread: no
+lock and no shared cache line on the recording side, a plain
+load+store on a relaxed atomic (single writer). A scrape sums all
+shards; it may see a shard mid-update, which is off by at most that
+one sample. Shards of finished threads are handed to the next new
+thread, their values stay in the totals.
+Histograms are log-linear (HDR style): exact up to 16 ns, then 16
+buckets per power of two, so any recorded value is known within
+6.25% up to ~36 minutes; longer ones share one overflow bucket.
+Percentiles are computed from those buckets at scrape time, nothing
+is sampled or reset.
+Gauges are changed by deltas (adjust), the sum over shards is the
+value, whichever thread did the changing.
+------------------------------------------------------------------
+*/
+class Metrics {
+public:
+  enum class t_Counter : quint8 {
+    CONNECTIONS_ACCEPTED,
+    HANDSHAKES_FAILED,  // Connection closed before the handshake completed
+    CONNECTIONS_TIMED_OUT, // Aborted for a missed handshake deadline or idle timeout
+    HANDSHAKES_SHED,    // Closed while queued for a handshake slot: queue full or waited too long
+    BYTES_IN,           // Decrypted application bytes, length prefixes included
+    BYTES_OUT,          // Same, as handed to the socket (compressed frames at compressed size)
+    FRAMES_IN,
+    FRAMES_OUT,
+    FRAMES_DROPPED,     // Superseded or shed by outbound queues
+    PARSE_FAILURES,
+    RUNS_FAILED,
+    COUNT
+  };
+
+  enum class t_Gauge : quint8 {
+    CONNECTIONS_OPEN,
+    HANDSHAKES_IN_PROGRESS,
+    HANDSHAKES_QUEUED,       // Accepted, waiting for a handshake slot on their worker
+    OUTBOUND_QUEUED_BYTES,   // All clients' outbound queues together
+    COUNT
+  };
+
+  enum class t_Histogram : quint8 {
+    HANDSHAKE,     // Handshake start -> encrypted
+    PARSE,         // Frame payload -> typed message (I/O thread)
+    DISPATCH,      // SessionManager handling one message (main thread)
+    BROADCAST,     // Session encoding + journaling + routing one outgoing message (main thread)
+    FANOUT,        // One worker writing a shared frame to its recipients (I/O thread)
+    DOCKER_SCAN,   // Workspace manifest
+    DOCKER_LEASE,  // Waiting for a pooled container
+    DOCKER_SYNC,   // Bringing container's /workspace in line
+    DOCKER_EXEC,   // Exec create -> exit
+    DOCKER_RUN,    // Whole run, request -> result
+    COUNT
+  };
+
+  static void add(t_Counter counter, quint64 value = 1);
+  static void adjust(t_Gauge gauge, qint64 delta);
+  static void record(t_Histogram histogram, qint64 nanoseconds);
+  // Received messages, per type
+  static void countMessage(SynergyProtocol::t_MessageType type);
+
+  static qint64 now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Records time from construction to destruction
+  class ScopedTimer {
+  public:
+    explicit ScopedTimer(t_Histogram histogram) : m_histogram(histogram), m_start(now()) {}
+    ~ScopedTimer() { record(m_histogram, now() - m_start); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+  private:
+    t_Histogram m_histogram;
+    qint64 m_start;
+  };
+
+  // All shards summed, Prometheus text exposition format 0.0.4. Any thread
+  static QByteArray prometheusText();
+
+  static constexpr int c_subBucketBits = 4;
+  static constexpr int c_subBuckets = 1 << c_subBucketBits;
+  static constexpr int c_maxExponent = 40; // Values from 2^41 ns (~36 min) on land in the overflow bucket
+  static constexpr int c_bucketCount = (c_maxExponent - c_subBucketBits + 2) * c_subBuckets + 1; // Last one is the overflow
+
+  static int bucketIndex(quint64 value);
+  static quint64 bucketLowerBound(int index);
+  static quint64 bucketUpperBound(int index); // Exclusive, max of quint64 for the overflow bucket
+
+  struct Shard;
+
+private:
+  static Shard& shard();
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef __METRICS_ENDPOINT_H__
+#define __METRICS_ENDPOINT_H__
+
+#include <QObject>
+#include <QTcpServer>
+#include <QHostAddress>
+
+/*
+------------------------------------------------------------------
+-------------------- Local admin endpoint ------------------------
+Plain HTTP on loopback, for a Prometheus scraper (or curl) running
+on the same host: GET /metrics -> Metrics::prometheusText().
+Binds to 127.0.0.1 only and is read-only, so it needs no TLS or
+authentication. It changes nothing in the server: log levels are set
+through the --logging-rules file (see main.cpp), never over a port
+any local process can reach. One request per connection, answered and closed;
+requests that are too long or too slow are dropped.
+Lives on the main thread, a scrape costs one pass over the shards.
+------------------------------------------------------------------
+*/
+class MetricsEndpoint : public QObject {
+  Q_OBJECT
+public:
+  static constexpr quint16 c_defaultPort = 9464;
+
+  explicit MetricsEndpoint(QObject *parent = nullptr);
+
+  bool listen(quint16 port = c_defaultPort);
+
+private slots:
+  void onNewConnection();
+
+private:
+  static constexpr qsizetype c_maxRequestSize = 8 * 1024;
+  static constexpr int c_requestTimeoutMs = 5000;
+
+  QTcpServer m_server;
+
+  void handleRequest(QTcpSocket *socket);
+  void respond(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType, const QByteArray &body);
+};
+
+#endif
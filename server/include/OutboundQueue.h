@@ -0,0 +1,109 @@
+#ifndef __OUTBOUND_QUEUE_H__
+#define __OUTBOUND_QUEUE_H__
+
+#include <QByteArray>
+#include <QString>
+#include <QSet>
+#include <QHash>
+#include <QList>
+
+#include <deque>
+#include <functional>
+
+#include "synergy_protocol/Message_Base.h"
+
+/*
+How a frame may be treated when its recipient can't keep up.
+- ESSENTIAL: always delivered (join/leave, acks of own requests, errors, results)
+- DROPPABLE: intermediate updates nobody has to see (draw strokes, live run output)
+- DELTA: change to state identified by 'key' (text operations of one file,
+  file tree diffs); may be dropped, the client then gets the STATE instead
+- STATE: full state of 'key' (whole file text, whole tree); replaces every
+  DELTA and older STATE of the same key still waiting
+- STATE_PART: continuation of a STATE sent in parts (same key and delivery
+  token), 'partial' is cleared on the last one; replaced together with
+  its STATE, parts of a replaced STATE are discarded on arrival
+*/
+struct FramePolicy {
+  enum class t_Kind { ESSENTIAL, DROPPABLE, DELTA, STATE, STATE_PART };
+
+  static constexpr const char* c_fileTreeKey = "tree";
+  static QString documentKey(const QString &filePath) { return QStringLiteral("doc:") + filePath; }
+
+  t_Kind kind = t_Kind::ESSENTIAL;
+  QString key;
+  // Non-zero: reported back (ClientConnection::frameDelivered) once the socket took the frame,
+  // lets a sender pace a long stream by what the client actually consumes
+  quint64 deliveryToken = 0;
+  // STATE / STATE_PART: more parts of this state follow
+  bool partial = false;
+
+  static FramePolicy forMessage(const SynergyProtocol::Message_Base &message);
+};
+
+/*
+------------------------------------------------------------------
+------------------ Outbound frames of one client -----------------
+Frames the socket hasn't taken yet. Connection keeps at most
+'socketBudget' bytes inside the socket, the rest waits here, where it
+can still be dropped or replaced:
+- backlog over 'highWatermark' -> client is behind: DROPPABLE frames are
+  discarded (queued ones too), every DELTA key in the queue is dropped
+  and reported once through the resync handler, later DELTAs of that key
+  are discarded until its STATE is pushed
+- from a STATE until its last part is written to the socket the key's
+  snapshot is in flight: DELTAs of the key are queued behind it (client
+  applies them on top) and never trigger another resync, even when behind
+- back under 'lowWatermark' -> client caught up, everything is queued again
+- backlog over 'disconnectBytes' even so -> push() fails, connection is
+  closed instead of letting a stalled client grow server memory
+Touched only on the owning I/O thread.
+------------------------------------------------------------------
+*/
+class OutboundQueue {
+public:
+  struct Limits {
+    qint64 socketBudget = 256 * 1024;
+    qint64 lowWatermark = 512 * 1024;
+    qint64 highWatermark = 2 * 1024 * 1024;
+    qint64 disconnectBytes = 16 * 1024 * 1024;
+  };
+
+  using ResyncHandler = std::function<void(const QString &key)>;
+
+  explicit OutboundQueue(Limits limits = Limits());
+
+  const Limits& limits() const { return m_limits; }
+  bool isEmpty() const { return m_frames.empty(); }
+  qint64 bytes() const { return m_bytes; }
+  bool isBehind() const { return m_behind; }
+  quint64 droppedFrames() const { return m_dropped; }
+
+  // False -> backlog is past 'disconnectBytes', client should be dropped
+  bool push(const QByteArray &frame, const FramePolicy &policy, const ResyncHandler &resync);
+  // 'deliveryToken' receives the token of the popped frame, 0 if it has none
+  QByteArray pop(quint64 *deliveryToken = nullptr);
+  // Tokens of frames dropped or replaced before reaching the socket since the last call
+  QList<quint64> takeDiscardedTokens();
+
+private:
+  struct Entry {
+    QByteArray frame;
+    FramePolicy policy;
+  };
+
+  Limits m_limits;
+  std::deque<Entry> m_frames;
+  qint64 m_bytes = 0;
+  bool m_behind = false;
+  QSet<QString> m_stale; // DELTA keys dropped, waiting for their STATE
+  QHash<QString, quint64> m_snapshots; // Key -> delivery token of its STATE in flight
+  quint64 m_dropped = 0;
+  QList<quint64> m_discardedTokens;
+
+  void fallBehind(const ResyncHandler &resync);
+  void markStale(const QString &key, const ResyncHandler &resync);
+  template<typename Predicate> void removeIf(Predicate predicate);
+};
+
+#endif
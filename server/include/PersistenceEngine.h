@@ -0,0 +1,87 @@
+#ifndef __PERSISTENCE_ENGINE_H__
+#define __PERSISTENCE_ENGINE_H__
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <functional>
+
+#include "TextRope.h"
+
+/*
+------------------------------------------------------------------
+------------------ Write-behind persistence (own thread) ---------
+Saves Active File content to the workspace without blocking the
+session thread (SRV-FUNC-WM-012).
+- schedule() only hands over an O(1) rope snapshot and returns
+- edits of the same file within the coalescing window overwrite each
+  other, a typing burst costs one write per window
+- every file is written to a temp file next to it, then renamed over
+  the original, so readers see old or new content, never a mix
+- one batch = all files due in the window: each temp file is fsynced
+  as it is written, then renamed, then each directory touched is
+  fsynced once. fsync rather than syncfs: syncfs flushes everything
+  dirty on the filesystem and its result can't be pinned on a file
+- persisted() is emitted per file once it is durable; ok == false if
+  any write, fsync or rename on its way failed (errno is logged)
+- a failed file is written again after a backoff (window doubled per
+  failed attempt, up to c_maxRetryDelayMs) until it succeeds or a newer
+  revision of it is scheduled, which replaces the retry
+Data-loss bound: edits younger than coalescing window + one batch write
+time may be lost on crash, as long as writes succeed; while they fail
+the last unsaved revision is held in memory and retried. Edit that
+arrives during a batch write goes into the next window.
+Thread-safe methods post into the engine thread, like ConnectionWorker.
+------------------------------------------------------------------
+*/
+class PersistenceEngine : public QObject {
+  Q_OBJECT
+public:
+  static constexpr int c_defaultWindowMs = 500;
+  static constexpr int c_maxRetryDelayMs = 30000;
+
+  explicit PersistenceEngine(int coalesceWindowMs = c_defaultWindowMs);
+
+  // Thread-safe. 'absolutePath' must already be validated against the workspace
+  void schedule(const QString &sessionId, const QString &relativePath, const QString &absolutePath, const TextRope &text, quint64 revision);
+
+  // Thread-safe, blocks caller until everything scheduled so far is on disk (shutdown).
+  // Failed writes waiting for their retry get one more attempt right away
+  void flushBlocking();
+
+  // Thread-safe, doesn't block: writes everything scheduled so far (retries too), then runs 'done' on context's thread
+  void flushAsync(QObject *context, std::function<void()> done);
+
+signals:
+  // Emitted from engine thread, per attempt. ok == false -> write failed, content stays only in memory until a retry succeeds
+  void persisted(const QString &sessionId, const QString &relativePath, quint64 revision, bool ok);
+
+private:
+  struct PendingWrite {
+    QString sessionId;
+    QString relativePath;
+    TextRope text;
+    quint64 revision;
+    int failures = 0; // Failed attempts of this revision
+  };
+
+  int m_windowMs;
+  QHash<QString, PendingWrite> m_pending; // Absolute path -> latest content. Engine thread only
+  QHash<QString, PendingWrite> m_retries; // Absolute path -> failed write waiting for its backoff
+  QTimer m_flushTimer {this};
+  QTimer m_retryTimer {this};
+  QElapsedTimer m_batchClock;
+
+  void enqueue(const QString &absolutePath, PendingWrite write);
+  void flush();
+  void retry(const QString &absolutePath, PendingWrite write);
+  void retryNow();
+  static bool writeTemporary(const QString &temporaryPath, const TextRope &text);
+  static bool syncDirectory(const QString &directory);
+  static QString temporaryPathFor(const QString &absolutePath);
+};
+
+#endif
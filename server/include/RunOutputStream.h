@@ -0,0 +1,88 @@
+#ifndef __RUN_OUTPUT_STREAM_H__
+#define __RUN_OUTPUT_STREAM_H__
+
+#include <QObject>
+#include <QString>
+#include <QByteArrayView>
+#include <QStringDecoder>
+#include <QTimer>
+
+#include <deque>
+#include <functional>
+
+#include "synergy_protocol/Message_Run_Output_Chunk.h"
+
+/*
+------------------------------------------------------------------
+------------------ Live output of one run ------------------------
+Turns the raw stdout/stderr of a running process into sequenced
+RUN_OUTPUT_CHUNK messages (SRV-FUNC-DOCKER-005/006, streamed):
+- output is batched for 'flushIntervalMs', a chatty process costs a
+  few frames per second, not one per write
+- at most 'maxBytesPerFlush' leave per interval, the rest waits in a
+  buffer of 'maxPendingBytes'; what doesn't fit is dropped and a
+  truncation marker takes its place, so server memory per run is bounded
+- after 'maxTotalBytes' the run's output is cut off: one marker at the
+  end, later output is only counted (isCutOff() tells the caller to
+  stop the process)
+Text is decoded per stream with a stateful decoder, a UTF-8 sequence
+split between two reads stays intact. Main thread only.
+------------------------------------------------------------------
+*/
+class RunOutputStream : public QObject {
+  Q_OBJECT
+public:
+  using t_Stream = SynergyProtocol::Message_Run_Output_Chunk::t_Stream;
+
+  struct Limits {
+    int flushIntervalMs = 50;
+    qsizetype maxChunkChars = 16 * 1024;
+    qsizetype maxBytesPerFlush = 64 * 1024;
+    qsizetype maxPendingBytes = 256 * 1024;
+    qint64 maxTotalBytes = 8 * 1024 * 1024;
+  };
+
+  using ChunkSink = std::function<void(const SynergyProtocol::Message_Run_Output_Chunk&)>;
+
+  RunOutputStream(QString runId, ChunkSink sink, Limits limits = Limits(), QObject *parent = nullptr);
+
+  void append(t_Stream stream, QByteArrayView data);
+  // Process ended: everything still buffered goes out now
+  void finish();
+
+  const QString& runId() const { return m_runId; }
+  quint64 chunkCount() const { return m_sequence; }
+  qint64 droppedBytes() const { return m_droppedTotal; }
+  bool isCutOff() const { return m_cutOff; }
+
+private slots:
+  void flush();
+
+private:
+  struct Segment {
+    t_Stream stream;
+    QString text;
+    qsizetype bytes = 0;    // Input bytes this text came from, counts against limits
+    qint64 dropped = 0;     // > 0 -> truncation marker instead of text
+    bool limitReached = false;
+  };
+
+  QString m_runId;
+  ChunkSink m_sink;
+  Limits m_limits;
+  QStringDecoder m_stdoutDecoder {QStringDecoder::Utf8};
+  QStringDecoder m_stderrDecoder {QStringDecoder::Utf8};
+  std::deque<Segment> m_pending;
+  qsizetype m_pendingBytes = 0;
+  qint64 m_acceptedTotal = 0;
+  qint64 m_droppedTotal = 0;
+  quint64 m_sequence = 0;
+  bool m_cutOff = false;
+  QTimer m_flushTimer {this};
+
+  void drop(qint64 bytes);
+  void emitSegment(Segment &segment);
+  QStringDecoder& decoderFor(t_Stream stream) { return stream == t_Stream::STDERR ? m_stderrDecoder : m_stdoutDecoder; }
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef __SESSION_H__
+#define __SESSION_H__
+
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+
+#include <array>
+#include <memory>
+#include <optional>
+
+#include "synergy_protocol/Message_Base.h"
+#include "ClientTransport.h"
+#include "ActiveDocument.h"
+#include "WorkspaceIndex.h"
+#include "CanvasState.h"
+#include "SessionJournal.h"
+
+/*
+------------------------------------------------------------------
+----------------------- Collaborative session --------------------
+Participants of one session and the broadcast path towards them.
+Outbound message is serialized once per wire format in use (at most
+two: JSON, CBOR), length prefix included, and that one implicitly
+shared QByteArray is queued on every recipient. Cost of a broadcast is
+one encode + one pointer copy per participant, not one encode each.
+Every frame is sequenced and journaled (SessionJournal). A participant
+whose connection drops is detached, not removed: its user id and
+resume token are kept until SessionManager's resume window runs out,
+so a reconnect can pick up where the stream stopped.
+Lives on the main thread, like SessionManager.
+------------------------------------------------------------------
+*/
+class Session {
+public:
+  struct Participant {
+    qintptr clientId;
+    QString userId;   // Id shown to other participants
+    QString username; // Display name from join request
+    QString resumeToken;
+  };
+
+  // Participant whose connection is gone but who may still resume
+  struct Detached {
+    QString userId;
+    QString username;
+    SynergyProtocol::t_WireFormat format;
+  };
+
+  Session(QString sessionId, ClientTransport &transport);
+
+  const QString& id() const { return m_id; }
+  bool isEmpty() const { return m_participants.isEmpty(); }
+  bool hasDetached() const { return !m_detached.isEmpty(); }
+  int participantCount() const { return static_cast<int>(m_participants.size()); }
+  bool contains(qintptr clientId) const { return m_participants.contains(clientId); }
+  const Participant* participant(qintptr clientId) const;
+  const QHash<qintptr, Participant>& participants() const { return m_participants; }
+
+  void addParticipant(qintptr clientId, const QString &userId, const QString &username, const QString &resumeToken);
+  void removeParticipant(qintptr clientId);
+
+  // Connection lost: participant kept under its resume token, frames keep being journaled for it
+  void detachParticipant(qintptr clientId);
+  // Detached participant identified by 'resumeToken' continues as 'clientId', token replaced
+  // by 'newResumeToken'. Nullptr if token unknown
+  const Participant* reattach(const QString &resumeToken, qintptr clientId, const QString &newResumeToken);
+  // Resume window is over, returns the participant that is gone for good
+  std::optional<Detached> dropDetached(const QString &resumeToken);
+
+  SessionJournal& journal() { return m_journal; }
+
+  // Index is built once here and kept current by file system notifications
+  void openWorkspace(const QString &rootPath);
+  WorkspaceIndex* workspace() const { return m_workspace.get(); }
+
+  // FILE_TREE_UPDATE from cached frame, encoded again only after the tree changed
+  void sendFileTree(qintptr clientId);
+
+  // Authoritative text of files edited in this session, loaded from workspace on first use
+  ActiveDocument& document(const QString &filePath);
+  const QHash<QString, ActiveDocument>& documents() const { return m_documents; }
+
+  // Whiteboard: log + compacted tiles, what a joiner needs to see the current picture
+  CanvasState& canvas() { return m_canvas; }
+
+  // Encode once, sequence and journal it, send to every participant except 'excludeClientId' (0 = nobody excluded)
+  void broadcast(const SynergyProtocol::Message_Base &message, qintptr excludeClientId = 0);
+  void sendTo(qintptr clientId, const SynergyProtocol::Message_Base &message);
+
+private:
+  QString m_id;
+  ClientTransport &m_transport;
+  QHash<qintptr, Participant> m_participants;
+  QHash<QString, Detached> m_detached; // Resume token -> participant
+  SessionJournal m_journal;
+  QHash<QString, ActiveDocument> m_documents; // File path -> document
+  std::unique_ptr<WorkspaceIndex> m_workspace;
+  CanvasState m_canvas;
+  std::array<QByteArray, 2> m_fileTreeFrames; // Per wire format, empty = not encoded yet
+
+  void onWorkspaceChanged(const SynergyProtocol::FileTreeDiff &diff);
+  // Sequence, encode for 'formats' (index = wire format), record; frames stay in the entry
+  SessionJournal::Entry record(const SynergyProtocol::Message_Base &message, const std::array<bool, SessionJournal::c_formatCount> &formats,
+                               QString targetUserId, QString excludeUserId);
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef __SESSION_JOURNAL_H__
+#define __SESSION_JOURNAL_H__
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include <array>
+#include <deque>
+#include <functional>
+
+#include "synergy_protocol/protocol.h"
+#include "OutboundQueue.h"
+
+/*
+------------------------------------------------------------------
+------------------- Outbound journal of a session ----------------
+Every frame a session sends gets the next sequence number and is kept
+here, already encoded, together with who it was for. A client that
+reconnects with the last sequence it saw gets exactly the frames it
+missed (SessionManager, RESUME_SESSION_REQUEST), no state is rebuilt.
+Bounded by entry count and bytes, oldest frames go first; once a
+client's gap reaches past the oldest frame it gets a full snapshot.
+Main thread only, like Session.
+------------------------------------------------------------------
+*/
+class SessionJournal {
+public:
+  static constexpr std::size_t c_formatCount = 2;
+  using Frames = std::array<QByteArray, c_formatCount>; // Indexed by t_WireFormat, empty = not encoded
+
+  struct Limits {
+    std::size_t maxEntries = 8192;
+    qint64 maxBytes = 8 * 1024 * 1024;
+  };
+
+  struct Entry {
+    quint64 sequence;
+    Frames frames;
+    FramePolicy policy;
+    QString targetUserId;  // Non-empty -> only this participant got it
+    QString excludeUserId; // Non-empty -> everyone but this participant got it
+  };
+
+  explicit SessionJournal(Limits limits = Limits());
+
+  // Sequence the next frame has to carry
+  quint64 nextSequence() const { return m_nextSequence; }
+  void append(Entry entry);
+
+  // True if every frame after 'lastSequence' is still here
+  bool covers(quint64 lastSequence) const;
+  // Frames after 'lastSequence' that 'userId' received, in 'format'. False (nothing
+  // delivered) if journal doesn't cover the gap or a frame isn't in that format
+  bool replay(quint64 lastSequence, const QString &userId, SynergyProtocol::t_WireFormat format,
+              const std::function<void(const QByteArray &frame, const FramePolicy &policy)> &deliver) const;
+
+private:
+  Limits m_limits;
+  std::deque<Entry> m_entries;
+  qint64 m_bytes = 0;
+  quint64 m_nextSequence = 1; // 0 means "nothing seen yet"
+
+  static qint64 sizeOf(const Entry &entry);
+};
+
+#endif
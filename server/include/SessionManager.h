@@ -0,0 +1,105 @@
+#ifndef __SESSION_MANAGER_H__
+#define __SESSION_MANAGER_H__
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QThread>
+
+#include <memory>
+
+#include "synergy_protocol/MessageFactory.h"
+#include "ClientTransport.h"
+#include "Session.h"
+#include "PersistenceEngine.h"
+#include "DockerExecutor.h"
+#include "RunOutputStream.h"
+#include "FileStreamer.h"
+
+/*
+------------------------------------------------------------------
+------------------------- Session manager ------------------------
+Owns all sessions and knows which session each client belongs to.
+Application messages coming from I/O workers are routed here (main
+thread); anything that must reach other participants goes out through
+Session::broadcast, so it is encoded once per wire format.
+Opened files, and document snapshots (join, resync, rejected
+operation), are streamed to the client in chunks (FileStreamer).
+Edited files are handed to PersistenceEngine (own thread) and saved
+behind the edits; participants get FILE_SAVED once content is durable.
+Run requests go to DockerExecutor after pending edits are on disk,
+so the container sees what the participants see.
+A dropped client stays in its session for c_resumeWindowMs: others
+see USER_LEFT only once that runs out, and a RESUME_SESSION_REQUEST
+with its token replays what it missed from the session journal.
+------------------------------------------------------------------
+*/
+class SessionManager : public QObject {
+  Q_OBJECT
+public:
+  // Session workspaces are created as subdirectories of 'workspaceBase' (SRV-FUNC-WM-001/002)
+  explicit SessionManager(ClientTransport &transport, const QString &workspaceBase = QStringLiteral("workspaces"),
+                          int persistenceWindowMs = PersistenceEngine::c_defaultWindowMs,
+                          DockerExecutor::Config executorConfig = DockerExecutor::Config());
+  ~SessionManager() override;
+
+  void handleMessage(qintptr clientId, const SynergyProtocol::Message_Base &message);
+
+  // Client went away. Participant is detached for the resume window, then others get USER_LEFT.
+  // Sessions with neither participants nor detached ones are dropped
+  void removeClient(qintptr clientId);
+
+  Session* sessionOf(qintptr clientId) const;
+
+  // Client's outbound queue dropped updates of 'key' (FramePolicy), it gets the full state instead
+  void resyncClient(qintptr clientId, const QString &key);
+  // Frame posted with a delivery token reached the client's socket (paces file transfers)
+  void frameDelivered(qintptr clientId, quint64 deliveryToken);
+  // Frame posted with a delivery token was replaced before reaching the socket
+  void frameDiscarded(qintptr clientId, quint64 deliveryToken);
+
+private slots:
+  void onPersisted(const QString &sessionId, const QString &relativePath, quint64 revision, bool ok);
+
+private:
+  static constexpr int c_sessionIdLength = 8;
+  static constexpr int c_resumeWindowMs = 30000;
+
+  ClientTransport &m_transport;
+  QString m_workspaceBase;
+  QHash<QString, std::shared_ptr<Session>> m_sessions; // Session id -> session
+  QHash<qintptr, Session*> m_clientSessions;           // Client id -> session it joined
+  FileStreamer m_files;
+  QThread m_persistenceThread;
+  PersistenceEngine *m_persistence; // Lives on m_persistenceThread, deleted when it finishes
+  DockerExecutor m_executor;
+  QSet<QString> m_runningSessions;  // One run per session at a time
+  QSet<QString> m_failingSaves;     // "<session id>/<relative path>" whose last save failed, reported once
+  quint64 m_runCounter = 0;
+  quint64 m_userCounter = 0;
+
+  void handleJoinRequest(qintptr clientId, const SynergyProtocol::Message_Join_Session_Request &request);
+  void handleResumeRequest(qintptr clientId, const SynergyProtocol::Message_Resume_Session_Request &request);
+  void handleFileTreeRequest(qintptr clientId);
+  void handleOpenFileRequest(qintptr clientId, const SynergyProtocol::Message_Request_Open_File &request);
+  void handleTextReplace(qintptr clientId, const SynergyProtocol::Message_Update_Text_Edit &edit);
+  void handleTextOperation(qintptr clientId, const SynergyProtocol::Message_Text_Operation &message);
+  void handleRunRequest(qintptr clientId, const SynergyProtocol::Message_Request_Run_Code &request);
+  void relayDrawCommand(qintptr clientId, const SynergyProtocol::Message_Draw_Command &command);
+  void relayDrawPolyline(qintptr clientId, const SynergyProtocol::Message_Draw_Polyline &polyline);
+
+  // Everything a (re)joining client needs besides the file tree: participants, open files, canvas
+  void sendSessionState(Session *session, qintptr clientId);
+  void expireDetached(const QString &sessionId, const QString &resumeToken);
+  void closeSession(Session *session);
+
+  void sendError(qintptr clientId, int code, const QString &message);
+  QString resolveInWorkspace(Session *session, const QString &filePath) const;
+  QString generateSessionId() const;
+  static QString generateResumeToken();
+  // Id the participant is known by, stays the same across resumes
+  QString userIdFor(qintptr clientId) const;
+};
+
+#endif
@@ -8,31 +8,76 @@
 #include <QSslCertificate>
 #include <QHash>
 #include <QFile>
+#include <QThread>
 #include <QDebug>
 
+#include <memory>
+#include <vector>
+
 #include "synergy_protocol/MessageFactory.h"
+#include "ConnectionWorker.h"
+#include "ClientTransport.h"
+#include "TlsContextCache.h"
+#include "SessionManager.h"
 
-class SslServer : public QSslServer {
+/*
+Accepts connections and spreads them over a pool of I/O worker threads.
+The listening socket, routing table and sessions live on the thread that
+created the server (main thread); every client socket lives on exactly one worker.
+*/
+class SslServer : public QSslServer, public ClientTransport {
   Q_OBJECT
 public:
-  explicit SslServer(QObject *parent = nullptr);
+  // ioThreads <= 0 -> one worker per core (QThread::idealThreadCount)
+  explicit SslServer(QObject *parent = nullptr, int ioThreads = 0, OutboundQueue::Limits outboundLimits = OutboundQueue::Limits(),
+                     ConnectionWorker::Liveness liveness = ConnectionWorker::Liveness());
+  ~SslServer() override;
   bool startListening(const QHostAddress &address = QHostAddress::LocalHost, quint16 port = 12345); // Todo : change this into actual parameters
 
+  int workerCount() const { return static_cast<int>(m_workers.size()); }
+
+  // Thread-safe delivery to a client, whichever worker owns it
+  void sendToClient(qintptr clientId, std::shared_ptr<const SynergyProtocol::Message_Base> message);
+  void sendFrameToClient(qintptr clientId, const QByteArray &payload);
+
+  // ClientTransport, used by sessions (main thread only)
+  SynergyProtocol::t_WireFormat wireFormat(qintptr clientId) const override;
+  void postFrame(const QList<qintptr> &clientIds, const QByteArray &frame, const FramePolicy &policy = FramePolicy()) override;
+  void disconnectClient(qintptr clientId) override;
+
 protected:
-  // Override incomngConnection to handle SSL sockets
+  // Override incomngConnection to hand descriptors over to I/O workers
   void incomingConnection(qintptr socketDescriptor) override;
 
 private slots:
-  void onReadyRead();
-  void onDisconnected();
-  void onSslErrors(const QList<QSslError> &errors);
-  void onEncrypted(); // Slot notified when handshake is complete
+  void onMessageReceived(qintptr clientId, std::shared_ptr<const SynergyProtocol::Message_Base> message);
+  void onClientDisconnected(qintptr clientId);
+  void onWireFormatNegotiated(qintptr clientId, SynergyProtocol::t_WireFormat format);
+  void onResyncNeeded(qintptr clientId, const QString &key);
+  void onFrameDelivered(qintptr clientId, quint64 deliveryToken);
+  void onFrameDiscarded(qintptr clientId, quint64 deliveryToken);
 
 private:
   QSslConfiguration m_sslConfiguration;
-  QHash<qintptr, QSslSocket*> m_clients; // Keep track of connected clients
+  OutboundQueue::Limits m_outboundLimits; // Per client, handed to every worker
+  ConnectionWorker::Liveness m_liveness;  // Same
+  TlsContextCache m_tlsContexts;          // Shared by all workers, outlives them
+  std::vector<QThread*> m_threads;
+  std::vector<ConnectionWorker*> m_workers; // Owned by their threads
+  // Client id -> worker that owns its socket, and format it negotiated (mirrored from the worker)
+  struct Route {
+    ConnectionWorker *worker = nullptr;
+    SynergyProtocol::t_WireFormat format = SynergyProtocol::t_WireFormat::JSON;
+  };
+  QHash<qintptr, Route> m_routes;
+  SessionManager m_sessions {*this};
+  qintptr m_nextClientId = 1;
+  int m_nextWorker = 0;
 
   bool loadCertAndKey(const QString &certPath, const QString &keyPath);
+  void startWorkers(int ioThreads);
+  void stopWorkers();
+  ConnectionWorker* pickWorker();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,88 @@
+#ifndef __TEXT_ROPE_H__
+#define __TEXT_ROPE_H__
+
+#include <QString>
+
+#include <QStringView>
+
+#include <functional>
+#include <memory>
+
+/*
+------------------------------------------------------------------
+----------------------- Text rope (server) -----------------------
+Authoritative text of an Active File. Text is kept in chunks of at
+most c_maxChunk UTF-16 units, held by a treap (balanced by random
+priorities) whose nodes store their subtree length and newline count.
+  insert / remove / line lookup - O(log n), independent of file size
+  snapshot                      - O(1), copy of root pointer
+Edits split chunks at their ends; a piece left shorter than
+c_minChunk is merged with a neighbouring chunk when both fit in one,
+so repeated small edits don't leave a trail of tiny nodes.
+Nodes are immutable and shared between versions: an edit copies only
+the O(log n) nodes on its path, so a snapshot handed to a late joiner
+(or to persistence) stays valid while editing continues.
+Not thread-safe for concurrent mutation of one instance, but snapshots
+may be read from other threads (node sharing uses atomic refcounts).
+------------------------------------------------------------------
+*/
+class TextRope {
+public:
+  static constexpr qsizetype c_maxChunk = 1024;
+  static constexpr qsizetype c_minChunk = c_maxChunk / 4; // Smaller ones are merged at edit points
+
+  TextRope() = default;
+  explicit TextRope(const QString &text);
+
+  qsizetype length() const;
+  bool isEmpty() const { return length() == 0; }
+  qsizetype lineCount() const; // Newlines + 1, empty text has one line
+
+  // Positions are clamped to text, like QString::insert/remove
+  void insert(qsizetype position, const QString &text);
+  void remove(qsizetype position, qsizetype count);
+
+  QChar at(qsizetype position) const;
+  QString mid(qsizetype position, qsizetype count) const;
+  QString toString() const;
+
+  // Chunks in text order, lets callers stream the text without materializing it
+  void forEachChunk(const std::function<void(QStringView)> &visit) const;
+
+  // Line index, lines are 0-based and separated by '\n'
+  qsizetype lineStart(qsizetype line) const; // -1 if there is no such line
+  qsizetype lineAt(qsizetype position) const;
+
+  qsizetype chunkCount() const;
+
+  // Independent copy sharing all nodes, later edits of either side don't affect the other
+  TextRope snapshot() const { return *this; }
+
+private:
+  struct Node;
+  using NodePtr = std::shared_ptr<const Node>;
+
+  NodePtr m_root;
+
+  static qsizetype lengthOf(const NodePtr &node);
+  static qsizetype newlinesOf(const NodePtr &node);
+  static NodePtr makeNode(QString chunk, quint32 priority, NodePtr left, NodePtr right);
+  static NodePtr withChildren(const NodePtr &node, NodePtr left, NodePtr right);
+  static NodePtr join(const NodePtr &node, NodePtr left, NodePtr right);
+  static NodePtr merge(const NodePtr &left, const NodePtr &right);
+  static void split(const NodePtr &node, qsizetype position, NodePtr &left, NodePtr &right);
+  static NodePtr build(const QString &text);
+  static NodePtr appendToLastChunk(const NodePtr &node, const QString &text);
+  static qsizetype lastChunkSize(const NodePtr &node);
+  static qsizetype firstChunkSize(const NodePtr &node);
+  static NodePtr withoutLast(const NodePtr &node, QString &chunk);
+  static NodePtr withoutFirst(const NodePtr &node, QString &chunk);
+  static NodePtr absorbLast(const NodePtr &node);
+  static NodePtr absorbFirst(const NodePtr &node);
+  static NodePtr mergeAtSeam(const NodePtr &left, const NodePtr &right);
+  static void visitChunks(const NodePtr &node, const std::function<void(QStringView)> &visit);
+  static void collect(const NodePtr &node, qsizetype position, qsizetype count, QString &out);
+  static quint32 randomPriority();
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include <QtGlobal>
+
+#include <array>
+#include <vector>
+
+/*
+------------------------------------------------------------------
+---------------------- Hierarchical timer wheel ------------------
+Deadlines for many connections on one thread without a QTimer each.
+Time advances in ticks; 4 levels of 64 slots cover 64, 64^2, 64^3
+and 64^4 ticks ahead (at 250 ms: 16 s, 17 min, 18 h, 48 days).
+A timer sits in the slot of the coarsest level its distance needs
+and moves down a level each time the wheel below wraps around, so
+schedule, cancel and expiry are O(1) whatever the number of timers,
+and a tick with nothing due touches one empty slot.
+Timers are plain entries in a slab (index + generation as id, no
+allocation per timer once warmed up) carrying a key and a kind; the
+owner decides what an expiry means. Deadlines further than the wheel
+reaches are parked at its end and rescheduled from there.
+Single threaded: owned and driven by one ConnectionWorker.
+------------------------------------------------------------------
+*/
+class TimerWheel {
+public:
+  using t_TimerId = quint64; // 0 = no timer
+
+  static constexpr int c_slotBits = 6;
+  static constexpr int c_slots = 1 << c_slotBits;
+  static constexpr int c_levels = 4;
+
+  // 'startMs' is tick 0, same clock as every later 'nowMs'
+  TimerWheel(qint64 tickMs, qint64 startMs);
+
+  // Fires on the first advance() at or after nowMs + delayMs, never sooner
+  t_TimerId schedule(qint64 nowMs, qint64 delayMs, qintptr key, int kind);
+  // False if it already fired or was cancelled
+  bool cancel(t_TimerId id);
+
+  /*
+  Runs onExpired(key, kind) for every timer due up to 'nowMs', tick by
+  tick. Callbacks may schedule and cancel freely; the firing timer is
+  already gone when its callback runs.
+  */
+  template<typename Callback>
+  void advance(qint64 nowMs, Callback &&onExpired) {
+    const quint64 target = nowMs > m_startMs ? quint64((nowMs - m_startMs) / m_tickMs) : 0;
+    if(m_count == 0) {
+      m_currentTick = qMax(m_currentTick, target); // Nothing to find on the way
+      return;
+    }
+    while(m_currentTick < target) {
+      ++m_currentTick;
+      cascade();
+      int &head = m_heads[slotIndex(0, m_currentTick)];
+      while(head >= 0) {
+        const int index = head;
+        unlink(index);
+        Entry &entry = m_entries[index];
+        if(entry.deadline > m_currentTick) {
+          place(index); // Parked at the end of the wheel, not due yet
+          continue;
+        }
+        const qintptr key = entry.key;
+        const int kind = entry.kind;
+        release(index);
+        onExpired(key, kind);
+      }
+    }
+  }
+
+  int size() const { return m_count; }
+  qint64 tickMs() const { return m_tickMs; }
+
+private:
+  struct Entry {
+    quint64 deadline = 0; // Tick
+    qintptr key = 0;
+    int kind = 0;
+    quint32 generation = 1;
+    int slot = -1;        // Index into m_heads, -1 = free
+    int prev = -1;
+    int next = -1;        // Also links the free list
+  };
+
+  qint64 m_tickMs;
+  qint64 m_startMs;
+  quint64 m_currentTick = 0; // Last tick processed
+  int m_count = 0;
+  std::vector<Entry> m_entries;
+  int m_free = -1;
+  std::array<int, c_slots * c_levels> m_heads;
+
+  static int slotIndex(int level, quint64 tick) {
+    return level * c_slots + int((tick >> (level * c_slotBits)) & (c_slots - 1));
+  }
+
+  void place(int index);
+  void unlink(int index);
+  void release(int index);
+  void cascade(); // Moves timers down from every level whose lower wheel just wrapped
+};
+
+#endif
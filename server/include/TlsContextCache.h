@@ -0,0 +1,47 @@
+#ifndef __TLS_CONTEXT_CACHE_H__
+#define __TLS_CONTEXT_CACHE_H__
+
+#include <QMutex>
+#include <QSslSocket>
+
+#include <memory>
+
+class QSslContext;
+
+/*
+------------------------------------------------------------------
+------------------ Shared server TLS context ---------------------
+TLS session resumption (1.3 tickets, or the 1.2 session cache) only
+works if the connection that resumes is handled by the same TLS
+context that issued the ticket: ticket keys and the session cache
+live there. Qt builds a new context for every server socket, so out
+of the box no resumption ever succeeds and every reconnect pays a
+full handshake.
+The context of the first completed handshake is kept here and handed
+to every later server socket, on all I/O workers (the context is
+read-only after creation, OpenSSL locks its session cache).
+Qt exposes this only through its private socket API, available when
+Qt6::NetworkPrivate is found (SYNERGY_TLS_SHARED_CONTEXT); without it
+both calls do nothing and handshakes stay full.
+------------------------------------------------------------------
+*/
+class TlsContextCache {
+public:
+  static constexpr bool c_supported =
+#ifdef SYNERGY_TLS_SHARED_CONTEXT
+    true;
+#else
+    false;
+#endif
+
+  // Before startServerEncryption(): socket uses the shared context, if there is one
+  void apply(QSslSocket *socket) const;
+  // After handshake: socket's context becomes the shared one, if there is none yet
+  void adopt(QSslSocket *socket);
+
+private:
+  mutable QMutex m_mutex;
+  std::shared_ptr<QSslContext> m_context;
+};
+
+#endif
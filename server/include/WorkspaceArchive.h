@@ -0,0 +1,70 @@
+#ifndef __WORKSPACE_ARCHIVE_H__
+#define __WORKSPACE_ARCHIVE_H__
+
+#include <QIODevice>
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QSet>
+
+/*
+------------------------------------------------------------------
+------------------ Streaming tar of workspace files --------------
+Tar (ustar, pax header for long names and files of 8 GiB or more) in the form
+PUT /containers/{id}/archive expects (SRV-FUNC-DOCKER-004 step 2).
+Archive is produced while it's read: header, then file content read
+straight from disk, one file open at a time. Memory use is a few
+blocks no matter how big the workspace is, nothing goes to a temp file.
+Entry sizes come from a prior scan, so total size is known up front
+(Content-Length). File that changed size since the scan is cut/zero
+padded to the scanned size and reported in incompleteFiles().
+------------------------------------------------------------------
+*/
+class WorkspaceArchive : public QIODevice {
+public:
+  struct Entry {
+    QString relativePath;   // '/' separated, relative to root
+    qint64 size = 0;        // Ignored for directories
+    qint64 modifiedSecs = 0;
+    bool isDirectory = false;
+  };
+
+  WorkspaceArchive(QString rootPath, QList<Entry> entries);
+
+  qint64 size() const override { return m_totalSize; }
+  bool isSequential() const override { return true; }
+  qint64 bytesAvailable() const override { return m_totalSize - m_produced + QIODevice::bytesAvailable(); }
+
+  // Files whose content in the archive doesn't match what's on disk now
+  const QSet<QString>& incompleteFiles() const { return m_incomplete; }
+
+protected:
+  qint64 readData(char *data, qint64 maxSize) override;
+  qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+  static constexpr int c_blockSize = 512;
+
+  QString m_rootPath;
+  QList<Entry> m_entries;
+  qint64 m_totalSize = 0;
+  qint64 m_produced = 0;
+
+  qsizetype m_nextEntry = 0;
+  QByteArray m_pending;          // Header bytes not yet read
+  qsizetype m_pendingOffset = 0;
+  QFile m_file;                  // Content of current entry
+  QString m_currentPath;
+  qint64 m_fileRemaining = 0;
+  qint64 m_padding = 0;
+  bool m_trailerQueued = false;
+  QSet<QString> m_incomplete;
+
+  void startEntry(const Entry &entry);
+  static QByteArray headersFor(const Entry &entry);
+  static QByteArray headerBlock(const QByteArray &name, const QByteArray &prefix, qint64 size, qint64 modified, char type);
+  static qint64 paddingFor(qint64 size) { return (c_blockSize - size % c_blockSize) % c_blockSize; }
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef __WORKSPACE_INDEX_H__
+#define __WORKSPACE_INDEX_H__
+
+#include <QObject>
+#include <QString>
+#include <QSet>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+#include <map>
+#include <optional>
+
+#include "synergy_protocol/Message_File_Tree_Diff.h"
+
+/*
+------------------------------------------------------------------
+---------------------- Workspace file-tree index -----------------
+In-memory index of one session's workspace. Directory is walked once
+(QDirIterator) when the index is created; after that every directory
+is watched (QFileSystemWatcher -> inotify on Linux) and only the
+directory that changed is re-listed and diffed against the index.
+Bursts of changes are coalesced for c_settleMs and reported as one
+FileTreeDiff. A remove + add pair in the same directory is reported
+as a rename only when it is the same inode on the same device (a
+rename keeps both); without that evidence it stays a remove + add and
+an added directory is walked again.
+Nested JSON tree (FILE_TREE_UPDATE payload) is built only when asked
+for and cached until next change.
+Note: inotify watches one directory per watch, the limit is
+/proc/sys/fs/inotify/max_user_watches.
+------------------------------------------------------------------
+*/
+class WorkspaceIndex : public QObject {
+  Q_OBJECT
+public:
+  static constexpr int c_settleMs = 50;
+
+  explicit WorkspaceIndex(const QString &rootPath, QObject *parent = nullptr);
+
+  const QString& rootPath() const { return m_rootPath; }
+  int entryCount() const { return static_cast<int>(m_entries.size()); }
+  bool contains(const QString &relativePath) const { return m_entries.count(relativePath) != 0; }
+
+  /*
+  Absolute path for a client supplied relative path, empty if it isn't strictly
+  inside the workspace (absolute paths, '..' escapes, SRV-FUNC-WM-006).
+  Path itself doesn't have to exist yet.
+  */
+  QString resolve(const QString &relativePath) const;
+
+  // Nested tree as in spec 5.5.6, cached between changes
+  const QJsonObject& tree() const;
+
+signals:
+  void treeChanged(const SynergyProtocol::FileTreeDiff &diff);
+
+private slots:
+  void onDirectoryChanged(const QString &path);
+  void processPendingDirectories();
+
+private:
+  struct Entry {
+    bool isDirectory;
+    qint64 size;
+    QDateTime modified;
+    quint64 device = 0; // 0 = unknown (lstat failed)
+    quint64 inode = 0;
+  };
+
+  // Path order with '/' before every other character: "a", "a/x", "a-b".
+  // Directory's whole subtree then directly follows it (plain QString order puts "a-b" in between)
+  struct PathLess {
+    bool operator()(const QString &left, const QString &right) const;
+  };
+  using EntryMap = std::map<QString, Entry, PathLess>;
+
+  QString m_rootPath;
+  EntryMap m_entries; // Relative path -> entry
+  QFileSystemWatcher m_watcher;
+  QSet<QString> m_pendingDirectories; // Relative paths, "" is root
+  QTimer m_settleTimer;
+  mutable std::optional<QJsonObject> m_tree;
+
+  void scanAll();
+  void addSubtree(const QString &relativeDirectory, SynergyProtocol::FileTreeDiff &diff);
+  void removeSubtree(const QString &relativePath);
+  void rescanDirectory(const QString &relativeDirectory, SynergyProtocol::FileTreeDiff &diff);
+
+  static Entry entryFor(const QFileInfo &info);
+  static bool isSameObject(const Entry &left, const Entry &right);
+
+  QString relativePath(const QString &absolutePath) const;
+  QString absolutePath(const QString &relativePath) const;
+  static QString childPath(const QString &directory, const QString &name);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef __WORKSPACE_MANIFEST_H__
+#define __WORKSPACE_MANIFEST_H__
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+/*
+Content hashes of every regular file in a workspace, used to decide
+which files a warm container is missing.
+Hashing is the expensive part, so scan() reuses the hash of a file whose
+size and mtime are unchanged since the previous scan; a typical run only
+hashes the files edited since the last one.
+Symlinks, temp files of PersistenceEngine and names with a newline are
+left out (the last ones can't be listed back from the container).
+Plain value type, scan() is safe to run off the main thread.
+*/
+struct WorkspaceManifest {
+  struct File {
+    qint64 size = 0;
+    qint64 modifiedMs = 0;
+    QByteArray hash; // SHA-256 of content
+  };
+
+  // Container's copy of a workspace, relative to the last upload (DockerExecutor::listContainerWorkspace)
+  struct Listing {
+    QSet<QString> clean;       // Regular files untouched since the upload
+    QSet<QString> dirty;       // Changed or created by runs, or not a regular file
+    QSet<QString> directories;
+  };
+
+  // What it takes to turn a listed container workspace into this manifest
+  struct Changes {
+    QStringList deletions;     // Topmost path of every deleted subtree, sorted
+    QSet<QString> files;       // To upload
+    QSet<QString> directories; // To create
+  };
+
+  QHash<QString, File> files;  // Relative path ('/' separated) -> file
+  QSet<QString> directories;   // Relative paths of all directories below root
+
+  static WorkspaceManifest scan(const QString &rootPath, const WorkspaceManifest &previous);
+  // 'uploaded': content hashes as of the upload the listing is relative to
+  Changes changesFrom(const Listing &listing, const QHash<QString, QByteArray> &uploaded) const;
+  // Empty on read error
+  static QByteArray hashFile(const QString &path);
+};
+
+#endif
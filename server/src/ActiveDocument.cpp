@@ -0,0 +1,70 @@
+#include "../include/ActiveDocument.h"
+
+#include <QDebug>
+#include <utility>
+
+ActiveDocument::ActiveDocument(const QString &content) :
+  m_text(content) {
+}
+
+ActiveDocument::t_ApplyResult ActiveDocument::apply(quint64 baseRevision, const SynergyProtocol::TextOperation &operation, SynergyProtocol::TextOperation &applied){
+  const quint64 oldestKnown = m_revision - m_history.size();
+  if(baseRevision > m_revision || baseRevision < oldestKnown) {
+    return t_ApplyResult::STALE_REVISION;
+  }
+
+  // Bring operation forward over everything it didn't see. History wins insert ties, it was applied first
+  applied = operation;
+  for(std::size_t i = std::size_t(baseRevision - oldestKnown); i < m_history.size(); ++i) {
+    SynergyProtocol::TextOperation historyPrime, operationPrime;
+    if(!SynergyProtocol::TextOperation::transform(m_history[i], applied, historyPrime, operationPrime)) {
+      return t_ApplyResult::INVALID_OPERATION;
+    }
+    applied = std::move(operationPrime);
+  }
+
+  if(!applyToText(applied)) {
+    return t_ApplyResult::INVALID_OPERATION;
+  }
+  record(applied);
+  return t_ApplyResult::APPLIED;
+}
+
+void ActiveDocument::replaceContent(const QString &content){
+  SynergyProtocol::TextOperation operation;
+  operation.remove(m_text.length()).insert(content);
+  m_text = TextRope(content);
+  record(std::move(operation));
+}
+
+void ActiveDocument::record(SynergyProtocol::TextOperation operation){
+  m_history.push_back(std::move(operation));
+  if(m_history.size() > c_maxHistory) {
+    m_history.pop_front();
+  }
+  ++m_revision;
+}
+
+// Same walk as TextOperation::applyTo, on the rope instead of a flat string
+bool ActiveDocument::applyToText(const SynergyProtocol::TextOperation &operation){
+  if(operation.baseLength() != m_text.length()) {
+    qCritical() << "ACTIVE DOCUMENT | Operation base length" << operation.baseLength() << "doesn't match document length" << m_text.length();
+    return false;
+  }
+  qsizetype position = 0;
+  for(const SynergyProtocol::TextOperation::Component &component : operation.components()) {
+    switch(component.kind) {
+      case SynergyProtocol::TextOperation::t_Kind::RETAIN:
+        position += component.length;
+        break;
+      case SynergyProtocol::TextOperation::t_Kind::INSERT:
+        m_text.insert(position, component.text);
+        position += component.length;
+        break;
+      case SynergyProtocol::TextOperation::t_Kind::REMOVE:
+        m_text.remove(position, component.length);
+        break;
+    }
+  }
+  return true;
+}
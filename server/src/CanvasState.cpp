@@ -0,0 +1,195 @@
+#include "../include/CanvasState.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QBuffer>
+#include <QColor>
+#include <QThreadPool>
+#include <QCoreApplication>
+#include <QPointer>
+#include <QMetaObject>
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+CanvasState::CanvasState(int compactThreshold, QObject *parent) :
+  QObject(parent),
+  m_compactThreshold(std::max(1, compactThreshold)) {
+}
+
+void CanvasState::append(const SynergyProtocol::Message_Draw_Command &command){
+  if(command.shape() != QLatin1StringView("line")) return; // Only shape known so far
+  append(Stroke {{QPointF(command.startX(), command.startY()), QPointF(command.endX(), command.endY())},
+                 command.color(), command.strokeWidth(), command.originatorId(), 0});
+}
+
+void CanvasState::append(const SynergyProtocol::Message_Draw_Polyline &polyline){
+  append(Stroke {polyline.points(), polyline.color(), polyline.strokeWidth(), polyline.originatorId(), polyline.strokeId()});
+}
+
+void CanvasState::append(Stroke stroke){
+  if(stroke.points.isEmpty()) return;
+  m_logPoints += static_cast<int>(stroke.points.size());
+  m_log.push_back(std::move(stroke));
+  if(m_logPoints >= m_compactThreshold && !isCompacting()) {
+    compact();
+  }
+}
+
+QRectF CanvasState::tileRect(qint32 x, qint32 y){
+  return QRectF(double(x) * c_tileSize, double(y) * c_tileSize, c_tileSize, c_tileSize);
+}
+
+// Liang-Barsky clip of the segment against 'area' grown by half the stroke width
+bool CanvasState::crosses(const QPointF &from, const QPointF &to, double width, const QRectF &area){
+  const double margin = width / 2 + 1; // +1 for antialiasing
+  const QRectF grown = area.adjusted(-margin, -margin, margin, margin);
+  const double dx = to.x() - from.x();
+  const double dy = to.y() - from.y();
+  const double p[4] = {-dx, dx, -dy, dy};
+  const double q[4] = {from.x() - grown.left(), grown.right() - from.x(),
+                       from.y() - grown.top(), grown.bottom() - from.y()};
+  double enter = 0, leave = 1;
+  for(int i = 0; i < 4; ++i) {
+    if(p[i] == 0) {
+      if(q[i] < 0) return false; // Parallel to this edge and outside
+      continue;
+    }
+    const double t = q[i] / p[i];
+    if(p[i] < 0) enter = std::max(enter, t);
+    else leave = std::min(leave, t);
+    if(enter > leave) return false;
+  }
+  return true;
+}
+
+void CanvasState::compact(){
+  if(m_log.empty() || isCompacting()) return;
+  m_compacting = std::exchange(m_log, {});
+  m_logPoints = 0;
+
+  // Worker gets copies: the strokes, and the tile hash (implicitly shared, only compacted() writes it).
+  // Result goes back through the application object, which outlives any session; whether this
+  // canvas still exists is checked there, on the main thread, never from the pool thread
+  QPointer<CanvasState> self(this);
+  QThreadPool::globalInstance()->start([self, strokes = m_compacting, tiles = m_tiles]() mutable {
+    Tiles updated = render(strokes, tiles);
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [self = std::move(self), updated = std::move(updated)]() {
+      if(self) self->compacted(updated);
+    }, Qt::QueuedConnection);
+  });
+}
+
+void CanvasState::compacted(const Tiles &updated){
+  for(auto it = updated.cbegin(); it != updated.cend(); ++it) {
+    m_tiles.insert(it.key(), it.value());
+  }
+  m_compacting.clear(); // Now in the tiles
+  if(m_logPoints >= m_compactThreshold) compact();
+}
+
+/*
+Strokes are grouped by the tiles their segments cross, then every touched
+tile is decoded (or started transparent), painted with its strokes in log
+order and encoded again. Each tile is painted in one pass, however many
+strokes hit it.
+*/
+CanvasState::Tiles CanvasState::render(const std::vector<Stroke> &strokes, const Tiles &tiles){
+
+  const int gridMin = int(std::floor(-c_maxExtent / c_tileSize));
+  const int gridMax = int(std::ceil(c_maxExtent / c_tileSize)) - 1;
+
+  QHash<qint64, QList<const Stroke*>> perTile;
+  for(const Stroke &stroke : strokes) {
+    const double width = std::clamp(stroke.width, 0.0, c_maxStrokeWidth);
+    const double margin = width / 2 + 1;
+    for(qsizetype i = 0; i < stroke.points.size(); ++i) {
+      // Single point is a dot: segment of zero length
+      const QPointF from = stroke.points[i > 0 ? i - 1 : 0];
+      const QPointF to = stroke.points[i];
+      if(i == 0 && stroke.points.size() > 1) continue;
+      if(!std::isfinite(from.x() + from.y() + to.x() + to.y())) continue;
+
+      const double left = std::max(std::min(from.x(), to.x()) - margin, -c_maxExtent);
+      const double right = std::min(std::max(from.x(), to.x()) + margin, c_maxExtent);
+      const double top = std::max(std::min(from.y(), to.y()) - margin, -c_maxExtent);
+      const double bottom = std::min(std::max(from.y(), to.y()) + margin, c_maxExtent);
+      if(left > right || top > bottom) continue;
+
+      const int firstX = std::max(gridMin, int(std::floor(left / c_tileSize)));
+      const int lastX = std::min(gridMax, int(std::floor(right / c_tileSize)));
+      const int firstY = std::max(gridMin, int(std::floor(top / c_tileSize)));
+      const int lastY = std::min(gridMax, int(std::floor(bottom / c_tileSize)));
+      for(int y = firstY; y <= lastY; ++y) {
+        for(int x = firstX; x <= lastX; ++x) {
+          if(!crosses(from, to, width, tileRect(x, y))) continue;
+          QList<const Stroke*> &strokes = perTile[tileKey(x, y)];
+          if(strokes.isEmpty() || strokes.last() != &stroke) strokes.append(&stroke);
+        }
+      }
+    }
+  }
+
+  Tiles updated;
+  for(auto it = perTile.cbegin(); it != perTile.cend(); ++it) {
+    const qint32 x = qint32(quint32(it.key()));
+    const qint32 y = qint32(it.key() >> 32);
+
+    QImage image;
+    const QByteArray existing = tiles.value(it.key());
+    if(existing.isEmpty() || !image.loadFromData(existing, "PNG")) {
+      image = QImage(c_tileSize, c_tileSize, QImage::Format_ARGB32_Premultiplied);
+      image.fill(Qt::transparent);
+    } else {
+      image.convertTo(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    {
+      QPainter painter(&image);
+      painter.setRenderHint(QPainter::Antialiasing);
+      painter.translate(-double(x) * c_tileSize, -double(y) * c_tileSize);
+      for(const Stroke *stroke : it.value()) {
+        QColor color = QColor::fromString(stroke->color);
+        if(!color.isValid()) color = Qt::black;
+        painter.setPen(QPen(color, std::clamp(stroke->width, 0.0, c_maxStrokeWidth), Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        if(stroke->points.size() == 1) {
+          painter.drawPoint(stroke->points.first());
+        } else {
+          painter.drawPolyline(stroke->points.constData(), static_cast<int>(stroke->points.size()));
+        }
+      }
+    }
+
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    if(!image.save(&buffer, "PNG")) {
+      qWarning() << "CANVAS STATE | Could not encode tile" << x << y << ", its strokes are lost";
+      continue;
+    }
+    updated.insert(it.key(), png);
+  }
+  return updated;
+}
+
+SynergyProtocol::Message_Canvas_Snapshot CanvasState::snapshot() const {
+  QList<SynergyProtocol::Message_Canvas_Snapshot::Tile> tiles;
+  tiles.reserve(m_tiles.size());
+  for(auto it = m_tiles.cbegin(); it != m_tiles.cend(); ++it) {
+    tiles.append({qint32(quint32(it.key())), qint32(it.key() >> 32), it.value()});
+  }
+  return SynergyProtocol::Message_Canvas_Snapshot {0, c_tileSize, std::move(tiles)};
+}
+
+QList<SynergyProtocol::Message_Draw_Polyline> CanvasState::tail() const {
+  QList<SynergyProtocol::Message_Draw_Polyline> polylines;
+  polylines.reserve(static_cast<qsizetype>(m_compacting.size() + m_log.size()));
+  for(const std::vector<Stroke> *strokes : {&m_compacting, &m_log}) {
+    for(const Stroke &stroke : *strokes) {
+      polylines.append(SynergyProtocol::Message_Draw_Polyline {0, stroke.strokeId, stroke.points, stroke.color, stroke.width, stroke.originatorId});
+    }
+  }
+  return polylines;
+}
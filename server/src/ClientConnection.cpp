@@ -0,0 +1,279 @@
+#include "../include/ClientConnection.h"
+
+#include <QSslCipher>
+
+ClientConnection::ClientConnection(qintptr clientId, OutboundQueue::Limits outboundLimits, QObject *parent) :
+  QObject(parent),
+  m_clientId(clientId),
+  m_outbound(outboundLimits) {
+}
+
+bool ClientConnection::start(qintptr socketDescriptor, const QSslConfiguration &configuration, TlsContextCache *tlsContexts){
+  // Ssl socket for this specific connection, created in the worker thread that will own it
+  m_socket = new QSslSocket(this); // parent is this for basic object ownership
+
+  // Setting socket descriptor obtained from listening server
+  // Associates OS-level socket with our QSslSocket object
+  if(!m_socket->setSocketDescriptor(socketDescriptor)){
+    qWarning() << "Failed to set socket descriptor: " << m_socket->errorString();
+    return false;
+  }
+
+  /* Security critial: Applying SSL configration & starting handshake
+  Apply SSL setting (cert, key, protocol) we prepared earlier
+  We can also set specific configuration per-socket if needed
+  */
+  m_socket->setSslConfiguration(configuration);
+  // Context that issued earlier session tickets, so returning clients can resume instead of a full handshake
+  m_tlsContexts = tlsContexts;
+  if(m_tlsContexts) m_tlsContexts->apply(m_socket);
+
+  // Connect signals from new socket to our slots before starting encryption, so we can handle errors/events during handshake
+  connect(m_socket, &QSslSocket::readyRead, this, &ClientConnection::onReadyRead);
+  connect(m_socket, &QAbstractSocket::disconnected, this, &ClientConnection::onDisconnected);
+  // Crucial signal for handling SSl-specific errors durng handshake or later
+  connect(m_socket, &QSslSocket::sslErrors, this, &ClientConnection::onSslErrors);
+  // Signal emitted when SSL handshake is successfully completed
+  connect(m_socket, &QSslSocket::encrypted, this, &ClientConnection::onEncrypted);
+  // Socket drained some of its buffer -> room for queued frames
+  connect(m_socket, &QSslSocket::encryptedBytesWritten, this, &ClientConnection::pumpOutbound);
+
+  /*
+  Start server-side SSL handshake.
+  Qt will now handle complex back-and-forth negotiation with client using configured settings
+  This is asynch operation, 'encrypted' or 'sslErrors' signal will follow
+  Handshake crypto runs on this worker thread, so it doesn't stall other workers
+  */
+  m_handshaking = true;
+  m_handshakeStartNs = Metrics::now();
+  m_lastReceivedNs = m_handshakeStartNs;
+  Metrics::add(Metrics::t_Counter::CONNECTIONS_ACCEPTED);
+  Metrics::adjust(Metrics::t_Gauge::CONNECTIONS_OPEN, 1);
+  Metrics::adjust(Metrics::t_Gauge::HANDSHAKES_IN_PROGRESS, 1);
+  m_socket->startServerEncryption();
+
+  qInfo() << "QSslSocket created for client" << m_clientId << "(descriptor" << socketDescriptor << "), starting encryption...";
+  return true;
+}
+
+// Slots - Data Recieved
+void ClientConnection::onReadyRead(){
+  m_lastReceivedNs = Metrics::now(); // Liveness, see ConnectionWorker
+  // Everything decrypted so far, readFrames drains all of it
+  Metrics::add(Metrics::t_Counter::BYTES_IN, static_cast<quint64>(m_socket->bytesAvailable()));
+  // One readyRead can carry several frames or only part of one
+  // Decoder keeps leftover bytes until rest of the frame arrives
+  auto status = m_decoder.readFrames(m_socket, [this](const QByteArray &frame) {
+    handleFrame(frame);
+  });
+
+  if(status == SynergyProtocol::FrameDecoder::t_Status::FRAME_TOO_LARGE) {
+    // Stream can't be resynchronized after bad length prefix -> drop the client (SRV-FUNC-NM-009)
+    qWarning() << "Frame exceeds maximum size of" << m_decoder.maxFrameSize() << "bytes, closing connection:" << m_socket->peerAddress();
+    m_socket->abort();
+  } else if(status == SynergyProtocol::FrameDecoder::t_Status::MALFORMED_FRAME) {
+    qWarning() << "Compressed frame could not be inflated, closing connection:" << m_socket->peerAddress();
+    m_socket->abort();
+  }
+}
+
+// Handles one complete frame payload
+void ClientConnection::handleFrame(const QByteArray &frame){
+  Metrics::add(Metrics::t_Counter::FRAMES_IN);
+  qCDebug(SynergyProtocol::logPayload) << "Received from client" << m_clientId << ":" << frame;
+  // Handler runs once the payload is parsed and decoded, that's where parsing time ends
+  const qint64 parseStartNs = Metrics::now();
+  const auto parsed = [parseStartNs](SynergyProtocol::t_MessageType type) {
+    Metrics::record(Metrics::t_Histogram::PARSE, Metrics::now() - parseStartNs);
+    Metrics::countMessage(type);
+  };
+
+  // Malformed payloads are logged and dropped, framing is still intact so connection can continue
+  // Each message is parsed into its concrete type and handed to matching handler below
+  const bool handled = SynergyProtocol::MessageFactory::dispatch(frame, m_wireFormat, SynergyProtocol::MessageHandlers {
+    [this, &parsed](const SynergyProtocol::Message_Client_Hello &hello) {
+      parsed(hello.type());
+      handleClientHello(hello);
+    },
+    // Liveness stays on the I/O thread, sessions never see it
+    [this, &parsed](const SynergyProtocol::Message_Ping &ping) {
+      parsed(ping.type());
+      sendMessage(SynergyProtocol::Message_Pong {m_clientId, ping.token()});
+    },
+    [this, &parsed](const SynergyProtocol::Message_Pong &pong) {
+      parsed(pong.type());
+      if(pong.token() == m_pingToken) {
+        qCDebug(SynergyProtocol::logTraffic) << "Client" << m_clientId << "round trip" << (Metrics::now() - m_pingSentNs) / 1000 << "us";
+      }
+    },
+    // By value: the decoded message is moved in, and from here into a pooled block
+    [this, &parsed](auto message) {
+      parsed(message.type());
+      // Everything else is application level, hand it over to whoever owns sessions
+      using MessageType = std::decay_t<decltype(message)>;
+      emit messageReceived(m_clientId, SynergyProtocol::makePooled<const MessageType>(std::move(message)));
+    }
+  });
+
+  if(!handled) {
+    Metrics::add(Metrics::t_Counter::PARSE_FAILURES);
+    qWarning() << "Factory failed to create message object or parse payload from client:" << m_socket->peerAddress();
+  }
+}
+
+/*
+Wire format negotiation
+Client offers formats in order of preference, we take the first one we support.
+serverHello itself still goes out as JSON (client doesn't know the choice yet),
+every frame after it, in both directions, uses the negotiated format.
+Compression is picked the same way and, like the format, applies from the
+first frame after serverHello.
+*/
+void ClientConnection::handleClientHello(const SynergyProtocol::Message_Client_Hello &hello){
+  const SynergyProtocol::t_WireFormat format = SynergyProtocol::negotiateWireFormat(hello.wireFormats());
+  const SynergyProtocol::t_Compression compression = SynergyProtocol::negotiateCompression(hello.compressions());
+  SynergyProtocol::Message_Server_Hello reply {m_clientId, QString(c_serverVersion), format, compression};
+  sendMessage(reply);
+  m_wireFormat = format;
+  m_compression = compression;
+  m_decoder.setCompression(compression);
+  emit wireFormatNegotiated(m_clientId, format);
+  qInfo() << "Negotiated wire format" << SynergyProtocol::wireFormatToString(format)
+          << "compression" << SynergyProtocol::compressionToString(compression) << "for" << m_socket->peerAddress();
+}
+
+void ClientConnection::sendMessage(const SynergyProtocol::Message_Base &message){
+  sendFrame(message.encode(m_wireFormat));
+}
+
+void ClientConnection::sendFrame(const QByteArray &payload){
+  QByteArray frame = SynergyProtocol::FrameDecoder::encodeFrame(payload);
+  QByteArray compressed = SynergyProtocol::FrameCompressor::compressFrame(frame, m_compression);
+  SynergyProtocol::FrameBufferPool::release(std::move(frame)); // Kept only if compression made a new buffer
+  writeFrame(compressed);
+}
+
+/*
+Frames go through the outbound queue, the socket only ever holds 'socketBudget'
+bytes. Whatever can't be written yet stays in the queue, where it can still be
+dropped or replaced when this client falls behind (see OutboundQueue).
+*/
+void ClientConnection::writeFrame(const QByteArray &frame, const FramePolicy &policy){
+  const bool withinLimit = m_outbound.push(frame, policy, [this](const QString &key) {
+    emit resyncNeeded(m_clientId, key);
+  });
+  for(const quint64 deliveryToken : m_outbound.takeDiscardedTokens()) {
+    emit frameDiscarded(m_clientId, deliveryToken);
+  }
+  if(!withinLimit) {
+    qWarning() << "Client" << m_clientId << "backlog exceeds" << m_outbound.limits().disconnectBytes << "bytes, disconnecting slow consumer" << m_socket->peerAddress();
+    m_socket->abort();
+    return;
+  }
+  pumpOutbound();
+}
+
+void ClientConnection::reportBacklog(){
+  const qint64 backlog = m_outbound.bytes();
+  if(backlog != m_reportedBacklog) {
+    Metrics::adjust(Metrics::t_Gauge::OUTBOUND_QUEUED_BYTES, backlog - m_reportedBacklog);
+    m_reportedBacklog = backlog;
+  }
+  const quint64 dropped = m_outbound.droppedFrames();
+  if(dropped != m_reportedDropped) {
+    Metrics::add(Metrics::t_Counter::FRAMES_DROPPED, dropped - m_reportedDropped);
+    m_reportedDropped = dropped;
+  }
+}
+
+void ClientConnection::pumpOutbound(){
+  // Unencrypted bytes waiting for TLS + ciphertext waiting for the kernel
+  while(!m_outbound.isEmpty() && m_socket->bytesToWrite() + m_socket->encryptedBytesToWrite() < m_outbound.limits().socketBudget) {
+    quint64 deliveryToken = 0;
+    QByteArray frame = m_outbound.pop(&deliveryToken);
+    m_socket->write(frame); // Qt handles encryption automatically
+    Metrics::add(Metrics::t_Counter::FRAMES_OUT);
+    Metrics::add(Metrics::t_Counter::BYTES_OUT, static_cast<quint64>(frame.size()));
+    // Back to the pool unless still shared: other recipients, session journal, or the socket's
+    // own write buffer (Qt keeps big chunks by reference instead of copying them)
+    SynergyProtocol::FrameBufferPool::release(std::move(frame));
+    if(deliveryToken != 0) emit frameDelivered(m_clientId, deliveryToken);
+  }
+  reportBacklog();
+}
+
+void ClientConnection::sendPing(){
+  m_pingSentNs = Metrics::now();
+  sendMessage(SynergyProtocol::Message_Ping {m_clientId, ++m_pingToken});
+}
+
+void ClientConnection::close(){
+  m_socket->disconnectFromHost();
+}
+
+// Graceful close waits for the peer to take our pending bytes, a dead peer never does
+void ClientConnection::abort(){
+  m_socket->abort();
+}
+
+// Slots - Client Disconnected
+void ClientConnection::onDisconnected(){
+  qInfo() << "Client disconnected: " << m_socket->peerAddress() << ":" << m_socket->peerPort();
+  if(m_handshaking) Metrics::add(Metrics::t_Counter::HANDSHAKES_FAILED);
+  finishHandshake(); // Died during handshake, its slot is free again
+  Metrics::adjust(Metrics::t_Gauge::CONNECTIONS_OPEN, -1);
+  Metrics::adjust(Metrics::t_Gauge::OUTBOUND_QUEUED_BYTES, -m_reportedBacklog); // Queue goes away with us
+  m_reportedBacklog = 0;
+  emit disconnected(m_clientId);
+
+  // Use deleteLater to safely remove QObject from within a slot connected to one of its signals
+  // This schedules deletion after the event loop returns (socket goes with us, it is our child)
+  deleteLater();
+}
+
+// Slot SSl Error occured
+// Catches errors during SSL handshake or later encryption issues
+// Vital for security
+void ClientConnection::onSslErrors(const QList<QSslError> &errors){
+  qWarning() << "SSL errors occured for a client connection: ";
+  for(const QSslError &error : errors){
+    qWarning() << "-" << error.errorString();
+  }
+
+  /* Security: Handling Self-Signed certificates
+  For this example, using self-signed certificate, the client will likely report an
+  "Unable to get local issuer certificate" or "Certificate untrusted" error
+  because certificate isn't signed bt a known CA
+
+  In production, we CANNOT ignore the errors
+  Proper handling invlolves:
+  1. Using certificates signed by a trusted CA
+  2. Configuring the client to explicitly trust you self-signed CA or specific server certificate
+  3. Carefully evaluate which errors are acceptable to ingore(if any)
+
+  For localhost example, we can chose to ignore self-signed error on client side.
+  Server typically doesn't ingore errors unless doing client certificate auth
+  Here, we just log errors, if they occur, handshake might fail and 'encrypted' signal won't be emitted
+  */
+
+  // m_socket->abort(); // To disconnect on any error, forcefully close connection
+}
+
+void ClientConnection::finishHandshake(){
+  if(!m_handshaking) return;
+  m_handshaking = false;
+  Metrics::adjust(Metrics::t_Gauge::HANDSHAKES_IN_PROGRESS, -1);
+  emit handshakeFinished(m_clientId);
+}
+
+// Slot: Connection encrypted
+void ClientConnection::onEncrypted(){
+  qInfo() << "Connection successfully encrypted for:" << m_socket->peerAddress() << ":" << m_socket->peerPort()
+          << "|" << m_socket->sessionProtocol() << m_socket->sessionCipher().name();
+  if(m_tlsContexts) m_tlsContexts->adopt(m_socket);
+  if(m_handshaking) Metrics::record(Metrics::t_Histogram::HANDSHAKE, Metrics::now() - m_handshakeStartNs);
+  finishHandshake();
+
+  // Connection is now secure, ready for application data exchange.
+  // Client opens the protocol with clientHello, we answer with serverHello (spec 5.4.1 / 5.5.1)
+}
@@ -0,0 +1,201 @@
+#include "../include/ConnectionWorker.h"
+
+#include <QMetaObject>
+#include <QTcpSocket>
+
+#include <algorithm>
+#include <array>
+
+ConnectionWorker::ConnectionWorker(int index, const QSslConfiguration &configuration, OutboundQueue::Limits outboundLimits,
+                                   TlsContextCache *tlsContexts, int maxConcurrentHandshakes, Liveness liveness) :
+  QObject(nullptr), // No parent, object is moved to its thread
+  m_index(index),
+  m_sslConfiguration(configuration),
+  m_outboundLimits(outboundLimits),
+  m_tlsContexts(tlsContexts),
+  m_maxConcurrentHandshakes(qMax(1, maxConcurrentHandshakes)),
+  m_liveness(liveness),
+  m_wheel(liveness.tickMs, nowMs()),
+  m_tick(new QTimer(this)) { // Moves to the worker thread with us
+  m_tick->setInterval(static_cast<int>(m_wheel.tickMs()));
+  connect(m_tick, &QTimer::timeout, this, &ConnectionWorker::onTick);
+}
+
+void ConnectionWorker::addConnection(qintptr socketDescriptor, qintptr clientId){
+  // Counted right away so next pick by the server already sees it
+  m_load.fetch_add(1, std::memory_order_relaxed);
+  QMetaObject::invokeMethod(this, [this, socketDescriptor, clientId]() {
+    openConnection(socketDescriptor, clientId);
+  }, Qt::QueuedConnection);
+}
+
+void ConnectionWorker::postFrame(qintptr clientId, const QByteArray &payload){
+  // QByteArray is implicitly shared, crossing the thread only copies a reference
+  QMetaObject::invokeMethod(this, [this, clientId, payload]() {
+    if(ClientConnection *connection = m_connections.value(clientId, nullptr)) {
+      connection->sendFrame(payload);
+    }
+  }, Qt::QueuedConnection);
+}
+
+void ConnectionWorker::postMessage(qintptr clientId, std::shared_ptr<const SynergyProtocol::Message_Base> message){
+  // Encoding happens here, on the I/O thread, in the format this client negotiated
+  QMetaObject::invokeMethod(this, [this, clientId, message = std::move(message)]() {
+    if(ClientConnection *connection = m_connections.value(clientId, nullptr)) {
+      connection->sendMessage(*message);
+    }
+  }, Qt::QueuedConnection);
+}
+
+void ConnectionWorker::postEncodedFrame(const QList<qintptr> &clientIds, const QByteArray &frame, const FramePolicy &policy){
+  // Every socket gets a reference to the same buffer, nothing is encoded or copied per client.
+  // Compression runs here, off the main thread, once per compression in use among these clients
+  QMetaObject::invokeMethod(this, [this, clientIds, frame, policy]() {
+    Metrics::ScopedTimer timer(Metrics::t_Histogram::FANOUT);
+    std::array<QByteArray, 3> compressed; // Per t_Compression, empty = not compressed yet
+    for(qintptr clientId : clientIds) {
+      if(ClientConnection *connection = m_connections.value(clientId, nullptr)) {
+        QByteArray &prepared = compressed[static_cast<std::size_t>(connection->compression())];
+        if(prepared.isEmpty()) prepared = SynergyProtocol::FrameCompressor::compressFrame(frame, connection->compression());
+        connection->writeFrame(prepared, policy);
+      }
+    }
+  }, Qt::QueuedConnection);
+}
+
+void ConnectionWorker::postDisconnect(qintptr clientId){
+  QMetaObject::invokeMethod(this, [this, clientId]() {
+    if(ClientConnection *connection = m_connections.value(clientId, nullptr)) {
+      connection->close();
+    }
+  }, Qt::QueuedConnection);
+}
+
+void ConnectionWorker::openConnection(qintptr socketDescriptor, qintptr clientId){
+  // Whole way to encrypted, queue included: stalled handshakes would keep their slot (and descriptor) forever
+  if(m_liveness.handshakeTimeoutMs > 0) scheduleTimer(clientId, HANDSHAKE_DEADLINE, m_liveness.handshakeTimeoutMs);
+  if(m_handshakes >= m_maxConcurrentHandshakes) {
+    if(static_cast<int>(m_waitingHandshakes.size()) >= c_maxWaitingHandshakes) {
+      qWarning() << "Worker" << m_index << "handshake queue full, dropping oldest waiting connection";
+      shedWaiting(m_waitingHandshakes.begin());
+    }
+    m_waitingHandshakes.push_back(WaitingHandshake{socketDescriptor, clientId});
+    Metrics::adjust(Metrics::t_Gauge::HANDSHAKES_QUEUED, 1);
+    return;
+  }
+  startConnection(socketDescriptor, clientId);
+}
+
+void ConnectionWorker::shedWaiting(std::deque<WaitingHandshake>::iterator waiting){
+  const WaitingHandshake shed = *waiting;
+  m_waitingHandshakes.erase(waiting);
+  Metrics::adjust(Metrics::t_Gauge::HANDSHAKES_QUEUED, -1);
+  Metrics::add(Metrics::t_Counter::HANDSHAKES_SHED);
+  m_wheel.cancel(m_timers.take(shed.clientId));
+  // Socket only to close the descriptor, portable and nothing is sent
+  QTcpSocket socket;
+  if(socket.setSocketDescriptor(shed.socketDescriptor)) socket.abort();
+  m_load.fetch_sub(1, std::memory_order_relaxed);
+  emit clientDisconnected(shed.clientId);
+}
+
+void ConnectionWorker::startConnection(qintptr socketDescriptor, qintptr clientId){
+  ClientConnection *connection = new ClientConnection(clientId, m_outboundLimits, this);
+  if(!connection->start(socketDescriptor, m_sslConfiguration, m_tlsContexts)) {
+    delete connection;
+    m_wheel.cancel(m_timers.take(clientId));
+    m_load.fetch_sub(1, std::memory_order_relaxed);
+    emit clientDisconnected(clientId);
+    return;
+  }
+  ++m_handshakes;
+  connect(connection, &ClientConnection::handshakeFinished, this, &ConnectionWorker::onHandshakeFinished);
+  connect(connection, &ClientConnection::messageReceived, this, &ConnectionWorker::messageReceived);
+  connect(connection, &ClientConnection::disconnected, this, &ConnectionWorker::onConnectionClosed);
+  connect(connection, &ClientConnection::wireFormatNegotiated, this, &ConnectionWorker::wireFormatNegotiated);
+  connect(connection, &ClientConnection::resyncNeeded, this, &ConnectionWorker::resyncNeeded);
+  connect(connection, &ClientConnection::frameDelivered, this, &ConnectionWorker::frameDelivered);
+  connect(connection, &ClientConnection::frameDiscarded, this, &ConnectionWorker::frameDiscarded);
+  m_connections.insert(clientId, connection); // Handshake deadline runs since accept
+  emit clientConnected(clientId);
+}
+
+void ConnectionWorker::onHandshakeFinished(qintptr finishedClientId){
+  // Deadline met (or connection already gone, then this does nothing)
+  m_wheel.cancel(m_timers.take(finishedClientId));
+  ClientConnection *connection = m_connections.value(finishedClientId, nullptr);
+  if(connection && connection->isEncrypted() && m_liveness.pingIntervalMs > 0) {
+    scheduleTimer(finishedClientId, LIVENESS, m_liveness.pingIntervalMs);
+  }
+
+  --m_handshakes;
+  while(m_handshakes < m_maxConcurrentHandshakes && !m_waitingHandshakes.empty()) {
+    const WaitingHandshake waiting = m_waitingHandshakes.front();
+    m_waitingHandshakes.pop_front();
+    Metrics::adjust(Metrics::t_Gauge::HANDSHAKES_QUEUED, -1);
+    startConnection(waiting.socketDescriptor, waiting.clientId);
+  }
+}
+
+void ConnectionWorker::onConnectionClosed(qintptr clientId){
+  // ClientConnection deletes itself (deleteLater), we only drop the reference
+  m_wheel.cancel(m_timers.take(clientId));
+  if(m_connections.remove(clientId)) {
+    m_load.fetch_sub(1, std::memory_order_relaxed);
+    emit clientDisconnected(clientId);
+  }
+}
+
+void ConnectionWorker::scheduleTimer(qintptr clientId, t_Timer kind, qint64 delayMs){
+  m_wheel.cancel(m_timers.value(clientId));
+  m_timers.insert(clientId, m_wheel.schedule(nowMs(), delayMs, clientId, kind));
+  if(!m_tick->isActive()) m_tick->start();
+}
+
+void ConnectionWorker::onTick(){
+  m_wheel.advance(nowMs(), [this](qintptr clientId, int kind) {
+    m_timers.remove(clientId); // Fired, onTimer may schedule the next one
+    onTimer(clientId, kind);
+  });
+  // Idle worker doesn't wake up 4 times a second for nothing
+  if(m_wheel.size() == 0) m_tick->stop();
+}
+
+void ConnectionWorker::onTimer(qintptr clientId, int kind){
+  ClientConnection *connection = m_connections.value(clientId, nullptr);
+  if(!connection && kind == HANDSHAKE_DEADLINE) {
+    // Deadline passed before a slot freed up
+    auto waiting = std::find_if(m_waitingHandshakes.begin(), m_waitingHandshakes.end(), [clientId](const WaitingHandshake &entry) {
+      return entry.clientId == clientId;
+    });
+    if(waiting == m_waitingHandshakes.end()) return;
+    qWarning() << "Client" << clientId << "waited" << m_liveness.handshakeTimeoutMs << "ms for a handshake slot, dropping connection";
+    shedWaiting(waiting);
+    return;
+  }
+  if(!connection) return;
+
+  if(kind == HANDSHAKE_DEADLINE) {
+    qWarning() << "Client" << clientId << "did not complete the TLS handshake within" << m_liveness.handshakeTimeoutMs << "ms, dropping connection";
+    Metrics::add(Metrics::t_Counter::CONNECTIONS_TIMED_OUT);
+    connection->abort(); // disconnected -> onConnectionClosed, handshake slot is freed
+    return;
+  }
+
+  // Traffic only moves the last receive time, the timer catches up here
+  const qint64 idleMs = (Metrics::now() - connection->lastReceivedNs()) / 1000000;
+  if(m_liveness.idleTimeoutMs > 0 && idleMs >= m_liveness.idleTimeoutMs) {
+    qWarning() << "Client" << clientId << "silent for" << idleMs << "ms, dropping connection";
+    Metrics::add(Metrics::t_Counter::CONNECTIONS_TIMED_OUT);
+    connection->abort();
+    return;
+  }
+
+  qint64 nextCheckMs = m_liveness.pingIntervalMs - idleMs;
+  if(idleMs >= m_liveness.pingIntervalMs) {
+    connection->sendPing();
+    nextCheckMs = m_liveness.pingIntervalMs;
+  }
+  if(m_liveness.idleTimeoutMs > 0) nextCheckMs = qMin<qint64>(nextCheckMs, m_liveness.idleTimeoutMs - idleMs);
+  scheduleTimer(clientId, LIVENESS, nextCheckMs);
+}
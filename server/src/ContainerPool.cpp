@@ -0,0 +1,234 @@
+#include "../include/ContainerPool.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QUrl>
+#include <QDebug>
+
+#include <algorithm>
+#include <utility>
+
+ContainerPool::ContainerPool(DockerApiClient &docker, Config config, QObject *parent) :
+  QObject(parent),
+  m_docker(docker),
+  m_config(std::move(config)) {
+  m_config.maxContainers = std::max(1, m_config.maxContainers);
+  m_config.warmContainers = std::clamp(m_config.warmContainers, 0, m_config.maxContainers);
+  connect(&m_healthTimer, &QTimer::timeout, this, &ContainerPool::checkHealth);
+  m_retryTimer.setSingleShot(true);
+  connect(&m_retryTimer, &QTimer::timeout, this, &ContainerPool::replenish);
+}
+
+ContainerPool::~ContainerPool(){
+  // Best effort, requests complete only if event loop still runs. Anything missed is removed on next start()
+  for(auto it = m_containers.cbegin(); it != m_containers.cend(); ++it) {
+    m_docker.remove(QStringLiteral("/containers/%1?force=1&v=1").arg(it.key()), [](const DockerApiClient::Response&) {});
+  }
+  for(const Waiter &waiter : std::as_const(m_waiters)) {
+    waiter.handler(QString(), QStringLiteral("Container pool shut down"));
+  }
+}
+
+void ContainerPool::start(){
+  if(m_started) return;
+  m_started = true;
+  removeLeftovers();
+  if(m_config.healthCheckIntervalMs > 0) {
+    m_healthTimer.start(m_config.healthCheckIntervalMs);
+  }
+}
+
+void ContainerPool::removeLeftovers(){
+  const QJsonObject filters {{"label", QJsonArray{QStringLiteral("%1=%2").arg(c_poolLabel, m_config.image)}}};
+  const QString query = QString::fromUtf8(QUrl::toPercentEncoding(QString::fromUtf8(QJsonDocument(filters).toJson(QJsonDocument::Compact))));
+
+  m_docker.get(QStringLiteral("/containers/json?all=1&filters=%1").arg(query), [this](const DockerApiClient::Response &response) {
+    if(!response.ok()) {
+      qWarning() << "CONTAINER POOL | Could not list leftover containers:" << response.error;
+    } else {
+      for(const QJsonValue &entry : response.json().array()) {
+        const QString id = entry.toObject().value("Id").toString();
+        if(id.isEmpty() || m_containers.contains(id)) continue;
+        qInfo() << "CONTAINER POOL | Removing leftover container" << id.left(12);
+        m_docker.remove(QStringLiteral("/containers/%1?force=1&v=1").arg(id), [](const DockerApiClient::Response&) {});
+      }
+    }
+    replenish();
+  });
+}
+
+/*
+Pool wants: one container per waiting lease + warm idle ones.
+Containers being created or reset will become idle, they count as supply.
+*/
+void ContainerPool::replenish(){
+  if(m_retryTimer.isActive()) return; // Backing off after failed creations
+  const int wanted = m_waiters.size() + m_config.warmContainers;
+  int supply = m_idle.size() + m_creating + m_resetting;
+  while(supply < wanted && containerCount() < m_config.maxContainers) {
+    createContainer();
+    ++supply;
+  }
+}
+
+QByteArray ContainerPool::createBody() const {
+  // No network, bounded memory/processes. Cmd keeps container running; it is PID 1, so the
+  // reset's "kill -9 -1" takes out everything else.
+  // Containers move between sessions: root file system is read-only, a run can write only to
+  // /workspace (anonymous volume, the archive API can't write into tmpfs) and the tmpfs
+  // scratch directories the reset empties. HOME points at one of them whatever user the image runs as
+  QJsonObject tmpfs;
+  for(const char *path : c_scratchPaths) {
+    tmpfs.insert(QString::fromLatin1(path), QStringLiteral("rw,nosuid,nodev,size=%1").arg(m_config.scratchLimitBytes));
+  }
+  const QJsonObject hostConfig {
+    {"NetworkMode", "none"},
+    {"Memory", m_config.memoryLimitBytes},
+    {"PidsLimit", m_config.pidsLimit},
+    {"ReadonlyRootfs", true},
+    {"Tmpfs", tmpfs},
+    {"ShmSize", m_config.scratchLimitBytes}
+  };
+  const QJsonObject body {
+    {"Image", m_config.image},
+    {"Cmd", QJsonArray{"sleep", "infinity"}},
+    {"WorkingDir", QString::fromLatin1(c_workspacePath)},
+    {"Env", QJsonArray{"HOME=/root", "TMPDIR=/tmp"}},
+    {"Volumes", QJsonObject{{QString::fromLatin1(c_workspacePath), QJsonObject()}}},
+    {"NetworkDisabled", true},
+    {"Labels", QJsonObject{{QString::fromLatin1(c_poolLabel), m_config.image}}},
+    {"HostConfig", hostConfig}
+  };
+  return QJsonDocument(body).toJson(QJsonDocument::Compact);
+}
+
+void ContainerPool::createContainer(){
+  ++m_creating;
+  m_docker.post(QStringLiteral("/containers/create"), createBody(), [this](const DockerApiClient::Response &created) {
+    if(!created.ok()) {
+      onCreationFailed(QStringLiteral("create: %1").arg(created.error));
+      return;
+    }
+    const QString id = created.json().object().value("Id").toString();
+    m_docker.post(QStringLiteral("/containers/%1/start").arg(id), QByteArray(), [this, id](const DockerApiClient::Response &started) {
+      if(!started.ok()) {
+        m_docker.remove(QStringLiteral("/containers/%1?force=1&v=1").arg(id), [](const DockerApiClient::Response&) {});
+        onCreationFailed(QStringLiteral("start: %1").arg(started.error));
+        return;
+      }
+      onContainerReady(id);
+    });
+  });
+}
+
+void ContainerPool::onContainerReady(const QString &containerId){
+  --m_creating;
+  m_failedCreations = 0;
+  m_containers.insert(containerId, Container{});
+  m_idle.append(containerId);
+  handOut();
+}
+
+void ContainerPool::onCreationFailed(const QString &error){
+  --m_creating;
+  ++m_failedCreations;
+  qWarning() << "CONTAINER POOL | Could not create container from" << m_config.image << "|" << error;
+
+  // Nothing that could serve waiting leases -> fail them instead of letting them hang
+  if(m_containers.isEmpty() && m_creating == 0) {
+    const QList<Waiter> waiters = std::exchange(m_waiters, {});
+    for(const Waiter &waiter : waiters) {
+      waiter.handler(QString(), QStringLiteral("No execution container available (%1)").arg(error));
+    }
+  }
+  // Exponential backoff, daemon down or image missing shouldn't turn into a request storm
+  const int delay = std::min(c_maxBackoffMs, 500 << std::min(m_failedCreations, 7));
+  m_retryTimer.start(delay);
+}
+
+void ContainerPool::lease(LeaseHandler handler, const QString &affinity){
+  m_waiters.append(Waiter{std::move(handler), affinity});
+  handOut();
+  replenish();
+}
+
+// Waiters are served in order; each gets an idle container of its affinity if there is one, else the oldest idle
+void ContainerPool::handOut(){
+  while(!m_waiters.isEmpty() && !m_idle.isEmpty()) {
+    const Waiter waiter = m_waiters.takeFirst();
+    qsizetype pick = 0;
+    if(!waiter.affinity.isEmpty()) {
+      const auto match = std::find_if(m_idle.cbegin(), m_idle.cend(), [&](const QString &id) {
+        return m_containers.value(id).affinity == waiter.affinity;
+      });
+      if(match != m_idle.cend()) pick = match - m_idle.cbegin();
+    }
+    const QString id = m_idle.takeAt(pick);
+    m_containers[id].state = t_State::LEASED;
+    waiter.handler(id, QString());
+  }
+}
+
+void ContainerPool::release(const QString &containerId, bool healthy, const QString &affinity){
+  auto it = m_containers.find(containerId);
+  if(it == m_containers.end() || it->state != t_State::LEASED) {
+    qWarning() << "CONTAINER POOL | Release of unknown container" << containerId.left(12);
+    return;
+  }
+  ++it->runs;
+  it->affinity = affinity;
+  if(!healthy || it->runs >= m_config.maxRunsPerContainer) {
+    recycle(containerId);
+  } else {
+    resetContainer(containerId);
+  }
+}
+
+void ContainerPool::resetContainer(const QString &containerId){
+  m_containers[containerId].state = t_State::RESETTING;
+  ++m_resetting;
+  // kill -1 skips PID 1 (the sleep) and the shell itself. Scratch directories and /dev/shm are
+  // the only writable places besides /workspace, nothing of this run reaches the next lease
+  QString wipe = QStringLiteral("kill -9 -1 2>/dev/null; find");
+  for(const char *path : c_scratchPaths) wipe += QLatin1Char(' ') + QString::fromLatin1(path);
+  wipe += QStringLiteral(" /dev/shm -mindepth 1 -delete");
+  const QStringList command {"sh", "-c", wipe};
+  m_docker.exec(containerId, command, QStringLiteral("/"), {}, [this, containerId](int exitCode, const QString &error) {
+    --m_resetting;
+    if(!m_containers.contains(containerId)) return;
+    if(exitCode != 0) {
+      qWarning() << "CONTAINER POOL | Reset failed for" << containerId.left(12) << "exit" << exitCode << error;
+      recycle(containerId);
+      return;
+    }
+    m_containers[containerId].state = t_State::IDLE;
+    m_idle.append(containerId);
+    handOut();
+  }, c_resetTimeoutMs);
+}
+
+void ContainerPool::recycle(const QString &containerId){
+  m_containers.remove(containerId);
+  m_idle.removeAll(containerId);
+  emit containerRemoved(containerId);
+  m_docker.remove(QStringLiteral("/containers/%1?force=1&v=1").arg(containerId), [containerId](const DockerApiClient::Response &response) {
+    if(!response.ok() && response.status != 404) {
+      qWarning() << "CONTAINER POOL | Could not remove container" << containerId.left(12) << response.error;
+    }
+  });
+  replenish();
+}
+
+void ContainerPool::checkHealth(){
+  for(const QString &id : std::as_const(m_idle)) {
+    m_docker.get(QStringLiteral("/containers/%1/json").arg(id), [this, id](const DockerApiClient::Response &response) {
+      const auto it = m_containers.constFind(id);
+      if(it == m_containers.cend() || it->state != t_State::IDLE) return; // Leased meanwhile, run will tell
+      if(!response.ok() || !response.json().object().value("State").toObject().value("Running").toBool()) {
+        qWarning() << "CONTAINER POOL | Idle container" << id.left(12) << "unhealthy, replacing";
+        recycle(id);
+      }
+    });
+  }
+  replenish();
+}
@@ -0,0 +1,291 @@
+#include "../include/DockerApiClient.h"
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+DockerApiClient::DockerApiClient(QString socketPath, QObject *parent) :
+  QObject(parent),
+  m_socketPath(std::move(socketPath)) {
+}
+
+QByteArray DockerApiClient::requestHead(const QByteArray &method, const QString &path, const QByteArray &contentType, qint64 length){
+  QByteArray head;
+  head += method + ' ' + QByteArray(c_apiVersion) + path.toUtf8() + " HTTP/1.1\r\n";
+  head += "Host: docker\r\n";
+  head += "Connection: close\r\n";
+  if(length > 0 || method == "POST" || method == "PUT") {
+    head += "Content-Type: " + contentType + "\r\n";
+    head += "Content-Length: " + QByteArray::number(length) + "\r\n";
+  }
+  head += "\r\n";
+  return head;
+}
+
+DockerHttpExchange* DockerApiClient::request(const QByteArray &method, const QString &path, const QByteArray &body, ResponseHandler onDone,
+                                             DataHandler onData, const QByteArray &contentType, int timeoutMs){
+  QByteArray request = requestHead(method, path, contentType, body.size());
+  request += body;
+
+  // Exchange is parented to the client: pending requests die with it, handlers never fire afterwards
+  return new DockerHttpExchange(m_socketPath, std::move(request), std::move(onDone), std::move(onData), timeoutMs, this);
+}
+
+void DockerApiClient::upload(const QByteArray &method, const QString &path, std::shared_ptr<QIODevice> body, qint64 length,
+                             const QByteArray &contentType, ResponseHandler onDone, int timeoutMs){
+  new DockerHttpExchange(m_socketPath, requestHead(method, path, contentType, length), std::move(onDone), {}, timeoutMs, this,
+                         std::move(body), length);
+}
+
+std::shared_ptr<DockerApiClient::ExecHandle> DockerApiClient::exec(const QString &containerId, const QStringList &command, const QString &workingDir,
+                                                                   DataHandler onOutput, ExecDoneHandler onDone, int timeoutMs){
+  auto handle = std::make_shared<ExecHandle>();
+  const QJsonObject setup {
+    {"AttachStdout", true},
+    {"AttachStderr", true},
+    {"Tty", false},
+    {"Cmd", QJsonArray::fromStringList(command)},
+    {"WorkingDir", workingDir}
+  };
+  post(QStringLiteral("/containers/%1/exec").arg(containerId), QJsonDocument(setup).toJson(QJsonDocument::Compact),
+    [this, handle, onOutput = std::move(onOutput), onDone = std::move(onDone), timeoutMs](const Response &created) mutable {
+      if(!created.ok()) {
+        onDone(-1, QStringLiteral("exec create failed: %1").arg(created.error));
+        return;
+      }
+      if(!handle->cancelReason.isEmpty()) {
+        onDone(-1, handle->cancelReason); // Never started
+        return;
+      }
+      const QString execId = created.json().object().value("Id").toString();
+      const QByteArray start = QJsonDocument(QJsonObject{{"Detach", false}, {"Tty", false}}).toJson(QJsonDocument::Compact);
+
+      // Stream stays open until the process exits, so run timeout applies to this request
+      handle->stream = request("POST", QStringLiteral("/exec/%1/start").arg(execId), start,
+        [this, execId, onDone = std::move(onDone)](const Response &started) mutable {
+          if(!started.ok()) {
+            onDone(-1, QStringLiteral("exec start failed: %1").arg(started.error));
+            return;
+          }
+          get(QStringLiteral("/exec/%1/json").arg(execId), [onDone = std::move(onDone)](const Response &inspected) {
+            if(!inspected.ok()) {
+              onDone(-1, QStringLiteral("exec inspect failed: %1").arg(inspected.error));
+              return;
+            }
+            onDone(inspected.json().object().value("ExitCode").toInt(-1), QString());
+          });
+        }, std::move(onOutput), "application/json", timeoutMs);
+    });
+  return handle;
+}
+
+void DockerApiClient::cancelExec(const std::shared_ptr<ExecHandle> &exec, const QString &reason){
+  if(!exec || !exec->cancelReason.isEmpty()) return;
+  exec->cancelReason = reason;
+  if(exec->stream) exec->stream->abort(reason); // Start request fails -> onDone(-1, reason)
+}
+
+DockerHttpExchange::DockerHttpExchange(const QString &socketPath, QByteArray request, DockerApiClient::ResponseHandler onDone,
+                                       DockerApiClient::DataHandler onData, int timeoutMs, QObject *parent,
+                                       std::shared_ptr<QIODevice> body, qint64 bodyLength) :
+  QObject(parent),
+  m_request(std::move(request)),
+  m_body(std::move(body)),
+  m_bodyRemaining(m_body ? bodyLength : 0),
+  m_onDone(std::move(onDone)),
+  m_onData(std::move(onData)) {
+  connect(&m_socket, &QLocalSocket::connected, this, &DockerHttpExchange::onConnected);
+  connect(&m_socket, &QLocalSocket::readyRead, this, &DockerHttpExchange::onReadyRead);
+  connect(&m_socket, &QLocalSocket::disconnected, this, &DockerHttpExchange::onDisconnected);
+  connect(&m_socket, &QLocalSocket::errorOccurred, this, &DockerHttpExchange::onError);
+  if(m_body) {
+    connect(&m_socket, &QLocalSocket::bytesWritten, this, &DockerHttpExchange::pumpBody);
+  }
+
+  if(timeoutMs > 0) {
+    m_timeout.setSingleShot(true);
+    connect(&m_timeout, &QTimer::timeout, this, [this, timeoutMs]() {
+      abort(QStringLiteral("Docker API request timed out after %1 ms").arg(timeoutMs));
+    });
+    m_timeout.start(timeoutMs);
+  }
+  m_socket.connectToServer(socketPath);
+}
+
+void DockerHttpExchange::onConnected(){
+  m_socket.write(m_request);
+  m_request.clear();
+  pumpBody();
+}
+
+// Refills socket buffer from body device, called again whenever socket drained some of it
+void DockerHttpExchange::pumpBody(){
+  if(!m_body || m_state == t_State::DONE) return;
+  while(m_bodyRemaining > 0 && m_socket.bytesToWrite() < c_sendWatermark) {
+    const QByteArray chunk = m_body->read(qMin(c_sendChunk, m_bodyRemaining));
+    if(chunk.isEmpty()) {
+      abort(QStringLiteral("Request body ended %1 bytes early").arg(m_bodyRemaining));
+      return;
+    }
+    m_socket.write(chunk);
+    m_bodyRemaining -= chunk.size();
+  }
+  if(m_bodyRemaining == 0) {
+    m_body.reset(); // Caller's reference (if any) decides how long device lives
+  }
+}
+
+void DockerHttpExchange::onReadyRead(){
+  m_buffer += m_socket.readAll();
+  if(m_state == t_State::HEADERS && !parseHeaders()) return;
+  parseBody();
+}
+
+bool DockerHttpExchange::parseHeaders(){
+  const qsizetype end = m_buffer.indexOf("\r\n\r\n");
+  if(end < 0) return false;
+
+  const QList<QByteArray> lines = m_buffer.left(end).split('\n');
+  m_buffer.remove(0, end + 4);
+
+  // "HTTP/1.1 200 OK"
+  const QList<QByteArray> statusLine = lines.value(0).trimmed().split(' ');
+  m_response.status = statusLine.value(1).toInt();
+
+  qint64 contentLength = -1;
+  bool chunked = false;
+  for(qsizetype i = 1; i < lines.size(); ++i) {
+    const QByteArray line = lines[i].trimmed();
+    const qsizetype colon = line.indexOf(':');
+    if(colon < 0) continue;
+    const QByteArray name = line.left(colon).trimmed().toLower();
+    const QByteArray value = line.mid(colon + 1).trimmed();
+    if(name == "content-length") {
+      contentLength = value.toLongLong();
+    } else if(name == "transfer-encoding" && value.toLower().contains("chunked")) {
+      chunked = true;
+    }
+  }
+
+  if(chunked) {
+    m_state = t_State::BODY_CHUNK_SIZE;
+  } else if(contentLength >= 0) {
+    m_state = t_State::BODY_LENGTH;
+    m_remaining = contentLength;
+  } else {
+    m_state = t_State::BODY_UNTIL_CLOSE;
+  }
+  return true;
+}
+
+void DockerHttpExchange::parseBody(){
+  while(m_state != t_State::DONE) {
+    switch(m_state) {
+      case t_State::BODY_LENGTH: {
+        const qint64 take = qMin<qint64>(m_remaining, m_buffer.size());
+        if(take > 0) {
+          deliver(m_buffer.left(take));
+          m_buffer.remove(0, take);
+          m_remaining -= take;
+        }
+        if(m_remaining == 0) {
+          finish();
+        }
+        return;
+      }
+      case t_State::BODY_UNTIL_CLOSE:
+        if(!m_buffer.isEmpty()) {
+          deliver(m_buffer);
+          m_buffer.clear();
+        }
+        return; // Finished by onDisconnected
+      case t_State::BODY_CHUNK_SIZE: {
+        const qsizetype lineEnd = m_buffer.indexOf("\r\n");
+        if(lineEnd < 0) return;
+        bool ok = false;
+        m_remaining = m_buffer.left(lineEnd).split(';').value(0).trimmed().toLongLong(&ok, 16);
+        m_buffer.remove(0, lineEnd + 2);
+        if(!ok) {
+          abort(QStringLiteral("Malformed chunked response from Docker API"));
+          return;
+        }
+        if(m_remaining == 0) {
+          finish(); // Trailers are ignored, connection closes anyway
+          return;
+        }
+        m_state = t_State::BODY_CHUNK_DATA;
+        break;
+      }
+      case t_State::BODY_CHUNK_DATA: {
+        const qint64 take = qMin<qint64>(m_remaining, m_buffer.size());
+        if(take == 0) return;
+        deliver(m_buffer.left(take));
+        m_buffer.remove(0, take);
+        m_remaining -= take;
+        if(m_remaining == 0) m_state = t_State::BODY_CHUNK_END;
+        break;
+      }
+      case t_State::BODY_CHUNK_END:
+        if(m_buffer.size() < 2) return;
+        m_buffer.remove(0, 2);
+        m_state = t_State::BODY_CHUNK_SIZE;
+        break;
+      case t_State::HEADERS:
+      case t_State::DONE:
+        return;
+    }
+  }
+}
+
+void DockerHttpExchange::deliver(const QByteArray &data){
+  // Error bodies are always collected, they carry the message we want to log
+  if(m_onData && m_response.ok()) {
+    m_onData(data);
+  } else {
+    m_response.body += data;
+  }
+}
+
+void DockerHttpExchange::onDisconnected(){
+  if(m_state == t_State::DONE) return;
+  if(m_state == t_State::BODY_UNTIL_CLOSE) {
+    m_buffer += m_socket.readAll();
+    parseBody();
+    finish();
+    return;
+  }
+  abort(QStringLiteral("Docker API closed connection before response was complete"));
+}
+
+void DockerHttpExchange::onError(QLocalSocket::LocalSocketError error){
+  // Peer closing is the normal end of a "Connection: close" exchange
+  if(error == QLocalSocket::PeerClosedError) return;
+  abort(QStringLiteral("Docker API socket error: %1").arg(m_socket.errorString()));
+}
+
+void DockerHttpExchange::abort(const QString &reason){
+  if(m_state == t_State::DONE) return;
+  m_response.error = reason;
+  if(m_response.ok()) m_response.status = 0; // Incomplete success is not a success
+  finish();
+}
+
+void DockerHttpExchange::finish(){
+  if(m_state == t_State::DONE) return;
+  m_state = t_State::DONE;
+  m_timeout.stop();
+
+  // Docker reports errors as {"message": "..."}
+  if(!m_response.ok() && m_response.error.isEmpty()) {
+    m_response.error = m_response.json().object().value("message").toString();
+    if(m_response.error.isEmpty()) m_response.error = QStringLiteral("HTTP status %1").arg(m_response.status);
+  }
+
+  m_socket.disconnect(this);
+  m_socket.abort();
+  if(m_onDone) {
+    DockerApiClient::ResponseHandler onDone = std::move(m_onDone);
+    onDone(m_response);
+  }
+  deleteLater();
+}
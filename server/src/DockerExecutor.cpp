@@ -0,0 +1,304 @@
+#include "../include/DockerExecutor.h"
+#include "../include/WorkspaceArchive.h"
+#include "../include/Metrics.h"
+
+#include <QThreadPool>
+#include <QCoreApplication>
+#include <QPointer>
+#include <QDateTime>
+#include <QDebug>
+
+#include <algorithm>
+#include <utility>
+
+struct DockerExecutor::Run {
+  QString workspaceRoot;
+  QStringList command;
+  ContainerPool *pool = nullptr;
+  QString containerId;
+  OutputHandler output;
+  ResultHandler done;
+  Result result;
+  WorkspaceManifest host;      // Workspace as scanned for this run
+  DockerStreamDemuxer demuxer;
+  std::shared_ptr<DockerApiClient::ExecHandle> exec;
+  bool outputStopped = false;  // Output handler said it wants no more
+  QByteArray listing;          // Output of container workspace listing
+  qint64 startedNs = Metrics::now();
+  qint64 stageStartedNs = startedNs;
+
+  // Time since the previous stage ended is this stage's
+  void endStage(Metrics::t_Histogram stage){
+    const qint64 now = Metrics::now();
+    Metrics::record(stage, now - stageStartedNs);
+    stageStartedNs = now;
+  }
+};
+
+DockerExecutor::DockerExecutor(Config config, QObject *parent) :
+  QObject(parent),
+  m_config(std::move(config)),
+  m_docker(m_config.socketPath, this) {
+}
+
+DockerExecutor::~DockerExecutor(){
+  // Pools talk to m_docker while shutting down, they must go before it does
+  qDeleteAll(m_pools);
+  m_pools.clear();
+}
+
+void DockerExecutor::start(){
+  QString error;
+  if(ContainerPool *pool = poolFor(QString(), error)) pool->start();
+}
+
+void DockerExecutor::forgetWorkspace(const QString &workspaceRoot){
+  m_hostManifests.remove(workspaceRoot);
+}
+
+ContainerPool* DockerExecutor::poolFor(const QString &environment, QString &error){
+  QString image = m_config.pool.image;
+  if(!environment.isEmpty()) {
+    if(!m_config.environments.contains(environment)) {
+      error = QStringLiteral("Unknown target environment '%1'").arg(environment);
+      return nullptr;
+    }
+    image = m_config.environments.value(environment);
+  }
+  if(ContainerPool *pool = m_pools.value(image)) return pool;
+
+  ContainerPool::Config poolConfig = m_config.pool;
+  poolConfig.image = image;
+  auto *pool = new ContainerPool(m_docker, poolConfig, this);
+  connect(pool, &ContainerPool::containerRemoved, this, [this](const QString &containerId) {
+    m_containerWorkspaces.remove(containerId);
+  });
+  m_pools.insert(image, pool);
+  pool->start();
+  return pool;
+}
+
+void DockerExecutor::run(const QString &workspaceRoot, const QString &command, const QStringList &args,
+                         const QString &environment, OutputHandler output, ResultHandler done){
+  auto run = std::make_shared<Run>();
+  run->workspaceRoot = workspaceRoot;
+  run->command = QStringList{command} + args;
+  run->output = std::move(output);
+  run->done = std::move(done);
+
+  QString error;
+  run->pool = poolFor(environment, error);
+  if(!run->pool) {
+    run->result.error = error;
+    Metrics::add(Metrics::t_Counter::RUNS_FAILED);
+    run->done(run->result);
+    return;
+  }
+  scan(run);
+}
+
+// Walking and hashing touch the disk a lot, so they stay off the main thread. Result is posted
+// to the application object (always alive), the executor is looked at only back on the main thread
+void DockerExecutor::scan(const std::shared_ptr<Run> &run){
+  QPointer<DockerExecutor> self(this);
+  QThreadPool::globalInstance()->start([self, run, previous = m_hostManifests.value(run->workspaceRoot)]() mutable {
+    WorkspaceManifest manifest = WorkspaceManifest::scan(run->workspaceRoot, previous);
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [self = std::move(self), run, manifest = std::move(manifest)]() mutable {
+      if(!self) return;
+      self->m_hostManifests.insert(run->workspaceRoot, manifest);
+      run->host = std::move(manifest);
+      run->endStage(Metrics::t_Histogram::DOCKER_SCAN);
+      self->lease(run);
+    }, Qt::QueuedConnection);
+  });
+}
+
+void DockerExecutor::lease(const std::shared_ptr<Run> &run){
+  run->pool->lease([this, run](const QString &containerId, const QString &leaseError) {
+    if(!leaseError.isEmpty()) {
+      run->result.error = leaseError;
+      Metrics::add(Metrics::t_Counter::RUNS_FAILED);
+      run->done(run->result);
+      return;
+    }
+    run->endStage(Metrics::t_Histogram::DOCKER_LEASE);
+    run->containerId = containerId;
+    const auto known = m_containerWorkspaces.constFind(containerId);
+    if(known != m_containerWorkspaces.cend() && known->workspaceRoot == run->workspaceRoot) {
+      listContainerWorkspace(run);
+    } else {
+      wipe(run); // Fresh container or other session's files
+    }
+  }, run->workspaceRoot);
+}
+
+/*
+Lists container's /workspace relative to the stamp written by our last upload.
+Output has three sections separated by "//" (find prints "./..." paths, so it can't clash):
+1. regular files untouched since upload
+2. files changed or created by runs, and anything that isn't a file/directory
+3. directories
+Exit code 3 -> no stamp, state unknown.
+*/
+void DockerExecutor::listContainerWorkspace(const std::shared_ptr<Run> &run){
+  const QString script = QStringLiteral(
+    "cd /workspace || exit 1\n"
+    "[ -f %1 ] || exit 3\n"
+    "find . -mindepth 1 -type f ! -newer %1 ! -path ./%1\n"
+    "echo //\n"
+    "find . -mindepth 1 ! -type d ! -path ./%1 \\( -newer %1 -o ! -type f \\)\n"
+    "echo //\n"
+    "find . -mindepth 1 -type d\n").arg(QString::fromLatin1(c_stampName));
+
+  m_docker.exec(run->containerId, {"sh", "-c", script}, QString::fromLatin1(ContainerPool::c_workspacePath),
+    [run](const QByteArray &data) {
+      run->demuxer.feed(data, [&](DockerStreamDemuxer::t_Stream stream, QByteArrayView payload) {
+        if(stream == DockerStreamDemuxer::t_Stream::STDOUT) run->listing.append(payload);
+      });
+    },
+    [this, run](int exitCode, const QString &error) {
+      run->demuxer = DockerStreamDemuxer();
+      const QByteArray listing = std::exchange(run->listing, {});
+      if(!error.isEmpty()) {
+        fail(run, QStringLiteral("Workspace listing failed: %1").arg(error));
+      } else if(exitCode != 0) {
+        wipe(run);
+      } else {
+        synchronize(run, listing);
+      }
+    }, c_syncTimeoutMs);
+}
+
+// Parses the listing, WorkspaceManifest::changesFrom() decides what has to change in the container
+void DockerExecutor::synchronize(const std::shared_ptr<Run> &run, const QByteArray &listing){
+  WorkspaceManifest::Listing container;
+  QSet<QString> *section = &container.clean;
+  for(const QByteArray &line : listing.split('\n')) {
+    if(line == "//") {
+      section = section == &container.clean ? &container.dirty : &container.directories;
+      continue;
+    }
+    if(line.startsWith("./")) section->insert(QString::fromUtf8(line.mid(2)));
+  }
+
+  const WorkspaceManifest::Changes changes = run->host.changesFrom(container, m_containerWorkspaces.value(run->containerId).hashes);
+  if(changes.deletions.size() > c_maxDeletePaths) {
+    wipe(run); // Cheaper than a huge argument list
+    return;
+  }
+  if(changes.deletions.isEmpty()) {
+    upload(run, changes.files, changes.directories);
+    return;
+  }
+  m_docker.exec(run->containerId, QStringList{"rm", "-rf", "--"} + changes.deletions, QString::fromLatin1(ContainerPool::c_workspacePath), {},
+    [this, run, changes](int exitCode, const QString &error) {
+      if(exitCode != 0) {
+        fail(run, QStringLiteral("Workspace cleanup failed: %1").arg(error.isEmpty() ? QStringLiteral("exit %1").arg(exitCode) : error));
+        return;
+      }
+      upload(run, changes.files, changes.directories);
+    }, c_syncTimeoutMs);
+}
+
+void DockerExecutor::wipe(const std::shared_ptr<Run> &run){
+  m_containerWorkspaces.remove(run->containerId);
+  m_docker.exec(run->containerId, {"find", QString::fromLatin1(ContainerPool::c_workspacePath), "-mindepth", "1", "-delete"}, "/", {},
+    [this, run](int exitCode, const QString &error) {
+      if(exitCode != 0) {
+        fail(run, QStringLiteral("Workspace reset failed: %1").arg(error.isEmpty() ? QStringLiteral("exit %1").arg(exitCode) : error));
+        return;
+      }
+      upload(run, QSet<QString>(run->host.files.keyBegin(), run->host.files.keyEnd()), run->host.directories);
+    }, c_syncTimeoutMs);
+}
+
+/*
+Tar is streamed from disk into the request (bounded memory), always with a fresh
+stamp file: its mtime marks "as uploaded", anything newer was changed by a run.
+Files are listed after their directories, so parents exist when children arrive.
+*/
+void DockerExecutor::upload(const std::shared_ptr<Run> &run, const QSet<QString> &files, const QSet<QString> &directories){
+  QStringList sortedDirectories(directories.cbegin(), directories.cend());
+  QStringList sortedFiles(files.cbegin(), files.cend());
+  std::sort(sortedDirectories.begin(), sortedDirectories.end());
+  std::sort(sortedFiles.begin(), sortedFiles.end());
+
+  QList<WorkspaceArchive::Entry> entries;
+  entries.reserve(sortedDirectories.size() + sortedFiles.size() + 1);
+  const qint64 now = QDateTime::currentSecsSinceEpoch();
+  for(const QString &path : std::as_const(sortedDirectories)) {
+    entries.append(WorkspaceArchive::Entry{path, 0, now, true});
+  }
+  qint64 bytes = 0;
+  for(const QString &path : std::as_const(sortedFiles)) {
+    const WorkspaceManifest::File file = run->host.files.value(path);
+    entries.append(WorkspaceArchive::Entry{path, file.size, file.modifiedMs / 1000, false});
+    bytes += file.size;
+  }
+  entries.append(WorkspaceArchive::Entry{QString::fromLatin1(c_stampName), 0, now, false});
+
+  auto archive = std::make_shared<WorkspaceArchive>(run->workspaceRoot, std::move(entries));
+  const qint64 length = archive->size();
+  qInfo() << "DOCKER | Uploading" << sortedFiles.size() << "of" << run->host.files.size() << "files (" << bytes << "bytes ) to" << run->containerId.left(12);
+
+  const QString path = QStringLiteral("/containers/%1/archive?path=%2").arg(run->containerId, QString::fromLatin1(ContainerPool::c_workspacePath));
+  m_docker.upload("PUT", path, archive, length, "application/x-tar", [this, run, archive](const DockerApiClient::Response &response) {
+    if(!response.ok()) {
+      fail(run, QStringLiteral("Workspace upload failed: %1").arg(response.error));
+      return;
+    }
+    // Container now mirrors the scan; files that changed while being read are left out, next run resends them
+    ContainerWorkspace &state = m_containerWorkspaces[run->containerId];
+    state.workspaceRoot = run->workspaceRoot;
+    state.hashes.clear();
+    for(auto it = run->host.files.cbegin(); it != run->host.files.cend(); ++it) {
+      if(!archive->incompleteFiles().contains(it.key())) state.hashes.insert(it.key(), it->hash);
+    }
+    execute(run);
+  }, m_config.uploadTimeoutMs);
+}
+
+void DockerExecutor::execute(const std::shared_ptr<Run> &run){
+  run->endStage(Metrics::t_Histogram::DOCKER_SYNC);
+  run->exec = m_docker.exec(run->containerId, run->command, QString::fromLatin1(ContainerPool::c_workspacePath),
+    [this, run](const QByteArray &data) {
+      if(run->outputStopped) return;
+      run->demuxer.feed(data, [run](DockerStreamDemuxer::t_Stream stream, QByteArrayView payload) {
+        if(!run->outputStopped && !run->output(stream, payload)) run->outputStopped = true;
+      });
+      if(run->outputStopped) {
+        // Not from inside the exchange's own data callback
+        QMetaObject::invokeMethod(this, [run]() {
+          DockerApiClient::cancelExec(run->exec, QStringLiteral("output limit reached, run stopped"));
+        }, Qt::QueuedConnection);
+      }
+    },
+    [this, run](int exitCode, const QString &error) {
+      if(!error.isEmpty()) {
+        // Process may still run inside, container can't be reused
+        fail(run, QStringLiteral("Execution failed: %1").arg(error));
+        return;
+      }
+      run->result.exitCode = exitCode;
+      run->endStage(Metrics::t_Histogram::DOCKER_EXEC);
+      complete(run, true);
+    }, m_config.runTimeoutMs);
+}
+
+void DockerExecutor::fail(const std::shared_ptr<Run> &run, const QString &error){
+  run->result.error = error;
+  complete(run, false);
+}
+
+void DockerExecutor::complete(const std::shared_ptr<Run> &run, bool containerHealthy){
+  Metrics::record(Metrics::t_Histogram::DOCKER_RUN, Metrics::now() - run->startedNs);
+  if(!run->result.error.isEmpty()) {
+    Metrics::add(Metrics::t_Counter::RUNS_FAILED);
+    qWarning() << "DOCKER | Run of" << run->command.join(' ') << "failed:" << run->result.error;
+  }
+  if(!containerHealthy) {
+    m_containerWorkspaces.remove(run->containerId);
+  }
+  run->pool->release(run->containerId, containerHealthy, run->workspaceRoot);
+  run->done(run->result);
+}
@@ -0,0 +1,27 @@
+#include "../include/DockerStreamDemuxer.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+
+void DockerStreamDemuxer::feed(QByteArrayView data, const PayloadHandler &handler){
+  while(!data.isEmpty()) {
+    if(m_payloadRemaining == 0) {
+      // Collect header, possibly across reads
+      const qsizetype take = std::min<qsizetype>(c_headerSize - m_headerFill, data.size());
+      std::copy_n(reinterpret_cast<const uchar*>(data.data()), take, m_header + m_headerFill);
+      m_headerFill += int(take);
+      data = data.sliced(take);
+      if(m_headerFill < c_headerSize) return;
+
+      m_headerFill = 0;
+      m_stream = m_header[0] == 2 ? t_Stream::STDERR : (m_header[0] == 0 ? t_Stream::STDIN : t_Stream::STDOUT);
+      m_payloadRemaining = qFromBigEndian<quint32>(m_header + 4);
+      continue;
+    }
+    const qsizetype take = std::min<qsizetype>(m_payloadRemaining, data.size());
+    handler(m_stream, data.first(take));
+    m_payloadRemaining -= quint32(take);
+    data = data.sliced(take);
+  }
+}
@@ -0,0 +1,157 @@
+#include "../include/FileStreamer.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <utility>
+
+#include "synergy_protocol/Message_File_Chunk.h"
+
+FileStreamer::FileStreamer(ClientTransport &transport) :
+  m_transport(transport) {
+}
+
+bool FileStreamer::openFile(qintptr clientId, const QString &filePath, const QString &absolutePath, quint64 revision){
+  auto file = std::make_unique<QFile>(absolutePath);
+  if(!file->open(QIODevice::ReadOnly)) {
+    qWarning() << "FILE STREAMER | Could not open" << absolutePath << file->errorString();
+    return false;
+  }
+  Transfer transfer;
+  transfer.clientId = clientId;
+  transfer.filePath = filePath;
+  transfer.revision = revision;
+  transfer.totalSize = file->size();
+  transfer.file = std::move(file);
+  start(std::move(transfer));
+  return true;
+}
+
+void FileStreamer::openText(qintptr clientId, const QString &filePath, const TextRope &text, quint64 revision){
+  Transfer transfer;
+  transfer.clientId = clientId;
+  transfer.filePath = filePath;
+  transfer.revision = revision;
+  transfer.totalSize = utf8Length(text);
+  transfer.text = text.snapshot();
+  start(std::move(transfer));
+}
+
+void FileStreamer::start(Transfer transfer){
+  // Chunks of the older transfer still queued are removed by this one's STATE chunk, none are added
+  m_transfers.removeIf([&transfer](const std::pair<const quint64&, Transfer&> &entry) {
+    return entry.second.clientId == transfer.clientId && entry.second.filePath == transfer.filePath;
+  });
+  transfer.id = m_nextId++;
+  transfer.stateKey = FramePolicy::documentKey(transfer.filePath);
+  const quint64 id = transfer.id;
+  m_transfers.insert(id, std::move(transfer));
+  pump(id);
+}
+
+void FileStreamer::onDelivered(qintptr clientId, quint64 deliveryToken){
+  auto it = m_transfers.find(deliveryToken);
+  if(it == m_transfers.end() || it->clientId != clientId) return;
+  --it->inFlight;
+  pump(deliveryToken);
+}
+
+void FileStreamer::onDiscarded(qintptr clientId, quint64 deliveryToken){
+  auto it = m_transfers.find(deliveryToken);
+  if(it == m_transfers.end() || it->clientId != clientId) return;
+  qInfo() << "FILE STREAMER | Transfer of" << it->filePath << "to client" << clientId << "superseded at" << it->offset;
+  m_transfers.erase(it);
+}
+
+void FileStreamer::cancel(qintptr clientId){
+  m_transfers.removeIf([clientId](const std::pair<const quint64&, Transfer&> &entry) {
+    return entry.second.clientId == clientId;
+  });
+}
+
+void FileStreamer::pump(quint64 transferId){
+  auto it = m_transfers.find(transferId);
+  if(it == m_transfers.end()) return;
+  Transfer &transfer = it.value();
+  while(transfer.inFlight < c_chunksInFlight && !transfer.posted) {
+    const bool first = transfer.offset == 0;
+    const QByteArray frame = nextFrame(transfer);
+    if(frame.isEmpty()) {
+      // Read failed halfway: client never sees a last chunk, it can ask again
+      qWarning() << "FILE STREAMER | Transfer of" << transfer.filePath << "to client" << transfer.clientId << "aborted at" << transfer.offset;
+      m_transfers.erase(it);
+      return;
+    }
+    ++transfer.inFlight;
+    // Snapshot stays in flight for the queue until its last chunk is written
+    const FramePolicy policy {first ? FramePolicy::t_Kind::STATE : FramePolicy::t_Kind::STATE_PART, transfer.stateKey, transfer.id, !transfer.posted};
+    m_transport.postFrame({transfer.clientId}, frame, policy);
+  }
+  if(transfer.posted && transfer.inFlight == 0) {
+    m_transfers.erase(it);
+  }
+}
+
+QByteArray FileStreamer::nextFrame(Transfer &transfer){
+  const SynergyProtocol::t_WireFormat format = m_transport.wireFormat(transfer.clientId);
+  const auto frameFor = [&](const QByteArray &data) {
+    return SynergyProtocol::Message_File_Chunk {0, transfer.id, transfer.filePath, transfer.revision, transfer.offset, transfer.totalSize, data}
+      .encodeFrame(format);
+  };
+
+  QByteArray frame;
+  if(transfer.file) {
+    const qint64 length = std::min(c_chunkSize, transfer.totalSize - transfer.offset);
+    if(length == 0) {
+      transfer.posted = true; // Empty file still gets its one (last) chunk
+      return frameFor(QByteArray());
+    }
+    uchar *mapped = transfer.file->map(transfer.offset, length);
+    if(mapped) {
+      // No copy until the encoder writes the bytes into the frame
+      frame = frameFor(QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), length));
+      transfer.file->unmap(mapped);
+    } else {
+      // Not mappable (pipe, some file systems), plain read of the same range
+      if(!transfer.file->seek(transfer.offset)) return QByteArray();
+      const QByteArray data = transfer.file->read(length);
+      if(data.size() != length) return QByteArray();
+      frame = frameFor(data);
+    }
+    transfer.offset += length;
+    transfer.posted = transfer.offset >= transfer.totalSize;
+    return frame;
+  }
+
+  // UTF-8 takes at most 3 bytes per UTF-16 unit, chunk never exceeds c_chunkSize
+  qsizetype count = std::min<qsizetype>(c_chunkSize / 3, transfer.text.length() - transfer.textPosition);
+  if(count > 1 && transfer.text.at(transfer.textPosition + count - 1).isHighSurrogate()) --count; // Keep pairs together
+  const QByteArray data = transfer.text.mid(transfer.textPosition, count).toUtf8();
+  frame = frameFor(data);
+  transfer.textPosition += count;
+  transfer.offset += data.size();
+  transfer.posted = transfer.textPosition >= transfer.text.length();
+  return frame;
+}
+
+qint64 FileStreamer::utf8Length(const TextRope &text){
+  // Same result as toUtf8().size() without building the bytes; unpaired surrogates become U+FFFD (3 bytes)
+  qint64 length = 0;
+  bool pendingHigh = false; // Pair may span rope chunks
+  text.forEachChunk([&](QStringView chunk) {
+    for(const QChar c : chunk) {
+      const char16_t unit = c.unicode();
+      if(QChar::isLowSurrogate(unit)) {
+        length += pendingHigh ? 4 : 3;
+        pendingHigh = false;
+        continue;
+      }
+      if(pendingHigh) length += 3;
+      pendingHigh = QChar::isHighSurrogate(unit);
+      if(pendingHigh) continue;
+      length += unit < 0x80 ? 1 : unit < 0x800 ? 2 : 3;
+    }
+  });
+  if(pendingHigh) length += 3;
+  return length;
+}
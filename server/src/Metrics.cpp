@@ -0,0 +1,246 @@
+#include "../include/Metrics.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+struct Metrics::Shard {
+  struct Histogram {
+    std::array<std::atomic<quint64>, c_bucketCount> buckets {};
+    std::atomic<quint64> count {0};
+    std::atomic<quint64> sum {0}; // Nanoseconds
+  };
+
+  std::array<std::atomic<quint64>, static_cast<std::size_t>(t_Counter::COUNT)> counters {};
+  std::array<std::atomic<qint64>, static_cast<std::size_t>(t_Gauge::COUNT)> gauges {};
+  std::array<std::atomic<quint64>, SynergyProtocol::messageTypeIndex(SynergyProtocol::t_MessageType::COUNT)> messages {};
+  std::array<Histogram, static_cast<std::size_t>(t_Histogram::COUNT)> histograms {};
+  bool inUse = false; // Guarded by registry mutex
+};
+
+namespace {
+  // Only the owning thread writes a shard: no read-modify-write instruction needed
+  template<typename T>
+  void bump(std::atomic<T> &value, T delta){
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+  }
+
+  struct Registry {
+    QMutex mutex;
+    std::vector<std::unique_ptr<Metrics::Shard>> shards;
+
+    Metrics::Shard* acquire(){
+      QMutexLocker lock(&mutex);
+      for(const std::unique_ptr<Metrics::Shard> &shard : shards) {
+        if(!shard->inUse) {
+          shard->inUse = true;
+          return shard.get();
+        }
+      }
+      shards.push_back(std::make_unique<Metrics::Shard>());
+      shards.back()->inUse = true;
+      return shards.back().get();
+    }
+
+    void release(Metrics::Shard *shard){
+      QMutexLocker lock(&mutex);
+      shard->inUse = false;
+    }
+  };
+
+  // Never destroyed: threads may still record while static objects go away at exit
+  Registry& registry(){
+    static Registry *instance = new Registry;
+    return *instance;
+  }
+
+  // Returns its shard to the registry when the thread ends
+  struct ShardLease {
+    Metrics::Shard *shard = registry().acquire();
+    ~ShardLease() { registry().release(shard); }
+  };
+
+  struct CounterInfo { const char *name; const char *help; };
+  constexpr std::array<CounterInfo, static_cast<std::size_t>(Metrics::t_Counter::COUNT)> c_counters {{
+    {"synergy_connections_accepted_total", "Accepted TCP connections"},
+    {"synergy_handshakes_failed_total", "Connections closed before the TLS handshake completed"},
+    {"synergy_connections_timed_out_total", "Connections aborted for a missed handshake deadline or idle timeout"},
+    {"synergy_handshakes_shed_total", "Connections closed while queued for a handshake slot (queue full or waited too long)"},
+    {"synergy_bytes_in_total", "Decrypted bytes received, length prefixes included"},
+    {"synergy_bytes_out_total", "Bytes handed to sockets before encryption"},
+    {"synergy_frames_in_total", "Frames received"},
+    {"synergy_frames_out_total", "Frames handed to sockets"},
+    {"synergy_frames_dropped_total", "Frames superseded or shed by outbound queues"},
+    {"synergy_parse_failures_total", "Frames that did not parse into a message"},
+    {"synergy_runs_failed_total", "Code runs that ended with an error"},
+  }};
+  constexpr std::array<CounterInfo, static_cast<std::size_t>(Metrics::t_Gauge::COUNT)> c_gauges {{
+    {"synergy_connections_open", "Open client connections"},
+    {"synergy_handshakes_in_progress", "TLS handshakes running"},
+    {"synergy_handshakes_queued", "Accepted connections waiting for a handshake slot"},
+    {"synergy_outbound_queued_bytes", "Bytes waiting in client outbound queues"},
+  }};
+  constexpr std::array<CounterInfo, static_cast<std::size_t>(Metrics::t_Histogram::COUNT)> c_histograms {{
+    {"handshake", "TLS handshake, start to encrypted"},
+    {"parse", "Frame payload to typed message"},
+    {"dispatch", "Session handling of one message"},
+    {"broadcast", "Encoding, journaling and routing of one outgoing session message"},
+    {"fanout", "One I/O worker writing a shared frame to its recipients"},
+    {"docker_scan", "Workspace scan before a run"},
+    {"docker_lease", "Wait for a pooled container"},
+    {"docker_sync", "Container workspace synchronization"},
+    {"docker_exec", "Command execution in the container"},
+    {"docker_run", "Whole code run, request to result"},
+  }};
+
+  // Cumulative bucket bounds exported to Prometheus (1-2.5-5 steps, 1 us .. 100 s). Percentiles use the fine buckets
+  constexpr std::array<double, 25> c_exportBounds {
+    1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3,
+    1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 25.0, 50.0, 100.0
+  };
+  constexpr std::array<double, 4> c_quantiles {0.5, 0.9, 0.99, 0.999};
+
+  QByteArray number(double value){
+    return QByteArray::number(value, 'g', 9);
+  }
+}
+
+Metrics::Shard& Metrics::shard(){
+  thread_local ShardLease lease;
+  return *lease.shard;
+}
+
+int Metrics::bucketIndex(quint64 value){
+  if(value < quint64(c_subBuckets)) return static_cast<int>(value);
+  int exponent = std::bit_width(value) - 1; // Position of highest set bit, >= c_subBucketBits
+  if(exponent > c_maxExponent) return c_bucketCount - 1;
+  const int shift = exponent - c_subBucketBits;
+  return (shift + 1) * c_subBuckets + static_cast<int>((value >> shift) - c_subBuckets);
+}
+
+quint64 Metrics::bucketLowerBound(int index){
+  if(index < c_subBuckets) return quint64(index);
+  const int shift = index / c_subBuckets - 1;
+  return (quint64(c_subBuckets) + quint64(index % c_subBuckets)) << shift;
+}
+
+quint64 Metrics::bucketUpperBound(int index){
+  if(index < c_subBuckets) return quint64(index) + 1;
+  if(index == c_bucketCount - 1) return std::numeric_limits<quint64>::max();
+  return bucketLowerBound(index) + (quint64(1) << (index / c_subBuckets - 1));
+}
+
+void Metrics::add(t_Counter counter, quint64 value){
+  bump(shard().counters[static_cast<std::size_t>(counter)], value);
+}
+
+void Metrics::adjust(t_Gauge gauge, qint64 delta){
+  bump(shard().gauges[static_cast<std::size_t>(gauge)], delta);
+}
+
+void Metrics::countMessage(SynergyProtocol::t_MessageType type){
+  const std::size_t index = SynergyProtocol::messageTypeIndex(type);
+  Shard &local = shard();
+  if(index < local.messages.size()) bump(local.messages[index], quint64(1));
+}
+
+void Metrics::record(t_Histogram histogram, qint64 nanoseconds){
+  const quint64 value = nanoseconds > 0 ? quint64(nanoseconds) : 0;
+  Shard::Histogram &target = shard().histograms[static_cast<std::size_t>(histogram)];
+  bump(target.buckets[static_cast<std::size_t>(bucketIndex(value))], quint64(1));
+  bump(target.count, quint64(1));
+  bump(target.sum, value);
+}
+
+QByteArray Metrics::prometheusText(){
+  constexpr std::size_t messageTypes = SynergyProtocol::messageTypeIndex(SynergyProtocol::t_MessageType::COUNT);
+  std::array<quint64, static_cast<std::size_t>(t_Counter::COUNT)> counters {};
+  std::array<qint64, static_cast<std::size_t>(t_Gauge::COUNT)> gauges {};
+  std::array<quint64, messageTypes> messages {};
+  struct Totals {
+    std::array<quint64, c_bucketCount> buckets {};
+    quint64 count = 0;
+    quint64 sum = 0;
+  };
+  auto histograms = std::make_unique<std::array<Totals, static_cast<std::size_t>(t_Histogram::COUNT)>>();
+
+  {
+    Registry &shards = registry();
+    QMutexLocker lock(&shards.mutex); // Keeps the shard list still, not the values
+    for(const std::unique_ptr<Shard> &shard : shards.shards) {
+      for(std::size_t i = 0; i < counters.size(); ++i) counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+      for(std::size_t i = 0; i < gauges.size(); ++i) gauges[i] += shard->gauges[i].load(std::memory_order_relaxed);
+      for(std::size_t i = 0; i < messages.size(); ++i) messages[i] += shard->messages[i].load(std::memory_order_relaxed);
+      for(std::size_t h = 0; h < histograms->size(); ++h) {
+        Totals &totals = (*histograms)[h];
+        const Shard::Histogram &source = shard->histograms[h];
+        for(int b = 0; b < c_bucketCount; ++b) totals.buckets[b] += source.buckets[b].load(std::memory_order_relaxed);
+        totals.count += source.count.load(std::memory_order_relaxed);
+        totals.sum += source.sum.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  QByteArray out;
+  out.reserve(16 * 1024);
+  for(std::size_t i = 0; i < counters.size(); ++i) {
+    out += QByteArray("# HELP ") + c_counters[i].name + ' ' + c_counters[i].help + '\n';
+    out += QByteArray("# TYPE ") + c_counters[i].name + " counter\n";
+    out += QByteArray(c_counters[i].name) + ' ' + QByteArray::number(counters[i]) + '\n';
+  }
+  for(std::size_t i = 0; i < gauges.size(); ++i) {
+    out += QByteArray("# HELP ") + c_gauges[i].name + ' ' + c_gauges[i].help + '\n';
+    out += QByteArray("# TYPE ") + c_gauges[i].name + " gauge\n";
+    out += QByteArray(c_gauges[i].name) + ' ' + QByteArray::number(gauges[i]) + '\n';
+  }
+
+  out += "# HELP synergy_messages_received_total Messages received from clients, per type\n";
+  out += "# TYPE synergy_messages_received_total counter\n";
+  for(std::size_t i = 0; i < messages.size(); ++i) {
+    if(messages[i] == 0) continue;
+    out += "synergy_messages_received_total{type=\""
+         + SynergyProtocol::messageTypeToString(static_cast<SynergyProtocol::t_MessageType>(i)).toLatin1()
+         + "\"} " + QByteArray::number(messages[i]) + '\n';
+  }
+
+  QByteArray quantiles;
+  for(std::size_t h = 0; h < histograms->size(); ++h) {
+    const Totals &totals = (*histograms)[h];
+    const QByteArray name = QByteArray("synergy_") + c_histograms[h].name + "_seconds";
+    out += "# HELP " + name + ' ' + c_histograms[h].help + '\n';
+    out += "# TYPE " + name + " histogram\n";
+    quint64 cumulative = 0;
+    int bucket = 0;
+    for(double bound : c_exportBounds) {
+      // Fine bucket belongs below 'bound' if all of its values do
+      const quint64 boundNs = quint64(bound * 1e9);
+      while(bucket < c_bucketCount && bucketUpperBound(bucket) - 1 <= boundNs) cumulative += totals.buckets[bucket++];
+      out += name + "_bucket{le=\"" + number(bound) + "\"} " + QByteArray::number(cumulative) + '\n';
+    }
+    out += name + "_bucket{le=\"+Inf\"} " + QByteArray::number(totals.count) + '\n';
+    out += name + "_sum " + number(totals.sum / 1e9) + '\n';
+    out += name + "_count " + QByteArray::number(totals.count) + '\n';
+
+    if(totals.count == 0) continue;
+    // Highest value of the bucket holding the rank: never reports less than was measured
+    for(double quantile : c_quantiles) {
+      const quint64 rank = qMax<quint64>(1, quint64(std::ceil(quantile * totals.count)));
+      quint64 seen = 0;
+      int index = 0;
+      while(index < c_bucketCount - 1 && (seen += totals.buckets[index]) < rank) ++index;
+      // Past the last bounded bucket nothing is known but "longer than that"
+      const QByteArray value = index == c_bucketCount - 1 ? QByteArray("+Inf") : number((bucketUpperBound(index) - 1) / 1e9);
+      quantiles += QByteArray("synergy_latency_quantile_seconds{histogram=\"") + c_histograms[h].name
+                 + "\",quantile=\"" + number(quantile) + "\"} " + value + '\n';
+    }
+  }
+  out += "# HELP synergy_latency_quantile_seconds Percentiles of the histograms above, from their full resolution buckets\n";
+  out += "# TYPE synergy_latency_quantile_seconds gauge\n";
+  out += quantiles;
+  return out;
+}
@@ -0,0 +1,71 @@
+#include "../include/MetricsEndpoint.h"
+#include "../include/Metrics.h"
+
+#include <QTcpSocket>
+#include <QTimer>
+#include <QDebug>
+
+MetricsEndpoint::MetricsEndpoint(QObject *parent) :
+  QObject(parent) {
+  connect(&m_server, &QTcpServer::newConnection, this, &MetricsEndpoint::onNewConnection);
+}
+
+bool MetricsEndpoint::listen(quint16 port){
+  if(!m_server.listen(QHostAddress::LocalHost, port)) {
+    qWarning() << "METRICS | Could not listen on 127.0.0.1:" << port << m_server.errorString();
+    return false;
+  }
+  qInfo() << "METRICS | Serving http://127.0.0.1:" << m_server.serverPort() << "/metrics";
+  return true;
+}
+
+void MetricsEndpoint::onNewConnection(){
+  while(QTcpSocket *socket = m_server.nextPendingConnection()) {
+    connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    QTimer::singleShot(c_requestTimeoutMs, socket, [socket]() { socket->abort(); });
+
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { handleRequest(socket); });
+  }
+}
+
+// Waits until headers and body (Content-Length) are complete, then answers
+void MetricsEndpoint::handleRequest(QTcpSocket *socket){
+  const QByteArray received = socket->peek(c_maxRequestSize + 1);
+  const qsizetype headerEnd = received.indexOf("\r\n\r\n");
+  if(headerEnd < 0 || received.size() > c_maxRequestSize) {
+    if(received.size() > c_maxRequestSize) socket->abort();
+    return;
+  }
+  const QList<QByteArray> lines = received.left(headerEnd).split('\n');
+  qsizetype contentLength = 0;
+  for(const QByteArray &line : lines) {
+    if(line.trimmed().toLower().startsWith("content-length:")) contentLength = line.mid(line.indexOf(':') + 1).trimmed().toLongLong();
+  }
+  if(contentLength < 0 || headerEnd + 4 + contentLength > c_maxRequestSize) {
+    socket->abort();
+    return;
+  }
+  if(received.size() < headerEnd + 4 + contentLength) return; // Rest of the body is on its way
+
+  const QList<QByteArray> requestLine = lines.front().trimmed().split(' ');
+  const QByteArray method = requestLine.value(0);
+  const QByteArray path = requestLine.value(1);
+  if(path == "/metrics" && method == "GET") {
+    respond(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8", Metrics::prometheusText());
+  } else if(path == "/metrics") {
+    respond(socket, "405 Method Not Allowed", "text/plain", "GET /metrics\n");
+  } else {
+    respond(socket, "404 Not Found", "text/plain", "GET /metrics\n");
+  }
+}
+
+void MetricsEndpoint::respond(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType, const QByteArray &body){
+  socket->disconnect(this); // One request per connection, anything after it is ignored
+  QByteArray response = "HTTP/1.1 " + status + "\r\n"
+                        "Content-Type: " + contentType + "\r\n"
+                        "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                        "Connection: close\r\n\r\n";
+  response += body;
+  socket->write(response);
+  socket->disconnectFromHost(); // Waits until everything is written
+}
@@ -0,0 +1,143 @@
+#include "../include/OutboundQueue.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <utility>
+
+#include "synergy_protocol/Message_Text_Operation.h"
+#include "synergy_protocol/Message_Text_Operation_Ack.h"
+#include "synergy_protocol/Message_Update_Text_Edit.h"
+
+FramePolicy FramePolicy::forMessage(const SynergyProtocol::Message_Base &message){
+  using SynergyProtocol::t_MessageType;
+  switch(message.type()) {
+    case t_MessageType::DRAW_COMMAND:
+    case t_MessageType::DRAW_POLYLINE:
+    case t_MessageType::RUN_OUTPUT_CHUNK: // Client notices the sequence gap
+      return {t_Kind::DROPPABLE, QString()};
+    case t_MessageType::TEXT_OPERATION:
+      return {t_Kind::DELTA, documentKey(static_cast<const SynergyProtocol::Message_Text_Operation&>(message).filePath())};
+    case t_MessageType::TEXT_OPERATION_ACK:
+      // Revision bookkeeping of the same document, snapshot resets it as well
+      return {t_Kind::DELTA, documentKey(static_cast<const SynergyProtocol::Message_Text_Operation_Ack&>(message).filePath())};
+    case t_MessageType::UPDATE_TEXT_EDIT:
+      return {t_Kind::STATE, documentKey(static_cast<const SynergyProtocol::Message_Update_Text_Edit&>(message).filePath())};
+    case t_MessageType::FILE_TREE_DIFF:
+      return {t_Kind::DELTA, QString::fromLatin1(c_fileTreeKey)};
+    case t_MessageType::FILE_TREE_UPDATE:
+      return {t_Kind::STATE, QString::fromLatin1(c_fileTreeKey)};
+    default:
+      return {};
+  }
+}
+
+OutboundQueue::OutboundQueue(Limits limits) :
+  m_limits(limits) {
+  m_limits.lowWatermark = std::min(m_limits.lowWatermark, m_limits.highWatermark);
+  m_limits.disconnectBytes = std::max(m_limits.disconnectBytes, m_limits.highWatermark);
+}
+
+template<typename Predicate>
+void OutboundQueue::removeIf(Predicate predicate){
+  const auto removed = std::remove_if(m_frames.begin(), m_frames.end(), [&](const Entry &entry) {
+    if(!predicate(entry)) return false;
+    m_bytes -= entry.frame.size();
+    ++m_dropped;
+    if(entry.policy.deliveryToken != 0) m_discardedTokens.append(entry.policy.deliveryToken);
+    return true;
+  });
+  m_frames.erase(removed, m_frames.end());
+}
+
+bool OutboundQueue::push(const QByteArray &frame, const FramePolicy &policy, const ResyncHandler &resync){
+  switch(policy.kind) {
+    case FramePolicy::t_Kind::ESSENTIAL:
+      break;
+    case FramePolicy::t_Kind::DROPPABLE:
+      if(m_behind) {
+        ++m_dropped;
+        return true;
+      }
+      break;
+    case FramePolicy::t_Kind::DELTA:
+      if(m_snapshots.contains(policy.key)) break; // Sent after the snapshot's revision, applies on top
+      if(m_behind) markStale(policy.key, resync);
+      if(m_stale.contains(policy.key)) {
+        ++m_dropped;
+        return true;
+      }
+      break;
+    case FramePolicy::t_Kind::STATE:
+      // Everything still waiting for this key is outdated by this frame
+      removeIf([&](const Entry &entry) {
+        return entry.policy.key == policy.key && entry.policy.kind != FramePolicy::t_Kind::ESSENTIAL;
+      });
+      m_stale.remove(policy.key);
+      m_snapshots.insert(policy.key, policy.deliveryToken);
+      break;
+    case FramePolicy::t_Kind::STATE_PART: {
+      // Part of a STATE that was replaced (or already completed), the client ignores it
+      const auto snapshot = m_snapshots.constFind(policy.key);
+      if(snapshot == m_snapshots.cend() || *snapshot != policy.deliveryToken) {
+        ++m_dropped;
+        if(policy.deliveryToken != 0) m_discardedTokens.append(policy.deliveryToken);
+        return true;
+      }
+      break;
+    }
+  }
+
+  m_frames.push_back(Entry{frame, policy});
+  m_bytes += frame.size();
+  if(!m_behind && m_bytes > m_limits.highWatermark) {
+    fallBehind(resync);
+  }
+  return m_bytes <= m_limits.disconnectBytes;
+}
+
+QByteArray OutboundQueue::pop(quint64 *deliveryToken){
+  if(m_frames.empty()) return QByteArray();
+  const FramePolicy policy = m_frames.front().policy;
+  if(deliveryToken) *deliveryToken = policy.deliveryToken;
+  QByteArray frame = std::move(m_frames.front().frame);
+  m_frames.pop_front();
+  if((policy.kind == FramePolicy::t_Kind::STATE || policy.kind == FramePolicy::t_Kind::STATE_PART) && !policy.partial) {
+    // Last part of the snapshot is out, a DELTA dropped from now on needs a new one
+    const auto snapshot = m_snapshots.constFind(policy.key);
+    if(snapshot != m_snapshots.cend() && *snapshot == policy.deliveryToken) m_snapshots.erase(snapshot);
+  }
+  m_bytes -= frame.size();
+  if(m_behind && m_bytes < m_limits.lowWatermark) {
+    m_behind = false;
+    qInfo() << "OUTBOUND QUEUE | Client caught up," << m_dropped << "frames dropped so far";
+  }
+  return frame;
+}
+
+QList<quint64> OutboundQueue::takeDiscardedTokens(){
+  return std::exchange(m_discardedTokens, QList<quint64>());
+}
+
+void OutboundQueue::fallBehind(const ResyncHandler &resync){
+  m_behind = true;
+  removeIf([](const Entry &entry) { return entry.policy.kind == FramePolicy::t_Kind::DROPPABLE; });
+
+  QSet<QString> deltaKeys;
+  for(const Entry &entry : m_frames) {
+    if(entry.policy.kind == FramePolicy::t_Kind::DELTA && !m_snapshots.contains(entry.policy.key)) deltaKeys.insert(entry.policy.key);
+  }
+  for(const QString &key : std::as_const(deltaKeys)) {
+    markStale(key, resync);
+  }
+  qWarning() << "OUTBOUND QUEUE | Client fell behind, backlog" << m_bytes << "bytes after dropping superseded frames";
+}
+
+void OutboundQueue::markStale(const QString &key, const ResyncHandler &resync){
+  if(m_stale.contains(key) || m_snapshots.contains(key)) return;
+  m_stale.insert(key);
+  removeIf([&](const Entry &entry) {
+    return entry.policy.kind == FramePolicy::t_Kind::DELTA && entry.policy.key == key;
+  });
+  if(resync) resync(key);
+}
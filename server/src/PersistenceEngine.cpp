@@ -0,0 +1,188 @@
+#include "../include/PersistenceEngine.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QStringEncoder>
+#include <QMetaObject>
+#include <QPointer>
+#include <QDebug>
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+PersistenceEngine::PersistenceEngine(int coalesceWindowMs) :
+  QObject(nullptr), // No parent, object is moved to its thread
+  m_windowMs(coalesceWindowMs) {
+  m_flushTimer.setSingleShot(true);
+  connect(&m_flushTimer, &QTimer::timeout, this, &PersistenceEngine::flush);
+  m_retryTimer.setSingleShot(true);
+  connect(&m_retryTimer, &QTimer::timeout, this, &PersistenceEngine::retryNow);
+}
+
+void PersistenceEngine::schedule(const QString &sessionId, const QString &relativePath, const QString &absolutePath, const TextRope &text, quint64 revision){
+  // Rope snapshot shares nodes, crossing the thread costs a pointer copy
+  QMetaObject::invokeMethod(this, [this, absolutePath, write = PendingWrite{sessionId, relativePath, text.snapshot(), revision}]() mutable {
+    enqueue(absolutePath, std::move(write));
+  }, Qt::QueuedConnection);
+}
+
+void PersistenceEngine::flushBlocking(){
+  QMetaObject::invokeMethod(this, [this]() { retryNow(); }, Qt::BlockingQueuedConnection);
+}
+
+void PersistenceEngine::flushAsync(QObject *context, std::function<void()> done){
+  QMetaObject::invokeMethod(this, [this, context = QPointer<QObject>(context), done = std::move(done)]() mutable {
+    retryNow();
+    if(context) {
+      QMetaObject::invokeMethod(context, std::move(done), Qt::QueuedConnection);
+    }
+  }, Qt::QueuedConnection);
+}
+
+void PersistenceEngine::enqueue(const QString &absolutePath, PendingWrite write){
+  m_retries.remove(absolutePath); // Failed older revision isn't worth writing any more
+  m_pending.insert(absolutePath, std::move(write)); // Newer content replaces unsaved older one
+  // Window starts with first unsaved edit and isn't extended by later ones -> bounded delay
+  if(!m_flushTimer.isActive()) {
+    m_flushTimer.start(m_windowMs);
+  }
+}
+
+QString PersistenceEngine::temporaryPathFor(const QString &absolutePath){
+  const QFileInfo info(absolutePath);
+  return info.absolutePath() + QStringLiteral("/.") + info.fileName() + QStringLiteral(".synergy-tmp");
+}
+
+bool PersistenceEngine::writeTemporary(const QString &temporaryPath, const TextRope &text){
+  QFile file(temporaryPath);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    qWarning() << "PERSISTENCE | Could not open" << temporaryPath << file.errorString();
+    return false;
+  }
+  // Encoder keeps state between chunks, surrogate pair split by a chunk boundary stays intact
+  QStringEncoder encoder(QStringEncoder::Utf8);
+  bool ok = true;
+  text.forEachChunk([&](QStringView chunk) {
+    if(ok && file.write(encoder.encode(chunk)) < 0) ok = false;
+  });
+  if(!ok || !file.flush()) {
+    qWarning() << "PERSISTENCE | Write failed for" << temporaryPath << file.errorString();
+    file.close();
+    QFile::remove(temporaryPath);
+    return false;
+  }
+#ifdef Q_OS_UNIX
+  // Data on disk before the rename can expose it under the real name
+  if(::fsync(file.handle()) != 0) {
+    qWarning() << "PERSISTENCE | fsync failed for" << temporaryPath << qt_error_string(errno);
+    file.close();
+    QFile::remove(temporaryPath);
+    return false;
+  }
+#endif
+  return true;
+}
+
+// Makes renames in 'directory' durable. False (errno logged) if that can't be confirmed
+bool PersistenceEngine::syncDirectory(const QString &directory){
+#ifdef Q_OS_UNIX
+  const int fd = ::open(QFile::encodeName(directory).constData(), O_RDONLY | O_DIRECTORY);
+  if(fd < 0) {
+    qWarning() << "PERSISTENCE | Could not open directory" << directory << qt_error_string(errno);
+    return false;
+  }
+  const bool ok = ::fsync(fd) == 0;
+  if(!ok) {
+    qWarning() << "PERSISTENCE | fsync failed for directory" << directory << qt_error_string(errno);
+  }
+  ::close(fd);
+  return ok;
+#else
+  Q_UNUSED(directory);
+  return true;
+#endif
+}
+
+/*
+Batch write
+1. every due file goes to its temp file, fsynced before it is closed
+2. temp files are renamed over targets (atomic replace)
+3. every directory with a renamed file is fsynced once
+Rename is only done after data is on disk, so a crash never leaves an empty
+or partial file under the real name. A failed directory sync fails every
+file renamed into it.
+*/
+void PersistenceEngine::flush(){
+  m_flushTimer.stop();
+  if(m_pending.isEmpty()) return;
+
+  m_batchClock.start();
+  QHash<QString, PendingWrite> batch = std::exchange(m_pending, {});
+
+  QList<QString> written;
+  for(auto it = batch.cbegin(); it != batch.cend(); ++it) {
+    QDir().mkpath(QFileInfo(it.key()).absolutePath());
+    if(writeTemporary(temporaryPathFor(it.key()), it->text)) {
+      written.append(it.key());
+    } else {
+      emit persisted(it->sessionId, it->relativePath, it->revision, false);
+      retry(it.key(), *it);
+    }
+  }
+
+  QHash<QString, QList<QString>> renamedByDirectory; // Directory -> files renamed into it
+  for(const QString &path : std::as_const(written)) {
+    std::error_code error;
+    std::filesystem::rename(QFile::encodeName(temporaryPathFor(path)).toStdString(), QFile::encodeName(path).toStdString(), error);
+    const PendingWrite &write = batch[path];
+    if(error) {
+      qWarning() << "PERSISTENCE | Rename failed for" << path << QString::fromStdString(error.message());
+      QFile::remove(temporaryPathFor(path));
+      emit persisted(write.sessionId, write.relativePath, write.revision, false);
+      retry(path, write);
+    } else {
+      renamedByDirectory[QFileInfo(path).absolutePath()].append(path);
+    }
+  }
+
+  int durable = 0;
+  for(auto it = renamedByDirectory.cbegin(); it != renamedByDirectory.cend(); ++it) {
+    const bool ok = syncDirectory(it.key());
+    for(const QString &path : it.value()) {
+      const PendingWrite &write = batch[path];
+      emit persisted(write.sessionId, write.relativePath, write.revision, ok);
+      if(!ok) retry(path, write); // Renamed, but can't tell whether that survives a crash
+    }
+    if(ok) durable += it->size();
+  }
+  qDebug() << "PERSISTENCE | Batch of" << durable << "files durable in" << m_batchClock.elapsed() << "ms";
+}
+
+// Failed write is kept for another attempt; only the last failure of a batch decides when the next one runs
+void PersistenceEngine::retry(const QString &absolutePath, PendingWrite write){
+  if(m_pending.contains(absolutePath)) return; // Newer revision already waits for its own write
+  ++write.failures;
+  const int delay = std::min<qint64>(c_maxRetryDelayMs, qint64(std::max(m_windowMs, 1)) << std::min(write.failures, 16));
+  qWarning() << "PERSISTENCE | Retrying" << absolutePath << "revision" << write.revision << "in" << delay << "ms, attempt" << write.failures;
+  m_retries.insert(absolutePath, std::move(write));
+  m_retryTimer.start(delay);
+}
+
+// Retries go into the next batch together with whatever is pending
+void PersistenceEngine::retryNow(){
+  m_retryTimer.stop();
+  for(auto it = m_retries.begin(); it != m_retries.end(); ++it) {
+    if(!m_pending.contains(it.key())) m_pending.insert(it.key(), std::move(it.value()));
+  }
+  m_retries.clear();
+  flush();
+}
@@ -0,0 +1,114 @@
+#include "../include/RunOutputStream.h"
+
+#include <algorithm>
+#include <utility>
+
+RunOutputStream::RunOutputStream(QString runId, ChunkSink sink, Limits limits, QObject *parent) :
+  QObject(parent),
+  m_runId(std::move(runId)),
+  m_sink(std::move(sink)),
+  m_limits(limits) {
+  m_flushTimer.setSingleShot(true);
+  connect(&m_flushTimer, &QTimer::timeout, this, &RunOutputStream::flush);
+}
+
+void RunOutputStream::append(t_Stream stream, QByteArrayView data){
+  if(data.isEmpty()) return;
+  if(m_cutOff) {
+    m_droppedTotal += data.size(); // Marker is already queued or sent, nothing more goes out
+    return;
+  }
+
+  // Whole-run limit, output past it is gone for good
+  qsizetype accept = qsizetype(std::min<qint64>(data.size(), m_limits.maxTotalBytes - m_acceptedTotal));
+  // Buffer limit, sending can't keep up -> drop instead of growing
+  accept = std::min(accept, std::max<qsizetype>(0, m_limits.maxPendingBytes - m_pendingBytes));
+
+  if(accept > 0) {
+    QString text = decoderFor(stream)(data.first(accept));
+    m_acceptedTotal += accept;
+    m_pendingBytes += accept;
+    if(!m_pending.empty() && m_pending.back().dropped == 0 && m_pending.back().stream == stream) {
+      m_pending.back().text += text;
+      m_pending.back().bytes += accept;
+    } else {
+      m_pending.push_back(Segment{stream, std::move(text), accept, 0});
+    }
+  }
+  if(accept < data.size()) {
+    // Next accepted bytes don't continue the dropped ones, decoder must not wait for the rest of a sequence
+    decoderFor(stream).resetState();
+    m_cutOff = m_acceptedTotal >= m_limits.maxTotalBytes;
+    drop(data.size() - accept);
+  }
+  if(!m_flushTimer.isActive()) m_flushTimer.start(m_limits.flushIntervalMs);
+}
+
+void RunOutputStream::drop(qint64 bytes){
+  m_droppedTotal += bytes;
+  if(m_pending.empty() || m_pending.back().dropped == 0) {
+    m_pending.push_back(Segment{t_Stream::STDERR, QString(), 0, 0});
+  }
+  m_pending.back().dropped += bytes;
+  m_pending.back().limitReached = m_pending.back().limitReached || m_cutOff;
+}
+
+// One interval's worth of output goes out, rest waits for the next tick
+void RunOutputStream::flush(){
+  qsizetype budget = m_limits.maxBytesPerFlush;
+  while(!m_pending.empty() && budget > 0) {
+    Segment &segment = m_pending.front();
+    if(segment.dropped > 0) {
+      emitSegment(segment);
+      m_pending.pop_front();
+      continue;
+    }
+    if(segment.bytes <= budget) {
+      budget -= segment.bytes;
+      m_pendingBytes -= segment.bytes;
+      emitSegment(segment);
+      m_pending.pop_front();
+      continue;
+    }
+    // Partial segment: send about 'budget' bytes worth of text, rest stays in front
+    qsizetype chars = std::max<qsizetype>(1, qsizetype(double(segment.text.size()) * budget / segment.bytes));
+    if(chars < segment.text.size() && segment.text.at(chars - 1).isHighSurrogate()) --chars;
+    if(chars <= 0) break;
+    const qsizetype bytes = std::min(segment.bytes, budget);
+    Segment head {segment.stream, segment.text.left(chars), bytes, 0};
+    segment.text.remove(0, chars);
+    segment.bytes -= bytes;
+    m_pendingBytes -= bytes;
+    emitSegment(head);
+    budget = 0;
+  }
+  if(!m_pending.empty()) m_flushTimer.start(m_limits.flushIntervalMs);
+}
+
+void RunOutputStream::finish(){
+  m_flushTimer.stop();
+  // Bytes held back by decoders (incomplete sequence at the very end) are lost, like any cut-off output
+  while(!m_pending.empty()) {
+    emitSegment(m_pending.front());
+    m_pending.pop_front();
+  }
+  m_pendingBytes = 0;
+}
+
+void RunOutputStream::emitSegment(Segment &segment){
+  using SynergyProtocol::Message_Run_Output_Chunk;
+  if(segment.dropped > 0) {
+    const QString note = segment.limitReached
+      ? QStringLiteral("[output limit of %1 bytes reached, %2 bytes dropped]").arg(m_limits.maxTotalBytes).arg(segment.dropped)
+      : QStringLiteral("[%1 bytes of output dropped]").arg(segment.dropped);
+    m_sink(Message_Run_Output_Chunk {0, m_runId, m_sequence++, t_Stream::STDERR, note, true});
+    return;
+  }
+  // Long text goes out as several chunks, frames stay small for everyone else on the connection
+  for(qsizetype offset = 0; offset < segment.text.size();) {
+    qsizetype length = std::min(m_limits.maxChunkChars, segment.text.size() - offset);
+    if(offset + length < segment.text.size() && segment.text.at(offset + length - 1).isHighSurrogate()) --length;
+    m_sink(Message_Run_Output_Chunk {0, m_runId, m_sequence++, segment.stream, segment.text.mid(offset, length)});
+    offset += length;
+  }
+}
@@ -0,0 +1,145 @@
+#include "../include/Session.h"
+#include "../include/Metrics.h"
+
+#include <QFile>
+
+#include <utility>
+
+#include "synergy_protocol/Message_File_Tree_Update.h"
+#include "synergy_protocol/Message_File_Tree_Diff.h"
+
+Session::Session(QString sessionId, ClientTransport &transport) :
+  m_id(std::move(sessionId)),
+  m_transport(transport) {
+}
+
+const Session::Participant* Session::participant(qintptr clientId) const {
+  auto it = m_participants.constFind(clientId);
+  return it == m_participants.cend() ? nullptr : &it.value();
+}
+
+void Session::addParticipant(qintptr clientId, const QString &userId, const QString &username, const QString &resumeToken){
+  m_participants.insert(clientId, Participant{clientId, userId, username, resumeToken});
+}
+
+void Session::removeParticipant(qintptr clientId){
+  m_participants.remove(clientId);
+}
+
+void Session::detachParticipant(qintptr clientId){
+  auto it = m_participants.find(clientId);
+  if(it == m_participants.end()) return;
+  if(!it->resumeToken.isEmpty()) {
+    m_detached.insert(it->resumeToken, Detached{it->userId, it->username, m_transport.wireFormat(clientId)});
+  }
+  m_participants.erase(it);
+}
+
+const Session::Participant* Session::reattach(const QString &resumeToken, qintptr clientId, const QString &newResumeToken){
+  auto it = m_detached.find(resumeToken);
+  if(it == m_detached.end()) return nullptr;
+  const Detached detached = it.value();
+  m_detached.erase(it);
+  auto inserted = m_participants.insert(clientId, Participant{clientId, detached.userId, detached.username, newResumeToken});
+  return &inserted.value();
+}
+
+std::optional<Session::Detached> Session::dropDetached(const QString &resumeToken){
+  auto it = m_detached.find(resumeToken);
+  if(it == m_detached.end()) return std::nullopt;
+  Detached detached = it.value();
+  m_detached.erase(it);
+  return detached;
+}
+
+SessionJournal::Entry Session::record(const SynergyProtocol::Message_Base &message, const std::array<bool, SessionJournal::c_formatCount> &formats,
+                                      QString targetUserId, QString excludeUserId){
+  SessionJournal::Entry entry {m_journal.nextSequence(), {}, FramePolicy::forMessage(message), std::move(targetUserId), std::move(excludeUserId)};
+  for(std::size_t format = 0; format < formats.size(); ++format) {
+    if(formats[format]) entry.frames[format] = message.encodeFrame(static_cast<SynergyProtocol::t_WireFormat>(format), entry.sequence);
+  }
+  m_journal.append(entry); // Frames are implicitly shared with the returned copy
+  return entry;
+}
+
+void Session::broadcast(const SynergyProtocol::Message_Base &message, qintptr excludeClientId){
+  Metrics::ScopedTimer timer(Metrics::t_Histogram::BROADCAST);
+  // Recipients grouped by wire format, each group gets one encoding of the message
+  std::array<QList<qintptr>, SessionJournal::c_formatCount> recipients;
+  std::array<bool, SessionJournal::c_formatCount> formats {};
+  QString excludeUserId;
+  for(const Participant &participant : m_participants) {
+    if(participant.clientId == excludeClientId) {
+      excludeUserId = participant.userId;
+      continue;
+    }
+    const auto format = static_cast<std::size_t>(m_transport.wireFormat(participant.clientId));
+    recipients[format].append(participant.clientId);
+    formats[format] = true;
+  }
+  // Detached participants get it on resume, in their format
+  for(const Detached &detached : m_detached) {
+    formats[static_cast<std::size_t>(detached.format)] = true;
+  }
+
+  const SessionJournal::Entry entry = record(message, formats, QString(), excludeUserId);
+  for(std::size_t format = 0; format < recipients.size(); ++format) {
+    if(recipients[format].isEmpty()) continue;
+    m_transport.postFrame(recipients[format], entry.frames[format], entry.policy);
+  }
+}
+
+void Session::sendTo(qintptr clientId, const SynergyProtocol::Message_Base &message){
+  Metrics::ScopedTimer timer(Metrics::t_Histogram::BROADCAST);
+  const Participant *target = participant(clientId);
+  if(!target) {
+    // Not (yet) part of the session, nothing to resume
+    m_transport.postFrame({clientId}, message.encodeFrame(m_transport.wireFormat(clientId)), FramePolicy::forMessage(message));
+    return;
+  }
+  const auto format = m_transport.wireFormat(clientId);
+  std::array<bool, SessionJournal::c_formatCount> formats {};
+  formats[static_cast<std::size_t>(format)] = true;
+  const SessionJournal::Entry entry = record(message, formats, target->userId, QString());
+  m_transport.postFrame({clientId}, entry.frames[static_cast<std::size_t>(format)], entry.policy);
+}
+
+ActiveDocument& Session::document(const QString &filePath){
+  auto it = m_documents.find(filePath);
+  if(it == m_documents.end()) {
+    // Existing file becomes revision 0, new file starts empty
+    QString content;
+    const QString absolutePath = m_workspace ? m_workspace->resolve(filePath) : QString();
+    QFile file(absolutePath);
+    if(!absolutePath.isEmpty() && file.exists() && file.open(QIODevice::ReadOnly)) {
+      content = QString::fromUtf8(file.readAll());
+    }
+    it = m_documents.insert(filePath, ActiveDocument(content));
+  }
+  return it.value();
+}
+
+void Session::openWorkspace(const QString &rootPath){
+  m_workspace = std::make_unique<WorkspaceIndex>(rootPath);
+  m_fileTreeFrames = {};
+  // Index is the connection context, it can't outlive this session
+  QObject::connect(m_workspace.get(), &WorkspaceIndex::treeChanged, m_workspace.get(), [this](const SynergyProtocol::FileTreeDiff &diff) {
+    onWorkspaceChanged(diff);
+  });
+}
+
+void Session::sendFileTree(qintptr clientId){
+  if(!m_workspace) return;
+  const SynergyProtocol::t_WireFormat format = m_transport.wireFormat(clientId);
+  QByteArray &frame = m_fileTreeFrames[static_cast<std::size_t>(format)];
+  if(frame.isEmpty()) {
+    // Not sequenced: a tree is a complete state, not part of the stream a resume replays
+    frame = SynergyProtocol::Message_File_Tree_Update {0, m_workspace->tree()}.encodeFrame(format);
+  }
+  m_transport.postFrame({clientId}, frame, FramePolicy {FramePolicy::t_Kind::STATE, QString::fromLatin1(FramePolicy::c_fileTreeKey)});
+}
+
+void Session::onWorkspaceChanged(const SynergyProtocol::FileTreeDiff &diff){
+  m_fileTreeFrames = {};
+  broadcast(SynergyProtocol::Message_File_Tree_Diff {0, diff});
+}
@@ -0,0 +1,52 @@
+#include "../include/SessionJournal.h"
+
+#include <utility>
+
+SessionJournal::SessionJournal(Limits limits) :
+  m_limits(limits) {
+}
+
+qint64 SessionJournal::sizeOf(const Entry &entry){
+  qint64 size = 0;
+  for(const QByteArray &frame : entry.frames) size += frame.size();
+  return size;
+}
+
+void SessionJournal::append(Entry entry){
+  m_nextSequence = entry.sequence + 1;
+  m_bytes += sizeOf(entry);
+  m_entries.push_back(std::move(entry));
+  // Newest entry always stays, even if it alone is over the byte limit
+  while(m_entries.size() > 1 && (m_entries.size() > m_limits.maxEntries || m_bytes > m_limits.maxBytes)) {
+    m_bytes -= sizeOf(m_entries.front());
+    m_entries.pop_front();
+  }
+}
+
+bool SessionJournal::covers(quint64 lastSequence) const {
+  if(lastSequence >= m_nextSequence) return false;        // Client claims more than was ever sent
+  if(lastSequence + 1 == m_nextSequence) return true;     // Nothing missed
+  return !m_entries.empty() && m_entries.front().sequence <= lastSequence + 1;
+}
+
+bool SessionJournal::replay(quint64 lastSequence, const QString &userId, SynergyProtocol::t_WireFormat format,
+                            const std::function<void(const QByteArray &frame, const FramePolicy &policy)> &deliver) const {
+  if(!covers(lastSequence)) return false;
+
+  const std::size_t formatIndex = static_cast<std::size_t>(format);
+  auto first = m_entries.cbegin();
+  while(first != m_entries.cend() && first->sequence <= lastSequence) ++first;
+
+  // Check before sending anything, a partial replay would leave client with a hole
+  QList<const Entry*> missed;
+  for(auto it = first; it != m_entries.cend(); ++it) {
+    if(!it->targetUserId.isEmpty() && it->targetUserId != userId) continue;
+    if(!it->excludeUserId.isEmpty() && it->excludeUserId == userId) continue;
+    if(it->frames[formatIndex].isEmpty()) return false;
+    missed.append(&*it);
+  }
+  for(const Entry *entry : missed) {
+    deliver(entry->frames[formatIndex], entry->policy);
+  }
+  return true;
+}
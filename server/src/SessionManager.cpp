@@ -0,0 +1,476 @@
+#include "../include/SessionManager.h"
+
+#include <QRandomGenerator>
+#include <QDir>
+#include <QTimer>
+
+SessionManager::SessionManager(ClientTransport &transport, const QString &workspaceBase, int persistenceWindowMs,
+                               DockerExecutor::Config executorConfig) :
+  m_transport(transport),
+  m_workspaceBase(workspaceBase),
+  m_files(transport),
+  m_persistence(new PersistenceEngine(persistenceWindowMs)),
+  m_executor(std::move(executorConfig)) {
+  m_persistenceThread.setObjectName(QStringLiteral("persistence"));
+  m_persistence->moveToThread(&m_persistenceThread);
+  connect(&m_persistenceThread, &QThread::finished, m_persistence, &QObject::deleteLater);
+  connect(m_persistence, &PersistenceEngine::persisted, this, &SessionManager::onPersisted);
+  m_persistenceThread.start();
+  m_executor.start(); // Warm containers are ready before the first run request
+}
+
+SessionManager::~SessionManager(){
+  // Everything accepted so far is written before the thread goes away
+  m_persistence->flushBlocking();
+  m_persistenceThread.quit();
+  m_persistenceThread.wait();
+}
+
+Session* SessionManager::sessionOf(qintptr clientId) const {
+  return m_clientSessions.value(clientId, nullptr);
+}
+
+void SessionManager::handleMessage(qintptr clientId, const SynergyProtocol::Message_Base &message){
+  switch(message.type()) {
+    case SynergyProtocol::t_MessageType::JOIN_SESSION_REQUEST:
+      handleJoinRequest(clientId, static_cast<const SynergyProtocol::Message_Join_Session_Request&>(message));
+      break;
+    case SynergyProtocol::t_MessageType::RESUME_SESSION_REQUEST:
+      handleResumeRequest(clientId, static_cast<const SynergyProtocol::Message_Resume_Session_Request&>(message));
+      break;
+    case SynergyProtocol::t_MessageType::REQUEST_FILE_TREE:
+      handleFileTreeRequest(clientId);
+      break;
+    case SynergyProtocol::t_MessageType::REQUEST_OPEN_FILE:
+      handleOpenFileRequest(clientId, static_cast<const SynergyProtocol::Message_Request_Open_File&>(message));
+      break;
+    case SynergyProtocol::t_MessageType::UPDATE_TEXT_EDIT:
+      handleTextReplace(clientId, static_cast<const SynergyProtocol::Message_Update_Text_Edit&>(message));
+      break;
+    case SynergyProtocol::t_MessageType::TEXT_OPERATION:
+      handleTextOperation(clientId, static_cast<const SynergyProtocol::Message_Text_Operation&>(message));
+      break;
+    case SynergyProtocol::t_MessageType::REQUEST_RUN_CODE:
+      handleRunRequest(clientId, static_cast<const SynergyProtocol::Message_Request_Run_Code&>(message));
+      break;
+    case SynergyProtocol::t_MessageType::DRAW_COMMAND:
+      relayDrawCommand(clientId, static_cast<const SynergyProtocol::Message_Draw_Command&>(message));
+      break;
+    case SynergyProtocol::t_MessageType::DRAW_POLYLINE:
+      relayDrawPolyline(clientId, static_cast<const SynergyProtocol::Message_Draw_Polyline&>(message));
+      break;
+    default:
+      qWarning() << "SESSION MANAGER | Unexpected message" << SynergyProtocol::messageTypeToString(message.type()) << "from client" << clientId;
+      break;
+  }
+}
+
+/*
+Join flow (spec 5.5.2 - 5.5.4)
+Requester gets JOIN_SESSION_RESPONSE, everyone already inside gets USER_JOINED.
+Newcomer is also told about existing participants with one USER_JOINED each,
+so its user list is complete without a separate request.
+*/
+void SessionManager::handleJoinRequest(qintptr clientId, const SynergyProtocol::Message_Join_Session_Request &request){
+  if(m_clientSessions.contains(clientId)) {
+    SynergyProtocol::Message_Join_Session_Response reply {request.clientId(), false, "", "", "Already in a session"};
+    m_transport.postFrame({clientId}, reply.encodeFrame(m_transport.wireFormat(clientId)));
+    return;
+  }
+
+  std::shared_ptr<Session> session;
+  if(request.shouldCreateNew()) {
+    QString sessionId = generateSessionId();
+    session = std::make_shared<Session>(sessionId, m_transport);
+    m_sessions.insert(sessionId, session);
+
+    // Workspace is indexed once here, file tree requests are then served from memory
+    const QString workspacePath = QDir(m_workspaceBase).filePath(sessionId);
+    if(!QDir().mkpath(workspacePath)) {
+      qWarning() << "SESSION MANAGER | Could not create workspace directory" << workspacePath;
+    }
+    session->openWorkspace(workspacePath);
+    qInfo() << "SESSION MANAGER | Created session" << sessionId;
+  } else {
+    session = m_sessions.value(request.sessionIdToJoin());
+    if(!session) {
+      SynergyProtocol::Message_Join_Session_Response reply {request.clientId(), false, "", "", "Session not found"};
+      m_transport.postFrame({clientId}, reply.encodeFrame(m_transport.wireFormat(clientId)));
+      return;
+    }
+  }
+
+  // Socket descriptors get reused, a resumed participant may keep an id derived from an old one
+  const QString userId = QStringLiteral("User_%1").arg(++m_userCounter);
+  const QString resumeToken = generateResumeToken();
+  session->addParticipant(clientId, userId, request.username(), resumeToken);
+  m_clientSessions.insert(clientId, session.get());
+
+  session->sendTo(clientId, SynergyProtocol::Message_Join_Session_Response {request.clientId(), true, session->id(), userId, "", resumeToken});
+  session->broadcast(SynergyProtocol::Message_User_Joined {0, userId, request.username()}, clientId);
+  sendSessionState(session.get(), clientId);
+  qInfo() << "SESSION MANAGER | Client" << clientId << "joined" << session->id() << "(" << session->participantCount() << "participants )";
+}
+
+void SessionManager::sendSessionState(Session *session, qintptr clientId){
+  // Existing participants towards the newcomer
+  for(const Session::Participant &participant : session->participants()) {
+    if(participant.clientId == clientId) continue;
+    session->sendTo(clientId, SynergyProtocol::Message_User_Joined {0, participant.userId, participant.username});
+  }
+  // Current text of open files, newcomer continues with deltas from these revisions.
+  // Streamed like an opened file: no frame holds a whole document, operations arriving meanwhile queue behind chunks
+  for(auto it = session->documents().cbegin(); it != session->documents().cend(); ++it) {
+    m_files.openText(clientId, it.key(), it->text(), it->revision());
+  }
+  // Canvas: compacted tiles, then commands drawn since, in order
+  if(session->canvas().tileCount() > 0) {
+    session->sendTo(clientId, session->canvas().snapshot());
+  }
+  for(const SynergyProtocol::Message_Draw_Polyline &stroke : session->canvas().tail()) {
+    session->sendTo(clientId, stroke);
+  }
+}
+
+/*
+Resume flow
+Client reconnected after a drop and presents the token of its detached participant.
+If the journal still holds everything after the client's last sequence, exactly those
+frames are sent again (as encoded back then); otherwise the client gets the state as on
+join. Response comes last and is not sequenced, token is replaced on every resume.
+*/
+void SessionManager::handleResumeRequest(qintptr clientId, const SynergyProtocol::Message_Resume_Session_Request &request){
+  const auto fail = [&](const QString &error) {
+    SynergyProtocol::Message_Resume_Session_Response reply {request.clientId(), false, false, "", "", error};
+    m_transport.postFrame({clientId}, reply.encodeFrame(m_transport.wireFormat(clientId)));
+  };
+  if(m_clientSessions.contains(clientId)) {
+    fail(QStringLiteral("Already in a session"));
+    return;
+  }
+  const std::shared_ptr<Session> session = m_sessions.value(request.sessionId());
+  if(!session) {
+    fail(QStringLiteral("Session not found"));
+    return;
+  }
+  const QString resumeToken = generateResumeToken();
+  const Session::Participant *participant = request.resumeToken().isEmpty() ? nullptr : session->reattach(request.resumeToken(), clientId, resumeToken);
+  if(!participant) {
+    fail(QStringLiteral("Resume window expired"));
+    return;
+  }
+  m_clientSessions.insert(clientId, session.get());
+  const QString userId = participant->userId;
+
+  const bool replayed = session->journal().replay(request.lastSequence(), userId, m_transport.wireFormat(clientId),
+    [this, clientId](const QByteArray &frame, const FramePolicy &policy) {
+      m_transport.postFrame({clientId}, frame, policy);
+    });
+  if(!replayed) {
+    sendSessionState(session.get(), clientId);
+  }
+
+  SynergyProtocol::Message_Resume_Session_Response reply {request.clientId(), true, replayed, userId, resumeToken};
+  m_transport.postFrame({clientId}, reply.encodeFrame(m_transport.wireFormat(clientId)));
+  qInfo() << "SESSION MANAGER | Client" << clientId << "resumed as" << userId << "in" << session->id()
+          << (replayed ? "(missed messages replayed)" : "(state resent)");
+}
+
+void SessionManager::handleFileTreeRequest(qintptr clientId){
+  Session *session = sessionOf(clientId);
+  if(!session) {
+    qWarning() << "SESSION MANAGER | File tree request from client" << clientId << "outside of a session, dropped";
+    return;
+  }
+  session->sendFileTree(clientId);
+}
+
+/*
+Open file (spec RequestOpenFile)
+Content goes only to the requester, as FILE_CHUNKs. File edited in this session
+comes from memory at its current revision (disk may not have the last edits yet),
+any other file straight from disk as revision 0. Operations on it broadcast
+meanwhile reach the requester after the chunks' revision and apply on top.
+*/
+void SessionManager::handleOpenFileRequest(qintptr clientId, const SynergyProtocol::Message_Request_Open_File &request){
+  Session *session = sessionOf(clientId);
+  if(!session) {
+    sendError(clientId, SynergyProtocol::Message_Error_Notification::NOT_IN_SESSION, QStringLiteral("File requested outside of a session"));
+    return;
+  }
+  const QString absolutePath = resolveInWorkspace(session, request.filePath());
+  if(absolutePath.isEmpty()) {
+    sendError(clientId, SynergyProtocol::Message_Error_Notification::INVALID_REQUEST, QStringLiteral("Invalid file path"));
+    return;
+  }
+  const auto document = session->documents().constFind(request.filePath());
+  if(document != session->documents().cend()) {
+    m_files.openText(clientId, request.filePath(), document->text(), document->revision());
+    return;
+  }
+  if(!m_files.openFile(clientId, request.filePath(), absolutePath, 0)) {
+    sendError(clientId, SynergyProtocol::Message_Error_Notification::INVALID_REQUEST, QStringLiteral("Could not open %1").arg(request.filePath()));
+  }
+}
+
+// Full content from a client (file opened / replaced). Recorded as one operation, others get the text
+void SessionManager::handleTextReplace(qintptr clientId, const SynergyProtocol::Message_Update_Text_Edit &edit){
+  Session *session = sessionOf(clientId);
+  if(!session) {
+    qWarning() << "SESSION MANAGER | Text edit from client" << clientId << "outside of a session, dropped";
+    return;
+  }
+  const QString absolutePath = resolveInWorkspace(session, edit.filePath());
+  if(absolutePath.isEmpty()) return;
+
+  ActiveDocument &document = session->document(edit.filePath());
+  document.replaceContent(edit.content());
+  m_persistence->schedule(session->id(), edit.filePath(), absolutePath, document.text(), document.revision());
+
+  session->sendTo(clientId, SynergyProtocol::Message_Text_Operation_Ack {clientId, edit.filePath(), document.revision()});
+  session->broadcast(SynergyProtocol::Message_Update_Text_Edit {0, edit.filePath(), edit.content(), userIdFor(clientId), document.revision()}, clientId);
+}
+
+/*
+Delta edit
+Operation is transformed to the current revision and applied to the authoritative text.
+Author gets an ack with the new revision, everyone else gets the transformed operation.
+Size of what crosses the wire depends on the edit, not on the file.
+*/
+void SessionManager::handleTextOperation(qintptr clientId, const SynergyProtocol::Message_Text_Operation &message){
+  Session *session = sessionOf(clientId);
+  if(!session) {
+    qWarning() << "SESSION MANAGER | Text operation from client" << clientId << "outside of a session, dropped";
+    return;
+  }
+  const QString absolutePath = resolveInWorkspace(session, message.filePath());
+  if(absolutePath.isEmpty()) return;
+
+  ActiveDocument &document = session->document(message.filePath());
+  if(message.operation().components().empty()) {
+    // Empty operation is a snapshot request (client lost track of the document)
+    m_files.openText(clientId, message.filePath(), document.text(), document.revision());
+    return;
+  }
+
+  SynergyProtocol::TextOperation applied;
+  const ActiveDocument::t_ApplyResult result = document.apply(message.revision(), message.operation(), applied);
+
+  if(result != ActiveDocument::t_ApplyResult::APPLIED) {
+    // Client copy diverged or is too far behind -> resend whole document, client rebases on it
+    qWarning() << "SESSION MANAGER | Rejected text operation on" << message.filePath() << "from client" << clientId
+               << (result == ActiveDocument::t_ApplyResult::STALE_REVISION ? "(stale revision)" : "(invalid operation)");
+    m_files.openText(clientId, message.filePath(), document.text(), document.revision());
+    return;
+  }
+
+  m_persistence->schedule(session->id(), message.filePath(), absolutePath, document.text(), document.revision());
+  session->sendTo(clientId, SynergyProtocol::Message_Text_Operation_Ack {clientId, message.filePath(), document.revision()});
+  session->broadcast(SynergyProtocol::Message_Text_Operation {0, message.filePath(), document.revision(), applied, userIdFor(clientId)}, clientId);
+}
+
+/*
+Run flow (SRV-FUNC-DOCKER-001..007)
+Pending edits are flushed first (without blocking this thread), then the
+workspace runs in a pooled container. Output reaches the whole session as
+RUN_OUTPUT_CHUNKs while the process runs, RUN_OUTPUT_RESULT (exit code) ends
+the run. Failures also go to the requester as ERROR_NOTIFICATION.
+*/
+void SessionManager::handleRunRequest(qintptr clientId, const SynergyProtocol::Message_Request_Run_Code &request){
+  Session *session = sessionOf(clientId);
+  if(!session || !session->workspace()) {
+    sendError(clientId, SynergyProtocol::Message_Error_Notification::NOT_IN_SESSION, QStringLiteral("Run requested outside of a session"));
+    return;
+  }
+  const QString sessionId = session->id();
+  if(m_runningSessions.contains(sessionId)) {
+    sendError(clientId, SynergyProtocol::Message_Error_Notification::INVALID_REQUEST, QStringLiteral("A run is already in progress in this session"));
+    return;
+  }
+  m_runningSessions.insert(sessionId);
+
+  const QString workspaceRoot = session->workspace()->rootPath();
+  const QString userId = userIdFor(clientId);
+  auto *output = new RunOutputStream(QStringLiteral("RUN_%1").arg(++m_runCounter),
+    [this, sessionId](const SynergyProtocol::Message_Run_Output_Chunk &chunk) {
+      if(const std::shared_ptr<Session> target = m_sessions.value(sessionId)) target->broadcast(chunk);
+    }, RunOutputStream::Limits(), this);
+
+  m_persistence->flushAsync(this, [this, sessionId, workspaceRoot, userId, clientId, output,
+                                   command = request.command(), args = request.args(), environment = request.targetEnvironment()]() {
+    m_executor.run(workspaceRoot, command, args, environment,
+      [output](DockerStreamDemuxer::t_Stream stream, QByteArrayView data) {
+        output->append(stream == DockerStreamDemuxer::t_Stream::STDERR ? RunOutputStream::t_Stream::STDERR : RunOutputStream::t_Stream::STDOUT, data);
+        return !output->isCutOff(); // Past the output limit nobody sees more, stop the process
+      },
+      [this, sessionId, userId, clientId, output](const DockerExecutor::Result &result) {
+        m_runningSessions.remove(sessionId);
+        output->finish();
+        output->deleteLater();
+        const std::shared_ptr<Session> session = m_sessions.value(sessionId);
+        if(!session) return; // Everyone left meanwhile
+
+        if(!result.error.isEmpty()) {
+          sendError(clientId, SynergyProtocol::Message_Error_Notification::EXECUTION_FAILED, result.error);
+        }
+        // Ends the run for every participant, also after a failure
+        session->broadcast(SynergyProtocol::Message_Run_Output_Result {0, "", result.error, result.exitCode, userId, output->runId(), output->chunkCount()});
+      });
+  });
+}
+
+void SessionManager::relayDrawCommand(qintptr clientId, const SynergyProtocol::Message_Draw_Command &command){
+  Session *session = sessionOf(clientId);
+  if(!session) {
+    qWarning() << "SESSION MANAGER | Draw command from client" << clientId << "outside of a session, dropped";
+    return;
+  }
+  SynergyProtocol::Message_Draw_Command relayed = command;
+  relayed.setOriginatorId(userIdFor(clientId));
+  session->broadcast(relayed, clientId);
+  session->canvas().append(relayed);
+}
+
+void SessionManager::relayDrawPolyline(qintptr clientId, const SynergyProtocol::Message_Draw_Polyline &polyline){
+  Session *session = sessionOf(clientId);
+  if(!session) {
+    qWarning() << "SESSION MANAGER | Draw polyline from client" << clientId << "outside of a session, dropped";
+    return;
+  }
+  SynergyProtocol::Message_Draw_Polyline relayed = polyline;
+  relayed.setOriginatorId(userIdFor(clientId));
+  session->broadcast(relayed, clientId);
+  session->canvas().append(relayed);
+}
+
+void SessionManager::resyncClient(qintptr clientId, const QString &key){
+  Session *session = sessionOf(clientId);
+  if(!session) return;
+  if(key == QLatin1StringView(FramePolicy::c_fileTreeKey)) {
+    session->sendFileTree(clientId);
+    return;
+  }
+  for(auto it = session->documents().cbegin(); it != session->documents().cend(); ++it) {
+    if(FramePolicy::documentKey(it.key()) == key) {
+      // Chunked, whatever the file size no single frame can push the backlog past 'disconnectBytes'
+      m_files.openText(clientId, it.key(), it->text(), it->revision());
+      return;
+    }
+  }
+  qWarning() << "SESSION MANAGER | Nothing to resync for key" << key << "of client" << clientId;
+}
+
+void SessionManager::frameDelivered(qintptr clientId, quint64 deliveryToken){
+  m_files.onDelivered(clientId, deliveryToken);
+}
+
+void SessionManager::frameDiscarded(qintptr clientId, quint64 deliveryToken){
+  m_files.onDiscarded(clientId, deliveryToken);
+}
+
+void SessionManager::removeClient(qintptr clientId){
+  m_files.cancel(clientId); // Also for clients that never joined
+  Session *session = m_clientSessions.take(clientId);
+  if(!session) return;
+
+  const Session::Participant *participant = session->participant(clientId);
+  const QString resumeToken = participant ? participant->resumeToken : QString();
+  session->detachParticipant(clientId);
+
+  if(!session->hasDetached() || resumeToken.isEmpty()) {
+    closeSession(session);
+    return;
+  }
+  // Others see the participant leave only when it doesn't come back in time
+  QTimer::singleShot(c_resumeWindowMs, this, [this, sessionId = session->id(), resumeToken]() {
+    expireDetached(sessionId, resumeToken);
+  });
+}
+
+void SessionManager::expireDetached(const QString &sessionId, const QString &resumeToken){
+  const std::shared_ptr<Session> session = m_sessions.value(sessionId);
+  if(!session) return;
+  const std::optional<Session::Detached> gone = session->dropDetached(resumeToken);
+  if(!gone) return; // Resumed meanwhile (token was replaced)
+
+  if(session->isEmpty() && !session->hasDetached()) {
+    closeSession(session.get());
+    return;
+  }
+  session->broadcast(SynergyProtocol::Message_User_Left {0, gone->userId, gone->username});
+}
+
+void SessionManager::closeSession(Session *session){
+  if(!session->isEmpty() || session->hasDetached()) return;
+  const QString sessionId = session->id(); // Key must outlive the session it points into
+  qInfo() << "SESSION MANAGER | Session" << sessionId << "is empty, closing";
+  if(session->workspace()) m_executor.forgetWorkspace(session->workspace()->rootPath());
+  m_failingSaves.removeIf([prefix = sessionId + QLatin1Char('/')](const QString &key) { return key.startsWith(prefix); });
+  m_sessions.remove(sessionId);
+}
+
+void SessionManager::sendError(qintptr clientId, int code, const QString &message){
+  // Unknown (already disconnected) clients are ignored by the transport
+  SynergyProtocol::Message_Error_Notification error {clientId, code, message};
+  m_transport.postFrame({clientId}, error.encodeFrame(m_transport.wireFormat(clientId)));
+}
+
+// Client paths are untrusted: must stay inside session workspace (SRV-FUNC-WM-006)
+QString SessionManager::resolveInWorkspace(Session *session, const QString &filePath) const {
+  const QString absolutePath = session->workspace() ? session->workspace()->resolve(filePath) : QString();
+  if(absolutePath.isEmpty()) {
+    qWarning() << "SESSION MANAGER | Rejected file path outside of workspace:" << filePath << "in session" << session->id();
+  }
+  return absolutePath;
+}
+
+/*
+Slot - file reached disk, or didn't (runs on this thread, signal comes queued from persistence thread)
+Engine keeps retrying a failed file; participants hear about the failure once, and
+the FILE_SAVED that eventually follows tells them it is on disk again.
+*/
+void SessionManager::onPersisted(const QString &sessionId, const QString &relativePath, quint64 revision, bool ok){
+  const std::shared_ptr<Session> session = m_sessions.value(sessionId);
+  const QString saveKey = sessionId + QLatin1Char('/') + relativePath;
+  if(!ok) {
+    if(m_failingSaves.contains(saveKey)) return;
+    m_failingSaves.insert(saveKey);
+    qCritical() << "SESSION MANAGER | Saving" << relativePath << "revision" << revision << "of session" << sessionId << "failed, retrying";
+    if(session) {
+      const QJsonObject context {{"filePath", relativePath}, {"revision", qint64(revision)}};
+      session->broadcast(SynergyProtocol::Message_Error_Notification {0, SynergyProtocol::Message_Error_Notification::SAVE_FAILED,
+        QStringLiteral("Edits of %1 are not saved to disk yet, retrying").arg(relativePath), context});
+    }
+    return;
+  }
+  m_failingSaves.remove(saveKey);
+  if(session) {
+    session->broadcast(SynergyProtocol::Message_File_Saved {0, relativePath, revision});
+  }
+}
+
+QString SessionManager::generateSessionId() const {
+  static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+  QString id;
+  do {
+    id = QStringLiteral("SESS_");
+    for(int i = 0; i < c_sessionIdLength; ++i) {
+      id.append(QChar(alphabet[QRandomGenerator::global()->bounded(int(sizeof(alphabet) - 1))]));
+    }
+  } while(m_sessions.contains(id));
+  return id;
+}
+
+QString SessionManager::generateResumeToken(){
+  // 128 random bits from the system generator, token is what authenticates a resume
+  quint32 words[4];
+  QRandomGenerator::system()->fillRange(words);
+  return QString::fromLatin1(QByteArray(reinterpret_cast<const char*>(words), sizeof(words)).toHex());
+}
+
+QString SessionManager::userIdFor(qintptr clientId) const {
+  if(const Session *session = sessionOf(clientId)) {
+    if(const Session::Participant *participant = session->participant(clientId)) return participant->userId;
+  }
+  return QStringLiteral("Client_%1").arg(clientId);
+}
@@ -2,7 +2,10 @@
 
 #include <QCoreApplication> // for error checking
 
-SslServer::SslServer(QObject *parent) : QSslServer(parent) {
+SslServer::SslServer(QObject *parent, int ioThreads, OutboundQueue::Limits outboundLimits, ConnectionWorker::Liveness liveness) :
+  QSslServer(parent),
+  m_outboundLimits(outboundLimits),
+  m_liveness(liveness) {
   // Setting up SSL configuration -> defining rules for ssl connections
   m_sslConfiguration = QSslConfiguration::defaultConfiguration();
 
@@ -16,7 +19,10 @@ SslServer::SslServer(QObject *parent) : QSslServer(parent) {
   but 'key.perm' should have strict file permissions in real
   scenario
   Crucial error handling
-  To generate for local testing:
+  To generate for local testing (ECDSA P-256: signing is an order
+  of magnitude cheaper than RSA-2048, the handshake's main cost):
+  openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -keyout key.pem -out cert.pem -sha256 -days 365 -nodes
+  RSA still works:
   openssl req -x509 -newkey rsa:2048 -keyout key.pem -out cert.pem -sha256 -days 365 -nodes
   ------------------------------------------------------------
   */
@@ -37,12 +43,31 @@ SslServer::SslServer(QObject *parent) : QSslServer(parent) {
   // Using newer (1.2 or 1.3) prevents known vulnerabilites
   m_sslConfiguration.setProtocol(QSsl::TlsV1_2OrLater);
 
+  /*
+  Session resumption: reconnecting client presents a ticket from its last
+  connection and skips certificate signing + key exchange verification.
+  Tickets are issued (TLS 1.3 NewSessionTicket) unless disabled; they can
+  only be redeemed on the context that issued them -> TlsContextCache
+  */
+  m_sslConfiguration.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+  if(!TlsContextCache::c_supported) {
+    qWarning() << "Built without Qt private network headers, TLS sessions can't be resumed: every reconnect is a full handshake";
+  }
+
   // TODO: Consider explicitly setting strong cipher suites if needed later.
   // m_sslConfiguration.setCiphers(...);
 
   QSslConfiguration::setDefaultConfiguration(m_sslConfiguration);
 
   qInfo() << "Server SSL configuration prepared";
+
+  // Workers get a copy of finished configuration
+  startWorkers(ioThreads);
+}
+
+SslServer::~SslServer(){
+  close();
+  stopWorkers();
 }
 
 bool SslServer::loadCertAndKey(const QString &certPath, const QString &keyPath){
@@ -72,19 +97,21 @@ bool SslServer::loadCertAndKey(const QString &certPath, const QString &keyPath){
 
   /*
   Load the key here.
-  We are using RSA, as we generated RSA key
+  Algorithm follows the certificate's public key (ECDSA or RSA), QSslKey can't detect it from PEM
   QSsl::Pem is file format. Null password handler used as key isn't encrypted
   If key was password protected, pass a labmda/function here to provide a password
   Avoid hardcoding passwords (Secure storage or prompts)
   Todo : Implement with secure storage
   */
-  QSslKey privateKey(&keyFile, QSsl::Rsa, QSsl::Pem, QSsl::PrivateKey, QByteArray()); // empty password
+  const QSsl::KeyAlgorithm algorithm = certificate.publicKey().algorithm();
+  QSslKey privateKey(&keyFile, algorithm, QSsl::Pem, QSsl::PrivateKey, QByteArray()); // empty password
   keyFile.close();
 
   if (privateKey.isNull()){
-    qWarning() << "Private key file is invalid or empty:" << keyPath;
+    qWarning() << "Private key file is invalid, empty or doesn't match certificate's key algorithm:" << keyPath;
     return false;
   }
+  qInfo() << "Server key:" << (algorithm == QSsl::Ec ? "ECDSA" : algorithm == QSsl::Rsa ? "RSA" : "other") << privateKey.length() << "bits";
 
   // Storing them in our member configuration object
   m_sslConfiguration.setLocalCertificate(certificate);
@@ -106,138 +133,152 @@ bool SslServer::startListening(const QHostAddress &address, quint16 port){
 ------------------------------------------------------------------
 ------------------ Handling incoming connections -----------------
 Called by QSslServer when a new client tries to connect
-We override it to create a QSslSocket instead of plain QTcpSocket
+We override it so QSslSocket is not built here, on the accepting
+thread. Descriptor is handed to the least loaded I/O worker, which
+creates the socket, runs the handshake and owns it from then on.
 ------------------------------------------------------------------
 */
 void SslServer::incomingConnection(qintptr socketDescriptor){
-  qInfo() << "Incoming connection, creating QSslSocket...";
+  ConnectionWorker *worker = pickWorker();
+  // Descriptors get reused by OS after close, so clients get ids that are never reused
+  const qintptr clientId = m_nextClientId++;
+  m_routes.insert(clientId, Route{worker, SynergyProtocol::t_WireFormat::JSON});
+  worker->addConnection(socketDescriptor, clientId);
 
-  // Ssl socket for this specific connection
-  QSslSocket *sslSocket = new QSslSocket(this); // parent is this for basic object ownership
+  qInfo() << "Incoming connection, client" << clientId << "assigned to I/O worker" << worker->index();
+}
 
-  // Setting socket descriptor obtained from base class
-  // Associates OS-level socket with our QSslSocket object
-  if(!sslSocket->setSocketDescriptor(socketDescriptor)){
-    qWarning() << "Failed to set socket descriptor: " << sslSocket->errorString();
-    return;
+// Least loaded worker, ties resolved round-robin so equal workers fill evenly
+ConnectionWorker* SslServer::pickWorker(){
+  ConnectionWorker *best = nullptr;
+  const int count = static_cast<int>(m_workers.size());
+  for(int i = 0; i < count; ++i) {
+    ConnectionWorker *candidate = m_workers[(m_nextWorker + i) % count];
+    if(!best || candidate->load() < best->load()) {
+      best = candidate;
+    }
   }
+  m_nextWorker = (m_nextWorker + 1) % count;
+  return best;
+}
 
-  /* Security critial: Applying SSL configration & starting handshake
-  Apply SSL setting (cert, key, protocol) we prepared earlier
-  We can also set specific configuration per-socket if needed
-  */
-  sslSocket->setSslConfiguration(m_sslConfiguration); // usually not needed if default is set
-
-  // Connect signals from new socket to our server slots before starting encryption, so we can handle errors/events during handshake
-  connect(sslSocket, &QSslSocket::readyRead, this, &SslServer::onReadyRead);
-  connect(sslSocket, &QAbstractSocket::disconnected, this, &SslServer::onDisconnected);
-  // Crucial signal for handling SSl-specific errors durng handshake or later
-  connect(sslSocket, &QSslSocket::sslErrors, this, &SslServer::onSslErrors);
-  // Signal emitted when SSL handshake is successfully completed
-  connect(sslSocket, &QSslSocket::encrypted, this, &SslServer::onEncrypted);
-  
-  /*
-  Start server-side SSL handshake. 
-  Qt will now handle complex back-and-forth negotiation with client using configured settings
-  This is asynch operation, 'encrypted' or 'sslErrors' signal will follow
-  */
-  sslSocket->startServerEncryption();
-
-  // Add socket to our list after setup seems okay
-  m_clients.insert(socketDescriptor, sslSocket);
+void SslServer::startWorkers(int ioThreads){
+  if(ioThreads <= 0) {
+    ioThreads = qMax(1, QThread::idealThreadCount());
+  }
 
-  qInfo() << "QSslSocket created for descriptor: " << socketDescriptor << "starting encryption...";
+  for(int i = 0; i < ioThreads; ++i) {
+    QThread *thread = new QThread(this);
+    thread->setObjectName(QStringLiteral("io-%1").arg(i));
+    ConnectionWorker *worker = new ConnectionWorker(i, m_sslConfiguration, m_outboundLimits, &m_tlsContexts,
+                                                    ConnectionWorker::c_defaultMaxConcurrentHandshakes, m_liveness);
+    worker->moveToThread(thread);
+    // Worker (and every connection it owns) is destroyed on its own thread when thread stops
+    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+
+    // Signals cross back to this (main) thread as queued calls
+    connect(worker, &ConnectionWorker::clientDisconnected, this, &SslServer::onClientDisconnected);
+    connect(worker, &ConnectionWorker::messageReceived, this, &SslServer::onMessageReceived);
+    connect(worker, &ConnectionWorker::wireFormatNegotiated, this, &SslServer::onWireFormatNegotiated);
+    connect(worker, &ConnectionWorker::resyncNeeded, this, &SslServer::onResyncNeeded);
+    connect(worker, &ConnectionWorker::frameDelivered, this, &SslServer::onFrameDelivered);
+    connect(worker, &ConnectionWorker::frameDiscarded, this, &SslServer::onFrameDiscarded);
+
+    m_threads.push_back(thread);
+    m_workers.push_back(worker);
+    thread->start();
+  }
+  qInfo() << "Started" << ioThreads << "I/O worker threads";
 }
 
-// Slots - Data Recieved
-void SslServer::onReadyRead(){
-  // Get socket that emitted signal
-  QSslSocket *clientSocket = qobject_cast<QSslSocket*>(sender()); // use qobject_cast for safe casting
-    if (!clientSocket) return; // Should not happen in connected correctly
-
-  // Read all available data from encrypted socket
-  QByteArray data = clientSocket->readAll();
-  qInfo() << "Recieved from client: " << data;
-  auto json_doc = QJsonDocument::fromJson(data);
-  if(json_doc.isNull()){
-    qDebug()<<"Failed to create JSON doc.";
-    exit(2);
+void SslServer::stopWorkers(){
+  for(QThread *thread : m_threads) {
+    thread->quit();
   }
-  if(!json_doc.isObject()){
-    qDebug()<<"JSON is not an object.";
-    exit(3);
+  for(QThread *thread : m_threads) {
+    thread->wait();
   }
+  m_threads.clear();
+  m_workers.clear();
+  m_routes.clear();
+}
 
-  std::unique_ptr<SynergyProtocol::Message_Base> message 
-    = SynergyProtocol::MessageFactory::instance().createMessage(json_doc.object());
-
-  if(message) {
-    qInfo() << "Server received message type:" << SynergyProtocol::messageTypeToString(message->type());
-    // Echo data back to client
-    QString response = "Server recieved command: " + SynergyProtocol::messageTypeToString(message->type()) + " from " + ((message->toJSon())["payload"].toObject()["username"].toString());
-    // Write data back. Qt handles encryption automatically
-    clientSocket->write(response.toUtf8());
-  } else {
-    qWarning() << "Factory failed to create message object or parse JSON payload from client:" << clientSocket->peerAddress();
+// Thread-safe message passing towards a client living on any worker
+void SslServer::sendToClient(qintptr clientId, std::shared_ptr<const SynergyProtocol::Message_Base> message){
+  auto it = m_routes.constFind(clientId);
+  if(it != m_routes.cend()) {
+    it->worker->postMessage(clientId, std::move(message));
   }
-
 }
 
-// Slots - Client Disconnected
-void SslServer::onDisconnected(){
-  QSslSocket *clientSocket = qobject_cast<QSslSocket*>(sender());
-    if (!clientSocket) return;
+void SslServer::sendFrameToClient(qintptr clientId, const QByteArray &payload){
+  auto it = m_routes.constFind(clientId);
+  if(it != m_routes.cend()) {
+    it->worker->postFrame(clientId, payload);
+  }
+}
 
-  qInfo() << "Client disconnected: " << clientSocket->peerAddress() << ":" << clientSocket->peerPort();
+SynergyProtocol::t_WireFormat SslServer::wireFormat(qintptr clientId) const {
+  return m_routes.value(clientId).format;
+}
 
-  // Remove socket from tracking list
-  m_clients.remove(clientSocket->socketDescriptor());
+// Recipients grouped per owning worker -> one queued call per worker, not per client
+void SslServer::postFrame(const QList<qintptr> &clientIds, const QByteArray &frame, const FramePolicy &policy){
+  if(clientIds.size() == 1) {
+    auto it = m_routes.constFind(clientIds.front());
+    if(it != m_routes.cend()) it->worker->postEncodedFrame(clientIds, frame, policy);
+    return;
+  }
 
-  // Use deleteLater to safely remove QObject from within a slot connected to one of its signals
-  // This schedules deletion after the event loop returns
-  clientSocket->deleteLater();
-  // #endif
+  QHash<ConnectionWorker*, QList<qintptr>> perWorker;
+  for(qintptr clientId : clientIds) {
+    auto it = m_routes.constFind(clientId);
+    if(it != m_routes.cend()) perWorker[it->worker].append(clientId);
+  }
+  for(auto it = perWorker.cbegin(); it != perWorker.cend(); ++it) {
+    it.key()->postEncodedFrame(it.value(), frame, policy);
+  }
 }
 
-// Slot SSl Error occured
-// Catches errors during SSL handshake or later encryption issues
-// Vital for security
-void SslServer::onSslErrors(const QList<QSslError> &errors){
-  QSslSocket *clientSocket = qobject_cast<QSslSocket*>(sender());
-    if (!clientSocket) return;
-  
-  qWarning() << "SSL errors occured for a client connection: ";
-  for(const QSslError &error : errors){
-    qWarning() << "-" << error.errorString();
+void SslServer::disconnectClient(qintptr clientId){
+  auto it = m_routes.constFind(clientId);
+  if(it != m_routes.cend()) {
+    it->worker->postDisconnect(clientId);
   }
+}
 
-  /* Security: Handling Self-Signed certificates
-  For this example, using self-signed certificate, the client will likely report an 
-  "Unable to get local issuer certificate" or "Certificate untrusted" error
-  because certificate isn't signed bt a known CA
-
-  In production, we CANNOT ignore the errors
-  Proper handling invlolves:
-  1. Using certificates signed by a trusted CA
-  2. Configuring the client to explicitly trust you self-signed CA or specific server certificate
-  3. Carefully evaluate which errors are acceptable to ingore(if any)
+// Slot - parsed message arrived from one of the workers (runs on main thread)
+void SslServer::onMessageReceived(qintptr clientId, std::shared_ptr<const SynergyProtocol::Message_Base> message){
+  // Counted per type on the I/O thread (Metrics), a log line per message would cost more than handling it
+  Metrics::ScopedTimer timer(Metrics::t_Histogram::DISPATCH);
+  m_sessions.handleMessage(clientId, *message);
+}
 
-  For localhost example, we can chose to ignore self-signed error on client side. 
-  Server typically doesn't ingore errors unless doing client certificate auth 
-  Here, we just log errors, if they occur, handshake might fail and 'encrypted' signal won't be emitted
-  */
+// Slot - client's queue dropped updates of 'key', it gets the current state instead
+void SslServer::onResyncNeeded(qintptr clientId, const QString &key){
+  m_sessions.resyncClient(clientId, key);
+}
 
-  // clientSocket->abort(); // To disconnect on any error, forcefully close connection
+// Slot - a paced frame left the client's queue, its sender may go on
+void SslServer::onFrameDelivered(qintptr clientId, quint64 deliveryToken){
+  m_sessions.frameDelivered(clientId, deliveryToken);
 }
 
-// Slot: Connection encrypted
-void SslServer::onEncrypted(){
-  QSslSocket *clientSocket = qobject_cast<QSslSocket*>(sender());
-    if (!clientSocket) return;
+// Slot - a paced frame was replaced in the client's queue, its sender stops
+void SslServer::onFrameDiscarded(qintptr clientId, quint64 deliveryToken){
+  m_sessions.frameDiscarded(clientId, deliveryToken);
+}
 
-  qInfo() << "Connection successfully encrypted for:" << clientSocket->peerAddress() << ":" << clientSocket->peerPort();
+void SslServer::onWireFormatNegotiated(qintptr clientId, SynergyProtocol::t_WireFormat format){
+  auto it = m_routes.find(clientId);
+  if(it != m_routes.end()) {
+    it->format = format;
+  }
+}
 
-  // Connection is now secure, ready for application data exchange.
-  // Sending a welcome message
-  clientSocket->write("Welcome! Connection is secure.\n");
+// Slot - Client Disconnected
+void SslServer::onClientDisconnected(qintptr clientId){
+  // Leave session first (others are notified), then remove client from routing table
+  m_sessions.removeClient(clientId);
+  m_routes.remove(clientId);
 }
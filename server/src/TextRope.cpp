@@ -0,0 +1,324 @@
+#include "../include/TextRope.h"
+
+#include <algorithm>
+#include <random>
+
+struct TextRope::Node {
+  QString chunk;
+  quint32 priority;
+  NodePtr left;
+  NodePtr right;
+  qsizetype length;   // Units in whole subtree
+  qsizetype newlines; // '\n' in whole subtree
+};
+
+TextRope::TextRope(const QString &text) :
+  m_root(build(text)) {
+}
+
+qsizetype TextRope::lengthOf(const NodePtr &node){
+  return node ? node->length : 0;
+}
+
+qsizetype TextRope::newlinesOf(const NodePtr &node){
+  return node ? node->newlines : 0;
+}
+
+quint32 TextRope::randomPriority(){
+  // Priorities only shape the tree, they don't need to be unpredictable
+  thread_local std::minstd_rand generator {std::random_device{}()};
+  return static_cast<quint32>(generator());
+}
+
+TextRope::NodePtr TextRope::makeNode(QString chunk, quint32 priority, NodePtr left, NodePtr right){
+  const qsizetype chunkNewlines = chunk.count(QLatin1Char('\n'));
+  const qsizetype length = chunk.size() + lengthOf(left) + lengthOf(right);
+  const qsizetype newlines = chunkNewlines + newlinesOf(left) + newlinesOf(right);
+  return std::make_shared<const Node>(Node{std::move(chunk), priority, std::move(left), std::move(right), length, newlines});
+}
+
+// Path copy: same chunk, new children. Chunk newlines are recovered from totals, no rescan
+TextRope::NodePtr TextRope::withChildren(const NodePtr &node, NodePtr left, NodePtr right){
+  const qsizetype chunkNewlines = node->newlines - newlinesOf(node->left) - newlinesOf(node->right);
+  const qsizetype length = node->chunk.size() + lengthOf(left) + lengthOf(right);
+  const qsizetype newlines = chunkNewlines + newlinesOf(left) + newlinesOf(right);
+  return std::make_shared<const Node>(Node{node->chunk, node->priority, std::move(left), std::move(right), length, newlines});
+}
+
+TextRope::NodePtr TextRope::merge(const NodePtr &left, const NodePtr &right){
+  if(!left) return right;
+  if(!right) return left;
+  if(left->priority > right->priority) {
+    return withChildren(left, left->left, merge(left->right, right));
+  }
+  return withChildren(right, merge(left, right->left), right->right);
+}
+
+// Puts 'node' between two treaps. Needs merges only if a child outranks it (fresh chunk halves)
+TextRope::NodePtr TextRope::join(const NodePtr &node, NodePtr left, NodePtr right){
+  if((left && left->priority > node->priority) || (right && right->priority > node->priority)) {
+    NodePtr pivot = withChildren(node, nullptr, nullptr);
+    return merge(merge(left, pivot), right);
+  }
+  return withChildren(node, std::move(left), std::move(right));
+}
+
+// left gets first 'position' units, right the rest. Chunk straddling the cut is split in two nodes
+void TextRope::split(const NodePtr &node, qsizetype position, NodePtr &left, NodePtr &right){
+  if(!node) {
+    left = right = nullptr;
+    return;
+  }
+  const qsizetype leftLength = lengthOf(node->left);
+  const qsizetype chunkEnd = leftLength + node->chunk.size();
+
+  if(position <= leftLength) {
+    NodePtr innerRight;
+    split(node->left, position, left, innerRight);
+    right = join(node, std::move(innerRight), node->right);
+  } else if(position >= chunkEnd) {
+    NodePtr innerLeft;
+    split(node->right, position - chunkEnd, innerLeft, right);
+    left = join(node, node->left, std::move(innerLeft));
+  } else {
+    /*
+    Halves get fresh priorities: reusing the old one for both creates equal
+    priorities, and chunks split over and over pile those up into long chains
+    */
+    const qsizetype offset = position - leftLength;
+    left = merge(node->left, makeNode(node->chunk.left(offset), randomPriority(), nullptr, nullptr));
+    right = merge(makeNode(node->chunk.mid(offset), randomPriority(), nullptr, nullptr), node->right);
+  }
+}
+
+TextRope::NodePtr TextRope::build(const QString &text){
+  NodePtr root;
+  for(qsizetype offset = 0; offset < text.size(); offset += c_maxChunk) {
+    root = merge(root, makeNode(text.mid(offset, c_maxChunk), randomPriority(), nullptr, nullptr));
+  }
+  return root;
+}
+
+qsizetype TextRope::lastChunkSize(const NodePtr &node){
+  if(!node) return c_maxChunk; // Nothing to append to
+  return node->right ? lastChunkSize(node->right) : node->chunk.size();
+}
+
+qsizetype TextRope::firstChunkSize(const NodePtr &node){
+  if(!node) return c_maxChunk;
+  return node->left ? firstChunkSize(node->left) : node->chunk.size();
+}
+
+// Drops the rightmost chunk (handed out in 'chunk'), path copy like every edit
+TextRope::NodePtr TextRope::withoutLast(const NodePtr &node, QString &chunk){
+  if(node->right) {
+    return withChildren(node, node->left, withoutLast(node->right, chunk));
+  }
+  chunk = node->chunk;
+  return node->left;
+}
+
+TextRope::NodePtr TextRope::withoutFirst(const NodePtr &node, QString &chunk){
+  if(node->left) {
+    return withChildren(node, withoutFirst(node->left, chunk), node->right);
+  }
+  chunk = node->chunk;
+  return node->right;
+}
+
+// A last chunk below c_minChunk joins the one before it, if both fit in one
+TextRope::NodePtr TextRope::absorbLast(const NodePtr &node){
+  if(!node || lastChunkSize(node) >= c_minChunk) return node;
+  QString chunk, previous;
+  const NodePtr rest = withoutLast(node, chunk);
+  if(!rest || lastChunkSize(rest) + chunk.size() > c_maxChunk) return node;
+  const NodePtr head = withoutLast(rest, previous);
+  return merge(head, makeNode(previous + chunk, randomPriority(), nullptr, nullptr));
+}
+
+TextRope::NodePtr TextRope::absorbFirst(const NodePtr &node){
+  if(!node || firstChunkSize(node) >= c_minChunk) return node;
+  QString chunk, next;
+  const NodePtr rest = withoutFirst(node, chunk);
+  if(!rest || firstChunkSize(rest) + chunk.size() > c_maxChunk) return node;
+  const NodePtr tail = withoutFirst(rest, next);
+  return merge(makeNode(chunk + next, randomPriority(), nullptr, nullptr), tail);
+}
+
+/*
+Joins the two sides of an edit. Cuts leave short chunks at the seam:
+one below c_minChunk is merged with the chunk across the seam, or if
+that one is too full, with its other neighbour. A short chunk is only
+left where both neighbours are nearly full
+*/
+TextRope::NodePtr TextRope::mergeAtSeam(const NodePtr &left, const NodePtr &right){
+  if(!left || !right) return merge(absorbLast(left), absorbFirst(right));
+  const qsizetype last = lastChunkSize(left);
+  const qsizetype first = firstChunkSize(right);
+  if(last >= c_minChunk && first >= c_minChunk) return merge(left, right);
+  if(last + first > c_maxChunk) return merge(absorbLast(left), absorbFirst(right));
+
+  QString lastChunk, firstChunk;
+  const NodePtr head = withoutLast(left, lastChunk);
+  const NodePtr tail = withoutFirst(right, firstChunk);
+  return merge(merge(head, makeNode(lastChunk + firstChunk, randomPriority(), nullptr, nullptr)), tail);
+}
+
+// Typing lands right after previous keystroke, so small inserts extend the chunk before them
+TextRope::NodePtr TextRope::appendToLastChunk(const NodePtr &node, const QString &text){
+  if(node->right) {
+    return withChildren(node, node->left, appendToLastChunk(node->right, text));
+  }
+  return makeNode(node->chunk + text, node->priority, node->left, nullptr);
+}
+
+qsizetype TextRope::length() const {
+  return lengthOf(m_root);
+}
+
+qsizetype TextRope::lineCount() const {
+  return newlinesOf(m_root) + 1;
+}
+
+void TextRope::insert(qsizetype position, const QString &text){
+  if(text.isEmpty()) return;
+  position = std::clamp<qsizetype>(position, 0, length());
+
+  NodePtr left, right;
+  split(m_root, position, left, right);
+  if(lastChunkSize(left) + text.size() <= c_maxChunk) {
+    left = appendToLastChunk(left, text);
+  } else {
+    left = merge(left, build(text));
+  }
+  m_root = mergeAtSeam(left, right);
+}
+
+void TextRope::remove(qsizetype position, qsizetype count){
+  position = std::clamp<qsizetype>(position, 0, length());
+  count = std::clamp<qsizetype>(count, 0, length() - position);
+  if(count == 0) return;
+
+  NodePtr left, rest, removed, right;
+  split(m_root, position, left, rest);
+  split(rest, count, removed, right);
+  m_root = mergeAtSeam(left, right);
+}
+
+QChar TextRope::at(qsizetype position) const {
+  const Node *node = m_root.get();
+  while(node) {
+    const qsizetype leftLength = lengthOf(node->left);
+    if(position < leftLength) {
+      node = node->left.get();
+    } else if(position < leftLength + node->chunk.size()) {
+      return node->chunk.at(position - leftLength);
+    } else {
+      position -= leftLength + node->chunk.size();
+      node = node->right.get();
+    }
+  }
+  return QChar();
+}
+
+// In-order walk limited to [position, position + count), untouched subtrees are skipped
+void TextRope::collect(const NodePtr &node, qsizetype position, qsizetype count, QString &out){
+  if(!node || count <= 0) return;
+  const qsizetype leftLength = lengthOf(node->left);
+  if(position < leftLength) {
+    collect(node->left, position, count, out);
+  }
+  const qsizetype chunkStart = leftLength;
+  const qsizetype chunkEnd = leftLength + node->chunk.size();
+  const qsizetype from = std::max(position, chunkStart);
+  const qsizetype to = std::min(position + count, chunkEnd);
+  if(from < to) {
+    out.append(QStringView(node->chunk).mid(from - chunkStart, to - from));
+  }
+  if(position + count > chunkEnd) {
+    const qsizetype skipped = std::max<qsizetype>(0, chunkEnd - position);
+    collect(node->right, std::max<qsizetype>(0, position - chunkEnd), count - skipped, out);
+  }
+}
+
+QString TextRope::mid(qsizetype position, qsizetype count) const {
+  position = std::clamp<qsizetype>(position, 0, length());
+  count = std::clamp<qsizetype>(count, 0, length() - position);
+  QString out;
+  out.reserve(count);
+  collect(m_root, position, count, out);
+  return out;
+}
+
+QString TextRope::toString() const {
+  return mid(0, length());
+}
+
+void TextRope::visitChunks(const NodePtr &node, const std::function<void(QStringView)> &visit){
+  if(!node) return;
+  visitChunks(node->left, visit);
+  visit(node->chunk);
+  visitChunks(node->right, visit);
+}
+
+void TextRope::forEachChunk(const std::function<void(QStringView)> &visit) const {
+  visitChunks(m_root, visit);
+}
+
+qsizetype TextRope::chunkCount() const {
+  qsizetype count = 0;
+  visitChunks(m_root, [&count](QStringView) { ++count; });
+  return count;
+}
+
+qsizetype TextRope::lineStart(qsizetype line) const {
+  if(line < 0 || line >= lineCount()) return -1;
+  if(line == 0) return 0;
+
+  // Find position of newline number 'line' (1-based), line starts right after it
+  qsizetype remaining = line;
+  qsizetype offset = 0;
+  const Node *node = m_root.get();
+  while(node) {
+    const qsizetype leftNewlines = newlinesOf(node->left);
+    const qsizetype chunkNewlines = node->newlines - leftNewlines - newlinesOf(node->right);
+    if(remaining <= leftNewlines) {
+      node = node->left.get();
+      continue;
+    }
+    remaining -= leftNewlines;
+    offset += lengthOf(node->left);
+    if(remaining <= chunkNewlines) {
+      for(qsizetype i = 0; i < node->chunk.size(); ++i) {
+        if(node->chunk.at(i) == QLatin1Char('\n') && --remaining == 0) {
+          return offset + i + 1;
+        }
+      }
+    }
+    remaining -= chunkNewlines;
+    offset += node->chunk.size();
+    node = node->right.get();
+  }
+  return -1;
+}
+
+qsizetype TextRope::lineAt(qsizetype position) const {
+  position = std::clamp<qsizetype>(position, 0, length());
+  // Newlines strictly before 'position'
+  qsizetype line = 0;
+  const Node *node = m_root.get();
+  while(node) {
+    const qsizetype leftLength = lengthOf(node->left);
+    if(position < leftLength) {
+      node = node->left.get();
+      continue;
+    }
+    line += newlinesOf(node->left);
+    const qsizetype inChunk = std::min(position - leftLength, node->chunk.size());
+    line += QStringView(node->chunk).left(inChunk).count(QLatin1Char('\n'));
+    if(position - leftLength <= node->chunk.size()) break;
+    position -= leftLength + node->chunk.size();
+    node = node->right.get();
+  }
+  return line;
+}
@@ -0,0 +1,98 @@
+#include "../include/TimerWheel.h"
+
+namespace {
+  constexpr quint64 c_span = quint64(1) << (TimerWheel::c_slotBits * TimerWheel::c_levels); // Ticks the wheel reaches
+}
+
+TimerWheel::TimerWheel(qint64 tickMs, qint64 startMs) :
+  m_tickMs(qMax<qint64>(1, tickMs)),
+  m_startMs(startMs) {
+  m_heads.fill(-1);
+}
+
+TimerWheel::t_TimerId TimerWheel::schedule(qint64 nowMs, qint64 delayMs, qintptr key, int kind){
+  int index = m_free;
+  if(index >= 0) {
+    m_free = m_entries[index].next;
+  } else {
+    index = static_cast<int>(m_entries.size());
+    m_entries.emplace_back();
+  }
+
+  // Rounded up: a timer may fire up to one tick late, never early
+  const qint64 dueMs = qMax<qint64>(0, nowMs + qMax<qint64>(0, delayMs) - m_startMs);
+  Entry &entry = m_entries[index];
+  entry.deadline = qMax(m_currentTick + 1, quint64((dueMs + m_tickMs - 1) / m_tickMs));
+  entry.key = key;
+  entry.kind = kind;
+  place(index);
+  ++m_count;
+  return (t_TimerId(entry.generation) << 32) | t_TimerId(quint32(index));
+}
+
+bool TimerWheel::cancel(t_TimerId id){
+  const int index = static_cast<int>(quint32(id));
+  if(id == 0 || index >= static_cast<int>(m_entries.size())) return false;
+  const Entry &entry = m_entries[index];
+  if(entry.slot < 0 || entry.generation != quint32(id >> 32)) return false;
+  unlink(index);
+  release(index);
+  return true;
+}
+
+void TimerWheel::place(int index){
+  Entry &entry = m_entries[index];
+  const quint64 delta = entry.deadline > m_currentTick ? entry.deadline - m_currentTick : 0;
+  int slot;
+  if(delta >= c_span) {
+    // Out of reach: waits in the last slot the top level gets to, then placed again
+    slot = slotIndex(c_levels - 1, m_currentTick + c_span - 1);
+  } else {
+    int level = 0;
+    while(delta >> ((level + 1) * c_slotBits)) ++level;
+    slot = slotIndex(level, qMax(entry.deadline, m_currentTick));
+  }
+
+  entry.slot = slot;
+  entry.prev = -1;
+  entry.next = m_heads[slot];
+  if(entry.next >= 0) m_entries[entry.next].prev = index;
+  m_heads[slot] = index;
+}
+
+void TimerWheel::unlink(int index){
+  Entry &entry = m_entries[index];
+  if(entry.prev >= 0) {
+    m_entries[entry.prev].next = entry.next;
+  } else {
+    m_heads[entry.slot] = entry.next;
+  }
+  if(entry.next >= 0) m_entries[entry.next].prev = entry.prev;
+  entry.prev = -1;
+  entry.next = -1;
+}
+
+void TimerWheel::release(int index){
+  Entry &entry = m_entries[index];
+  entry.slot = -1;
+  ++entry.generation; // Ids handed out for this entry go stale
+  if(entry.generation == 0) entry.generation = 1;
+  entry.next = m_free;
+  m_free = index;
+  --m_count;
+}
+
+void TimerWheel::cascade(){
+  for(int level = 1; level < c_levels; ++level) {
+    // Level below wrapped around only if all its lower bits are zero
+    if(m_currentTick & ((quint64(1) << (level * c_slotBits)) - 1)) break;
+    int &head = m_heads[slotIndex(level, m_currentTick)];
+    int index = head;
+    head = -1;
+    while(index >= 0) {
+      const int next = m_entries[index].next;
+      place(index); // Lands on a lower level: closer than one turn of this one now
+      index = next;
+    }
+  }
+}
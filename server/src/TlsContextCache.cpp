@@ -0,0 +1,29 @@
+#include "../include/TlsContextCache.h"
+
+#include <QMutexLocker>
+
+#ifdef SYNERGY_TLS_SHARED_CONTEXT
+#include <QtNetwork/private/qsslsocket_p.h>
+#endif
+
+void TlsContextCache::apply(QSslSocket *socket) const {
+#ifdef SYNERGY_TLS_SHARED_CONTEXT
+  std::shared_ptr<QSslContext> context;
+  {
+    QMutexLocker lock(&m_mutex);
+    context = m_context;
+  }
+  if(context) QSslSocketPrivate::checkSettingSslContext(socket, std::move(context));
+#else
+  Q_UNUSED(socket);
+#endif
+}
+
+void TlsContextCache::adopt(QSslSocket *socket){
+#ifdef SYNERGY_TLS_SHARED_CONTEXT
+  QMutexLocker lock(&m_mutex);
+  if(!m_context) m_context = QSslSocketPrivate::sslContext(socket);
+#else
+  Q_UNUSED(socket);
+#endif
+}
@@ -0,0 +1,168 @@
+#include "../include/WorkspaceArchive.h"
+
+#include <QDir>
+#include <QDebug>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+  // Largest value of the 12 byte size field: 11 octal digits, 8 GiB - 1
+  constexpr qint64 c_maxUstarSize = 077777777777;
+
+  // Octal number, zero padded, NUL terminated, into a fixed-size header field
+  void writeOctal(char *field, int width, qint64 value){
+    const QByteArray digits = QByteArray::number(value, 8).rightJustified(width - 1, '0');
+    Q_ASSERT_X(digits.size() == width - 1, "writeOctal", "value doesn't fit the field");
+    std::memcpy(field, digits.constData(), width - 1);
+    field[width - 1] = '\0';
+  }
+
+  // pax record "<length> path=<value>\n", length counts its own digits
+  QByteArray paxRecord(const QByteArray &key, const QByteArray &value){
+    const qsizetype body = 1 + key.size() + 1 + value.size() + 1; // ' ' key '=' value '\n'
+    qsizetype length = body + 1;
+    while(QByteArray::number(length).size() + body != length) ++length;
+    return QByteArray::number(length) + ' ' + key + '=' + value + '\n';
+  }
+}
+
+WorkspaceArchive::WorkspaceArchive(QString rootPath, QList<Entry> entries) :
+  m_rootPath(std::move(rootPath)),
+  m_entries(std::move(entries)) {
+  for(const Entry &entry : std::as_const(m_entries)) {
+    const qint64 content = entry.isDirectory ? 0 : entry.size;
+    m_totalSize += headersFor(entry).size() + content + paddingFor(content);
+  }
+  m_totalSize += 2 * c_blockSize; // End of archive
+  open(QIODevice::ReadOnly);
+}
+
+QByteArray WorkspaceArchive::headerBlock(const QByteArray &name, const QByteArray &prefix, qint64 size, qint64 modified, char type){
+  char header[c_blockSize];
+  std::memset(header, 0, sizeof(header));
+
+  std::memcpy(header, name.constData(), std::min<qsizetype>(name.size(), 100));
+  writeOctal(header + 100, 8, type == '5' ? 0755 : 0644);
+  writeOctal(header + 108, 8, 0);    // uid
+  writeOctal(header + 116, 8, 0);    // gid
+  writeOctal(header + 124, 12, size);
+  writeOctal(header + 136, 12, modified);
+  std::memset(header + 148, ' ', 8); // Checksum is computed with its own field as spaces
+  header[156] = type;
+  std::memcpy(header + 257, "ustar", 6);
+  std::memcpy(header + 263, "00", 2);
+  std::memcpy(header + 345, prefix.constData(), std::min<qsizetype>(prefix.size(), 155));
+
+  unsigned int checksum = 0;
+  for(unsigned char byte : header) checksum += byte;
+  writeOctal(header + 148, 7, checksum);
+  header[155] = ' ';
+  return QByteArray(header, c_blockSize);
+}
+
+/*
+ustar fits 100 bytes of name + 155 bytes of prefix split at a '/', and sizes
+below 8 GiB. Anything longer or bigger is preceded by a pax extended header
+carrying the full path / exact size, readers (Docker included) use those
+instead of the truncated ustar name and the zero in its size field.
+*/
+QByteArray WorkspaceArchive::headersFor(const Entry &entry){
+  const QByteArray path = entry.relativePath.toUtf8() + (entry.isDirectory ? "/" : "");
+  const qint64 size = entry.isDirectory ? 0 : entry.size;
+  const char type = entry.isDirectory ? '5' : '0';
+
+  QByteArray records;
+  QByteArray name = path;
+  QByteArray prefix;
+  if(path.size() > 100) {
+    // Trailing '/' of a directory name can't be the split point
+    const qsizetype cut = path.lastIndexOf('/', std::min<qsizetype>(155, path.size() - 2));
+    if(cut > 0 && path.size() - cut - 1 <= 100) {
+      name = path.mid(cut + 1);
+      prefix = path.left(cut);
+    } else {
+      records += paxRecord("path", path);
+      name = path.left(100);
+    }
+  }
+  const bool sizeFits = size <= c_maxUstarSize;
+  if(!sizeFits) records += paxRecord("size", QByteArray::number(size));
+
+  const QByteArray header = headerBlock(name, prefix, sizeFits ? size : 0, entry.modifiedSecs, type);
+  if(records.isEmpty()) return header;
+  QByteArray headers = headerBlock("PaxHeaders/" + path.right(80), QByteArray(), records.size(), entry.modifiedSecs, 'x');
+  headers += records;
+  headers += QByteArray(paddingFor(records.size()), '\0');
+  headers += header;
+  return headers;
+}
+
+void WorkspaceArchive::startEntry(const Entry &entry){
+  m_pending = headersFor(entry);
+  m_pendingOffset = 0;
+  m_currentPath = entry.relativePath;
+  m_fileRemaining = entry.isDirectory ? 0 : entry.size;
+  m_padding = paddingFor(m_fileRemaining);
+  if(m_fileRemaining > 0) {
+    m_file.setFileName(QDir(m_rootPath).filePath(entry.relativePath));
+    if(!m_file.open(QIODevice::ReadOnly)) {
+      qWarning() << "WORKSPACE ARCHIVE | Could not open" << m_file.fileName() << ", sending zeros";
+      m_incomplete.insert(entry.relativePath);
+    }
+  }
+}
+
+qint64 WorkspaceArchive::readData(char *data, qint64 maxSize){
+  qint64 produced = 0;
+  while(produced < maxSize) {
+    const qint64 room = maxSize - produced;
+
+    if(m_pendingOffset < m_pending.size()) {
+      const qint64 take = std::min<qint64>(room, m_pending.size() - m_pendingOffset);
+      std::memcpy(data + produced, m_pending.constData() + m_pendingOffset, take);
+      m_pendingOffset += take;
+      produced += take;
+      continue;
+    }
+    if(m_fileRemaining > 0) {
+      const qint64 want = std::min(room, m_fileRemaining);
+      qint64 got = m_file.isOpen() ? m_file.read(data + produced, want) : -1;
+      if(got <= 0) {
+        // File shrank (or is unreadable): keep archive consistent with announced size
+        if(m_file.isOpen()) m_incomplete.insert(m_currentPath);
+        m_file.close();
+        std::memset(data + produced, 0, want);
+        got = want;
+      }
+      produced += got;
+      m_fileRemaining -= got;
+      if(m_fileRemaining == 0 && m_file.isOpen()) {
+        if(!m_file.atEnd()) m_incomplete.insert(m_currentPath); // Grew since scan, rest is cut off
+        m_file.close();
+      }
+      continue;
+    }
+    if(m_padding > 0) {
+      const qint64 take = std::min(room, m_padding);
+      std::memset(data + produced, 0, take);
+      m_padding -= take;
+      produced += take;
+      continue;
+    }
+    if(m_nextEntry < m_entries.size()) {
+      startEntry(m_entries[m_nextEntry++]);
+      continue;
+    }
+    if(!m_trailerQueued) {
+      m_trailerQueued = true;
+      m_pending = QByteArray(2 * c_blockSize, '\0');
+      m_pendingOffset = 0;
+      continue;
+    }
+    break;
+  }
+  m_produced += produced;
+  return produced > 0 ? produced : -1;
+}
@@ -0,0 +1,296 @@
+#include "../include/WorkspaceIndex.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QDebug>
+
+#include <algorithm>
+#include <utility>
+
+#include <sys/stat.h>
+
+namespace {
+  constexpr QDir::Filters c_entryFilters = QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::NoSymLinks;
+
+  // Temp files of PersistenceEngine exist only for the duration of a save
+  bool isIgnored(const QFileInfo &info){
+    return info.fileName().endsWith(QLatin1String(".synergy-tmp"));
+  }
+}
+
+WorkspaceIndex::WorkspaceIndex(const QString &rootPath, QObject *parent) :
+  QObject(parent),
+  m_rootPath(QDir(rootPath).absolutePath()) {
+  m_settleTimer.setSingleShot(true);
+  m_settleTimer.setInterval(c_settleMs);
+  connect(&m_settleTimer, &QTimer::timeout, this, &WorkspaceIndex::processPendingDirectories);
+  connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &WorkspaceIndex::onDirectoryChanged);
+  scanAll();
+}
+
+// Only full walk of the workspace, done once
+void WorkspaceIndex::scanAll(){
+  QStringList directories {m_rootPath};
+  QDirIterator iterator(m_rootPath, c_entryFilters, QDirIterator::Subdirectories);
+  while(iterator.hasNext()) {
+    iterator.next();
+    const QFileInfo info = iterator.fileInfo();
+    if(isIgnored(info)) continue;
+    m_entries.insert_or_assign(relativePath(info.absoluteFilePath()), entryFor(info));
+    if(info.isDir()) {
+      directories.append(info.absoluteFilePath());
+    }
+  }
+  const QStringList failed = m_watcher.addPaths(directories);
+  if(!failed.isEmpty()) {
+    qWarning() << "WORKSPACE INDEX | Could not watch" << failed.size() << "directories (inotify watch limit?), changes there won't be seen";
+  }
+  qInfo() << "WORKSPACE INDEX | Indexed" << m_entries.size() << "entries under" << m_rootPath;
+}
+
+void WorkspaceIndex::onDirectoryChanged(const QString &path){
+  m_pendingDirectories.insert(relativePath(path));
+  m_settleTimer.start(); // Restart, burst (e.g. git checkout) becomes one diff
+}
+
+void WorkspaceIndex::processPendingDirectories(){
+  SynergyProtocol::FileTreeDiff diff;
+  // Parents first: directory removed or renamed by its parent's rescan is skipped below
+  QStringList pending = std::exchange(m_pendingDirectories, {}).values();
+  auto depth = [](const QString &path) { return path.isEmpty() ? -1 : path.count(QLatin1Char('/')); };
+  std::sort(pending.begin(), pending.end(), [&depth](const QString &left, const QString &right) {
+    return depth(left) < depth(right);
+  });
+  for(const QString &directory : pending) {
+    if(directory.isEmpty() || contains(directory)) {
+      rescanDirectory(directory, diff);
+    }
+  }
+  if(diff.isEmpty()) return;
+
+  m_tree.reset();
+  emit treeChanged(diff);
+}
+
+// Diff of one directory listing against its direct children in the index
+void WorkspaceIndex::rescanDirectory(const QString &relativeDirectory, SynergyProtocol::FileTreeDiff &diff){
+  const QFileInfoList listing = QDir(absolutePath(relativeDirectory)).entryInfoList(c_entryFilters);
+
+  EntryMap current;
+  for(const QFileInfo &info : listing) {
+    if(isIgnored(info)) continue;
+    current.insert_or_assign(childPath(relativeDirectory, info.fileName()), entryFor(info));
+  }
+
+  // Direct children currently in the index
+  QList<QString> removed;
+  const QString prefix = relativeDirectory.isEmpty() ? QString() : relativeDirectory + QLatin1Char('/');
+  for(auto it = m_entries.lower_bound(prefix); it != m_entries.end() && it->first.startsWith(prefix); ++it) {
+    if(it->first.indexOf(QLatin1Char('/'), prefix.size()) != -1) continue; // Deeper level
+    if(current.count(it->first) == 0) removed.append(it->first);
+  }
+  QList<QString> added;
+  for(const auto &[path, entry] : current) {
+    auto known = m_entries.find(path);
+    if(known == m_entries.end()) {
+      added.append(path);
+    } else if(known->second.isDirectory != entry.isDirectory
+              || (entry.isDirectory && known->second.inode != 0 && entry.inode != 0 && !isSameObject(known->second, entry))) {
+      removed.append(path); // Replaced by different type or another directory, report as remove + add
+      added.append(path);
+    } else if(!entry.isDirectory) {
+      known->second = entry; // Content change only, tree shape is the same
+    }
+  }
+
+  // Rename shows up as remove + add in the same directory, pair only what is provably the same object
+  for(auto removedIt = removed.begin(); removedIt != removed.end();) {
+    const Entry old = m_entries.at(*removedIt);
+    auto match = std::find_if(added.begin(), added.end(), [&](const QString &path) {
+      const Entry &candidate = current[path];
+      if(candidate.isDirectory != old.isDirectory) return false;
+      if(isSameObject(old, candidate)) return true;
+      // Directory without proof is walked as new, pairing two unrelated ones would report a wrong subtree
+      const bool unknown = old.inode == 0 || candidate.inode == 0;
+      return !old.isDirectory && unknown && candidate.size == old.size && candidate.modified == old.modified;
+    });
+    if(match == added.end() || *match == *removedIt) {
+      ++removedIt;
+      continue;
+    }
+    const QString from = *removedIt;
+    const QString to = *match;
+    if(old.isDirectory) {
+      // Move subtree under new name without touching the disk again
+      EntryMap moved;
+      const QString fromPrefix = from + QLatin1Char('/');
+      for(auto it = m_entries.lower_bound(fromPrefix); it != m_entries.end() && it->first.startsWith(fromPrefix); ++it) {
+        moved.insert_or_assign(to + it->first.mid(from.size()), it->second);
+      }
+      removeSubtree(from);
+      for(const auto &[path, entry] : moved) {
+        m_entries.insert_or_assign(path, entry);
+        if(entry.isDirectory) m_watcher.addPath(absolutePath(path));
+      }
+      m_watcher.addPath(absolutePath(to));
+    } else {
+      m_entries.erase(from);
+    }
+    m_entries.insert_or_assign(to, current[to]);
+    diff.renamed.append(SynergyProtocol::FileTreeDiff::Rename{from, to});
+    added.erase(match);
+    removedIt = removed.erase(removedIt);
+  }
+
+  for(const QString &path : removed) {
+    removeSubtree(path);
+    diff.removed.append(path);
+  }
+  for(const QString &path : added) {
+    const Entry &entry = current[path];
+    m_entries.insert_or_assign(path, entry);
+    diff.added.append(SynergyProtocol::FileTreeDiff::Entry{path, entry.isDirectory});
+    if(entry.isDirectory) {
+      m_watcher.addPath(absolutePath(path));
+      addSubtree(path, diff); // New directory may arrive with content (mv, unzip)
+    }
+  }
+}
+
+void WorkspaceIndex::addSubtree(const QString &relativeDirectory, SynergyProtocol::FileTreeDiff &diff){
+  QDirIterator iterator(absolutePath(relativeDirectory), c_entryFilters, QDirIterator::Subdirectories);
+  while(iterator.hasNext()) {
+    iterator.next();
+    const QFileInfo info = iterator.fileInfo();
+    if(isIgnored(info)) continue;
+    const QString path = relativePath(info.absoluteFilePath());
+    m_entries.insert_or_assign(path, entryFor(info));
+    diff.added.append(SynergyProtocol::FileTreeDiff::Entry{path, info.isDir()});
+    if(info.isDir()) {
+      m_watcher.addPath(info.absoluteFilePath());
+    }
+  }
+}
+
+void WorkspaceIndex::removeSubtree(const QString &relativePath){
+  auto entry = m_entries.find(relativePath);
+  if(entry == m_entries.end()) return;
+  if(entry->second.isDirectory) {
+    m_watcher.removePath(absolutePath(relativePath));
+    const QString prefix = relativePath + QLatin1Char('/');
+    auto it = m_entries.lower_bound(prefix);
+    while(it != m_entries.end() && it->first.startsWith(prefix)) {
+      if(it->second.isDirectory) m_watcher.removePath(absolutePath(it->first));
+      it = m_entries.erase(it);
+    }
+  }
+  m_entries.erase(relativePath);
+}
+
+/*
+Nested tree from the path map. Whole subtree of a directory follows it
+directly (PathLess), so one pass with a stack of open directories is enough.
+*/
+const QJsonObject& WorkspaceIndex::tree() const {
+  if(m_tree) return *m_tree;
+
+  struct OpenDirectory {
+    QString prefix; // "dir/sub/" ("" for root)
+    QJsonObject node;
+    QJsonArray children;
+  };
+  auto close = [](OpenDirectory &directory) {
+    directory.node.insert("children", directory.children);
+    return directory.node;
+  };
+
+  QList<OpenDirectory> stack;
+  stack.append(OpenDirectory{QString(), QJsonObject{{"name", "/"}, {"type", "directory"}}, QJsonArray()});
+  for(const auto &[path, entry] : m_entries) {
+    while(!path.startsWith(stack.last().prefix)) {
+      OpenDirectory finished = stack.takeLast();
+      stack.last().children.append(close(finished));
+    }
+    const QString name = path.mid(stack.last().prefix.size());
+    if(entry.isDirectory) {
+      stack.append(OpenDirectory{path + QLatin1Char('/'), QJsonObject{{"name", name}, {"type", "directory"}}, QJsonArray()});
+    } else {
+      stack.last().children.append(QJsonObject{{"name", name}, {"type", "file"}});
+    }
+  }
+  while(stack.size() > 1) {
+    OpenDirectory finished = stack.takeLast();
+    stack.last().children.append(close(finished));
+  }
+  m_tree = close(stack.last());
+  return *m_tree;
+}
+
+bool WorkspaceIndex::PathLess::operator()(const QString &left, const QString &right) const {
+  const qsizetype length = std::min(left.size(), right.size());
+  for(qsizetype i = 0; i < length; ++i) {
+    const char16_t a = left.at(i).unicode();
+    const char16_t b = right.at(i).unicode();
+    if(a == b) continue;
+    if(a == u'/') return true;
+    if(b == u'/') return false;
+    return a < b;
+  }
+  return left.size() < right.size();
+}
+
+QString WorkspaceIndex::resolve(const QString &relativePath) const {
+  if(relativePath.isEmpty() || QDir::isAbsolutePath(relativePath) || relativePath.contains(QLatin1Char('\\'))) {
+    return QString();
+  }
+  const QString cleaned = QDir::cleanPath(relativePath);
+  if(cleaned == QLatin1String("..") || cleaned.startsWith(QLatin1String("../")) || cleaned == QLatin1String(".")) {
+    return QString();
+  }
+  // Symlinks are skipped by the index, don't let writes follow one either (file or any parent)
+  const QString absolute = absolutePath(cleaned);
+  if(QFileInfo(absolute).isSymLink()) {
+    return QString();
+  }
+  QFileInfo ancestor(QFileInfo(absolute).absolutePath());
+  while(!ancestor.exists() && ancestor.absoluteFilePath() != m_rootPath) {
+    ancestor = QFileInfo(ancestor.absolutePath());
+  }
+  const QString root = QFileInfo(m_rootPath).canonicalFilePath();
+  const QString resolvedParent = ancestor.canonicalFilePath();
+  if(resolvedParent != root && !resolvedParent.startsWith(root + QLatin1Char('/'))) {
+    return QString();
+  }
+  return absolute;
+}
+
+WorkspaceIndex::Entry WorkspaceIndex::entryFor(const QFileInfo &info){
+  Entry entry {info.isDir(), info.size(), info.lastModified()};
+  struct stat status;
+  if(::lstat(QFile::encodeName(info.absoluteFilePath()).constData(), &status) == 0) {
+    entry.device = quint64(status.st_dev);
+    entry.inode = quint64(status.st_ino);
+  }
+  return entry;
+}
+
+// Rename within one file system keeps inode and device
+bool WorkspaceIndex::isSameObject(const Entry &left, const Entry &right){
+  return left.inode != 0 && left.inode == right.inode && left.device == right.device;
+}
+
+QString WorkspaceIndex::relativePath(const QString &absolutePath) const {
+  const QString relative = QDir(m_rootPath).relativeFilePath(absolutePath);
+  return relative == QLatin1String(".") ? QString() : relative;
+}
+
+QString WorkspaceIndex::absolutePath(const QString &relativePath) const {
+  return relativePath.isEmpty() ? m_rootPath : m_rootPath + QLatin1Char('/') + relativePath;
+}
+
+QString WorkspaceIndex::childPath(const QString &directory, const QString &name){
+  return directory.isEmpty() ? name : directory + QLatin1Char('/') + name;
+}
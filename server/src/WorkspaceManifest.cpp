@@ -0,0 +1,88 @@
+#include "../include/WorkspaceManifest.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QCryptographicHash>
+#include <QDebug>
+
+#include <algorithm>
+
+WorkspaceManifest WorkspaceManifest::scan(const QString &rootPath, const WorkspaceManifest &previous){
+  WorkspaceManifest manifest;
+  const QDir root(rootPath);
+  QDirIterator iterator(rootPath, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+  while(iterator.hasNext()) {
+    iterator.next();
+    const QFileInfo info = iterator.fileInfo();
+    const QString name = info.fileName();
+    if(name.endsWith(QLatin1String(".synergy-tmp")) || name.contains(QLatin1Char('\n'))) continue;
+
+    const QString relativePath = root.relativeFilePath(info.absoluteFilePath());
+    if(info.isDir()) {
+      manifest.directories.insert(relativePath);
+      continue;
+    }
+    if(!info.isFile()) continue; // Sockets, fifos, devices
+
+    File file {info.size(), info.lastModified().toMSecsSinceEpoch(), QByteArray()};
+    const auto known = previous.files.constFind(relativePath);
+    if(known != previous.files.cend() && known->size == file.size && known->modifiedMs == file.modifiedMs && !known->hash.isEmpty()) {
+      file.hash = known->hash;
+    } else {
+      file.hash = hashFile(info.absoluteFilePath());
+      if(file.hash.isEmpty()) {
+        qWarning() << "WORKSPACE MANIFEST | Skipping unreadable file" << info.absoluteFilePath();
+        continue;
+      }
+    }
+    manifest.files.insert(relativePath, std::move(file));
+  }
+  return manifest;
+}
+
+/*
+- delete: files changed by earlier runs, files/directories the host doesn't have,
+  and entries whose type differs from the host (only topmost path of a deleted subtree)
+- upload: host files the container doesn't hold with the same content hash
+*/
+WorkspaceManifest::Changes WorkspaceManifest::changesFrom(const Listing &listing, const QHash<QString, QByteArray> &uploaded) const {
+  QSet<QString> candidates = listing.dirty;
+  for(const QString &path : listing.clean) {
+    if(!files.contains(path)) candidates.insert(path);
+  }
+  for(const QString &path : listing.directories) {
+    if(!directories.contains(path)) candidates.insert(path);
+  }
+
+  const auto deletedAbove = [&](const QString &path) {
+    for(qsizetype slash = path.lastIndexOf('/'); slash > 0; slash = path.lastIndexOf('/', slash - 1)) {
+      if(candidates.contains(path.left(slash))) return true;
+    }
+    return false;
+  };
+
+  Changes changes;
+  for(const QString &path : std::as_const(candidates)) {
+    if(!deletedAbove(path)) changes.deletions.append(path);
+  }
+  std::sort(changes.deletions.begin(), changes.deletions.end());
+
+  for(auto it = files.cbegin(); it != files.cend(); ++it) {
+    const bool present = listing.clean.contains(it.key()) && !candidates.contains(it.key()) && !deletedAbove(it.key());
+    if(!present || uploaded.value(it.key()) != it->hash) changes.files.insert(it.key());
+  }
+  for(const QString &path : directories) {
+    if(!listing.directories.contains(path) || candidates.contains(path) || deletedAbove(path)) changes.directories.insert(path);
+  }
+  return changes;
+}
+
+QByteArray WorkspaceManifest::hashFile(const QString &path){
+  QFile file(path);
+  if(!file.open(QIODevice::ReadOnly)) return QByteArray();
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  if(!hash.addData(&file)) return QByteArray(); // Reads in blocks, file isn't loaded whole
+  return hash.result();
+}
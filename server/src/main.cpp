@@ -3,15 +3,66 @@
 #include <QDebug>
 #include <QSslSocket>
 #include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
 #include <iostream>
 
 #include "../include/SslServer.h"
+#include "../include/MetricsEndpoint.h"
+#include "synergy_protocol/AsyncLog.h"
 
 constexpr quint16 _port = 10345;
 
+namespace {
+  /*
+  Runtime log levels (--logging-rules <file>, off unless given): the file
+  holds QLoggingCategory rules, e.g. 'synergy.payload.debug=true', and is
+  applied again whenever it changes. synergy.payload logs resume tokens
+  and document content, so a file other users can write is refused.
+  */
+  bool applyLoggingRules(const QString &path){
+    const QFileInfo info(path);
+    if(info.permissions() & (QFileDevice::WriteGroup | QFileDevice::WriteOther)) {
+      qWarning() << "LOGGING | Ignoring" << path << "- writable by other users";
+      return false;
+    }
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+      qWarning() << "LOGGING | Could not read" << path << file.errorString();
+      return false;
+    }
+    QLoggingCategory::setFilterRules(QString::fromUtf8(file.readAll()));
+    qInfo() << "LOGGING | Rules applied from" << path;
+    return true;
+  }
+}
+
 
 int main(int argc, char *argv[]){
   QCoreApplication a(argc, argv); 
+  // Log lines are written by a background thread from here on; declared first, so it is flushed last
+  SynergyProtocol::AsyncLog logging;
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Synergy Studio server");
+  parser.addHelpOption();
+  const QCommandLineOption loggingRulesOption("logging-rules", "QLoggingCategory rules file, re-read when it changes.", "file");
+  parser.addOption(loggingRulesOption);
+  parser.process(a);
+
+  QFileSystemWatcher loggingRulesWatcher;
+  if(parser.isSet(loggingRulesOption)) {
+    const QString rulesPath = QFileInfo(parser.value(loggingRulesOption)).absoluteFilePath();
+    applyLoggingRules(rulesPath);
+    loggingRulesWatcher.addPath(rulesPath);
+    QObject::connect(&loggingRulesWatcher, &QFileSystemWatcher::fileChanged, [&loggingRulesWatcher](const QString &path) {
+      applyLoggingRules(path);
+      // Editors save by replacing the file, which drops it from the watch
+      if(!loggingRulesWatcher.files().contains(path)) loggingRulesWatcher.addPath(path);
+    });
+  }
 
   qInfo() << "Synergy Studio - SSL Test";
   qInfo() << "Using Qt Version:" << QT_VERSION_STR;
@@ -43,6 +94,10 @@ int main(int argc, char *argv[]){
     return 1;
   }
 
+  // Loopback only, server runs without it if the port is taken
+  MetricsEndpoint metrics;
+  metrics.listen();
+
   qInfo() << "Starting event loop...";
   return a.exec(); // Start the Qt event loop
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef __EVENT_LOOP_WAIT_H__
+#define __EVENT_LOOP_WAIT_H__
+
+#include <QDeadlineTimer>
+#include <QEventLoop>
+#include <QTimer>
+
+#include <functional>
+
+// Runs the event loop until 'done' holds or 'timeoutMs' passed. False on timeout
+inline bool waitUntil(const std::function<bool()> &done, int timeoutMs = 5000){
+  QDeadlineTimer deadline(timeoutMs);
+  while(!done()) {
+    if(deadline.hasExpired()) return false;
+    QEventLoop loop;
+    QTimer::singleShot(5, &loop, &QEventLoop::quit);
+    loop.exec();
+  }
+  return true;
+}
+
+// Runs the event loop for 'ms', for checking that something does NOT happen
+inline void spinFor(int ms){
+  waitUntil([]() { return false; }, ms);
+}
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef __FAKE_DOCKER_DAEMON_H__
+#define __FAKE_DOCKER_DAEMON_H__
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSet>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <functional>
+
+#include "EventLoopWait.h"
+
+/*
+Stand-in for the Docker Engine API on a Unix socket, speaking the HTTP
+subset DockerApiClient uses: one request per connection, Content-Length
+bodies, exec output as a raw stream until close. Containers are just
+ids; what an exec prints and returns comes from 'onExec'.
+*/
+class FakeDockerDaemon {
+public:
+  struct Request {
+    QByteArray method;
+    QString path; // Without the API version, query included
+    QByteArray body;
+  };
+
+  struct ExecReply {
+    QByteArray output;  // Sent as one stdout frame
+    int exitCode = 0;
+    bool hang = false;  // Stream stays open until the client gives up
+  };
+
+  std::function<ExecReply(const QStringList &command)> onExec = [](const QStringList&) { return ExecReply(); };
+  int failCreations = 0; // That many next creates fail with 500
+
+  FakeDockerDaemon(){
+    m_server.listen(m_dir.filePath(QStringLiteral("docker.sock")));
+    QObject::connect(&m_server, &QLocalServer::newConnection, [this]() {
+      while(QLocalSocket *socket = m_server.nextPendingConnection()) {
+        QObject::connect(socket, &QLocalSocket::readyRead, socket, [this, socket]() { onReadyRead(socket); });
+        QObject::connect(socket, &QLocalSocket::disconnected, socket, [this, socket]() {
+          m_buffers.remove(socket);
+          socket->deleteLater();
+        });
+      }
+    });
+  }
+
+  QString socketPath() const { return m_server.fullServerName(); }
+  bool isListening() const { return m_server.isListening(); }
+  const QList<Request>& requests() const { return m_requests; }
+  const QList<QStringList>& execCommands() const { return m_execCommands; }
+  bool isRunning(const QString &containerId) const { return m_containers.contains(containerId); }
+
+  int count(const QByteArray &method, const QString &pathPrefix) const {
+    int matches = 0;
+    for(const Request &request : m_requests) {
+      if(request.method == method && request.path.startsWith(pathPrefix)) ++matches;
+    }
+    return matches;
+  }
+
+  QList<Request> matching(const QByteArray &method, const QString &pathPrefix) const {
+    QList<Request> result;
+    for(const Request &request : m_requests) {
+      if(request.method == method && request.path.startsWith(pathPrefix)) result.append(request);
+    }
+    return result;
+  }
+
+private:
+  QTemporaryDir m_dir;
+  QLocalServer m_server;
+  QHash<QLocalSocket*, QByteArray> m_buffers;
+  QList<Request> m_requests;
+  QList<QStringList> m_execCommands;
+  QSet<QString> m_containers;            // Created and not removed
+  QHash<QString, QStringList> m_execs;   // Exec id -> command
+  QHash<QString, int> m_exitCodes;       // Exec id -> exit code, once started
+  int m_nextId = 1;
+
+  void onReadyRead(QLocalSocket *socket){
+    QByteArray &buffer = m_buffers[socket];
+    buffer += socket->readAll();
+    const qsizetype headEnd = buffer.indexOf("\r\n\r\n");
+    if(headEnd < 0) return;
+
+    const QList<QByteArray> lines = buffer.left(headEnd).split('\n');
+    qint64 length = 0;
+    for(const QByteArray &line : lines) {
+      if(line.toLower().startsWith("content-length:")) length = line.mid(15).trimmed().toLongLong();
+    }
+    if(buffer.size() - headEnd - 4 < length) return; // Body still arriving
+
+    const QList<QByteArray> requestLine = lines.front().trimmed().split(' ');
+    Request request;
+    request.method = requestLine.value(0);
+    request.path = QString::fromUtf8(requestLine.value(1)).mid(QByteArray("/v1.41").size());
+    request.body = buffer.mid(headEnd + 4, length);
+    m_buffers.remove(socket);
+    m_requests.append(request);
+    handle(socket, request);
+  }
+
+  static void reply(QLocalSocket *socket, int status, const QByteArray &body = QByteArray()){
+    socket->write("HTTP/1.1 " + QByteArray::number(status) + " Fake\r\nContent-Type: application/json\r\nContent-Length: "
+                  + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+    socket->disconnectFromServer();
+  }
+
+  static QByteArray json(const QJsonObject &object){
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+  }
+
+  void handle(QLocalSocket *socket, const Request &request){
+    const QString path = request.path.section(QLatin1Char('?'), 0, 0);
+    const QStringList parts = path.split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    const QString id = parts.value(1);
+    const QString action = parts.value(2);
+
+    if(request.method == "POST" && path == QLatin1StringView("/containers/create")) {
+      if(failCreations > 0) {
+        --failCreations;
+        reply(socket, 500, json({{"message", "no such image"}}));
+        return;
+      }
+      const QString created = QStringLiteral("container%1").arg(m_nextId++);
+      m_containers.insert(created);
+      reply(socket, 201, json({{"Id", created}}));
+    } else if(request.method == "GET" && path == QLatin1StringView("/containers/json")) {
+      reply(socket, 200, "[]");
+    } else if(request.method == "POST" && parts.value(0) == QLatin1StringView("containers") && action == QLatin1StringView("start")) {
+      reply(socket, 204);
+    } else if(request.method == "DELETE" && parts.value(0) == QLatin1StringView("containers")) {
+      m_containers.remove(id);
+      reply(socket, 204);
+    } else if(request.method == "GET" && parts.value(0) == QLatin1StringView("containers") && action == QLatin1StringView("json")) {
+      reply(socket, 200, json({{"State", QJsonObject{{"Running", m_containers.contains(id)}}}}));
+    } else if(request.method == "PUT" && action == QLatin1StringView("archive")) {
+      reply(socket, 200);
+    } else if(request.method == "POST" && action == QLatin1StringView("exec")) {
+      QStringList command;
+      for(const QJsonValue &argument : QJsonDocument::fromJson(request.body).object().value("Cmd").toArray()) {
+        command.append(argument.toString());
+      }
+      const QString execId = QStringLiteral("exec%1").arg(m_nextId++);
+      m_execs.insert(execId, command);
+      m_execCommands.append(command);
+      reply(socket, 201, json({{"Id", execId}}));
+    } else if(request.method == "POST" && parts.value(0) == QLatin1StringView("exec") && action == QLatin1StringView("start")) {
+      const ExecReply result = onExec(m_execs.value(id));
+      m_exitCodes.insert(id, result.exitCode);
+      socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/vnd.docker.raw-stream\r\n\r\n");
+      if(!result.output.isEmpty()) {
+        // Stream header: type (1 = stdout), 3 zero bytes, big endian payload size
+        const quint32 size = static_cast<quint32>(result.output.size());
+        const char header[8] = {1, 0, 0, 0, char(size >> 24), char(size >> 16), char(size >> 8), char(size)};
+        socket->write(header, sizeof(header));
+        socket->write(result.output);
+      }
+      if(!result.hang) socket->disconnectFromServer();
+    } else if(request.method == "GET" && parts.value(0) == QLatin1StringView("exec") && action == QLatin1StringView("json")) {
+      reply(socket, 200, json({{"Running", false}, {"ExitCode", m_exitCodes.value(id, -1)}}));
+    } else {
+      reply(socket, 404, json({{"message", "no such route"}}));
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+#include "ContainerPool.h"
+#include "DockerApiClient.h"
+#include "FakeDockerDaemon.h"
+
+namespace {
+  ContainerPool::Config poolConfig(int warm, int max){
+    ContainerPool::Config config;
+    config.image = QStringLiteral("synergy-test:latest");
+    config.warmContainers = warm;
+    config.maxContainers = max;
+    config.healthCheckIntervalMs = 0;
+    return config;
+  }
+
+  struct Lease {
+    QString containerId;
+    QString error;
+    bool done = false;
+  };
+
+  ContainerPool::LeaseHandler into(Lease &lease){
+    return [&lease](const QString &containerId, const QString &error) {
+      lease = Lease{containerId, error, true};
+    };
+  }
+
+  bool isReset(const QStringList &command){
+    return command.value(0) == QLatin1StringView("sh") && command.value(2).contains(QLatin1StringView("kill -9 -1"));
+  }
+}
+
+TEST(ContainerPool, WarmsUpAndReusesReleasedContainerOfSameAffinity){
+  FakeDockerDaemon daemon;
+  ASSERT_TRUE(daemon.isListening());
+  DockerApiClient docker(daemon.socketPath());
+  ContainerPool pool(docker, poolConfig(1, 4));
+  pool.start();
+  ASSERT_TRUE(waitUntil([&]() { return pool.idleCount() == 1; }));
+
+  Lease first;
+  pool.lease(into(first), QStringLiteral("ws-a"));
+  ASSERT_TRUE(first.done); // Idle one goes out at once
+  ASSERT_TRUE(first.error.isEmpty());
+  ASSERT_TRUE(waitUntil([&]() { return pool.idleCount() == 1; })); // Warm one replaced
+
+  pool.release(first.containerId, true, QStringLiteral("ws-a"));
+  ASSERT_TRUE(waitUntil([&]() { return pool.idleCount() == 2; }));
+  ASSERT_FALSE(daemon.execCommands().isEmpty());
+  EXPECT_TRUE(isReset(daemon.execCommands().last()));
+
+  // Oldest idle is the replacement, affinity picks the one that already has ws-a
+  Lease second;
+  pool.lease(into(second), QStringLiteral("ws-a"));
+  ASSERT_TRUE(second.done);
+  EXPECT_EQ(second.containerId, first.containerId);
+  EXPECT_EQ(daemon.count("POST", "/containers/create"), 2);
+}
+
+TEST(ContainerPool, CreatesContainersWithReadOnlyRootAndWipesScratchOnReset){
+  FakeDockerDaemon daemon;
+  DockerApiClient docker(daemon.socketPath());
+  ContainerPool pool(docker, poolConfig(1, 1));
+  pool.start();
+  ASSERT_TRUE(waitUntil([&]() { return pool.idleCount() == 1; }));
+
+  const QJsonObject body = QJsonDocument::fromJson(daemon.matching("POST", "/containers/create").front().body).object();
+  const QJsonObject hostConfig = body.value("HostConfig").toObject();
+  EXPECT_TRUE(hostConfig.value("ReadonlyRootfs").toBool());
+  EXPECT_EQ(hostConfig.value("NetworkMode").toString(), QStringLiteral("none"));
+  for(const char *path : ContainerPool::c_scratchPaths) {
+    EXPECT_TRUE(hostConfig.value("Tmpfs").toObject().contains(QString::fromLatin1(path))) << path;
+  }
+  EXPECT_TRUE(body.value("Volumes").toObject().contains(QString::fromLatin1(ContainerPool::c_workspacePath)));
+
+  Lease lease;
+  pool.lease(into(lease));
+  ASSERT_TRUE(lease.done);
+  pool.release(lease.containerId, true);
+  ASSERT_TRUE(waitUntil([&]() { return pool.idleCount() == 1; }));
+  const QString reset = daemon.execCommands().last().value(2);
+  for(const char *path : ContainerPool::c_scratchPaths) {
+    EXPECT_TRUE(reset.contains(QString::fromLatin1(path))) << path;
+  }
+  EXPECT_TRUE(reset.contains(QLatin1StringView("/dev/shm")));
+}
+
+TEST(ContainerPool, RecyclesUnhealthyAndWornOutContainers){
+  FakeDockerDaemon daemon;
+  DockerApiClient docker(daemon.socketPath());
+  ContainerPool::Config config = poolConfig(0, 2);
+  config.maxRunsPerContainer = 2;
+  ContainerPool pool(docker, config);
+  QStringList removed;
+  QObject::connect(&pool, &ContainerPool::containerRemoved, [&](const QString &containerId) { removed.append(containerId); });
+  pool.start();
+
+  Lease broken;
+  pool.lease(into(broken));
+  ASSERT_TRUE(waitUntil([&]() { return broken.done; }));
+  pool.release(broken.containerId, false);
+  EXPECT_EQ(removed, QStringList {broken.containerId});
+  ASSERT_TRUE(waitUntil([&]() { return !daemon.isRunning(broken.containerId); }));
+
+  // Healthy runs reuse the container until it served maxRunsPerContainer of them
+  Lease run1;
+  pool.lease(into(run1));
+  ASSERT_TRUE(waitUntil([&]() { return run1.done; }));
+  ASSERT_NE(run1.containerId, broken.containerId);
+  pool.release(run1.containerId, true);
+  Lease run2;
+  pool.lease(into(run2));
+  ASSERT_TRUE(waitUntil([&]() { return run2.done; }));
+  EXPECT_EQ(run2.containerId, run1.containerId);
+  pool.release(run2.containerId, true);
+  EXPECT_EQ(removed.last(), run1.containerId);
+  ASSERT_TRUE(waitUntil([&]() { return !daemon.isRunning(run1.containerId); }));
+  EXPECT_EQ(pool.containerCount(), 0);
+}
+
+TEST(ContainerPool, NeverExceedsMaxContainersAndQueuesLeases){
+  FakeDockerDaemon daemon;
+  DockerApiClient docker(daemon.socketPath());
+  ContainerPool pool(docker, poolConfig(0, 2));
+  pool.start();
+
+  Lease a, b, c;
+  pool.lease(into(a));
+  pool.lease(into(b));
+  pool.lease(into(c));
+  ASSERT_TRUE(waitUntil([&]() { return a.done && b.done; }));
+  spinFor(100);
+  EXPECT_FALSE(c.done);
+  EXPECT_EQ(pool.containerCount(), 2);
+  EXPECT_EQ(daemon.count("POST", "/containers/create"), 2);
+
+  // Returned container serves the waiting lease after its reset
+  pool.release(a.containerId, true);
+  ASSERT_TRUE(waitUntil([&]() { return c.done; }));
+  EXPECT_EQ(c.containerId, a.containerId);
+  EXPECT_EQ(daemon.count("POST", "/containers/create"), 2);
+}
+
+TEST(ContainerPool, FailsWaitingLeasesAndBacksOffWhenCreationFails){
+  FakeDockerDaemon daemon;
+  daemon.failCreations = 1;
+  DockerApiClient docker(daemon.socketPath());
+  ContainerPool pool(docker, poolConfig(0, 1));
+  pool.start();
+
+  Lease failed;
+  pool.lease(into(failed));
+  ASSERT_TRUE(waitUntil([&]() { return failed.done; }));
+  EXPECT_TRUE(failed.containerId.isEmpty());
+  EXPECT_TRUE(failed.error.contains(QLatin1StringView("no such image")));
+  QElapsedTimer sinceFailure;
+  sinceFailure.start();
+
+  // Next attempt waits for the backoff (1 s after the first failure) instead of hitting the daemon again
+  Lease retried;
+  pool.lease(into(retried));
+  spinFor(200);
+  EXPECT_EQ(daemon.count("POST", "/containers/create"), 1);
+  ASSERT_TRUE(waitUntil([&]() { return retried.done; }, 5000));
+  EXPECT_TRUE(retried.error.isEmpty());
+  EXPECT_GE(sinceFailure.elapsed(), 800);
+  EXPECT_EQ(daemon.count("POST", "/containers/create"), 2);
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <QStringList>
+
+#include "DockerApiClient.h"
+#include "FakeDockerDaemon.h"
+
+namespace {
+  struct ExecResult {
+    int exitCode = 0;
+    QString error;
+    bool done = false;
+  };
+
+  DockerApiClient::ExecDoneHandler into(ExecResult &result){
+    return [&result](int exitCode, const QString &error) {
+      result = ExecResult{exitCode, error, true};
+    };
+  }
+
+  FakeDockerDaemon::ExecReply hanging(const QByteArray &output = QByteArray()){
+    FakeDockerDaemon::ExecReply reply;
+    reply.output = output;
+    reply.hang = true;
+    return reply;
+  }
+}
+
+TEST(DockerApiClient, RequestReportsStatusAndApiErrorMessage){
+  FakeDockerDaemon daemon;
+  daemon.failCreations = 1;
+  DockerApiClient docker(daemon.socketPath());
+
+  DockerApiClient::Response failed;
+  docker.post(QStringLiteral("/containers/create"), "{}", [&](const DockerApiClient::Response &response) { failed = response; });
+  ASSERT_TRUE(waitUntil([&]() { return failed.status != 0; }));
+  EXPECT_EQ(failed.status, 500);
+  EXPECT_EQ(failed.error, QStringLiteral("no such image"));
+
+  DockerApiClient::Response created;
+  docker.post(QStringLiteral("/containers/create"), "{}", [&](const DockerApiClient::Response &response) { created = response; });
+  ASSERT_TRUE(waitUntil([&]() { return created.status != 0; }));
+  EXPECT_TRUE(created.ok());
+  EXPECT_FALSE(created.json().object().value("Id").toString().isEmpty());
+}
+
+TEST(DockerApiClient, ExecStreamsOutputAndReportsExitCode){
+  FakeDockerDaemon daemon;
+  daemon.onExec = [](const QStringList &) { return FakeDockerDaemon::ExecReply{"hello", 7, false}; };
+  DockerApiClient docker(daemon.socketPath());
+
+  QByteArray output;
+  ExecResult result;
+  docker.exec(QStringLiteral("c1"), {"echo", "hello"}, QStringLiteral("/workspace"),
+              [&](const QByteArray &data) { output += data; }, into(result));
+  ASSERT_TRUE(waitUntil([&]() { return result.done; }));
+  EXPECT_TRUE(result.error.isEmpty()) << result.error.toStdString();
+  EXPECT_EQ(result.exitCode, 7);
+  EXPECT_EQ(output.size(), 8 + 5); // Raw stream: frame header + payload
+  EXPECT_TRUE(output.endsWith("hello"));
+  EXPECT_EQ(daemon.execCommands(), QList<QStringList> {QStringList {"echo", "hello"}});
+}
+
+TEST(DockerApiClient, ExecThatOutlivesItsTimeoutFails){
+  FakeDockerDaemon daemon;
+  daemon.onExec = [](const QStringList &) { return hanging("partial"); };
+  DockerApiClient docker(daemon.socketPath());
+
+  QByteArray output;
+  ExecResult result;
+  docker.exec(QStringLiteral("c1"), {"sleep", "60"}, QStringLiteral("/"),
+              [&](const QByteArray &data) { output += data; }, into(result), 200);
+  ASSERT_TRUE(waitUntil([&]() { return result.done; }));
+  EXPECT_EQ(result.exitCode, -1);
+  EXPECT_TRUE(result.error.contains(QLatin1StringView("timed out"))) << result.error.toStdString();
+  EXPECT_TRUE(output.endsWith("partial")); // Whatever came before the timeout was delivered
+  EXPECT_EQ(daemon.count("GET", "/exec/"), 0); // Never inspected
+}
+
+TEST(DockerApiClient, CancelledExecReportsTheReason){
+  FakeDockerDaemon daemon;
+  daemon.onExec = [](const QStringList &) { return hanging(); };
+  DockerApiClient docker(daemon.socketPath());
+
+  ExecResult result;
+  const auto handle = docker.exec(QStringLiteral("c1"), {"yes"}, QStringLiteral("/"), {}, into(result), 0);
+  ASSERT_TRUE(waitUntil([&]() { return daemon.count("POST", "/exec/") == 1 && handle->stream; }));
+  spinFor(50);
+  EXPECT_FALSE(result.done);
+
+  DockerApiClient::cancelExec(handle, QStringLiteral("stopped by test"));
+  ASSERT_TRUE(waitUntil([&]() { return result.done; }));
+  EXPECT_EQ(result.exitCode, -1);
+  EXPECT_TRUE(result.error.contains(QLatin1StringView("stopped by test"))) << result.error.toStdString();
+}
+
+TEST(DockerApiClient, ExecCancelledBeforeItStartedNeverStarts){
+  FakeDockerDaemon daemon;
+  DockerApiClient docker(daemon.socketPath());
+
+  ExecResult result;
+  const auto handle = docker.exec(QStringLiteral("c1"), {"true"}, QStringLiteral("/"), {}, into(result));
+  DockerApiClient::cancelExec(handle, QStringLiteral("session closed"));
+  ASSERT_TRUE(waitUntil([&]() { return result.done; }));
+  EXPECT_EQ(result.exitCode, -1);
+  EXPECT_EQ(result.error, QStringLiteral("session closed"));
+  EXPECT_EQ(daemon.count("POST", "/exec/"), 0);
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include "DockerExecutor.h"
+#include "FakeDockerDaemon.h"
+
+namespace {
+  DockerExecutor::Config executorConfig(const FakeDockerDaemon &daemon){
+    DockerExecutor::Config config;
+    config.socketPath = daemon.socketPath();
+    config.pool.image = QStringLiteral("synergy-test:latest");
+    config.pool.warmContainers = 0;
+    config.pool.maxContainers = 2;
+    config.pool.healthCheckIntervalMs = 0;
+    return config;
+  }
+
+  struct RunResult {
+    DockerExecutor::Result result;
+    QByteArray stdoutData;
+    bool done = false;
+  };
+
+  void runIn(DockerExecutor &executor, const QString &workspace, const QString &command, RunResult &run, qsizetype outputLimit = -1){
+    executor.run(workspace, command, {}, QString(),
+      [&run, outputLimit](DockerStreamDemuxer::t_Stream stream, QByteArrayView data) {
+        if(stream == DockerStreamDemuxer::t_Stream::STDOUT) run.stdoutData.append(data);
+        return outputLimit < 0 || run.stdoutData.size() < outputLimit;
+      },
+      [&run](const DockerExecutor::Result &result) {
+        run.result = result;
+        run.done = true;
+      });
+  }
+
+  // Workspace with one file, so the upload has something to carry
+  bool makeWorkspace(QTemporaryDir &dir){
+    QFile file(dir.filePath(QStringLiteral("main.py")));
+    if(!file.open(QIODevice::WriteOnly)) return false;
+    file.write("print('hi')\n");
+    return true;
+  }
+}
+
+TEST(DockerExecutor, UploadsWorkspaceRunsCommandAndStreamsOutput){
+  FakeDockerDaemon daemon;
+  daemon.onExec = [](const QStringList &command) {
+    if(command.value(0) == QLatin1StringView("run-me")) return FakeDockerDaemon::ExecReply{"hi\n", 3, false};
+    return FakeDockerDaemon::ExecReply();
+  };
+  QTemporaryDir workspace;
+  ASSERT_TRUE(makeWorkspace(workspace));
+  DockerExecutor executor(executorConfig(daemon));
+
+  RunResult run;
+  runIn(executor, workspace.path(), QStringLiteral("run-me"), run);
+  ASSERT_TRUE(waitUntil([&]() { return run.done; }));
+  EXPECT_TRUE(run.result.error.isEmpty()) << run.result.error.toStdString();
+  EXPECT_EQ(run.result.exitCode, 3);
+  EXPECT_EQ(run.stdoutData, QByteArray("hi\n"));
+
+  const QList<FakeDockerDaemon::Request> uploads = daemon.matching("PUT", "/containers/");
+  ASSERT_EQ(uploads.size(), 1);
+  EXPECT_TRUE(uploads.front().body.contains("print('hi')"));
+  EXPECT_EQ(daemon.count("DELETE", "/containers/"), 0); // Healthy container went back to the pool
+}
+
+TEST(DockerExecutor, RunPastItsTimeoutFailsAndRecyclesTheContainer){
+  FakeDockerDaemon daemon;
+  daemon.onExec = [](const QStringList &command) {
+    FakeDockerDaemon::ExecReply reply;
+    reply.hang = command.value(0) == QLatin1StringView("sleep");
+    return reply;
+  };
+  QTemporaryDir workspace;
+  ASSERT_TRUE(makeWorkspace(workspace));
+  DockerExecutor::Config config = executorConfig(daemon);
+  config.runTimeoutMs = 200;
+  DockerExecutor executor(config);
+
+  RunResult run;
+  runIn(executor, workspace.path(), QStringLiteral("sleep"), run);
+  ASSERT_TRUE(waitUntil([&]() { return run.done; }));
+  EXPECT_TRUE(run.result.error.contains(QLatin1StringView("timed out"))) << run.result.error.toStdString();
+  // Process may still run inside, the container must not be reused
+  ASSERT_TRUE(waitUntil([&]() { return daemon.count("DELETE", "/containers/") == 1; }));
+}
+
+TEST(DockerExecutor, OutputLimitCancelsTheExecAndRecyclesTheContainer){
+  FakeDockerDaemon daemon;
+  daemon.onExec = [](const QStringList &command) {
+    FakeDockerDaemon::ExecReply reply;
+    if(command.value(0) == QLatin1StringView("yes")) {
+      reply.output = QByteArray(4096, 'y');
+      reply.hang = true;
+    }
+    return reply;
+  };
+  QTemporaryDir workspace;
+  ASSERT_TRUE(makeWorkspace(workspace));
+  DockerExecutor executor(executorConfig(daemon));
+
+  RunResult run;
+  runIn(executor, workspace.path(), QStringLiteral("yes"), run, 1024);
+  ASSERT_TRUE(waitUntil([&]() { return run.done; }));
+  EXPECT_TRUE(run.result.error.contains(QLatin1StringView("output limit"))) << run.result.error.toStdString();
+  EXPECT_GE(run.stdoutData.size(), 1024);
+  ASSERT_TRUE(waitUntil([&]() { return daemon.count("DELETE", "/containers/") == 1; }));
+}
+
+TEST(DockerExecutor, UnknownEnvironmentFailsWithoutTouchingDocker){
+  FakeDockerDaemon daemon;
+  DockerExecutor executor(executorConfig(daemon));
+
+  DockerExecutor::Result result;
+  bool done = false;
+  executor.run(QStringLiteral("/nonexistent"), QStringLiteral("true"), {}, QStringLiteral("cobol"),
+    [](DockerStreamDemuxer::t_Stream, QByteArrayView) { return true; },
+    [&](const DockerExecutor::Result &r) { result = r; done = true; });
+  EXPECT_TRUE(done);
+  EXPECT_TRUE(result.error.contains(QLatin1StringView("cobol")));
+  spinFor(50);
+  EXPECT_TRUE(daemon.requests().isEmpty());
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <QByteArray>
+#include <QtEndian>
+
+#include <vector>
+
+#include "DockerStreamDemuxer.h"
+
+namespace {
+  using t_Stream = DockerStreamDemuxer::t_Stream;
+
+  QByteArray frame(quint8 stream, const QByteArray &payload){
+    QByteArray header(8, '\0');
+    header[0] = char(stream);
+    qToBigEndian<quint32>(quint32(payload.size()), header.data() + 4);
+    return header + payload;
+  }
+
+  struct Output {
+    QByteArray out;
+    QByteArray err;
+    int pieces = 0;
+  };
+
+  DockerStreamDemuxer::PayloadHandler collect(Output &output){
+    return [&output](t_Stream stream, QByteArrayView payload) {
+      (stream == t_Stream::STDERR ? output.err : output.out).append(payload);
+      ++output.pieces;
+    };
+  }
+}
+
+TEST(DockerStreamDemuxer, SplitsStdoutAndStderr){
+  DockerStreamDemuxer demuxer;
+  Output output;
+  demuxer.feed(frame(1, "hello ") + frame(2, "oops") + frame(1, "world"), collect(output));
+  EXPECT_EQ(output.out, QByteArray("hello world"));
+  EXPECT_EQ(output.err, QByteArray("oops"));
+  EXPECT_FALSE(demuxer.midFrame());
+}
+
+// Socket reads ignore frame boundaries, one byte at a time is the worst case
+TEST(DockerStreamDemuxer, HeadersAndPayloadsSplitAcrossReads){
+  const QByteArray stream = frame(2, "first") + frame(1, QByteArray(1000, 'x')) + frame(2, "last");
+  DockerStreamDemuxer demuxer;
+  Output output;
+  for(qsizetype i = 0; i < stream.size(); ++i) {
+    demuxer.feed(QByteArrayView(stream).sliced(i, 1), collect(output));
+  }
+  EXPECT_EQ(output.out, QByteArray(1000, 'x'));
+  EXPECT_EQ(output.err, QByteArray("firstlast"));
+  EXPECT_FALSE(demuxer.midFrame());
+}
+
+TEST(DockerStreamDemuxer, PayloadIsPassedOnWithoutWaitingForTheFrame){
+  const QByteArray whole = frame(1, "0123456789");
+  DockerStreamDemuxer demuxer;
+  Output output;
+  demuxer.feed(QByteArrayView(whole).first(8 + 4), collect(output));
+  EXPECT_EQ(output.out, QByteArray("0123"));
+  EXPECT_TRUE(demuxer.midFrame());
+  demuxer.feed(QByteArrayView(whole).sliced(8 + 4), collect(output));
+  EXPECT_EQ(output.out, QByteArray("0123456789"));
+  EXPECT_EQ(output.pieces, 2);
+  EXPECT_FALSE(demuxer.midFrame());
+}
+
+TEST(DockerStreamDemuxer, EmptyFramesAndCutOffHeaders){
+  DockerStreamDemuxer demuxer;
+  Output output;
+  demuxer.feed(frame(1, QByteArray()) + frame(1, "a"), collect(output));
+  EXPECT_EQ(output.out, QByteArray("a"));
+  EXPECT_EQ(output.pieces, 1);
+
+  demuxer.feed(frame(2, "b").first(5), collect(output));
+  EXPECT_TRUE(demuxer.midFrame()); // Connection cut inside a header
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <QByteArray>
+#include <QList>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "Metrics.h"
+
+namespace {
+  constexpr quint64 c_overflowStart = quint64(1) << (Metrics::c_maxExponent + 1);
+
+  // Value of the first line of the scrape starting with 'prefix'
+  QByteArray sampleOf(const QByteArray &text, const QByteArray &prefix){
+    for(const QByteArray &line : text.split('\n')) {
+      if(line.startsWith(prefix)) return line.mid(line.lastIndexOf(' ') + 1);
+    }
+    return QByteArray();
+  }
+
+  QByteArray quantileOf(const QByteArray &text, const char *histogram, const char *quantile){
+    return sampleOf(text, QByteArray("synergy_latency_quantile_seconds{histogram=\"") + histogram + "\",quantile=\"" + quantile + "\"}");
+  }
+
+  struct Bucket {
+    double le;
+    quint64 count;
+  };
+
+  QList<Bucket> cumulativeBuckets(const QByteArray &text, const QByteArray &name){
+    QList<Bucket> buckets;
+    const QByteArray prefix = name + "_bucket{le=\"";
+    for(const QByteArray &line : text.split('\n')) {
+      if(!line.startsWith(prefix)) continue;
+      const QByteArray le = line.mid(prefix.size(), line.indexOf('"', prefix.size()) - prefix.size());
+      const double bound = le == "+Inf" ? std::numeric_limits<double>::infinity() : le.toDouble();
+      buckets.append(Bucket{bound, line.mid(line.lastIndexOf(' ') + 1).toULongLong()});
+    }
+    return buckets;
+  }
+}
+
+TEST(Metrics, ValuesBelow16NanosecondsHaveABucketEach){
+  for(quint64 value = 0; value < 16; ++value) {
+    const int index = Metrics::bucketIndex(value);
+    EXPECT_EQ(index, int(value));
+    EXPECT_EQ(Metrics::bucketLowerBound(index), value);
+    EXPECT_EQ(Metrics::bucketUpperBound(index), value + 1);
+  }
+  // First log-linear octave still has width 1, the next one width 2
+  EXPECT_EQ(Metrics::bucketIndex(15), 15);
+  EXPECT_EQ(Metrics::bucketIndex(16), 16);
+  EXPECT_EQ(Metrics::bucketIndex(17), 17);
+  EXPECT_EQ(Metrics::bucketUpperBound(Metrics::bucketIndex(16)), 17u);
+  EXPECT_EQ(Metrics::bucketIndex(31), 31);
+  EXPECT_EQ(Metrics::bucketIndex(32), Metrics::bucketIndex(33));
+  EXPECT_EQ(Metrics::bucketLowerBound(Metrics::bucketIndex(33)), 32u);
+  EXPECT_EQ(Metrics::bucketUpperBound(Metrics::bucketIndex(33)), 34u);
+}
+
+TEST(Metrics, PowersOfTwoStartABucketOneSixteenthWide){
+  for(int exponent = Metrics::c_subBucketBits; exponent <= Metrics::c_maxExponent; ++exponent) {
+    const quint64 power = quint64(1) << exponent;
+    const int index = Metrics::bucketIndex(power);
+    EXPECT_EQ(Metrics::bucketLowerBound(index), power) << exponent;
+    EXPECT_EQ(Metrics::bucketUpperBound(index), power + power / 16) << exponent;
+    EXPECT_EQ(Metrics::bucketIndex(power - 1), index - 1) << exponent;
+    EXPECT_EQ(Metrics::bucketUpperBound(index - 1), power) << exponent;
+  }
+}
+
+TEST(Metrics, ValuesFrom2Pow41NanosecondsShareTheOverflowBucket){
+  const int overflow = Metrics::c_bucketCount - 1;
+  EXPECT_EQ(Metrics::bucketIndex(c_overflowStart - 1), overflow - 1);
+  EXPECT_EQ(Metrics::bucketUpperBound(overflow - 1), c_overflowStart);
+  for(const quint64 value : {c_overflowStart, c_overflowStart + 1, c_overflowStart * 1000, std::numeric_limits<quint64>::max()}) {
+    EXPECT_EQ(Metrics::bucketIndex(value), overflow) << value;
+  }
+  EXPECT_EQ(Metrics::bucketLowerBound(overflow), c_overflowStart);
+  EXPECT_EQ(Metrics::bucketUpperBound(overflow), std::numeric_limits<quint64>::max());
+}
+
+TEST(Metrics, BucketsTileTheRangeAndHoldTheirValues){
+  for(int index = 0; index + 1 < Metrics::c_bucketCount; ++index) {
+    ASSERT_EQ(Metrics::bucketUpperBound(index), Metrics::bucketLowerBound(index + 1)) << index;
+    const quint64 width = Metrics::bucketUpperBound(index) - Metrics::bucketLowerBound(index);
+    EXPECT_LE(width * 16, std::max<quint64>(16, Metrics::bucketLowerBound(index))) << index; // Within 6.25%
+  }
+  for(double value = 1; value < double(c_overflowStart); value *= 1.013) {
+    for(const quint64 probe : {quint64(value) - 1, quint64(value), quint64(value) + 1}) {
+      const int index = Metrics::bucketIndex(probe);
+      ASSERT_GE(index, 0);
+      ASSERT_LT(index, Metrics::c_bucketCount - 1);
+      EXPECT_LE(Metrics::bucketLowerBound(index), probe);
+      EXPECT_LT(probe, Metrics::bucketUpperBound(index));
+    }
+  }
+}
+
+TEST(Metrics, QuantilesNeverReportLessThanTheRecordedValue){
+  std::vector<quint64> values;
+  for(quint64 i = 0; i < 1000; ++i) values.push_back(17 + i * i * 4099); // 17 ns .. ~4 s
+  for(const quint64 value : values) Metrics::record(Metrics::t_Histogram::PARSE, qint64(value));
+  std::sort(values.begin(), values.end());
+
+  const QByteArray text = Metrics::prometheusText();
+  for(const char *quantile : {"0.5", "0.9", "0.99", "0.999"}) {
+    const double q = QByteArray(quantile).toDouble();
+    const double actual = double(values[std::size_t(std::ceil(q * values.size())) - 1]);
+    const QByteArray sample = quantileOf(text, "parse", quantile);
+    ASSERT_FALSE(sample.isEmpty()) << quantile;
+    const double reported = sample.toDouble() * 1e9;
+    EXPECT_GE(reported, actual * (1 - 1e-8)) << quantile; // 9 significant digits in the text
+    EXPECT_LE(reported, actual * 1.0625 + 1) << quantile;
+  }
+}
+
+TEST(Metrics, QuantileOfAnOverflowValueIsInfinite){
+  Metrics::record(Metrics::t_Histogram::DISPATCH, qint64(c_overflowStart) + 5);
+  const QByteArray text = Metrics::prometheusText();
+  EXPECT_EQ(quantileOf(text, "dispatch", "0.5"), QByteArray("+Inf"));
+  EXPECT_EQ(sampleOf(text, "synergy_dispatch_seconds_bucket{le=\"100\"}"), QByteArray("0"));
+  EXPECT_EQ(sampleOf(text, "synergy_dispatch_seconds_bucket{le=\"+Inf\"}"), QByteArray("1"));
+}
+
+TEST(Metrics, CumulativeBucketsAreMonotonicAndEndAtTheCount){
+  std::vector<quint64> values;
+  for(double seconds = 2e-7; seconds < 300; seconds *= 1.37) values.push_back(quint64(seconds * 1e9));
+  values.push_back(quint64(1e9)); // Exactly on a bound
+  for(const quint64 value : values) Metrics::record(Metrics::t_Histogram::BROADCAST, qint64(value));
+
+  const QByteArray text = Metrics::prometheusText();
+  const QList<Bucket> buckets = cumulativeBuckets(text, "synergy_broadcast_seconds");
+  ASSERT_GE(buckets.size(), 2);
+  for(qsizetype i = 1; i < buckets.size(); ++i) {
+    EXPECT_LT(buckets[i - 1].le, buckets[i].le);
+    EXPECT_LE(buckets[i - 1].count, buckets[i].count);
+  }
+  EXPECT_TRUE(std::isinf(buckets.last().le));
+  EXPECT_EQ(buckets.last().count, values.size());
+  EXPECT_EQ(sampleOf(text, "synergy_broadcast_seconds_count "), QByteArray::number(quint64(values.size())));
+
+  // A bucket counts values up to its bound, never above; straddling fine buckets go to the next bound
+  for(const Bucket &bucket : buckets) {
+    if(std::isinf(bucket.le)) continue;
+    const double boundNs = bucket.le * 1e9;
+    const auto atMost = [&](double limit) { return quint64(std::count_if(values.begin(), values.end(), [&](quint64 v) { return double(v) <= limit; })); };
+    EXPECT_LE(bucket.count, atMost(boundNs)) << bucket.le;
+    EXPECT_GE(bucket.count, atMost(boundNs / 1.0625)) << bucket.le;
+  }
+}
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include <QStringList>
+
+#include "OutboundQueue.h"
+#include "synergy_protocol/Message_Draw_Command.h"
+#include "synergy_protocol/Message_File_Tree_Update.h"
+#include "synergy_protocol/Message_Ping.h"
+#include "synergy_protocol/Message_Text_Operation.h"
+
+namespace {
+  using t_Kind = FramePolicy::t_Kind;
+
+  // Small limits so a handful of 100 byte frames crosses them
+  OutboundQueue::Limits smallLimits(){
+    OutboundQueue::Limits limits;
+    limits.socketBudget = 100;
+    limits.lowWatermark = 300;
+    limits.highWatermark = 500;
+    limits.disconnectBytes = 1000;
+    return limits;
+  }
+
+  QByteArray frame(char tag, qsizetype size = 100){
+    return QByteArray(size, tag);
+  }
+
+  FramePolicy policy(t_Kind kind, const QString &key = QString(), quint64 token = 0){
+    FramePolicy result;
+    result.kind = kind;
+    result.key = key;
+    result.deliveryToken = token;
+    return result;
+  }
+
+  QByteArray drainTags(OutboundQueue &queue){
+    QByteArray tags;
+    while(!queue.isEmpty()) tags.append(queue.pop().front());
+    return tags;
+  }
+}
+
+TEST(OutboundQueue, KeepsOrderAndDeliveryTokens){
+  OutboundQueue queue(smallLimits());
+  EXPECT_TRUE(queue.push(frame('a'), policy(t_Kind::ESSENTIAL, QString(), 7), nullptr));
+  EXPECT_TRUE(queue.push(frame('b'), policy(t_Kind::DROPPABLE), nullptr));
+  EXPECT_EQ(queue.bytes(), 200);
+
+  quint64 token = 0;
+  EXPECT_EQ(queue.pop(&token), frame('a'));
+  EXPECT_EQ(token, 7u);
+  EXPECT_EQ(queue.pop(&token), frame('b'));
+  EXPECT_EQ(token, 0u);
+  EXPECT_TRUE(queue.isEmpty());
+  EXPECT_EQ(queue.bytes(), 0);
+}
+
+TEST(OutboundQueue, StateReplacesWaitingDeltasOfItsKey){
+  OutboundQueue queue(smallLimits());
+  const QString doc = FramePolicy::documentKey("a.txt");
+  queue.push(frame('1'), policy(t_Kind::DELTA, doc), nullptr);
+  queue.push(frame('x'), policy(t_Kind::DELTA, FramePolicy::documentKey("b.txt")), nullptr);
+  queue.push(frame('e'), policy(t_Kind::ESSENTIAL, doc), nullptr);
+  queue.push(frame('S'), policy(t_Kind::STATE, doc), nullptr);
+  EXPECT_EQ(drainTags(queue), QByteArray("xeS"));
+  EXPECT_EQ(queue.droppedFrames(), 1u);
+}
+
+TEST(OutboundQueue, FallingBehindDropsDroppablesAndResyncsDeltaKeysOnce){
+  OutboundQueue queue(smallLimits());
+  const QString doc = FramePolicy::documentKey("a.txt");
+  QStringList resynced;
+  const OutboundQueue::ResyncHandler resync = [&](const QString &key) { resynced.append(key); };
+
+  queue.push(frame('d'), policy(t_Kind::DROPPABLE), resync);
+  queue.push(frame('1'), policy(t_Kind::DELTA, doc), resync);
+  queue.push(frame('2'), policy(t_Kind::DELTA, doc), resync);
+  queue.push(frame('e'), policy(t_Kind::ESSENTIAL), resync);
+  queue.push(frame('f'), policy(t_Kind::ESSENTIAL), resync);
+  EXPECT_FALSE(queue.isBehind());
+  queue.push(frame('g'), policy(t_Kind::ESSENTIAL), resync); // 600 > high watermark
+  EXPECT_TRUE(queue.isBehind());
+  EXPECT_EQ(resynced, QStringList {doc});
+  EXPECT_EQ(queue.bytes(), 300);
+
+  // Behind: new droppables and deltas of the stale key are discarded, no second resync
+  queue.push(frame('D'), policy(t_Kind::DROPPABLE), resync);
+  queue.push(frame('3'), policy(t_Kind::DELTA, doc), resync);
+  EXPECT_EQ(resynced.size(), 1);
+  EXPECT_EQ(queue.bytes(), 300);
+
+  // STATE clears the stale mark, deltas after it flow again
+  queue.push(frame('S'), policy(t_Kind::STATE, doc), resync);
+  EXPECT_EQ(drainTags(queue), QByteArray("efgS"));
+  EXPECT_FALSE(queue.isBehind());
+  queue.push(frame('4'), policy(t_Kind::DELTA, doc), resync);
+  EXPECT_EQ(drainTags(queue), QByteArray("4"));
+}
+
+TEST(OutboundQueue, DeltaWhileBehindAfterAStateWaitsForTheSnapshotInsteadOfResyncing){
+  OutboundQueue queue(smallLimits());
+  const QString doc = FramePolicy::documentKey("a.txt");
+  int resyncs = 0;
+  const OutboundQueue::ResyncHandler resync = [&](const QString &) { ++resyncs; };
+
+  queue.push(frame('1'), policy(t_Kind::DELTA, doc), resync);
+  queue.push(frame('e', 500), policy(t_Kind::ESSENTIAL), resync);
+  ASSERT_TRUE(queue.isBehind());
+  ASSERT_EQ(resyncs, 1);
+
+  // Snapshot in two parts; deltas while it is in flight follow it, no second resync
+  FramePolicy first = policy(t_Kind::STATE, doc, 9);
+  first.partial = true;
+  queue.push(frame('S'), first, resync);
+  queue.push(frame('2'), policy(t_Kind::DELTA, doc), resync);
+  queue.push(frame('P'), policy(t_Kind::STATE_PART, doc, 9), resync);
+  queue.push(frame('3'), policy(t_Kind::DELTA, doc), resync);
+  EXPECT_EQ(resyncs, 1);
+  EXPECT_TRUE(queue.isBehind());
+  EXPECT_EQ(queue.bytes(), 900);
+
+  // Last part written: falling behind again drops the delta and needs a new snapshot
+  EXPECT_EQ(queue.pop(), frame('e', 500));
+  EXPECT_EQ(queue.pop(), frame('S'));
+  EXPECT_EQ(queue.pop(), frame('2'));
+  EXPECT_EQ(queue.pop(), frame('P'));
+  queue.push(frame('x', 500), policy(t_Kind::ESSENTIAL), resync);
+  ASSERT_TRUE(queue.isBehind());
+  EXPECT_EQ(resyncs, 2);
+  queue.push(frame('4'), policy(t_Kind::DELTA, doc), resync);
+  EXPECT_EQ(resyncs, 2);
+  EXPECT_EQ(drainTags(queue), QByteArray("x"));
+}
+
+TEST(OutboundQueue, NewerStateRemovesPartsOfAReplacedOneAndReportsTheirTokens){
+  OutboundQueue queue(smallLimits());
+  const QString doc = FramePolicy::documentKey("a.txt");
+  FramePolicy older = policy(t_Kind::STATE, doc, 1);
+  older.partial = true;
+  FramePolicy olderPart = policy(t_Kind::STATE_PART, doc, 1);
+  olderPart.partial = true;
+  queue.push(frame('S'), older, nullptr);
+  queue.push(frame('p'), olderPart, nullptr);
+  EXPECT_TRUE(queue.takeDiscardedTokens().isEmpty());
+
+  FramePolicy newer = policy(t_Kind::STATE, doc, 2);
+  newer.partial = true;
+  queue.push(frame('T'), newer, nullptr);
+  EXPECT_EQ(queue.takeDiscardedTokens(), QList<quint64>({1, 1}));
+
+  // Part of the replaced transfer posted meanwhile never enters the queue
+  queue.push(frame('q'), olderPart, nullptr);
+  queue.push(frame('P'), policy(t_Kind::STATE_PART, doc, 2), nullptr);
+  EXPECT_EQ(queue.takeDiscardedTokens(), QList<quint64>({1}));
+  EXPECT_EQ(drainTags(queue), QByteArray("TP"));
+  EXPECT_EQ(queue.droppedFrames(), 3u);
+}
+
+TEST(OutboundQueue, DeltasOfAStaleKeyWaitForItsStateAfterCatchingUp){
+  OutboundQueue queue(smallLimits());
+  const QString doc = FramePolicy::documentKey("a.txt");
+  int resyncs = 0;
+  const OutboundQueue::ResyncHandler resync = [&](const QString &) { ++resyncs; };
+
+  queue.push(frame('1'), policy(t_Kind::DELTA, doc), resync);
+  queue.push(frame('e', 500), policy(t_Kind::ESSENTIAL), resync);
+  ASSERT_TRUE(queue.isBehind());
+  drainTags(queue);
+  EXPECT_FALSE(queue.isBehind());
+
+  // Caught up, but the client still misses the dropped delta: nothing of that key until STATE
+  queue.push(frame('2'), policy(t_Kind::DELTA, doc), resync);
+  EXPECT_TRUE(queue.isEmpty());
+  EXPECT_EQ(resyncs, 1);
+}
+
+TEST(OutboundQueue, PushFailsPastDisconnectBytes){
+  OutboundQueue queue(smallLimits());
+  for(int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(queue.push(frame('e'), policy(t_Kind::ESSENTIAL), nullptr));
+  }
+  EXPECT_FALSE(queue.push(frame('e'), policy(t_Kind::ESSENTIAL), nullptr));
+}
+
+TEST(FramePolicy, FollowsMessageType){
+  EXPECT_EQ(FramePolicy::forMessage(SynergyProtocol::Message_Ping()).kind, t_Kind::ESSENTIAL);
+  EXPECT_EQ(FramePolicy::forMessage(SynergyProtocol::Message_Draw_Command()).kind, t_Kind::DROPPABLE);
+
+  const FramePolicy operation = FramePolicy::forMessage(SynergyProtocol::Message_Text_Operation(1, "src/a.cpp"));
+  EXPECT_EQ(operation.kind, t_Kind::DELTA);
+  EXPECT_EQ(operation.key, FramePolicy::documentKey("src/a.cpp"));
+
+  const FramePolicy tree = FramePolicy::forMessage(SynergyProtocol::Message_File_Tree_Update());
+  EXPECT_EQ(tree.kind, t_Kind::STATE);
+  EXPECT_EQ(tree.key, QString::fromLatin1(FramePolicy::c_fileTreeKey));
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include "PersistenceEngine.h"
+#include "EventLoopWait.h"
+
+namespace {
+  struct Saved {
+    quint64 revision;
+    bool ok;
+  };
+
+  QByteArray contentOf(const QString &path){
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+  }
+
+  QString temporaryPathFor(const QString &path){
+    const QFileInfo info(path);
+    return info.absolutePath() + QStringLiteral("/.") + info.fileName() + QStringLiteral(".synergy-tmp");
+  }
+}
+
+// Engine stays on the test thread: schedule() posts to it, the event loop runs the batches
+class PersistenceEngineTest : public ::testing::Test {
+protected:
+  static constexpr int c_windowMs = 50;
+
+  QTemporaryDir m_dir;
+  PersistenceEngine m_engine {c_windowMs};
+  QList<Saved> m_saves;
+
+  void SetUp() override {
+    ASSERT_TRUE(m_dir.isValid());
+    QObject::connect(&m_engine, &PersistenceEngine::persisted, [this](const QString &, const QString &, quint64 revision, bool ok) {
+      m_saves.append(Saved{revision, ok});
+    });
+  }
+
+  QString path(const QString &name) const { return m_dir.filePath(name); }
+
+  void schedule(const QString &name, const QString &text, quint64 revision){
+    m_engine.schedule(QStringLiteral("SESS_TEST"), name, path(name), TextRope(text), revision);
+  }
+};
+
+TEST_F(PersistenceEngineTest, CoalescesEditsWithinTheWindowIntoOneWrite){
+  schedule("a.txt", "a", 1);
+  schedule("a.txt", "ab", 2);
+  schedule("a.txt", "abc", 3);
+  ASSERT_TRUE(waitUntil([&]() { return !m_saves.isEmpty(); }));
+  spinFor(4 * c_windowMs);
+
+  ASSERT_EQ(m_saves.size(), 1);
+  EXPECT_EQ(m_saves.front().revision, 3u);
+  EXPECT_TRUE(m_saves.front().ok);
+  EXPECT_EQ(contentOf(path("a.txt")), QByteArray("abc"));
+}
+
+TEST_F(PersistenceEngineTest, ReplacesTheFileByRenameNotInPlace){
+  {
+    QFile old(path("a.txt"));
+    ASSERT_TRUE(old.open(QIODevice::WriteOnly));
+    old.write("old content");
+  }
+  QFile reader(path("a.txt"));
+  ASSERT_TRUE(reader.open(QIODevice::ReadOnly));
+
+  schedule("a.txt", QStringLiteral("new é"), 7);
+  ASSERT_TRUE(waitUntil([&]() { return !m_saves.isEmpty(); }));
+  EXPECT_TRUE(m_saves.front().ok);
+  EXPECT_EQ(contentOf(path("a.txt")), QStringLiteral("new é").toUtf8());
+  EXPECT_FALSE(QFileInfo::exists(temporaryPathFor(path("a.txt")))); // Renamed away, nothing left behind
+  // Handle opened before still sees the old file: it was replaced, never truncated and rewritten
+  EXPECT_EQ(reader.readAll(), QByteArray("old content"));
+}
+
+TEST_F(PersistenceEngineTest, RetriesAFailedWriteUntilItSucceeds){
+  // A directory where the temp file should go makes every write fail, even for root
+  ASSERT_TRUE(QDir().mkpath(temporaryPathFor(path("a.txt"))));
+  schedule("a.txt", "kept", 1);
+  ASSERT_TRUE(waitUntil([&]() { return !m_saves.isEmpty(); }));
+  EXPECT_FALSE(m_saves.front().ok);
+  EXPECT_FALSE(QFileInfo::exists(path("a.txt")));
+
+  ASSERT_TRUE(QDir(temporaryPathFor(path("a.txt"))).removeRecursively());
+  ASSERT_TRUE(waitUntil([&]() { return m_saves.last().ok; }));
+  EXPECT_EQ(m_saves.last().revision, 1u);
+  EXPECT_EQ(contentOf(path("a.txt")), QByteArray("kept"));
+}
+
+TEST_F(PersistenceEngineTest, NewerRevisionReplacesAPendingRetry){
+  ASSERT_TRUE(QDir().mkpath(temporaryPathFor(path("a.txt"))));
+  schedule("a.txt", "first", 1);
+  ASSERT_TRUE(waitUntil([&]() { return !m_saves.isEmpty(); }));
+  ASSERT_FALSE(m_saves.front().ok);
+
+  ASSERT_TRUE(QDir(temporaryPathFor(path("a.txt"))).removeRecursively());
+  schedule("a.txt", "second", 2);
+  ASSERT_TRUE(waitUntil([&]() { return m_saves.last().ok; }));
+  spinFor(8 * c_windowMs); // Longer than the first retry's backoff
+  EXPECT_EQ(m_saves.last().revision, 2u);
+  for(const Saved &save : std::as_const(m_saves)) {
+    EXPECT_FALSE(save.ok && save.revision == 1u) << "revision 1 written after revision 2 replaced it";
+  }
+  EXPECT_EQ(contentOf(path("a.txt")), QByteArray("second"));
+}
+
+TEST_F(PersistenceEngineTest, FlushWritesRetriesAtOnce){
+  ASSERT_TRUE(QDir().mkpath(temporaryPathFor(path("a.txt"))));
+  schedule("a.txt", "kept", 1);
+  ASSERT_TRUE(waitUntil([&]() { return !m_saves.isEmpty(); }));
+  ASSERT_TRUE(QDir(temporaryPathFor(path("a.txt"))).removeRecursively());
+
+  bool flushed = false;
+  m_engine.flushAsync(&m_engine, [&]() { flushed = true; });
+  ASSERT_TRUE(waitUntil([&]() { return flushed; }, c_windowMs)); // Backoff of the first retry is twice the window
+  EXPECT_TRUE(m_saves.last().ok);
+  EXPECT_EQ(contentOf(path("a.txt")), QByteArray("kept"));
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <QString>
+
+#include <algorithm>
+#include <utility>
+
+#include "RunOutputStream.h"
+#include "EventLoopWait.h"
+
+using t_Stream = RunOutputStream::t_Stream;
+
+namespace {
+  struct Chunk {
+    quint64 sequence;
+    t_Stream stream;
+    QString data;
+    bool truncated;
+  };
+
+  // Nothing leaves on its own unless a test shortens the interval
+  RunOutputStream::Limits manualLimits(){
+    RunOutputStream::Limits limits;
+    limits.flushIntervalMs = 60 * 1000;
+    return limits;
+  }
+
+  bool hasLoneSurrogate(const QString &text){
+    for(qsizetype i = 0; i < text.size(); ++i) {
+      if(text.at(i).isHighSurrogate() && (i + 1 == text.size() || !text.at(i + 1).isLowSurrogate())) return true;
+      if(text.at(i).isLowSurrogate() && (i == 0 || !text.at(i - 1).isHighSurrogate())) return true;
+    }
+    return false;
+  }
+}
+
+class RunOutputStreamTest : public ::testing::Test {
+protected:
+  QList<Chunk> m_chunks;
+
+  RunOutputStream::ChunkSink sink(){
+    return [this](const SynergyProtocol::Message_Run_Output_Chunk &chunk) {
+      m_chunks.append(Chunk{chunk.sequence(), chunk.stream(), chunk.data(), chunk.truncated()});
+    };
+  }
+
+  QString textOf(t_Stream stream) const {
+    QString text;
+    for(const Chunk &chunk : m_chunks) {
+      if(!chunk.truncated && chunk.stream == stream) text += chunk.data;
+    }
+    return text;
+  }
+
+  qsizetype markerCount() const {
+    return std::count_if(m_chunks.begin(), m_chunks.end(), [](const Chunk &chunk) { return chunk.truncated; });
+  }
+};
+
+TEST_F(RunOutputStreamTest, FullBufferDropsOutputBehindOneMarker){
+  RunOutputStream::Limits limits = manualLimits();
+  limits.maxPendingBytes = 100;
+  RunOutputStream output(QStringLiteral("RUN_1"), sink(), limits);
+
+  output.append(t_Stream::STDOUT, QByteArray(80, 'a'));
+  output.append(t_Stream::STDOUT, QByteArray(50, 'b')); // 20 fit
+  output.append(t_Stream::STDOUT, QByteArray(10, 'c')); // Nothing fits, same marker
+  EXPECT_EQ(output.droppedBytes(), 40);
+  EXPECT_FALSE(output.isCutOff());
+  EXPECT_TRUE(m_chunks.isEmpty());
+
+  output.finish();
+  ASSERT_EQ(m_chunks.size(), 2);
+  EXPECT_EQ(m_chunks[0].data, QString(80, u'a') + QString(20, u'b'));
+  EXPECT_TRUE(m_chunks[1].truncated);
+  EXPECT_EQ(m_chunks[1].stream, t_Stream::STDERR);
+  EXPECT_EQ(m_chunks[1].data, QStringLiteral("[40 bytes of output dropped]"));
+  EXPECT_EQ(m_chunks[0].sequence, 0u);
+  EXPECT_EQ(m_chunks[1].sequence, 1u);
+}
+
+TEST_F(RunOutputStreamTest, BufferTakesOutputAgainOnceFlushed){
+  RunOutputStream::Limits limits;
+  limits.flushIntervalMs = 5;
+  limits.maxPendingBytes = 100;
+  RunOutputStream output(QStringLiteral("RUN_1"), sink(), limits);
+
+  output.append(t_Stream::STDOUT, QByteArray(150, 'a'));
+  ASSERT_TRUE(waitUntil([&]() { return m_chunks.size() == 2; }));
+  EXPECT_TRUE(m_chunks[1].truncated);
+
+  output.append(t_Stream::STDOUT, "after");
+  output.finish();
+  ASSERT_EQ(m_chunks.size(), 3);
+  EXPECT_EQ(m_chunks[2].data, QStringLiteral("after"));
+  EXPECT_EQ(output.droppedBytes(), 50);
+}
+
+TEST_F(RunOutputStreamTest, TotalLimitCutsOffWithExactlyOneMarker){
+  RunOutputStream::Limits limits = manualLimits();
+  limits.maxTotalBytes = 100;
+  RunOutputStream output(QStringLiteral("RUN_2"), sink(), limits);
+
+  output.append(t_Stream::STDOUT, QByteArray(60, 'a'));
+  EXPECT_FALSE(output.isCutOff());
+  output.append(t_Stream::STDERR, QByteArray(60, 'b')); // 40 fit, limit reached
+  EXPECT_TRUE(output.isCutOff());
+  output.append(t_Stream::STDOUT, QByteArray(30, 'c'));  // Only counted
+  output.append(t_Stream::STDERR, QByteArray(30, 'd'));
+  EXPECT_EQ(output.droppedBytes(), 80);
+
+  output.finish();
+  EXPECT_EQ(textOf(t_Stream::STDOUT), QString(60, u'a'));
+  EXPECT_EQ(textOf(t_Stream::STDERR), QString(40, u'b'));
+  ASSERT_EQ(markerCount(), 1);
+  EXPECT_TRUE(m_chunks.last().truncated);
+  EXPECT_EQ(m_chunks.last().data, QStringLiteral("[output limit of 100 bytes reached, 20 bytes dropped]"));
+
+  output.append(t_Stream::STDOUT, "late");
+  output.finish();
+  EXPECT_EQ(markerCount(), 1);
+  EXPECT_EQ(output.droppedBytes(), 84);
+}
+
+TEST_F(RunOutputStreamTest, FlushBudgetSplitsTextBetweenSurrogatePairs){
+  RunOutputStream::Limits limits;
+  limits.flushIntervalMs = 1;
+  limits.maxBytesPerFlush = 10;
+  RunOutputStream output(QStringLiteral("RUN_3"), sink(), limits);
+
+  // 4 UTF-8 bytes, 2 UTF-16 units each: an even budget share lands inside a pair
+  const QString faces = QString::fromUtf8("😀").repeated(10);
+  output.append(t_Stream::STDOUT, faces.toUtf8());
+  ASSERT_TRUE(waitUntil([&]() { return textOf(t_Stream::STDOUT).size() == faces.size(); }));
+
+  EXPECT_GT(m_chunks.size(), 2);
+  for(const Chunk &chunk : std::as_const(m_chunks)) {
+    EXPECT_FALSE(chunk.data.isEmpty());
+    EXPECT_FALSE(hasLoneSurrogate(chunk.data)) << chunk.sequence;
+  }
+  EXPECT_EQ(textOf(t_Stream::STDOUT), faces);
+  for(qsizetype i = 0; i < m_chunks.size(); ++i) EXPECT_EQ(m_chunks[i].sequence, quint64(i));
+}
+
+TEST_F(RunOutputStreamTest, LongTextIsChunkedBetweenSurrogatePairs){
+  RunOutputStream::Limits limits = manualLimits();
+  limits.maxChunkChars = 3;
+  RunOutputStream output(QStringLiteral("RUN_3"), sink(), limits);
+
+  const QString text = QStringLiteral("x") + QString::fromUtf8("😀😀😀");
+  output.append(t_Stream::STDOUT, text.toUtf8());
+  output.finish();
+  ASSERT_EQ(m_chunks.size(), 3);
+  EXPECT_EQ(m_chunks[0].data, QStringLiteral("x") + QString::fromUtf8("😀"));
+  EXPECT_EQ(m_chunks[1].data, QString::fromUtf8("😀"));
+  EXPECT_EQ(m_chunks[2].data, QString::fromUtf8("😀"));
+}
+
+TEST_F(RunOutputStreamTest, DecodesUtf8SequencesSplitBetweenAppends){
+  RunOutputStream output(QStringLiteral("RUN_4"), sink(), manualLimits());
+
+  output.append(t_Stream::STDOUT, "caf\xC3");
+  output.append(t_Stream::STDOUT, "\xA9 ");
+  // Each stream has its own decoder, stderr in between doesn't disturb the pending euro sign
+  output.append(t_Stream::STDOUT, "\xE2\x82");
+  output.append(t_Stream::STDERR, "warn");
+  output.append(t_Stream::STDOUT, "\xAC");
+  output.finish();
+
+  EXPECT_EQ(textOf(t_Stream::STDOUT), QString::fromUtf8("café €"));
+  EXPECT_EQ(textOf(t_Stream::STDERR), QStringLiteral("warn"));
+  EXPECT_EQ(output.droppedBytes(), 0);
+  EXPECT_EQ(markerCount(), 0);
+}
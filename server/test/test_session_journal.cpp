@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <QStringList>
+
+#include "SessionJournal.h"
+
+using SynergyProtocol::t_WireFormat;
+
+namespace {
+  SessionJournal::Entry entry(quint64 sequence, const QByteArray &cbor, const QString &target = QString(), const QString &exclude = QString()){
+    SessionJournal::Entry result;
+    result.sequence = sequence;
+    result.frames[static_cast<std::size_t>(t_WireFormat::CBOR)] = cbor;
+    result.targetUserId = target;
+    result.excludeUserId = exclude;
+    return result;
+  }
+
+  // Appends frames "1".."count" with sequences 1..count
+  void fill(SessionJournal &journal, int count){
+    for(int i = 1; i <= count; ++i) {
+      journal.append(entry(journal.nextSequence(), QByteArray::number(i)));
+    }
+  }
+
+  QStringList replayed(const SessionJournal &journal, quint64 lastSequence, const QString &userId, bool *ok = nullptr){
+    QStringList frames;
+    const bool result = journal.replay(lastSequence, userId, t_WireFormat::CBOR, [&](const QByteArray &frame, const FramePolicy &) {
+      frames.append(QString::fromLatin1(frame));
+    });
+    if(ok) *ok = result;
+    return frames;
+  }
+}
+
+TEST(SessionJournal, ReplaysExactlyTheMissedFrames){
+  SessionJournal journal;
+  EXPECT_EQ(journal.nextSequence(), 1u);
+  fill(journal, 5);
+  EXPECT_EQ(journal.nextSequence(), 6u);
+
+  bool ok = false;
+  EXPECT_EQ(replayed(journal, 2, "alice", &ok), (QStringList {"3", "4", "5"}));
+  EXPECT_TRUE(ok);
+  EXPECT_TRUE(replayed(journal, 5, "alice", &ok).isEmpty()); // Nothing missed
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(replayed(journal, 0, "alice").size(), 5);
+}
+
+TEST(SessionJournal, RejectsSequencesNeverSent){
+  SessionJournal journal;
+  fill(journal, 3);
+  EXPECT_FALSE(journal.covers(3 + 1));
+  bool ok = true;
+  EXPECT_TRUE(replayed(journal, 10, "alice", &ok).isEmpty());
+  EXPECT_FALSE(ok);
+}
+
+TEST(SessionJournal, SkipsFramesMeantForSomeoneElse){
+  SessionJournal journal;
+  journal.append(entry(1, "all"));
+  journal.append(entry(2, "to-bob", "bob"));
+  journal.append(entry(3, "not-alice", QString(), "alice"));
+  journal.append(entry(4, "to-alice", "alice"));
+  EXPECT_EQ(replayed(journal, 0, "alice"), (QStringList {"all", "to-alice"}));
+  EXPECT_EQ(replayed(journal, 0, "bob"), (QStringList {"all", "to-bob", "not-alice"}));
+}
+
+TEST(SessionJournal, DropsOldestPastTheLimits){
+  SessionJournal::Limits limits;
+  limits.maxEntries = 3;
+  SessionJournal journal(limits);
+  fill(journal, 5);
+  EXPECT_FALSE(journal.covers(0));
+  EXPECT_FALSE(journal.covers(1));
+  EXPECT_TRUE(journal.covers(2));
+  EXPECT_EQ(replayed(journal, 2, "alice"), (QStringList {"3", "4", "5"}));
+
+  limits.maxEntries = 100;
+  limits.maxBytes = 10;
+  SessionJournal bytes(limits);
+  bytes.append(entry(1, QByteArray(6, 'a')));
+  bytes.append(entry(2, QByteArray(6, 'b')));
+  EXPECT_FALSE(bytes.covers(0));
+  EXPECT_TRUE(bytes.covers(1));
+  bytes.append(entry(3, QByteArray(50, 'c'))); // Alone over the limit, still kept
+  EXPECT_TRUE(bytes.covers(2));
+}
+
+// A partial replay would leave a hole the client never notices
+TEST(SessionJournal, DeliversNothingIfAFrameLacksTheFormat){
+  SessionJournal journal;
+  fill(journal, 2);
+  SessionJournal::Entry jsonOnly;
+  jsonOnly.sequence = journal.nextSequence();
+  jsonOnly.frames[static_cast<std::size_t>(t_WireFormat::JSON)] = "{}";
+  journal.append(jsonOnly);
+
+  bool ok = true;
+  EXPECT_TRUE(replayed(journal, 0, "alice", &ok).isEmpty());
+  EXPECT_FALSE(ok);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <QString>
+
+#include <algorithm>
+#include <random>
+
+#include "TextRope.h"
+
+namespace {
+  // Source-like text: 80 column lines
+  QString makeText(qsizetype size){
+    QString text(size, QLatin1Char('x'));
+    for(qsizetype i = 79; i < size; i += 80) {
+      text[i] = QLatin1Char('\n');
+    }
+    return text;
+  }
+
+  qsizetype smallestChunk(const TextRope &rope){
+    qsizetype smallest = TextRope::c_maxChunk;
+    rope.forEachChunk([&smallest](QStringView chunk) { smallest = std::min(smallest, chunk.size()); });
+    return smallest;
+  }
+}
+
+TEST(TextRope, BuildsFromTextInFullChunks){
+  const QString text = makeText(5 * TextRope::c_maxChunk + 10);
+  const TextRope rope(text);
+  EXPECT_EQ(rope.length(), text.size());
+  EXPECT_EQ(rope.toString(), text);
+  EXPECT_EQ(rope.chunkCount(), 6);
+  EXPECT_EQ(rope.lineCount(), text.count(QLatin1Char('\n')) + 1);
+  EXPECT_TRUE(TextRope().isEmpty());
+  EXPECT_EQ(TextRope().lineCount(), 1);
+}
+
+TEST(TextRope, EditsMatchQString){
+  QString expected = makeText(20 * 1024);
+  TextRope rope(expected);
+  std::minstd_rand random(7);
+  for(int i = 0; i < 5000; ++i) {
+    // Same amount in and out, so the size stays put
+    const QString text(qsizetype(random() % 40 + 1), QLatin1Char('a' + i % 26));
+    const qsizetype position = random() % (expected.size() + 1);
+    expected.insert(position, text);
+    rope.insert(position, text);
+    const qsizetype removeAt = random() % expected.size();
+    expected.remove(removeAt, text.size());
+    rope.remove(removeAt, text.size());
+  }
+  ASSERT_EQ(rope.toString(), expected);
+  EXPECT_EQ(rope.mid(1000, 500), expected.mid(1000, 500));
+  EXPECT_EQ(rope.at(4321), expected.at(4321));
+  EXPECT_EQ(rope.lineCount(), expected.count(QLatin1Char('\n')) + 1);
+}
+
+TEST(TextRope, LineIndexMatchesText){
+  const QString text = QStringLiteral("first\n\nthird line\nlast");
+  TextRope rope(text);
+  rope.insert(6, QStringLiteral("second\n"));
+  EXPECT_EQ(rope.lineCount(), 5);
+  EXPECT_EQ(rope.lineStart(0), 0);
+  EXPECT_EQ(rope.lineStart(1), 6);
+  EXPECT_EQ(rope.lineStart(2), 13);
+  EXPECT_EQ(rope.lineStart(4), 25);
+  EXPECT_EQ(rope.lineStart(5), -1);
+  EXPECT_EQ(rope.lineAt(0), 0);
+  EXPECT_EQ(rope.lineAt(12), 1);
+  EXPECT_EQ(rope.lineAt(13), 2);
+  EXPECT_EQ(rope.lineAt(rope.length()), 4);
+}
+
+TEST(TextRope, SnapshotIsUnaffectedByLaterEdits){
+  const QString text = makeText(10 * 1024);
+  TextRope rope(text);
+  const TextRope snapshot = rope.snapshot();
+  rope.remove(100, 5000);
+  rope.insert(3, QStringLiteral("changed"));
+  EXPECT_EQ(snapshot.toString(), text);
+  EXPECT_NE(rope.toString(), text);
+}
+
+// Keystrokes and single deletes all over a document used to split chunks until nodes held a few units each
+TEST(TextRope, ScatteredSmallEditsKeepChunksLarge){
+  const QString text = makeText(256 * 1024);
+  TextRope rope(text);
+  std::minstd_rand random(42);
+  for(int i = 0; i < 5000; ++i) {
+    rope.insert(random() % rope.length(), QStringLiteral("a"));
+    rope.remove(random() % rope.length(), 1);
+  }
+  ASSERT_EQ(rope.length(), text.size());
+  // Without merging every keystroke left a one unit chunk behind (tens of thousands of nodes)
+  EXPECT_LE(rope.chunkCount(), text.size() / TextRope::c_minChunk);
+}
+
+TEST(TextRope, DeletingBackwardsMergesTheRemainder){
+  TextRope rope(makeText(3 * TextRope::c_maxChunk));
+  ASSERT_EQ(rope.chunkCount(), 3);
+  // Backspace from the end of the middle chunk down to a few units
+  for(qsizetype position = 2 * TextRope::c_maxChunk - 1; position > TextRope::c_maxChunk + 3; --position) {
+    rope.remove(position, 1);
+  }
+  EXPECT_EQ(rope.length(), 2 * TextRope::c_maxChunk + 4);
+  EXPECT_EQ(rope.chunkCount(), 3); // Neighbours are full, the remainder stays on its own
+  // Once a neighbour has room, the short chunk goes into it
+  rope.remove(TextRope::c_maxChunk - TextRope::c_minChunk, TextRope::c_minChunk);
+  EXPECT_EQ(rope.chunkCount(), 2);
+  EXPECT_GE(smallestChunk(rope), TextRope::c_minChunk);
+}
+
+TEST(TextRope, InsertsNextToShortChunksJoinThem){
+  TextRope rope;
+  for(int i = 0; i < 500; ++i) {
+    rope.insert(rope.length() / 2, QStringLiteral("ab"));
+  }
+  EXPECT_EQ(rope.length(), 1000);
+  EXPECT_LE(rope.chunkCount(), 2);
+  EXPECT_GE(smallestChunk(rope), TextRope::c_minChunk);
+}
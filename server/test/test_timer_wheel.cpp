@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "TimerWheel.h"
+
+namespace {
+  // 1 ms ticks from 0: milliseconds and ticks are the same numbers
+  constexpr qint64 c_level1 = qint64(1) << TimerWheel::c_slotBits;       // 64
+  constexpr qint64 c_level2 = qint64(1) << (2 * TimerWheel::c_slotBits); // 4096
+  constexpr qint64 c_level3 = qint64(1) << (3 * TimerWheel::c_slotBits); // 262144
+  constexpr qint64 c_span = qint64(1) << (4 * TimerWheel::c_slotBits);   // Whole wheel
+
+  struct Fired {
+    qintptr key;
+    qint64 atMs;
+  };
+
+  // Advances one tick at a time so every firing time is exact
+  std::vector<Fired> runUntil(TimerWheel &wheel, qint64 fromMs, qint64 toMs) {
+    std::vector<Fired> fired;
+    for(qint64 now = fromMs; now <= toMs; ++now) {
+      wheel.advance(now, [&](qintptr key, int) { fired.push_back(Fired{key, now}); });
+    }
+    return fired;
+  }
+}
+
+TEST(TimerWheel, FiresAtDeadlineNotBefore){
+  TimerWheel wheel(1, 0);
+  wheel.schedule(0, 10, 1, 0);
+  const auto fired = runUntil(wheel, 1, 20);
+  ASSERT_EQ(fired.size(), 1u);
+  EXPECT_EQ(fired[0].atMs, 10);
+  EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(TimerWheel, CoarseTicksRoundUp){
+  TimerWheel wheel(250, 1000);
+  wheel.schedule(1000, 300, 1, 0); // Due at 1300, ticks are at 1250, 1500
+  int fired = 0;
+  wheel.advance(1499, [&](qintptr, int) { ++fired; });
+  EXPECT_EQ(fired, 0);
+  wheel.advance(1500, [&](qintptr, int) { ++fired; });
+  EXPECT_EQ(fired, 1);
+}
+
+TEST(TimerWheel, WrapsAroundLevelZero){
+  TimerWheel wheel(1, 0);
+  // Every deadline lands in a slot the level 0 wheel has already passed once
+  const qint64 start = 3 * c_level1 + 50;
+  runUntil(wheel, 1, start);
+  wheel.schedule(start, 20, 1, 0); // Crosses the wrap at 256
+  wheel.schedule(start, c_level1 - 1, 2, 0);
+  const auto fired = runUntil(wheel, start + 1, start + 2 * c_level1);
+  ASSERT_EQ(fired.size(), 2u);
+  EXPECT_EQ(fired[0].key, 1);
+  EXPECT_EQ(fired[0].atMs, start + 20);
+  EXPECT_EQ(fired[1].key, 2);
+  EXPECT_EQ(fired[1].atMs, start + c_level1 - 1);
+}
+
+TEST(TimerWheel, CascadesAtEveryLevelBoundary){
+  TimerWheel wheel(1, 0);
+  // Just before, on and just after each boundary where a level hands its slot down
+  std::vector<qint64> deadlines;
+  for(qint64 boundary : {c_level1, c_level2, c_level3, 2 * c_level3}) {
+    deadlines.push_back(boundary - 1);
+    deadlines.push_back(boundary);
+    deadlines.push_back(boundary + 1);
+  }
+  for(std::size_t i = 0; i < deadlines.size(); ++i) {
+    wheel.schedule(0, deadlines[i], static_cast<qintptr>(i), 0);
+  }
+  const auto fired = runUntil(wheel, 1, 2 * c_level3 + 2);
+  ASSERT_EQ(fired.size(), deadlines.size());
+  for(const Fired &timer : fired) {
+    EXPECT_EQ(timer.atMs, deadlines[static_cast<std::size_t>(timer.key)]) << "timer " << timer.key;
+  }
+}
+
+TEST(TimerWheel, ParksDeadlinesBeyondItsReach){
+  TimerWheel wheel(1, 0);
+  wheel.schedule(0, c_span + 100, 1, 0);
+  int fired = 0;
+  qint64 firedAt = 0;
+  for(qint64 now : {c_span - 1, c_span, c_span + 99}) {
+    wheel.advance(now, [&](qintptr, int) { ++fired; });
+  }
+  EXPECT_EQ(fired, 0);
+  wheel.advance(c_span + 100, [&](qintptr, int) { ++fired; firedAt = c_span + 100; });
+  EXPECT_EQ(fired, 1);
+  EXPECT_EQ(firedAt, c_span + 100);
+}
+
+TEST(TimerWheel, CancelAfterCascade){
+  TimerWheel wheel(1, 0);
+  const TimerWheel::t_TimerId id = wheel.schedule(0, c_level2 + 10, 1, 0); // Starts on level 1
+  wheel.schedule(0, c_level2 + 20, 2, 0);
+  EXPECT_TRUE(runUntil(wheel, 1, c_level2).empty()); // Both moved down to level 0 now
+
+  EXPECT_TRUE(wheel.cancel(id));
+  EXPECT_FALSE(wheel.cancel(id));
+  EXPECT_EQ(wheel.size(), 1);
+  const auto fired = runUntil(wheel, c_level2 + 1, c_level2 + 30);
+  ASSERT_EQ(fired.size(), 1u);
+  EXPECT_EQ(fired[0].key, 2);
+  EXPECT_EQ(fired[0].atMs, c_level2 + 20);
+}
+
+TEST(TimerWheel, StaleIdDoesNotCancelReusedEntry){
+  TimerWheel wheel(1, 0);
+  const TimerWheel::t_TimerId first = wheel.schedule(0, 5, 1, 0);
+  runUntil(wheel, 1, 5);
+  const TimerWheel::t_TimerId second = wheel.schedule(5, 5, 2, 0); // Same slab entry
+  EXPECT_NE(first, second);
+  EXPECT_FALSE(wheel.cancel(first));
+  EXPECT_FALSE(wheel.cancel(0));
+  EXPECT_EQ(wheel.size(), 1);
+  EXPECT_TRUE(wheel.cancel(second));
+}
+
+TEST(TimerWheel, RearmAndCancelDuringFire){
+  TimerWheel wheel(1, 0);
+  wheel.schedule(0, 10, 1, 0);
+  const TimerWheel::t_TimerId victim = wheel.schedule(0, 11, 2, 0);
+  std::vector<std::pair<qintptr, qint64>> fired;
+  qint64 now = 0;
+  auto onExpired = [&](qintptr key, int kind) {
+    fired.emplace_back(key, now);
+    if(kind == 0) {
+      EXPECT_TRUE(wheel.cancel(victim));
+      wheel.schedule(now, 0, 1, 1); // Next tick at the earliest, never the one running
+      wheel.schedule(now, 100, 1, 2);
+    }
+  };
+  for(now = 1; now <= 200; ++now) wheel.advance(now, onExpired);
+
+  const std::vector<std::pair<qintptr, qint64>> expected {{1, 10}, {1, 11}, {1, 110}};
+  EXPECT_EQ(fired, expected);
+  EXPECT_EQ(wheel.size(), 0);
+}
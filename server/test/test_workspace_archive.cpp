@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include "WorkspaceArchive.h"
+
+namespace {
+  constexpr qsizetype c_block = 512;
+
+  void writeFile(const QString &path, const QByteArray &content){
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(content);
+  }
+
+  // Reads in odd sized pieces, like a socket taking whatever fits
+  QByteArray readAll(WorkspaceArchive &archive){
+    QByteArray out;
+    char buffer[700];
+    qint64 got;
+    while((got = archive.read(buffer, sizeof(buffer))) > 0) out.append(buffer, got);
+    return out;
+  }
+
+  struct Header {
+    QByteArray name;
+    QByteArray prefix;
+    qint64 size;
+    char type;
+    bool checksumOk;
+  };
+
+  Header parseHeader(const QByteArray &tar, qsizetype offset){
+    const QByteArray block = tar.mid(offset, c_block);
+    const auto field = [&](int from, int width) { return QByteArray(block.constData() + from, width).split('\0').front(); };
+    Header header;
+    header.name = field(0, 100);
+    header.prefix = field(345, 155);
+    header.size = field(124, 12).toLongLong(nullptr, 8);
+    header.type = block.at(156);
+    unsigned int sum = 0;
+    for(int i = 0; i < c_block; ++i) sum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(block.at(i));
+    header.checksumOk = field(148, 8).trimmed().toUInt(nullptr, 8) == sum;
+    return header;
+  }
+}
+
+TEST(WorkspaceArchive, ProducesUstarEntriesOfAnnouncedSize){
+  QTemporaryDir root;
+  ASSERT_TRUE(root.isValid());
+  writeFile(root.filePath("src/main.py"), "print('hi')\n");
+
+  WorkspaceArchive archive(root.path(), {
+    WorkspaceArchive::Entry {"src", 0, 1700000000, true},
+    WorkspaceArchive::Entry {"src/main.py", 12, 1700000000, false}
+  });
+  const QByteArray tar = readAll(archive);
+  ASSERT_EQ(tar.size(), archive.size());
+  EXPECT_EQ(tar.size(), 2 * c_block + c_block + 2 * c_block); // Two headers, one content block, trailer
+  EXPECT_TRUE(archive.incompleteFiles().isEmpty());
+
+  const Header directory = parseHeader(tar, 0);
+  EXPECT_EQ(directory.name, QByteArray("src/"));
+  EXPECT_EQ(directory.type, '5');
+  EXPECT_TRUE(directory.checksumOk);
+
+  const Header file = parseHeader(tar, c_block);
+  EXPECT_EQ(file.name, QByteArray("src/main.py"));
+  EXPECT_EQ(file.size, 12);
+  EXPECT_EQ(file.type, '0');
+  EXPECT_TRUE(file.checksumOk);
+  EXPECT_EQ(tar.mid(2 * c_block, 12), QByteArray("print('hi')\n"));
+  EXPECT_EQ(tar.mid(2 * c_block + 12).count('\0'), tar.size() - 2 * c_block - 12); // Padding and trailer
+}
+
+TEST(WorkspaceArchive, LongPathsUsePrefixOrPaxHeader){
+  const QString directory = QString(120, 'd');
+  const QString longName = QString(150, 'n');
+  WorkspaceArchive archive(QDir::tempPath(), {
+    WorkspaceArchive::Entry {directory + "/file", 0, 0, false},
+    WorkspaceArchive::Entry {directory + "/" + longName, 0, 0, false}
+  });
+  const QByteArray tar = readAll(archive);
+  ASSERT_EQ(tar.size(), archive.size());
+
+  // Fits ustar split at the '/'
+  const Header split = parseHeader(tar, 0);
+  EXPECT_EQ(split.prefix, directory.toLatin1());
+  EXPECT_EQ(split.name, QByteArray("file"));
+
+  // Name part alone is over 100 bytes: pax record carries the full path
+  const Header pax = parseHeader(tar, c_block);
+  EXPECT_EQ(pax.type, 'x');
+  const QByteArray records = tar.mid(2 * c_block, pax.size);
+  EXPECT_TRUE(records.endsWith(" path=" + (directory + "/" + longName).toLatin1() + "\n"));
+  EXPECT_EQ(records.left(records.indexOf(' ')).toLongLong(), records.size());
+  EXPECT_EQ(parseHeader(tar, 3 * c_block).type, '0');
+}
+
+// Size is announced up front (Content-Length), a file that changed since the scan can't change it
+TEST(WorkspaceArchive, FilesThatChangedSizeKeepTheScannedSize){
+  QTemporaryDir root;
+  ASSERT_TRUE(root.isValid());
+  writeFile(root.filePath("shrunk.txt"), "abc");
+  writeFile(root.filePath("grown.txt"), "0123456789");
+
+  WorkspaceArchive archive(root.path(), {
+    WorkspaceArchive::Entry {"shrunk.txt", 8, 0, false},
+    WorkspaceArchive::Entry {"grown.txt", 4, 0, false},
+    WorkspaceArchive::Entry {"missing.txt", 5, 0, false}
+  });
+  const QByteArray tar = readAll(archive);
+  ASSERT_EQ(tar.size(), archive.size());
+  EXPECT_EQ(tar.mid(c_block, 8), QByteArray("abc\0\0\0\0\0", 8));
+  EXPECT_EQ(tar.mid(3 * c_block, 4), QByteArray("0123"));
+  EXPECT_EQ(archive.incompleteFiles(), (QSet<QString> {"shrunk.txt", "grown.txt", "missing.txt"}));
+}
+
+// ustar's size field ends at 8 GiB - 1, beyond that the exact size goes in a pax record
+TEST(WorkspaceArchive, SizesFrom8GiBUsePaxSizeRecord){
+  constexpr qint64 largestUstar = 077777777777;
+  WorkspaceArchive fitting(QDir::tempPath(), {WorkspaceArchive::Entry {"fits.bin", largestUstar, 0, false}});
+  EXPECT_EQ(fitting.size(), c_block + largestUstar + 1 + 2 * c_block);
+  const Header fits = parseHeader(fitting.read(c_block), 0); // Just the header, content is gigabytes of zeros
+  EXPECT_EQ(fits.type, '0');
+  EXPECT_EQ(fits.size, largestUstar);
+  EXPECT_TRUE(fits.checksumOk);
+
+  constexpr qint64 huge = largestUstar + 4;
+  WorkspaceArchive archive(QDir::tempPath(), {WorkspaceArchive::Entry {"huge.bin", huge, 0, false}});
+  EXPECT_EQ(archive.size(), 3 * c_block + huge + (c_block - 3) + 2 * c_block);
+  const QByteArray headers = archive.read(3 * c_block);
+  const Header pax = parseHeader(headers, 0);
+  EXPECT_EQ(pax.type, 'x');
+  EXPECT_TRUE(pax.checksumOk);
+  const QByteArray records = headers.mid(c_block, pax.size);
+  EXPECT_TRUE(records.endsWith(" size=" + QByteArray::number(huge) + "\n"));
+  EXPECT_EQ(records.left(records.indexOf(' ')).toLongLong(), records.size());
+
+  const Header file = parseHeader(headers, 2 * c_block);
+  EXPECT_EQ(file.type, '0');
+  EXPECT_EQ(file.name, QByteArray("huge.bin"));
+  EXPECT_EQ(file.size, 0); // Readers take the pax size
+  EXPECT_TRUE(file.checksumOk);
+}
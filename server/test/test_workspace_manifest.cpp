@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include "WorkspaceManifest.h"
+
+namespace {
+  void writeFile(const QString &path, const QByteArray &content){
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(content);
+  }
+
+  WorkspaceManifest::File file(const QByteArray &hash){
+    return WorkspaceManifest::File {1, 1, hash};
+  }
+
+  QSet<QString> set(std::initializer_list<QString> paths){
+    return QSet<QString>(paths);
+  }
+}
+
+TEST(WorkspaceManifest, ScanHashesFilesAndSkipsTemporaries){
+  QTemporaryDir root;
+  ASSERT_TRUE(root.isValid());
+  writeFile(root.filePath("main.py"), "print(1)\n");
+  writeFile(root.filePath("src/util.py"), "x = 2\n");
+  writeFile(root.filePath("src/util.py.synergy-tmp"), "half written");
+  QDir(root.path()).mkpath("empty/inner");
+
+  const WorkspaceManifest manifest = WorkspaceManifest::scan(root.path(), WorkspaceManifest());
+  EXPECT_EQ(manifest.files.size(), 2);
+  EXPECT_EQ(manifest.directories, set({"src", "empty", "empty/inner"}));
+  ASSERT_TRUE(manifest.files.contains("src/util.py"));
+  EXPECT_EQ(manifest.files.value("src/util.py").size, 6);
+  EXPECT_EQ(manifest.files.value("main.py").hash, QCryptographicHash::hash("print(1)\n", QCryptographicHash::Sha256));
+}
+
+TEST(WorkspaceManifest, ScanReusesHashesOfUnchangedFiles){
+  QTemporaryDir root;
+  ASSERT_TRUE(root.isValid());
+  writeFile(root.filePath("same.txt"), "same");
+  writeFile(root.filePath("edited.txt"), "before");
+
+  // Cached hashes are taken on trust while size and mtime match
+  WorkspaceManifest previous = WorkspaceManifest::scan(root.path(), WorkspaceManifest());
+  previous.files["same.txt"].hash = "cached";
+  previous.files["edited.txt"].hash = "cached";
+  writeFile(root.filePath("edited.txt"), "after, longer");
+
+  const WorkspaceManifest manifest = WorkspaceManifest::scan(root.path(), previous);
+  EXPECT_EQ(manifest.files.value("same.txt").hash, QByteArray("cached"));
+  EXPECT_EQ(manifest.files.value("edited.txt").hash, QCryptographicHash::hash("after, longer", QCryptographicHash::Sha256));
+}
+
+TEST(WorkspaceManifest, EmptyContainerGetsEverything){
+  WorkspaceManifest host;
+  host.files.insert("a.txt", file("A"));
+  host.files.insert("dir/b.txt", file("B"));
+  host.directories.insert("dir");
+
+  const WorkspaceManifest::Changes changes = host.changesFrom(WorkspaceManifest::Listing(), {});
+  EXPECT_TRUE(changes.deletions.isEmpty());
+  EXPECT_EQ(changes.files, set({"a.txt", "dir/b.txt"}));
+  EXPECT_EQ(changes.directories, set({"dir"}));
+}
+
+TEST(WorkspaceManifest, OnlyChangedContentIsUploaded){
+  WorkspaceManifest host;
+  host.files.insert("same.txt", file("S"));
+  host.files.insert("edited.txt", file("E2"));
+  host.files.insert("new.txt", file("N"));
+
+  WorkspaceManifest::Listing container;
+  container.clean = set({"same.txt", "edited.txt"});
+  const WorkspaceManifest::Changes changes = host.changesFrom(container, {{"same.txt", "S"}, {"edited.txt", "E1"}});
+  EXPECT_TRUE(changes.deletions.isEmpty());
+  EXPECT_EQ(changes.files, set({"edited.txt", "new.txt"}));
+}
+
+TEST(WorkspaceManifest, RunOutputIsDeletedAndRestored){
+  WorkspaceManifest host;
+  host.files.insert("data.csv", file("D"));
+  host.directories.insert("src");
+
+  // A run overwrote data.csv, created out.log and a build tree
+  WorkspaceManifest::Listing container;
+  container.dirty = set({"data.csv", "out.log", "build/obj/a.o"});
+  container.directories = set({"src", "build", "build/obj"});
+  const WorkspaceManifest::Changes changes = host.changesFrom(container, {{"data.csv", "D"}});
+  EXPECT_EQ(changes.deletions, (QStringList {"build", "data.csv", "out.log"})); // Topmost of a subtree only, sorted
+  EXPECT_EQ(changes.files, set({"data.csv"}));
+  EXPECT_TRUE(changes.directories.isEmpty());
+}
+
+TEST(WorkspaceManifest, TypeChangesAreReplaced){
+  WorkspaceManifest host;
+  host.directories.insert("was-file");
+  host.files.insert("was-dir", file("F"));
+
+  WorkspaceManifest::Listing container;
+  container.clean = set({"was-file", "was-dir/inner.txt"});
+  container.directories = set({"was-dir"});
+  const WorkspaceManifest::Changes changes = host.changesFrom(container, {{"was-file", "X"}, {"was-dir/inner.txt", "Y"}});
+  EXPECT_EQ(changes.deletions, (QStringList {"was-dir", "was-file"}));
+  EXPECT_EQ(changes.files, set({"was-dir"}));
+  EXPECT_EQ(changes.directories, set({"was-file"}));
+}